@@ -188,12 +188,10 @@ void DrawBody::initialise(SimulationWidget *simulationWidget)
     m_facetedObjectList.push_back(m_meshEntity3.get());
 }
 
-void DrawBody::updateEntityPose()
+void DrawBody::updateEntityPose(const RenderState::Pose &pose)
 {
-    const double *quaternion = m_body->GetQuaternion();
-    const double *position = m_body->GetPosition();
-    SetDisplayRotationFromQuaternion(quaternion);
-    SetDisplayPosition(position[0], position[1], position[2]);
+    SetDisplayRotationFromQuaternion(pose.quaternion);
+    SetDisplayPosition(pose.position[0], pose.position[1], pose.position[2]);
     m_axes->SetDisplayScale(m_body->size1(), m_body->size1(), m_body->size1());
 }
 
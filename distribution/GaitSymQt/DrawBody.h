@@ -11,6 +11,7 @@
 #define DRAWBODY_H
 
 #include "Drawable.h"
+#include "RenderState.h"
 
 #include <QColor>
 #include <QStringList>
@@ -30,7 +31,7 @@ public:
     virtual void Draw();
     virtual std::string name();
 
-    void updateEntityPose();
+    void updateEntityPose(const RenderState::Pose &pose);
 
     Body *body() const;
     void setBody(Body *body);
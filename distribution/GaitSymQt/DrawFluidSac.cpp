@@ -33,9 +33,24 @@ std::string DrawFluidSac::name()
     else return std::string();
 }
 
+// this is called on the thread that steps the simulation so it must not touch anything OpenGL related
+void DrawFluidSac::CaptureState(FluidSac *fluidSac, RenderState::FluidSacState *state)
+{
+    state->vertices.resize(fluidSac->numTriangles() * 9);
+    for (size_t i = 0; i < fluidSac->numTriangles(); i++) fluidSac->triangleVertices(i, &state->vertices[i * 9]);
+    const std::vector<PointForce> &pointForceList = fluidSac->pointForceList();
+    state->forceOrigins.resize(pointForceList.size());
+    state->forceVectors.resize(pointForceList.size());
+    for (size_t i = 0; i < pointForceList.size(); i++)
+    {
+        state->forceOrigins[i] = pgd::Vector3(pointForceList[i].point[0], pointForceList[i].point[1], pointForceList[i].point[2]);
+        state->forceVectors[i] = pgd::Vector3(pointForceList[i].vector[0], pointForceList[i].vector[1], pointForceList[i].vector[2]);
+    }
+}
+
 void DrawFluidSac::initialise(SimulationWidget *simulationWidget)
 {
-    if (!m_fluidSac) return;
+    if (!m_fluidSac || !m_fluidSacState) return;
 
     m_fluidSacColour.setRedF(qreal(m_fluidSac->colour1().r()));
     m_fluidSacColour.setGreenF(qreal(m_fluidSac->colour1().g()));
@@ -52,30 +67,61 @@ void DrawFluidSac::initialise(SimulationWidget *simulationWidget)
     m_facetedObject = std::make_unique<FacetedObject>();
     m_facetedObject->setSimulationWidget(simulationWidget);
     m_facetedObject->setBlendColour(m_fluidSacColour, 1);
-    m_facetedObject->AllocateMemory(m_fluidSac->numTriangles());
-    double vertices[9];
-    for (size_t i = 0; i < m_fluidSac->numTriangles(); i++)
+    size_t numTriangles = m_fluidSacState->vertices.size() / 9;
+    m_facetedObject->AllocateMemory(numTriangles);
+    for (size_t i = 0; i < numTriangles; i++)
     {
-        m_fluidSac->triangleVertices(i, vertices);
-        m_facetedObject->AddTriangle(vertices);
+        m_facetedObject->AddTriangle(&m_fluidSacState->vertices[i * 9]);
     }
 //    qDebug() << "DrawFluidSac " << facetedObject->GetNumTriangles() << " triangles created\n";
 
     if (m_displayFluidSacForces)
     {
-        const std::vector<PointForce> &pointForceList = m_fluidSac->pointForceList();
-        for (size_t i = 0; i < pointForceList.size(); i++)
+        for (size_t i = 0; i < m_fluidSacState->forceOrigins.size(); i++)
         {
             std::vector<pgd::Vector3> polyline;
-            polyline.clear();
-            pgd::Vector3 f = pgd::Vector3(pointForceList.at(i).vector[0], pointForceList.at(i).vector[1], pointForceList.at(i).vector[2]) * m_fluidSacForceScale;
-            polyline.push_back(pgd::Vector3(pointForceList.at(i).point[0], pointForceList.at(i).point[1], pointForceList.at(i).point[2]));
-            polyline.push_back(pgd::Vector3(pointForceList.at(i).point[0], pointForceList.at(i).point[1], pointForceList.at(i).point[2]) + f);
+            polyline.push_back(m_fluidSacState->forceOrigins[i]);
+            polyline.push_back(m_fluidSacState->forceOrigins[i] + m_fluidSacState->forceVectors[i] * m_fluidSacForceScale);
             std::unique_ptr<FacetedObject> facetedPolyline = std::make_unique<FacetedPolyline>(&polyline, m_fluidSacForceRadius, m_fluidSacForceSegments, m_fluidSacForceColour, 1);
+            facetedPolyline->setSimulationWidget(simulationWidget);
             m_facetedObjectForceList.push_back(std::move(facetedPolyline));
         }
     }
     m_facetedObjectList.push_back(m_facetedObject.get());
+    m_drawnState = *m_fluidSacState;
+}
+
+// bring the existing meshes up to date with a new state without reallocating anything
+// returns false if the number of parts has changed and the whole DrawFluidSac needs to be recreated
+bool DrawFluidSac::updateEntityState(const RenderState::FluidSacState &fluidSacState)
+{
+    if (fluidSacState.vertices.size() != m_drawnState.vertices.size() ||
+            fluidSacState.forceOrigins.size() != m_drawnState.forceOrigins.size())
+        return false;
+
+    if (fluidSacState.vertices != m_drawnState.vertices)
+    {
+        m_facetedObject->ClearGeometry();
+        size_t numTriangles = fluidSacState.vertices.size() / 9;
+        for (size_t i = 0; i < numTriangles; i++)
+        {
+            m_facetedObject->AddTriangle(&fluidSacState.vertices[i * 9]);
+        }
+    }
+
+    if (m_facetedObjectForceList.size())
+    {
+        std::vector<pgd::Vector3> polyline(2);
+        for (size_t i = 0; i < m_facetedObjectForceList.size(); i++)
+        {
+            polyline[0] = fluidSacState.forceOrigins[i];
+            polyline[1] = fluidSacState.forceOrigins[i] + fluidSacState.forceVectors[i] * m_fluidSacForceScale;
+            static_cast<FacetedPolyline *>(m_facetedObjectForceList[i].get())->Update(&polyline, m_fluidSacForceRadius, m_fluidSacForceSegments);
+        }
+    }
+
+    m_drawnState = fluidSacState;
+    return true;
 }
 
 FluidSac *DrawFluidSac::fluidSac() const
@@ -118,6 +164,16 @@ void DrawFluidSac::setFluidSac(FluidSac *fluidSac)
     m_fluidSac = fluidSac;
 }
 
+const RenderState::FluidSacState *DrawFluidSac::fluidSacState() const
+{
+    return m_fluidSacState;
+}
+
+void DrawFluidSac::setFluidSacState(const RenderState::FluidSacState *fluidSacState)
+{
+    m_fluidSacState = fluidSacState;
+}
+
 void DrawFluidSac::Draw()
 {
     m_facetedObject->Draw();
@@ -11,6 +11,7 @@
 #define DRAWFLUIDSAC_H
 
 #include "Drawable.h"
+#include "RenderState.h"
 
 #include <QColor>
 
@@ -33,6 +34,12 @@ public:
     FluidSac *fluidSac() const;
     void setFluidSac(FluidSac *fluidSac);
 
+    const RenderState::FluidSacState *fluidSacState() const;
+    void setFluidSacState(const RenderState::FluidSacState *fluidSacState);
+
+    static void CaptureState(FluidSac *fluidSac, RenderState::FluidSacState *state);
+    bool updateEntityState(const RenderState::FluidSacState &fluidSacState);
+
     QColor fluidSacColour() const;
     void setFluidSacColour(const QColor &fluidSacColour);
 
@@ -45,6 +52,8 @@ public:
 
 private:
     FluidSac *m_fluidSac = nullptr;
+    const RenderState::FluidSacState *m_fluidSacState = nullptr;
+    RenderState::FluidSacState m_drawnState;
 
     std::unique_ptr<FacetedObject> m_facetedObject;
     std::vector<std::unique_ptr<FacetedObject>> m_facetedObjectForceList;
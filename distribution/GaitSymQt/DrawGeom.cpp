@@ -108,13 +108,10 @@ void DrawGeom::initialise(SimulationWidget *simulationWidget)
     qDebug() << "Error in DrawGeom::initialise: Unsupported GEOM type";
 }
 
-void DrawGeom::updateEntityPose()
+void DrawGeom::updateEntityPose(const RenderState::Pose &pose)
 {
-    Marker *marker = m_geom->geomMarker();
-    pgd::Quaternion q = marker->GetWorldQuaternion();
-    pgd::Vector3 p = marker->GetWorldPosition();
-    SetDisplayRotationFromQuaternion(q.data());
-    SetDisplayPosition(p.x, p.y, p.z);
+    SetDisplayRotationFromQuaternion(pose.quaternion);
+    SetDisplayPosition(pose.position[0], pose.position[1], pose.position[2]);
 
 //    SphereGeom *sphereGeom = dynamic_cast<SphereGeom *>(m_geom);
 //    if (sphereGeom)
@@ -11,6 +11,7 @@
 #define DRAWGEOM_H
 
 #include <Drawable.h>
+#include "RenderState.h"
 
 #include <QColor>
 
@@ -29,7 +30,7 @@ public:
     virtual void Draw();
     virtual std::string name();
 
-    void updateEntityPose();
+    void updateEntityPose(const RenderState::Pose &pose);
 
     Geom *geom() const;
     void setGeom(Geom *geom);
@@ -148,20 +148,16 @@ void DrawJoint::initialise(SimulationWidget *simulationWidget)
     qDebug() << "Error in DrawJoint::initialise: Unsupported JOINT type \"" << m_joint->name().c_str() << "\"";
 }
 
-void DrawJoint::updateEntityPose()
+void DrawJoint::updateEntityPose(const RenderState::JointState &jointState)
 {
-    Marker *marker = m_joint->body1Marker();
-    pgd::Quaternion q = marker->GetWorldQuaternion();
-    pgd::Vector3 p = marker->GetWorldPosition();
-    SetDisplayRotationFromQuaternion(q.data());
-    SetDisplayPosition(p.x, p.y, p.z);
-    FixedJoint *fixedJoint = dynamic_cast<FixedJoint *>(m_joint);
-    if (fixedJoint && fixedJoint->CalculatePixmapNeeded() && m_facetedObject1->texture())
+    SetDisplayRotationFromQuaternion(jointState.pose.quaternion);
+    SetDisplayPosition(jointState.pose.position[0], jointState.pose.position[1], jointState.pose.position[2]);
+    // the pixmap was calculated when the render state was captured
+    if (jointState.pixMap.size() && m_facetedObject1->texture())
     {
-        fixedJoint->CalculatePixmap();
         QOpenGLPixelTransferOptions uploadOptions;
         uploadOptions.setAlignment(1);
-        m_facetedObject1->texture()->setData(0, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, fixedJoint->pixMap().data(), &uploadOptions);
+        m_facetedObject1->texture()->setData(0, QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, jointState.pixMap.data(), &uploadOptions);
     }
 }
 
@@ -11,6 +11,7 @@
 #define DRAWJOINT_H
 
 #include <Drawable.h>
+#include "RenderState.h"
 
 #include <QColor>
 
@@ -30,7 +31,7 @@ public:
     virtual void Draw();
     virtual std::string name();
 
-    void updateEntityPose();
+    void updateEntityPose(const RenderState::JointState &jointState);
 
     Joint *joint() const;
     void setJoint(Joint *joint);
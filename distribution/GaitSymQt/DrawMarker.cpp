@@ -45,13 +45,11 @@ void DrawMarker::initialise(SimulationWidget *simulationWidget)
     m_facetedObjectList.push_back(m_facetedObject.get());
 }
 
-void DrawMarker::updateEntityPose()
+void DrawMarker::updateEntityPose(const RenderState::Pose &pose)
 {
-    pgd::Vector3 p = m_marker->GetWorldPosition();
-    pgd::Quaternion q = m_marker->GetWorldQuaternion();
     SetDisplayScale(m_marker->size1(), m_marker->size1(), m_marker->size1());
-    SetDisplayRotationFromQuaternion(q.constData());
-    SetDisplayPosition(p.x, p.y, p.z);
+    SetDisplayRotationFromQuaternion(pose.quaternion);
+    SetDisplayPosition(pose.position[0], pose.position[1], pose.position[2]);
 }
 
 void DrawMarker::Draw()
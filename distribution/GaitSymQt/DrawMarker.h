@@ -11,6 +11,7 @@
 #define DRAWMARKER_H
 
 #include "Drawable.h"
+#include "RenderState.h"
 
 #include <memory>
 
@@ -26,7 +27,7 @@ public:
     virtual void Draw();
     virtual std::string name();
 
-    void updateEntityPose();
+    void updateEntityPose(const RenderState::Pose &pose);
 
     Marker *marker() const;
     void setMarker(Marker *marker);
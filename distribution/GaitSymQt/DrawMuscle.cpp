@@ -159,102 +159,70 @@ void DrawMuscle::setMuscle(Muscle *muscle)
     m_muscle = muscle;
 }
 
-void DrawMuscle::initialise(SimulationWidget *simulationWidget)
+const RenderState::MuscleState *DrawMuscle::muscleState() const
 {
-    if (!m_muscle) return;
+    return m_muscleState;
+}
 
-    Colour colour(m_muscle->GetStrap()->colour1());
-    switch (m_muscle->strapColourControl())
+void DrawMuscle::setMuscleState(const RenderState::MuscleState *muscleState)
+{
+    m_muscleState = muscleState;
+}
+
+// this is called on the thread that steps the simulation so it must not touch anything OpenGL related
+void DrawMuscle::CaptureState(Muscle *muscle, RenderState::MuscleState *state)
+{
+    state->path.clear();
+    state->hasCylinder = false;
+    state->forceOrigins.clear();
+    state->forceVectors.clear();
+
+    switch (muscle->strapColourControl())
     {
     case Muscle::fixedColour:
-        m_strapColor.setRedF(qreal(m_muscle->GetStrap()->colour1().r()));
-        m_strapColor.setGreenF(qreal(m_muscle->GetStrap()->colour1().g()));
-        m_strapColor.setBlueF(qreal(m_muscle->GetStrap()->colour1().b()));
-        m_strapColor.setAlphaF(qreal(m_muscle->GetStrap()->colour1().alpha()));
+        state->colourValue = 0;
         break;
     case Muscle::activationMap:
-        Colour::SetColourFromMap(float(m_muscle->GetActivation()), m_strapColourMap, &colour, false);
-        m_strapColor = QColor(QString::fromStdString(colour.GetHexArgb()));
+        state->colourValue = muscle->GetActivation();
         break;
     case Muscle::strainMap:
-        if (dynamic_cast<DampedSpringMuscle *>(m_muscle)) Colour::SetColourFromMap(float(m_muscle->GetLength() / dynamic_cast<DampedSpringMuscle *>(m_muscle)->GetUnloadedLength()) - 0.5f, m_strapColourMap, &colour, false);
-        else if (dynamic_cast<MAMuscleComplete *>(m_muscle)) Colour::SetColourFromMap(
-                    float(m_muscle->GetLength() / (dynamic_cast<MAMuscleComplete *>(m_muscle)->fibreLength() + dynamic_cast<MAMuscleComplete *>(m_muscle)->tendonLength())) - 0.5f, m_strapColourMap, &colour, false);
-        else if (dynamic_cast<MAMuscle *>(m_muscle)) Colour::SetColourFromMap(float(m_muscle->GetLength() / (dynamic_cast<MAMuscle *>(m_muscle)->fibreLength())) - 0.5f, m_strapColourMap, &colour, false);
-        m_strapColor = QColor(QString::fromStdString(colour.GetHexArgb()));
+        if (dynamic_cast<DampedSpringMuscle *>(muscle)) state->colourValue = muscle->GetLength() / dynamic_cast<DampedSpringMuscle *>(muscle)->GetUnloadedLength() - 0.5;
+        else if (dynamic_cast<MAMuscleComplete *>(muscle)) state->colourValue = muscle->GetLength() / (dynamic_cast<MAMuscleComplete *>(muscle)->fibreLength() + dynamic_cast<MAMuscleComplete *>(muscle)->tendonLength()) - 0.5;
+        else if (dynamic_cast<MAMuscle *>(muscle)) state->colourValue = muscle->GetLength() / (dynamic_cast<MAMuscle *>(muscle)->fibreLength()) - 0.5;
         break;
     case Muscle::forceMap:
-        if (dynamic_cast<DampedSpringMuscle *>(m_muscle)) Colour::SetColourFromMap(
-                    float(m_muscle->GetTension() / (dynamic_cast<DampedSpringMuscle *>(m_muscle)->GetUnloadedLength() * dynamic_cast<DampedSpringMuscle *>(m_muscle)->GetSpringConstant())), m_strapColourMap, &colour, false);
-        else if (dynamic_cast<MAMuscleComplete *>(m_muscle)) Colour::SetColourFromMap(
-                    float(m_muscle->GetTension() / (dynamic_cast<MAMuscleComplete *>(m_muscle)->forcePerUnitArea() * dynamic_cast<MAMuscleComplete *>(m_muscle)->pca())), m_strapColourMap, &colour, false);
-        else if (dynamic_cast<MAMuscle *>(m_muscle)) Colour::SetColourFromMap(
-                    float(m_muscle->GetLength() / (dynamic_cast<MAMuscle *>(m_muscle)->forcePerUnitArea() * dynamic_cast<MAMuscle *>(m_muscle)->pca())), m_strapColourMap, &colour, false);
-        m_strapColor = QColor(QString::fromStdString(colour.GetHexArgb()));
+        if (dynamic_cast<DampedSpringMuscle *>(muscle)) state->colourValue = muscle->GetTension() / (dynamic_cast<DampedSpringMuscle *>(muscle)->GetUnloadedLength() * dynamic_cast<DampedSpringMuscle *>(muscle)->GetSpringConstant());
+        else if (dynamic_cast<MAMuscleComplete *>(muscle)) state->colourValue = muscle->GetTension() / (dynamic_cast<MAMuscleComplete *>(muscle)->forcePerUnitArea() * dynamic_cast<MAMuscleComplete *>(muscle)->pca());
+        else if (dynamic_cast<MAMuscle *>(muscle)) state->colourValue = muscle->GetLength() / (dynamic_cast<MAMuscle *>(muscle)->forcePerUnitArea() * dynamic_cast<MAMuscle *>(muscle)->pca());
         break;
     }
-    m_strapCylinderColor.setRedF(qreal(m_muscle->GetStrap()->colour2().r()));
-    m_strapCylinderColor.setGreenF(qreal(m_muscle->GetStrap()->colour2().g()));
-    m_strapCylinderColor.setBlueF(qreal(m_muscle->GetStrap()->colour2().b()));
-    m_strapCylinderColor.setAlphaF(qreal(m_muscle->GetStrap()->colour2().alpha()));
-
-    m_strapForceColor.setRedF(qreal(m_muscle->colour1().r()));
-    m_strapForceColor.setGreenF(qreal(m_muscle->colour1().g()));
-    m_strapForceColor.setBlueF(qreal(m_muscle->colour1().b()));
-    m_strapForceColor.setAlphaF(qreal(m_muscle->colour1().alpha()));
-
-    m_strapRadius = m_muscle->GetStrap()->size1();
-    m_strapCylinderLength  = m_muscle->GetStrap()->size2();
-    m_strapForceRadius  = m_muscle->size1();
-    m_strapForceScale  = m_muscle->size2();
 
     for (bool first = true; first; first = false) // this loop runs once to avoid nasty nested if-else statements
     {
-        TwoPointStrap *twoPointStrap = dynamic_cast<TwoPointStrap *>(m_muscle->GetStrap());
+        TwoPointStrap *twoPointStrap = dynamic_cast<TwoPointStrap *>(muscle->GetStrap());
         if (twoPointStrap)
         {
             std::vector<std::unique_ptr<PointForce >> *pointForceList = twoPointStrap->GetPointForceList();
-            std::vector<pgd::Vector3> polyline;
-            polyline.reserve(pointForceList->size());
-            polyline.push_back(pgd::Vector3(pointForceList->at(0)->point[0], pointForceList->at(0)->point[1], pointForceList->at(0)->point[2]));
-            polyline.push_back(pgd::Vector3(pointForceList->at(1)->point[0], pointForceList->at(1)->point[1], pointForceList->at(1)->point[2]));
-            m_facetedObject1 = std::make_unique<FacetedPolyline>(&polyline, m_strapRadius, m_strapNumSegments, m_strapColor, 1);
-            m_facetedObject1->setSimulationWidget(simulationWidget);
-            m_facetedObjectList.push_back(m_facetedObject1.get());
+            state->path.push_back(pgd::Vector3(pointForceList->at(0)->point[0], pointForceList->at(0)->point[1], pointForceList->at(0)->point[2]));
+            state->path.push_back(pgd::Vector3(pointForceList->at(1)->point[0], pointForceList->at(1)->point[1], pointForceList->at(1)->point[2]));
             break;
         }
-        NPointStrap *nPointStrap = dynamic_cast<NPointStrap *>(m_muscle->GetStrap());
+        NPointStrap *nPointStrap = dynamic_cast<NPointStrap *>(muscle->GetStrap());
         if (nPointStrap)
         {
             std::vector<std::unique_ptr<PointForce >> *pointForceList = nPointStrap->GetPointForceList();
-            std::vector<pgd::Vector3> polyline;
-            polyline.reserve(pointForceList->size());
-            polyline.push_back(pgd::Vector3(pointForceList->at(0)->point[0], pointForceList->at(0)->point[1], pointForceList->at(0)->point[2]));
+            state->path.push_back(pgd::Vector3(pointForceList->at(0)->point[0], pointForceList->at(0)->point[1], pointForceList->at(0)->point[2]));
             for (size_t i = 2; i < pointForceList->size(); i++)
-                polyline.push_back(pgd::Vector3(pointForceList->at(i)->point[0], pointForceList->at(i)->point[1], pointForceList->at(i)->point[2]));
-            polyline.push_back(pgd::Vector3(pointForceList->at(1)->point[0], pointForceList->at(1)->point[1], pointForceList->at(1)->point[2]));
-            m_facetedObject1 = std::make_unique<FacetedPolyline>(&polyline, m_strapRadius, m_strapNumSegments, m_strapColor, 1);
-            m_facetedObject1->setSimulationWidget(simulationWidget);
-            m_facetedObjectList.push_back(m_facetedObject1.get());
+                state->path.push_back(pgd::Vector3(pointForceList->at(i)->point[0], pointForceList->at(i)->point[1], pointForceList->at(i)->point[2]));
+            state->path.push_back(pgd::Vector3(pointForceList->at(1)->point[0], pointForceList->at(1)->point[1], pointForceList->at(1)->point[2]));
             break;
         }
-        CylinderWrapStrap *cylinderWrapStrap = dynamic_cast<CylinderWrapStrap *>(m_muscle->GetStrap());
+        CylinderWrapStrap *cylinderWrapStrap = dynamic_cast<CylinderWrapStrap *>(muscle->GetStrap());
         if (cylinderWrapStrap)
         {
-            std::vector<pgd::Vector3> polyline;
             const pgd::Vector3 *pathCoordinates = cylinderWrapStrap->GetPathCoordinates();
             int numPathCoordinates = cylinderWrapStrap->GetNumPathCoordinates();
-            polyline.reserve(size_t(numPathCoordinates));
-            if (numPathCoordinates)
-            {
-                for (size_t i = 0; i < size_t(numPathCoordinates); i++)
-                {
-                    polyline.push_back(pathCoordinates[i]);
-                }
-                m_facetedObject1 = std::make_unique<FacetedPolyline>(&polyline, m_strapRadius, m_strapNumSegments, m_strapColor, 1);
-                m_facetedObject1->setSimulationWidget(simulationWidget);
-                m_facetedObjectList.push_back(m_facetedObject1.get());
-            }
+            for (size_t i = 0; i < size_t(numPathCoordinates); i++) state->path.push_back(pathCoordinates[i]);
 
             // calculate the quaternion that rotates from cylinder coordinates to world coordinates
             const Body *body;
@@ -265,45 +233,158 @@ void DrawMuscle::initialise(SimulationWidget *simulationWidget)
             const double *q = dBodyGetQuaternion(body->GetBodyID());
             pgd::Quaternion qBody(q[0], q[1], q[2], q[3]);
             pgd::Quaternion cylinderToWorldQuaternion =  qBody * pgd::Quaternion(qq[0], qq[1], qq[2], qq[3]);
-            pgd::Vector3 cylinderVecWorld = pgd::QVRotate(cylinderToWorldQuaternion, pgd::Vector3(0, 0, m_strapCylinderLength / 2));
+            pgd::Vector3 cylinderVecWorld = pgd::QVRotate(cylinderToWorldQuaternion, pgd::Vector3(0, 0, muscle->GetStrap()->size2() / 2));
             // calculate the cylinder world position
             dVector3 position;
             dBodyGetRelPointPos(body->GetBodyID(), pos[0], pos[1], pos[2], position);
-            // and draw it
-            polyline.clear();
-            polyline.push_back(pgd::Vector3(position[0] - cylinderVecWorld.x, position[1] - cylinderVecWorld.y, position[2] - cylinderVecWorld.z));
-            polyline.push_back(pgd::Vector3(position[0] + cylinderVecWorld.x, position[1] + cylinderVecWorld.y, position[2] + cylinderVecWorld.z));
-            m_facetedObject2 = std::make_unique<FacetedPolyline>(&polyline, radius, m_strapCylinderSegments, m_strapCylinderColor, 1);
-            m_facetedObject2->setSimulationWidget(simulationWidget);
-            m_facetedObjectList.push_back(m_facetedObject2.get());
+            state->hasCylinder = true;
+            state->cylinderEnd0 = pgd::Vector3(position[0] - cylinderVecWorld.x, position[1] - cylinderVecWorld.y, position[2] - cylinderVecWorld.z);
+            state->cylinderEnd1 = pgd::Vector3(position[0] + cylinderVecWorld.x, position[1] + cylinderVecWorld.y, position[2] + cylinderVecWorld.z);
+            state->cylinderRadius = radius;
             break;
         }
+    }
+
+    std::vector<std::unique_ptr<PointForce >> *pointForceList = muscle->GetPointForceList();
+    for (size_t i = 0; i < pointForceList->size(); i++)
+    {
+        state->forceOrigins.push_back(pgd::Vector3(pointForceList->at(i)->point[0], pointForceList->at(i)->point[1], pointForceList->at(i)->point[2]));
+        state->forceVectors.push_back(pgd::Vector3(pointForceList->at(i)->vector[0], pointForceList->at(i)->vector[1], pointForceList->at(i)->vector[2]) * muscle->GetTension());
+    }
+}
+
+void DrawMuscle::setStrapColourFromState(const RenderState::MuscleState &muscleState)
+{
+    Colour colour(m_muscle->GetStrap()->colour1());
+    switch (m_muscle->strapColourControl())
+    {
+    case Muscle::fixedColour:
+        m_strapColor.setRedF(qreal(m_muscle->GetStrap()->colour1().r()));
+        m_strapColor.setGreenF(qreal(m_muscle->GetStrap()->colour1().g()));
+        m_strapColor.setBlueF(qreal(m_muscle->GetStrap()->colour1().b()));
+        m_strapColor.setAlphaF(qreal(m_muscle->GetStrap()->colour1().alpha()));
+        break;
+    case Muscle::activationMap:
+    case Muscle::strainMap:
+    case Muscle::forceMap:
+        Colour::SetColourFromMap(float(muscleState.colourValue), m_strapColourMap, &colour, false);
+        m_strapColor = QColor(QString::fromStdString(colour.GetHexArgb()));
+        break;
+    }
+}
+
+void DrawMuscle::initialise(SimulationWidget *simulationWidget)
+{
+    if (!m_muscle || !m_muscleState) return;
+
+    setStrapColourFromState(*m_muscleState);
+    m_strapCylinderColor.setRedF(qreal(m_muscle->GetStrap()->colour2().r()));
+    m_strapCylinderColor.setGreenF(qreal(m_muscle->GetStrap()->colour2().g()));
+    m_strapCylinderColor.setBlueF(qreal(m_muscle->GetStrap()->colour2().b()));
+    m_strapCylinderColor.setAlphaF(qreal(m_muscle->GetStrap()->colour2().alpha()));
+    m_strapForceColor.setRedF(qreal(m_muscle->colour1().r()));
+    m_strapForceColor.setGreenF(qreal(m_muscle->colour1().g()));
+    m_strapForceColor.setBlueF(qreal(m_muscle->colour1().b()));
+    m_strapForceColor.setAlphaF(qreal(m_muscle->colour1().alpha()));
+
+    m_strapRadius = m_muscle->GetStrap()->size1();
+    m_strapCylinderLength  = m_muscle->GetStrap()->size2();
+    m_strapForceRadius  = m_muscle->size1();
+    m_strapForceScale  = m_muscle->size2();
+
+    if (m_muscleState->path.size())
+    {
+        std::vector<pgd::Vector3> polyline = m_muscleState->path;
+        m_facetedObject1 = std::make_unique<FacetedPolyline>(&polyline, m_strapRadius, m_strapNumSegments, m_strapColor, 1);
+        m_facetedObject1->setSimulationWidget(simulationWidget);
+        m_facetedObjectList.push_back(m_facetedObject1.get());
+    }
+    else if (!dynamic_cast<CylinderWrapStrap *>(m_muscle->GetStrap()))
+    {
         qDebug() << "Error in DrawMuscle::initialise: Unsupported STRAP type";
     }
 
+    if (m_muscleState->hasCylinder)
+    {
+        std::vector<pgd::Vector3> polyline = {m_muscleState->cylinderEnd0, m_muscleState->cylinderEnd1};
+        m_facetedObject2 = std::make_unique<FacetedPolyline>(&polyline, m_muscleState->cylinderRadius, m_strapCylinderSegments, m_strapCylinderColor, 1);
+        m_facetedObject2->setSimulationWidget(simulationWidget);
+        m_facetedObjectList.push_back(m_facetedObject2.get());
+    }
+
     if (m_displayMuscleForces)
     {
-        std::vector<std::unique_ptr<PointForce >> *pointForceList = m_muscle->GetPointForceList();
-        for (size_t i = 0; i < pointForceList->size(); i++)
+        for (size_t i = 0; i < m_muscleState->forceOrigins.size(); i++)
         {
             std::vector<pgd::Vector3> polyline;
             polyline.reserve(2);
-            polyline.clear();
-            pgd::Vector3 f = pgd::Vector3(pointForceList->at(i)->vector[0], pointForceList->at(i)->vector[1], pointForceList->at(i)->vector[2]) * m_muscle->GetTension() * m_strapForceScale;
-            polyline.push_back(pgd::Vector3(pointForceList->at(i)->point[0], pointForceList->at(i)->point[1], pointForceList->at(i)->point[2]));
-            polyline.push_back(pgd::Vector3(pointForceList->at(i)->point[0], pointForceList->at(i)->point[1], pointForceList->at(i)->point[2]) + f);
+            polyline.push_back(m_muscleState->forceOrigins[i]);
+            polyline.push_back(m_muscleState->forceOrigins[i] + m_muscleState->forceVectors[i] * m_strapForceScale);
             std::unique_ptr<FacetedPolyline>facetedPolyline = std::make_unique<FacetedPolyline>(&polyline, m_strapForceRadius, m_strapNumSegments, m_strapForceColor, 1);
             facetedPolyline->setSimulationWidget(simulationWidget);
-            m_facetedObjectForceList.push_back(std::move(facetedPolyline));
             m_facetedObjectList.push_back(facetedPolyline.get());
+            m_facetedObjectForceList.push_back(std::move(facetedPolyline));
         }
     }
 
+    m_drawnState = *m_muscleState;
 //    qDebug() << "DrawMuscle::initialise: finished " << m_muscle->name().c_str();
 
     return;
 }
 
+static bool SamePoints(const std::vector<pgd::Vector3> &points1, const std::vector<pgd::Vector3> &points2)
+{
+    if (points1.size() != points2.size()) return false;
+    for (size_t i = 0; i < points1.size(); i++)
+    {
+        if (points1[i].x != points2[i].x || points1[i].y != points2[i].y || points1[i].z != points2[i].z) return false;
+    }
+    return true;
+}
+
+// bring the existing meshes up to date with a new state
+// the meshes are only regenerated if the geometry has actually moved and the vertex buffers are refilled in place
+// returns false if the number of parts has changed and the whole DrawMuscle needs to be recreated
+bool DrawMuscle::updateEntityState(const RenderState::MuscleState &muscleState)
+{
+    if (muscleState.path.size() != m_drawnState.path.size() ||
+            muscleState.hasCylinder != m_drawnState.hasCylinder ||
+            muscleState.forceOrigins.size() != m_drawnState.forceOrigins.size())
+        return false;
+
+    if (muscleState.colourValue != m_drawnState.colourValue)
+    {
+        setStrapColourFromState(muscleState);
+        if (m_facetedObject1) m_facetedObject1->setBlendColour(m_strapColor, 1);
+    }
+
+    if (m_facetedObject1 && SamePoints(muscleState.path, m_drawnState.path) == false)
+        static_cast<FacetedPolyline *>(m_facetedObject1.get())->Update(&muscleState.path, m_strapRadius, m_strapNumSegments);
+
+    if (m_facetedObject2 && (muscleState.cylinderRadius != m_drawnState.cylinderRadius ||
+                             SamePoints({muscleState.cylinderEnd0, muscleState.cylinderEnd1}, {m_drawnState.cylinderEnd0, m_drawnState.cylinderEnd1}) == false))
+    {
+        std::vector<pgd::Vector3> polyline = {muscleState.cylinderEnd0, muscleState.cylinderEnd1};
+        static_cast<FacetedPolyline *>(m_facetedObject2.get())->Update(&polyline, muscleState.cylinderRadius, m_strapCylinderSegments);
+    }
+
+    if (m_facetedObjectForceList.size() && (SamePoints(muscleState.forceOrigins, m_drawnState.forceOrigins) == false ||
+                                            SamePoints(muscleState.forceVectors, m_drawnState.forceVectors) == false))
+    {
+        std::vector<pgd::Vector3> polyline(2);
+        for (size_t i = 0; i < m_facetedObjectForceList.size(); i++)
+        {
+            polyline[0] = muscleState.forceOrigins[i];
+            polyline[1] = muscleState.forceOrigins[i] + muscleState.forceVectors[i] * m_strapForceScale;
+            static_cast<FacetedPolyline *>(m_facetedObjectForceList[i].get())->Update(&polyline, m_strapForceRadius, m_strapNumSegments);
+        }
+    }
+
+    m_drawnState = muscleState;
+    return true;
+}
+
 void DrawMuscle::Draw()
 {
     if (m_facetedObject1.get()) m_facetedObject1->Draw();
@@ -11,6 +11,7 @@
 #define DRAWMUSCLE_H
 
 #include "Drawable.h"
+#include "RenderState.h"
 
 #include "Colour.h"
 
@@ -35,6 +36,12 @@ public:
     Muscle *muscle() const;
     void setMuscle(Muscle *muscle);
 
+    const RenderState::MuscleState *muscleState() const;
+    void setMuscleState(const RenderState::MuscleState *muscleState);
+
+    static void CaptureState(Muscle *muscle, RenderState::MuscleState *state);
+    bool updateEntityState(const RenderState::MuscleState &muscleState);
+
     double strapRadius() const;
     void setStrapRadius(double strapRadius);
 
@@ -67,7 +74,11 @@ public:
     void setStrapColourMap(const Colour::ColourMap &strapColourMap);
 
 private:
+    void setStrapColourFromState(const RenderState::MuscleState &muscleState);
+
     Muscle *m_muscle = nullptr;
+    const RenderState::MuscleState *m_muscleState = nullptr;
+    RenderState::MuscleState m_drawnState;
 
     std::unique_ptr<FacetedObject> m_facetedObject1;
     std::unique_ptr<FacetedObject> m_facetedObject2;
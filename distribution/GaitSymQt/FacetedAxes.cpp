@@ -62,4 +62,7 @@ FacetedAxes::FacetedAxes()
     cone3.Rotate(1, 0, 0, 0);
     cone3.Move(0, 0, (1 - heightCone));
     AddFacetedObject(&cone3, useDisplayRotation, useDirectAccess);
+
+    // all axes are the same and are sized with the display scale
+    setInstanceKey("FacetedAxes");
 }
@@ -8,6 +8,9 @@
  */
 
 #include "FacetedCappedCylinder.h"
+#include "GSUtil.h"
+
+using namespace std::literals::string_literals;
 
 // draw a capped cylinder of length l and radius r, aligned along the x axis
 
@@ -123,6 +126,9 @@ FacetedCappedCylinder::FacetedCappedCylinder(double l, double r, size_t capped_c
         start_ny = start_ny2;
     }
 
+    // l has been halved above
+    setInstanceKey("FacetedCappedCylinder "s + GSUtil::ToString(l) + " "s + GSUtil::ToString(r) + " "s + GSUtil::ToString(uint64_t(capped_cylinder_quality)));
+
 //    qDebug() << "FacetedCappedCylinder " << GetNumTriangles() << " triangles created\n";
 }
 
@@ -43,6 +43,9 @@
 #include <sstream>
 #include <cstdlib>
 #include <regex>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
 
 using namespace std::literals::string_literals;
 
@@ -83,8 +86,10 @@ int FacetedObject::ParseOBJFile(const std::string &filename)
         m_upperBound[0] = meshStoreObject->upperBound[0];
         m_upperBound[1] = meshStoreObject->upperBound[1];
         m_upperBound[2] = meshStoreObject->upperBound[2];
+        m_bvh = meshStoreObject->bvh;
         return 0;
     }
+    if (ReadMeshCache(filename)) return 0;
 
     // read the whole file into memory
     DataFile theFile;
@@ -119,6 +124,7 @@ int FacetedObject::ParseOBJFile(const std::string &filename)
 
     std::map<std::string, OBJMaterial> materialMap;
     OBJMaterial *currentMaterial = nullptr;
+    std::vector<std::string> cacheDependencies = {filename};
     std::string line;
     line.reserve(1024);
     while (ptr < endPtr)
@@ -152,6 +158,7 @@ int FacetedObject::ParseOBJFile(const std::string &filename)
             if (pystring::startswith(line, "mtllib "s))
             {
                 std::string materialsFile = pystring::os::path::join(pystring::os::path::dirname(filename), line.substr("mtllib "s.size(), std::string::npos));
+                cacheDependencies.push_back(materialsFile); // if it is missing the mesh is not cached so it is picked up when it appears
                 if (ParseOBJMaterialFile(materialsFile, &materialMap))
                 {
                     qDebug() << "Error reading material file \"" << materialsFile.c_str() << "\"";
@@ -465,7 +472,9 @@ int FacetedObject::ParseOBJFile(const std::string &filename)
     }
 
     m_meshStore.setTargetMemory(Preferences::valueDouble("MeshStoreMemoryFraction"));
-    m_meshStore.addMesh(filename, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+    MeshStoreObject *storedMesh = m_meshStore.addMesh(filename, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+    m_bvh = storedMesh ? storedMesh->bvh : nullptr;
+    if (Preferences::valueBool("MeshDiskCache")) MeshStore::writeCacheFile(cacheDependencies, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
 
     return 0;
 }
@@ -585,8 +594,10 @@ int FacetedObject::ParsePLYFile(const std::string &filename)
         m_upperBound[0] = meshStoreObject->upperBound[0];
         m_upperBound[1] = meshStoreObject->upperBound[1];
         m_upperBound[2] = meshStoreObject->upperBound[2];
+        m_bvh = meshStoreObject->bvh;
         return 0;
     }
+    if (ReadMeshCache(filename)) return 0;
     try
     {
 #if (defined(_WIN32) || defined(WIN32)) && !defined(__MINGW32__)
@@ -724,7 +735,9 @@ int FacetedObject::ParsePLYFile(const std::string &filename)
         }
 
         m_meshStore.setTargetMemory(Preferences::valueDouble("MeshStoreMemoryFraction"));
-        m_meshStore.addMesh(filename, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+        MeshStoreObject *storedMesh = m_meshStore.addMesh(filename, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+        m_bvh = storedMesh ? storedMesh->bvh : nullptr;
+        if (Preferences::valueBool("MeshDiskCache")) MeshStore::writeCacheFile({filename}, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
     }
     catch (const std::exception &e)
     {
@@ -734,6 +747,25 @@ int FacetedObject::ParsePLYFile(const std::string &filename)
     return 0;
 }
 
+// load a previously parsed mesh file from the disk cache
+// returns true on success
+bool FacetedObject::ReadMeshCache(const std::string &filename)
+{
+    if (!Preferences::valueBool("MeshDiskCache")) return false;
+    MeshStoreObject meshStoreObject;
+    if (!MeshStore::readCacheFile(filename, &meshStoreObject)) return false;
+    m_meshStore.setTargetMemory(Preferences::valueDouble("MeshStoreMemoryFraction"));
+    MeshStoreObject *storedMesh = m_meshStore.addMesh(meshStoreObject);
+    m_bvh = storedMesh ? storedMesh->bvh : nullptr;
+    m_vertexList = std::move(meshStoreObject.vertexList);
+    m_normalList = std::move(meshStoreObject.normalList);
+    m_colourList = std::move(meshStoreObject.colourList);
+    m_uvList = std::move(meshStoreObject.uvList);
+    std::copy_n(meshStoreObject.lowerBound, 3, m_lowerBound);
+    std::copy_n(meshStoreObject.upperBound, 3, m_upperBound);
+    return true;
+}
+
 int FacetedObject::ReadFromMemory(const char *data, size_t len, bool binary, const std::string &meshName)
 {
     m_filename = meshName;
@@ -750,6 +782,7 @@ int FacetedObject::ReadFromMemory(const char *data, size_t len, bool binary, con
         m_upperBound[0] = meshStoreObject->upperBound[0];
         m_upperBound[1] = meshStoreObject->upperBound[1];
         m_upperBound[2] = meshStoreObject->upperBound[2];
+        m_bvh = meshStoreObject->bvh;
         return 0;
     }
 
@@ -824,7 +857,8 @@ int FacetedObject::ReadFromMemory(const char *data, size_t len, bool binary, con
         for (size_t i = 0; i < numTriangles * 6; i++) m_uvList.push_back(std::strtod(endPtr, &endPtr));
     }
     m_meshStore.setTargetMemory(Preferences::valueDouble("MeshStoreMemoryFraction"));
-    m_meshStore.addMesh(meshName, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+    MeshStoreObject *storedMesh = m_meshStore.addMesh(meshName, m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+    m_bvh = storedMesh ? storedMesh->bvh : nullptr;
     return 0;
 }
 
@@ -909,6 +943,8 @@ int FacetedObject::ReadFromResource(const QString &resourceName)
         m_upperBound[0] = meshStoreObject->upperBound[0];
         m_upperBound[1] = meshStoreObject->upperBound[1];
         m_upperBound[2] = meshStoreObject->upperBound[2];
+        m_bvh = meshStoreObject->bvh;
+        m_instanceKey = m_filename;
         return 0;
     }
 
@@ -947,77 +983,127 @@ int FacetedObject::ReadFromResource(const QString &resourceName)
         m_uvList.push_back(0); m_uvList.push_back(0);
     }
     m_meshStore.setTargetMemory(Preferences::valueDouble("MeshStoreMemoryFraction"));
-    m_meshStore.addMesh(resourceName.toStdString(), m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+    MeshStoreObject *storedMesh = m_meshStore.addMesh(resourceName.toStdString(), m_vertexList, m_normalList, m_colourList, m_uvList, m_lowerBound, m_upperBound);
+    m_bvh = storedMesh ? storedMesh->bvh : nullptr;
+    m_instanceKey = m_filename;
     return 0;
 }
 
 void FacetedObject::Draw()
 {
+    if (m_visible == false) return;
+    // identical meshes are collected by the widget and drawn together
+    if (m_instanceKey.size() && m_texture == nullptr && m_simulationWidget->queueInstance(this)) return;
+
     QOpenGLFunctions_3_3_Core *f = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_3_Core>();
+    if (m_VBOAllocated == false || m_VBOStale) UploadVertexBuffer();
 
-    if (m_VBOAllocated == false)
+    // select the rendering program
+    QOpenGLShaderProgram *shader = m_simulationWidget->facetedObjectShader();
+    shader->bind();
+    EnableVertexAttributes(shader);
+
+    // set the uniforms
+    QMatrix4x4 model = this->model(); // thios recalculates the model matrix
+    QMatrix4x4 modelView = m_simulationWidget->view() * model;
+    shader->setUniformValue("mvMatrix", modelView);
+    QMatrix4x4 modelViewProjection = m_simulationWidget->proj() * modelView;
+    shader->setUniformValue("mvpMatrix", modelViewProjection);
+    QMatrix3x3 normalMatrix = modelView.normalMatrix();
+    shader->setUniformValue("normalMatrix", normalMatrix);
+    SetMaterialUniforms(shader);
+
+    if (m_texture)
     {
-        m_VBOAllocated = true;
-        // order vertex data as x, y, z, xn, yn, zn, r, g, b, u, v
-        size_t vertBufSize = m_vertexList.size() + m_normalList.size() + m_colourList.size()  + m_uvList.size();
-        std::unique_ptr<GLfloat []> vertBuf = std::make_unique<GLfloat []>(vertBufSize);
-        GLfloat *vertBufPtr = vertBuf.get();
-        double *vertexListPtr = m_vertexList.data();
-        double *normalListPtr = m_normalList.data();
-        double *colourListPtr = m_colourList.data();
-        double *uvListPtr = m_uvList.data();
-        for (size_t i = 0; i < m_vertexList.size() / 3; i++)
-        {
-            *vertBufPtr++ = GLfloat(*vertexListPtr++);
-            *vertBufPtr++ = GLfloat(*vertexListPtr++);
-            *vertBufPtr++ = GLfloat(*vertexListPtr++);
-            *vertBufPtr++ = GLfloat(*normalListPtr++);
-            *vertBufPtr++ = GLfloat(*normalListPtr++);
-            *vertBufPtr++ = GLfloat(*normalListPtr++);
-            *vertBufPtr++ = GLfloat(*colourListPtr++);
-            *vertBufPtr++ = GLfloat(*colourListPtr++);
-            *vertBufPtr++ = GLfloat(*colourListPtr++);
-            *vertBufPtr++ = GLfloat(*uvListPtr++);
-            *vertBufPtr++ = GLfloat(*uvListPtr++);
-        }
-
-        // Setup our vertex buffer object.
-        m_VBO.create();
-        m_VBO.bind();
-        m_VBO.allocate(vertBuf.get(), int(vertBufSize * sizeof(GLfloat)));
+        f->glActiveTexture(GL_TEXTURE0);
+        shader->setUniformValue("textureSampler", 0);
+        shader->setUniformValue("hasTexture", true);
+        m_texture->bind();
+        DrawTriangles(f, 1);
+        m_texture->release();
+    }
+    else
+    {
+        shader->setUniformValue("hasTexture", false);
+        DrawTriangles(f, 1);
     }
-    if (m_visible == false) return;
 
-    // select the rendering program
-    m_simulationWidget->facetedObjectShader()->bind();
+    DisableVertexAttributes(shader);
+    shader->release();
+}
+
+// draw this mesh once for every object in the list using their model matrices
+// the objects must all have the same geometry as this one, which is what the instance key guarantees
+void FacetedObject::DrawInstances(const std::vector<FacetedObject *> &instances, QOpenGLBuffer *instanceBuffer)
+{
+    QOpenGLFunctions_3_3_Core *f = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_3_Core>();
+    if (m_VBOAllocated == false || m_VBOStale) UploadVertexBuffer();
+
+    // QMatrix4x4 is stored column major which is what the shader wants
+    std::vector<GLfloat> modelMatrices(instances.size() * 16);
+    for (size_t i = 0; i < instances.size(); i++) std::copy_n(instances[i]->model().constData(), 16, &modelMatrices[i * 16]);
+
+    QOpenGLShaderProgram *shader = m_simulationWidget->facetedObjectInstancedShader();
+    shader->bind();
+    EnableVertexAttributes(shader);
+
+    instanceBuffer->bind();
+    instanceBuffer->allocate(modelMatrices.data(), int(modelMatrices.size() * sizeof(GLfloat)));
+    int instanceModelLocation = shader->attributeLocation("instanceModel");
+    for (int column = 0; column < 4; column++)
+    {
+        shader->enableAttributeArray(instanceModelLocation + column);
+        shader->setAttributeBuffer(instanceModelLocation + column, GL_FLOAT, column * 4 * int(sizeof(GLfloat)), 4, 16 * sizeof(GLfloat));
+        f->glVertexAttribDivisor(GLuint(instanceModelLocation + column), 1);
+    }
+    instanceBuffer->release();
+
+    shader->setUniformValue("viewMatrix", m_simulationWidget->view());
+    shader->setUniformValue("projMatrix", m_simulationWidget->proj());
+    SetMaterialUniforms(shader);
+    shader->setUniformValue("hasTexture", false);
+    DrawTriangles(f, GLsizei(instances.size()));
+
+    // the divisors are part of the vertex array object state so they need to be put back
+    for (int column = 0; column < 4; column++)
+    {
+        f->glVertexAttribDivisor(GLuint(instanceModelLocation + column), 0);
+        shader->disableAttributeArray(instanceModelLocation + column);
+    }
+    DisableVertexAttributes(shader);
+    shader->release();
+}
 
+void FacetedObject::EnableVertexAttributes(QOpenGLShaderProgram *shader)
+{
     // select the vertex attribute bindings for the program.
     m_VBO.bind();
     int stride = 11 * sizeof(GLfloat);
     int offset = 0;
-    m_simulationWidget->facetedObjectShader()->enableAttributeArray("vertex");
-    m_simulationWidget->facetedObjectShader()->setAttributeBuffer("vertex", GL_FLOAT, offset, 3, stride);
+    shader->enableAttributeArray("vertex");
+    shader->setAttributeBuffer("vertex", GL_FLOAT, offset, 3, stride);
     offset += 3 * sizeof(GLfloat);
-    m_simulationWidget->facetedObjectShader()->enableAttributeArray("vertexNormal");
-    m_simulationWidget->facetedObjectShader()->setAttributeBuffer("vertexNormal", GL_FLOAT, offset, 3, stride);
+    shader->enableAttributeArray("vertexNormal");
+    shader->setAttributeBuffer("vertexNormal", GL_FLOAT, offset, 3, stride);
     offset += 3 * sizeof(GLfloat);
-    m_simulationWidget->facetedObjectShader()->enableAttributeArray("vertexColour");
-    m_simulationWidget->facetedObjectShader()->setAttributeBuffer("vertexColour", GL_FLOAT, offset, 3, stride);
+    shader->enableAttributeArray("vertexColour");
+    shader->setAttributeBuffer("vertexColour", GL_FLOAT, offset, 3, stride);
     offset += 3 * sizeof(GLfloat);
-    m_simulationWidget->facetedObjectShader()->enableAttributeArray("vertexUV");
-    m_simulationWidget->facetedObjectShader()->setAttributeBuffer("vertexUV", GL_FLOAT, offset, 2, stride);
-
+    shader->enableAttributeArray("vertexUV");
+    shader->setAttributeBuffer("vertexUV", GL_FLOAT, offset, 2, stride);
     m_VBO.release();
+}
 
-    // set the uniforms
-    QMatrix4x4 model = this->model(); // thios recalculates the model matrix
-    QMatrix4x4 modelView = m_simulationWidget->view() * model;
-    m_simulationWidget->facetedObjectShader()->setUniformValue("mvMatrix", modelView);
-    QMatrix4x4 modelViewProjection = m_simulationWidget->proj() * modelView;
-    m_simulationWidget->facetedObjectShader()->setUniformValue("mvpMatrix", modelViewProjection);
-    QMatrix3x3 normalMatrix = modelView.normalMatrix();
-    m_simulationWidget->facetedObjectShader()->setUniformValue("normalMatrix", normalMatrix);
+void FacetedObject::DisableVertexAttributes(QOpenGLShaderProgram *shader)
+{
+    shader->disableAttributeArray("vertex");
+    shader->disableAttributeArray("vertexNormal");
+    shader->disableAttributeArray("vertexColour");
+    shader->disableAttributeArray("vertexUV");
+}
 
+void FacetedObject::SetMaterialUniforms(QOpenGLShaderProgram *shader)
+{
     GLfloat r = GLfloat(m_blendColour.redF());
     GLfloat g = GLfloat(m_blendColour.greenF());
     GLfloat b = GLfloat(m_blendColour.blueF());
@@ -1031,36 +1117,168 @@ void FacetedObject::Draw()
     QVector4D diffuse(diffuseProportion, diffuseProportion, diffuseProportion, alpha);
     QVector4D specular(specularProportion, specularProportion, specularProportion, alpha);
     QVector4D blendColour(r, g, b, alpha);
-    m_simulationWidget->facetedObjectShader()->setUniformValue("ambient", ambient);
-    m_simulationWidget->facetedObjectShader()->setUniformValue("diffuse", diffuse);
-    m_simulationWidget->facetedObjectShader()->setUniformValue("specular", specular);
-    m_simulationWidget->facetedObjectShader()->setUniformValue("shininess", specularPower);
-    m_simulationWidget->facetedObjectShader()->setUniformValue("blendColour", blendColour);
-    m_simulationWidget->facetedObjectShader()->setUniformValue("blendFraction", blendFraction);
+    shader->setUniformValue("ambient", ambient);
+    shader->setUniformValue("diffuse", diffuse);
+    shader->setUniformValue("specular", specular);
+    shader->setUniformValue("shininess", specularPower);
+    shader->setUniformValue("blendColour", blendColour);
+    shader->setUniformValue("blendFraction", blendFraction);
     // decal is set to avoid z-fighting for decals (0 is normal, 1 and higher will be put in front)
-    m_simulationWidget->facetedObjectShader()->setUniformValue("decal", GLfloat(m_decal));
+    shader->setUniformValue("decal", GLfloat(m_decal));
+}
 
-    if (m_texture)
+void FacetedObject::DrawTriangles(QOpenGLFunctions_3_3_Core *f, GLsizei instanceCount)
+{
+    if (m_indexed)
     {
-        f->glActiveTexture(GL_TEXTURE0);
-        m_simulationWidget->facetedObjectShader()->setUniformValue("textureSampler", 0);
-        m_simulationWidget->facetedObjectShader()->setUniformValue("hasTexture", true);
-        m_texture->bind();
-        f->glDrawArrays(GL_TRIANGLES, 0, GLsizei(m_vertexList.size() / 3));
-        m_texture->release();
+        m_IBO.bind();
+        if (instanceCount == 1) f->glDrawElements(GL_TRIANGLES, GLsizei(m_numIndices), GL_UNSIGNED_INT, nullptr);
+        else f->glDrawElementsInstanced(GL_TRIANGLES, GLsizei(m_numIndices), GL_UNSIGNED_INT, nullptr, instanceCount);
+        m_IBO.release();
+    }
+    else
+    {
+        if (instanceCount == 1) f->glDrawArrays(GL_TRIANGLES, 0, GLsizei(m_vertexList.size() / 3));
+        else f->glDrawArraysInstanced(GL_TRIANGLES, 0, GLsizei(m_vertexList.size() / 3), instanceCount);
+    }
+}
+
+// key for finding identical interleaved vertices
+struct InterleavedVertex
+{
+    GLfloat data[11];
+    bool operator==(const InterleavedVertex &other) const { return std::memcmp(data, other.data, sizeof(data)) == 0; }
+};
+struct InterleavedVertexHash
+{
+    size_t operator()(const InterleavedVertex &vertex) const
+    {
+        // FNV-1a over the raw bytes
+        const unsigned char *p = reinterpret_cast<const unsigned char *>(vertex.data);
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < sizeof(vertex.data); i++) { hash ^= p[i]; hash *= 1099511628211ULL; }
+        return size_t(hash);
+    }
+};
+
+// fill the vertex buffer object from the double precision lists
+// the first upload goes through UploadIndexedVertexBuffer since most meshes share vertices between triangles
+// after that the geometry is being regenerated so the buffer is written unindexed and only reallocated when it grows
+void FacetedObject::UploadVertexBuffer()
+{
+    if (m_VBOAllocated == false)
+    {
+        UploadIndexedVertexBuffer();
+        return;
+    }
+    if (m_indexed)
+    {
+        m_IBO.destroy();
+        m_indexed = false;
+        m_numIndices = 0;
+    }
+
+    // order vertex data as x, y, z, xn, yn, zn, r, g, b, u, v
+    size_t numVertices = m_vertexList.size() / 3;
+    int vertBufBytes = int(numVertices * 11 * sizeof(GLfloat));
+    m_VBO.bind();
+    if (vertBufBytes > m_VBOAllocatedBytes)
+    {
+        // anything that is being updated will probably be updated again
+        m_VBO.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+        m_VBO.allocate(vertBufBytes);
+        m_VBOAllocatedBytes = vertBufBytes;
+    }
+    m_VBOStale = false;
+    if (vertBufBytes == 0)
+    {
+        m_VBO.release();
+        return;
+    }
+
+    // write straight into the mapped buffer if possible
+    std::unique_ptr<GLfloat []> vertBuf;
+    GLfloat *vertBufPtr = static_cast<GLfloat *>(m_VBO.mapRange(0, vertBufBytes, QOpenGLBuffer::RangeWrite | QOpenGLBuffer::RangeInvalidateBuffer));
+    if (vertBufPtr == nullptr)
+    {
+        vertBuf = std::make_unique<GLfloat []>(numVertices * 11);
+        vertBufPtr = vertBuf.get();
+    }
+    InterleaveVertices(0, numVertices, vertBufPtr);
+    if (vertBuf) m_VBO.write(0, vertBuf.get(), vertBufBytes);
+    else m_VBO.unmap();
+    m_VBO.release();
+}
+
+// the static upload removes duplicate vertices and adds an index buffer
+// the triangle lists store every corner separately so a closed mesh typically shrinks to about a sixth of its vertices
+void FacetedObject::UploadIndexedVertexBuffer()
+{
+    size_t numVertices = m_vertexList.size() / 3;
+    std::vector<InterleavedVertex> interleaved(numVertices);
+    if (numVertices) InterleaveVertices(0, numVertices, interleaved[0].data);
+
+    std::unordered_map<InterleavedVertex, GLuint, InterleavedVertexHash> uniqueMap;
+    uniqueMap.reserve(numVertices);
+    std::vector<GLuint> indices;
+    indices.reserve(numVertices);
+    size_t numUnique = 0;
+    for (size_t i = 0; i < numVertices; i++)
+    {
+        auto inserted = uniqueMap.insert(std::make_pair(interleaved[i], GLuint(numUnique)));
+        if (inserted.second) interleaved[numUnique++] = interleaved[i];
+        indices.push_back(inserted.first->second);
+    }
+
+    // only worth the indirection if it saves something
+    if (numUnique * sizeof(InterleavedVertex) + indices.size() * sizeof(GLuint) < numVertices * sizeof(InterleavedVertex))
+    {
+        interleaved.resize(numUnique);
+        m_IBO.create();
+        m_IBO.bind();
+        m_IBO.allocate(indices.data(), int(indices.size() * sizeof(GLuint)));
+        m_IBO.release();
+        m_numIndices = indices.size();
+        m_indexed = true;
     }
     else
     {
-        m_simulationWidget->facetedObjectShader()->setUniformValue("hasTexture", false);
-        f->glDrawArrays(GL_TRIANGLES, 0, GLsizei(m_vertexList.size() / 3));
+        // put the original vertex order back (indices[i] <= i so working backwards never overwrites a value still needed)
+        for (size_t i = numVertices; i > 0; i--) interleaved[i - 1] = interleaved[indices[i - 1]];
     }
 
-    m_simulationWidget->facetedObjectShader()->disableAttributeArray("vertex");
-    m_simulationWidget->facetedObjectShader()->disableAttributeArray("vertexNormal");
-    m_simulationWidget->facetedObjectShader()->disableAttributeArray("vertexColour");
-    m_simulationWidget->facetedObjectShader()->disableAttributeArray("vertexUV");
+    int vertBufBytes = int(interleaved.size() * sizeof(InterleavedVertex));
+    m_VBO.create();
+    m_VBO.bind();
+    m_VBO.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    m_VBO.allocate(interleaved.data(), vertBufBytes);
+    m_VBO.release();
+    m_VBOAllocatedBytes = vertBufBytes;
+    m_VBOAllocated = true;
+    m_VBOStale = false;
+}
 
-    m_simulationWidget->facetedObjectShader()->release();
+// convert vertices from the double precision lists to the interleaved float layout
+void FacetedObject::InterleaveVertices(size_t first, size_t count, GLfloat *vertBufPtr) const
+{
+    const double *vertexListPtr = m_vertexList.data() + first * 3;
+    const double *normalListPtr = m_normalList.data() + first * 3;
+    const double *colourListPtr = m_colourList.data() + first * 3;
+    const double *uvListPtr = m_uvList.data() + first * 2;
+    for (size_t i = 0; i < count; i++)
+    {
+        *vertBufPtr++ = GLfloat(*vertexListPtr++);
+        *vertBufPtr++ = GLfloat(*vertexListPtr++);
+        *vertBufPtr++ = GLfloat(*vertexListPtr++);
+        *vertBufPtr++ = GLfloat(*normalListPtr++);
+        *vertBufPtr++ = GLfloat(*normalListPtr++);
+        *vertBufPtr++ = GLfloat(*normalListPtr++);
+        *vertBufPtr++ = GLfloat(*colourListPtr++);
+        *vertBufPtr++ = GLfloat(*colourListPtr++);
+        *vertBufPtr++ = GLfloat(*colourListPtr++);
+        *vertBufPtr++ = GLfloat(*uvListPtr++);
+        *vertBufPtr++ = GLfloat(*uvListPtr++);
+    }
 }
 
 // Write a FacetedObject out as a POVRay file
@@ -1315,6 +1533,7 @@ void FacetedObject::ComputeFaceNormal(const double *v1, const double *v2, const
 void FacetedObject::Move(double x, double y, double z)
 {
     if (x == 0.0 && y == 0.0 && z == 0.0) return;
+    GeometryChanged();
     for (size_t i = 0; i < m_vertexList.size() / 3; i++)
     {
         m_vertexList[i * 3] += x;
@@ -1334,6 +1553,7 @@ void FacetedObject::Move(double x, double y, double z)
 void FacetedObject::Scale(double x, double y, double z)
 {
     if (x == 1.0 && y == 1.0 && z == 1.0) return;
+    GeometryChanged();
     for (size_t i = 0; i < m_vertexList.size() / 3; i++)
     {
         m_vertexList[i * 3] *= x;
@@ -1354,6 +1574,7 @@ void FacetedObject::Rotate(double x, double y, double z, double angleDegrees)
 {
     Q_ASSERT_X(x != 0 || y != 0 || z != 0, "Axis must be non-zero", "FacetedObject::Rotate");
     if (angleDegrees == 0) return;
+    GeometryChanged();
     pgd::Quaternion q = pgd::MakeQFromAxisAngle(x, y, z, pgd::DegreesToRadians(angleDegrees));
     pgd::Vector3 v;
     for (size_t i = 0; i < m_vertexList.size() / 3; i++)
@@ -1510,6 +1731,7 @@ void FacetedObject::AddPolygon(const double *vertices, size_t nSides, const doub
 void FacetedObject::AddTriangle(const double *vertices, const double *normals, const double *UVs)
 {
     Q_ASSERT_X(m_vertexList.capacity() - m_vertexList.size() >= 9, "FacetedObject::AddTriangle", "Warning: not enough triangle space reserved");
+    GeometryChanged();
     pgd::Vector3 vertex;
     for (size_t i = 0; i < 3; i++)
     {
@@ -1647,6 +1869,23 @@ void FacetedObject::AllocateMemory(size_t numTriangles)
     m_uvList.reserve(numTriangles * 6);
 }
 
+// empty the geometry but keep the memory so that it can be refilled
+// the vertex buffer object is refreshed at the next draw
+void FacetedObject::ClearGeometry()
+{
+    m_vertexList.clear();
+    m_normalList.clear();
+    m_colourList.clear();
+    m_uvList.clear();
+    for (size_t i = 0; i < 3; i++)
+    {
+        m_lowerBound[i] = DBL_MAX;
+        m_upperBound[i] = -DBL_MAX;
+    }
+    m_VBOStale = true;
+    GeometryChanged();
+}
+
 // return an ODE style trimesh
 // note memory is allocated by this routine and will need to be released elsewhere
 // warning - this routine will not cope with very big meshes because it uses ints
@@ -1956,6 +2195,7 @@ void FacetedObject::CalculateMassProperties(dMass *m, double density, bool clock
 // reverse the face winding
 void FacetedObject::ReverseWinding()
 {
+    GeometryChanged();
     double t;
     size_t numTriangles = (m_vertexList.size() / 3) / 3;
     size_t i, j;
@@ -1976,6 +2216,7 @@ void FacetedObject::ReverseWinding()
 // there is probably no good reason currently not to use useDirectAccess
 void FacetedObject::AddFacetedObject(const FacetedObject *object, bool useDisplayRotation, bool useDirectAccess)
 {
+    GeometryChanged();
     if (useDirectAccess)
     {
         size_t offset = m_vertexList.size();
@@ -2193,6 +2434,7 @@ bool FacetedObject::HitBoundingBox(const double minB[HITBOUNDINBOX_NUMDIM], cons
 }
 
 // this routine works in model coordinates and rayVector must be unit length
+// the hits are returned nearest first
 int FacetedObject::FindIntersection(const pgd::Vector3 &rayOrigin, const pgd::Vector3 &rayVector, std::vector<pgd::Vector3> *intersectionCoordList, std::vector<size_t> *intersectionIndexList) const
 {
     if (!m_visible || !m_vertexList.size()) return 0;
@@ -2202,38 +2444,40 @@ int FacetedObject::FindIntersection(const pgd::Vector3 &rayOrigin, const pgd::Ve
     bool bbHit = HitBoundingBox(m_lowerBound, m_upperBound, rayOrigin.constData(), rayVector.constData(), coord);
     if (!bbHit) return 0;
 
-    // now loop through the triangles
-    bool triHit;
-    int hitCount = 0;
+    // then only test the triangles in the boxes that the ray passes through
+    if (!m_bvh) m_bvh = std::make_shared<TriangleBVH>();
+    if (!m_bvh->built()) m_bvh->Build(m_vertexList.data(), m_vertexList.size() / 9);
+    struct Hit
+    {
+        double distance;
+        size_t index;
+        pgd::Vector3 location;
+    };
+    std::vector<Hit> hits;
     pgd::Vector3 outIntersectionPoint;
-    for (size_t i = 0; i < m_vertexList.size(); i += 9)
+    m_bvh->Traverse(rayOrigin.constData(), rayVector.constData(), [&](size_t triangle)
     {
-#ifdef PRECHECK_BOUNDINGBOX
-        double lowerBound[3] = {std::min({mVertexList[i], mVertexList[i + 3], mVertexList[i + 6]}), std::min({mVertexList[i + 1], mVertexList[i + 4], mVertexList[i + 7]}), std::min({mVertexList[i + 2], mVertexList[i + 5], mVertexList[i + 8]})};
-        double upperBound[3] = {std::max({mVertexList[i], mVertexList[i + 3], mVertexList[i + 6]}), std::max({mVertexList[i + 1], mVertexList[i + 4], mVertexList[i + 7]}), std::max({mVertexList[i + 2], mVertexList[i + 5], mVertexList[i + 8]})};
-        bbHit = HitBoundingBox(lowerBound, upperBound, rayOrigin.constData(), rayVector.constData(), coord);
-        if (bbHit)
-        {
-            triHit = RayIntersectsTriangle(rayOrigin, rayVectorNorm, &mVertexList[i], &mVertexList[i + 3], &mVertexList[i + 6], &outIntersectionPoint);
-            if (triHit)
-            {
-                hitCount++;;
-                if (intersectionCoordList) intersectionCoordList->push_back(outIntersectionPoint);
-                if (intersectionIndexList) intersectionIndexList->push_back(i);
-            }
-        }
-#else
-        triHit = RayIntersectsTriangle(rayOrigin, rayVector, &m_vertexList[i], &m_vertexList[i + 3], &m_vertexList[i + 6], &outIntersectionPoint);
-        if (triHit)
-        {
-            hitCount++;
-            if (intersectionCoordList) intersectionCoordList->push_back(outIntersectionPoint);
-            if (intersectionIndexList) intersectionIndexList->push_back(i);
-        }
-#endif
+        size_t i = triangle * 9;
+        if (RayIntersectsTriangle(rayOrigin, rayVector, &m_vertexList[i], &m_vertexList[i + 3], &m_vertexList[i + 6], &outIntersectionPoint))
+            hits.push_back({(outIntersectionPoint - rayOrigin).Dot(rayVector), i, outIntersectionPoint});
+        return true;
+    });
 
+    // the traversal is roughly near to far but the boxes overlap so the order needs fixing
+    std::sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) { return a.distance < b.distance; });
+    for (auto &&hit : hits)
+    {
+        if (intersectionCoordList) intersectionCoordList->push_back(hit.location);
+        if (intersectionIndexList) intersectionIndexList->push_back(hit.index);
     }
-    return hitCount;
+    return int(hits.size());
+}
+
+// called whenever the vertex list is altered so that nothing derived from the old geometry is used
+void FacetedObject::GeometryChanged()
+{
+    m_instanceKey.clear();
+    m_bvh.reset();
 }
 
 void FacetedObject::ApplyDisplayTransformation(const pgd::Vector3 inVec, pgd::Vector3 *outVec)
@@ -2281,6 +2525,7 @@ void FacetedObject::SetDisplayRotationFromQuaternion(const dQuaternion q)
 void FacetedObject::ClearMeshStore()
 {
     m_meshStore.clear();
+    MeshStore::clearCacheFiles();
 }
 
 bool FacetedObject::visible() const
@@ -2344,6 +2589,16 @@ std::string FacetedObject::filename() const
     return m_filename;
 }
 
+std::string FacetedObject::instanceKey() const
+{
+    return m_instanceKey;
+}
+
+void FacetedObject::setInstanceKey(const std::string &instanceKey)
+{
+    m_instanceKey = instanceKey;
+}
+
 QColor FacetedObject::blendColour() const
 {
     return m_blendColour;
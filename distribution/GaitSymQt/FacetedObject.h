@@ -24,6 +24,8 @@ class SimulationWidget;
 class DataFile;
 class TrimeshGeom;
 class QOpenGLTexture;
+class QOpenGLShaderProgram;
+class QOpenGLFunctions_3_3_Core;
 
 class FacetedObject
 {
@@ -50,6 +52,7 @@ public:
     };
 
     virtual void Draw();
+    void DrawInstances(const std::vector<FacetedObject *> &instances, QOpenGLBuffer *instanceBuffer);
 
     int ParseMeshFile(const std::string &filename);
     int ParseOBJFile(const std::string &filename);
@@ -98,6 +101,7 @@ public:
     // utility
     void ReverseWinding();
     void AllocateMemory(size_t numTriangles);
+    void ClearGeometry();
     void ApplyDisplayTransformation(const pgd::Vector3 inVec, pgd::Vector3 *outVec);
     void ApplyDisplayRotation(const pgd::Vector3 inVec, pgd::Vector3 *outVec);
 
@@ -140,7 +144,20 @@ public:
 
     std::string filename() const;
 
+    // objects with the same non-empty instance key have identical geometry and can be drawn in a single call
+    std::string instanceKey() const;
+    void setInstanceKey(const std::string &instanceKey);
+
 private:
+    void GeometryChanged();
+    bool ReadMeshCache(const std::string &filename);
+    void UploadVertexBuffer();
+    void UploadIndexedVertexBuffer();
+    void InterleaveVertices(size_t first, size_t count, GLfloat *vertBufPtr) const;
+    void EnableVertexAttributes(QOpenGLShaderProgram *shader);
+    void DisableVertexAttributes(QOpenGLShaderProgram *shader);
+    void SetMaterialUniforms(QOpenGLShaderProgram *shader);
+    void DrawTriangles(QOpenGLFunctions_3_3_Core *f, GLsizei instanceCount);
 
     std::vector<double> m_vertexList;
     std::vector<double> m_normalList;
@@ -169,6 +186,13 @@ private:
     SimulationWidget *m_simulationWidget = nullptr;
     QOpenGLBuffer m_VBO;
     bool m_VBOAllocated = false;
+    bool m_VBOStale = false;
+    int m_VBOAllocatedBytes = 0;
+    QOpenGLBuffer m_IBO = QOpenGLBuffer(QOpenGLBuffer::IndexBuffer);
+    bool m_indexed = false;
+    size_t m_numIndices = 0;
+    std::string m_instanceKey;
+    mutable std::shared_ptr<TriangleBVH> m_bvh; // built lazily by FindIntersection
     std::unique_ptr<QOpenGLTexture> m_texture;
     double m_decal = 0;
 
@@ -22,33 +22,7 @@ FacetedPolyline::FacetedPolyline(std::vector<pgd::Vector3> *polyline, double rad
     setBlendColour(blendColour, blendFraction);
     if (internal)
     {
-        std::vector<pgd::Vector3> profile;
-        AllocateMemory(n * (polyline->size() * 2 + 2));
-
-        // need to add extra tails to the polyline for direction padding
-        std::vector<pgd::Vector3> newPolyline;
-        newPolyline.reserve(polyline->size() + 2);
-        pgd::Vector3 v0 = (*polyline)[1] - (*polyline)[0];
-        pgd::Vector3 v1 = (*polyline)[0] - v0;
-        newPolyline.push_back(v1);
-        for (size_t i = 0; i < polyline->size(); i++) newPolyline.push_back((*polyline)[i]);
-        v0 = (*polyline)[polyline->size() - 1] - (*polyline)[polyline->size() - 2];
-        v1 = (*polyline)[polyline->size() - 1] + v0;
-        newPolyline.push_back(v1);
-
-        // create the profile
-        double delTheta = 2 * M_PI / n;
-        double theta = M_PI / 2;
-        for (size_t i = 0; i < n; i++)
-        {
-            v0.x = cos(theta) * radius;
-            v0.y = sin(theta) * radius;
-            v0.z = 0;
-            theta -= delTheta;
-            profile.push_back(v0);
-        }
-
-        Extrude(&newPolyline, &profile);
+        Build(polyline, radius, n);
     }
     else
     {
@@ -86,6 +60,44 @@ FacetedPolyline::FacetedPolyline(std::vector<pgd::Vector3> *polyline, double rad
 
 }
 
+// regenerate the extrusion for a new polyline reusing the existing memory
+void FacetedPolyline::Update(const std::vector<pgd::Vector3> *polyline, double radius, size_t n)
+{
+    ClearGeometry();
+    Build(polyline, radius, n);
+}
+
+void FacetedPolyline::Build(const std::vector<pgd::Vector3> *polyline, double radius, size_t n)
+{
+    std::vector<pgd::Vector3> profile;
+    AllocateMemory(n * (polyline->size() * 2 + 2));
+
+    // need to add extra tails to the polyline for direction padding
+    std::vector<pgd::Vector3> newPolyline;
+    newPolyline.reserve(polyline->size() + 2);
+    pgd::Vector3 v0 = (*polyline)[1] - (*polyline)[0];
+    pgd::Vector3 v1 = (*polyline)[0] - v0;
+    newPolyline.push_back(v1);
+    for (size_t i = 0; i < polyline->size(); i++) newPolyline.push_back((*polyline)[i]);
+    v0 = (*polyline)[polyline->size() - 1] - (*polyline)[polyline->size() - 2];
+    v1 = (*polyline)[polyline->size() - 1] + v0;
+    newPolyline.push_back(v1);
+
+    // create the profile
+    double delTheta = 2 * M_PI / n;
+    double theta = M_PI / 2;
+    for (size_t i = 0; i < n; i++)
+    {
+        v0.x = cos(theta) * radius;
+        v0.y = sin(theta) * radius;
+        v0.z = 0;
+        theta -= delTheta;
+        profile.push_back(v0);
+    }
+
+    Extrude(&newPolyline, &profile);
+}
+
 // extrude profile along a poly line using sharp corners
 // profile is a 2D shape with z = 0 for all values.
 // polyline needs to have no parallel neighbouring segements
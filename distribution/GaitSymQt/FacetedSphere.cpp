@@ -44,6 +44,9 @@
 #include <sstream>
 
 #include "FacetedSphere.h"
+#include "GSUtil.h"
+
+using namespace std::literals::string_literals;
 
 typedef struct
 {
@@ -222,6 +225,9 @@ FacetedSphere::FacetedSphere(double radius, size_t maxlevels, const QColor &blen
 
     Scale(radius, radius, radius);
 
+    // spheres with the same radius and level can share a single draw call
+    setInstanceKey("FacetedSphere "s + GSUtil::ToString(radius) + " "s + GSUtil::ToString(uint64_t(maxlevels)));
+
 //    qDebug() << "FacetedSphere " << GetNumTriangles() << " triangles created\n";
 }
 
@@ -295,6 +295,9 @@ SOURCES += \
     ../src/AMotorJoint.cpp \
     ../src/ArgParse.cpp \
     ../src/BallJoint.cpp \
+    ../src/BatchEvaluator.cpp \
+    ../src/BinaryDump.cpp \
+    ../src/BinaryModel.cpp \
     ../src/Body.cpp \
     ../src/BoxGeom.cpp \
     ../src/ButterworthFilter.cpp \
@@ -344,19 +347,23 @@ SOURCES += \
     ../src/PCA.cpp \
     ../src/PIDErrorInController.cpp \
     ../src/PIDMuscleLengthController.cpp \
+    ../src/PipelinedTCPClient.cpp \
     ../src/ParseXML.cpp \
     ../src/PlaneGeom.cpp \
     ../src/RayGeom.cpp \
     ../src/Reporter.cpp \
+    ../src/SharedXMLCache.cpp \
     ../src/Simulation.cpp \
     ../src/SliderJoint.cpp \
     ../src/SphereGeom.cpp \
     ../src/StackedBoxCarDriver.cpp \
     ../src/StepDriver.cpp \
+    ../src/StepProfiler.cpp \
     ../src/Strap.cpp \
     ../src/SwingClearanceAbortReporter.cpp \
     ../src/TCP.cpp \
     ../src/TegotaeDriver.cpp \
+    ../src/ThreadPool.cpp \
     ../src/ThreeHingeJointDriver.cpp \
     ../src/TorqueReporter.cpp \
     ../src/TrimeshGeom.cpp \
@@ -413,10 +420,13 @@ SOURCES += \
     MainWindowActions.cpp \
     MeshStore.cpp \
     Preferences.cpp \
+    RenderState.cpp \
     SimulationWidget.cpp \
+    SimulationWorker.cpp \
     StrokeFont.cpp \
     TextEditDialog.cpp \
     TrackBall.cpp \
+    TriangleBVH.cpp \
     UniqueNameValidator.cpp \
     ViewControlWidget.cpp \
     main.cpp
@@ -617,6 +627,9 @@ HEADERS += \
     ../src/AMotorJoint.h \
     ../src/ArgParse.h \
     ../src/BallJoint.h \
+    ../src/BatchEvaluator.h \
+    ../src/BinaryDump.h \
+    ../src/BinaryModel.h \
     ../src/Body.h \
     ../src/BoxGeom.h \
     ../src/ButterworthFilter.h \
@@ -668,22 +681,27 @@ HEADERS += \
     ../src/PGDMath.h \
     ../src/PIDErrorInController.h \
     ../src/PIDMuscleLengthController.h \
+    ../src/PipelinedTCPClient.h \
     ../src/ParseXML.h \
     ../src/PlaneGeom.h \
     ../src/RayGeom.h \
     ../src/Reporter.h \
     ../src/SimpleStrap.h \
+    ../src/SharedXMLCache.h \
     ../src/Simulation.h \
     ../src/SliderJoint.h \
     ../src/SmartEnum.h \
     ../src/SphereGeom.h \
     ../src/StackedBoxCarDriver.h \
+    ../src/StateBuffer.h \
     ../src/StepDriver.h \
+    ../src/StepProfiler.h \
     ../src/Strap.h \
     ../src/SwingClearanceAbortReporter.h \
     ../src/TCP.h \
     ../src/TCPIPMessage.h \
     ../src/TegotaeDriver.h \
+    ../src/ThreadPool.h \
     ../src/ThreeHingeJointDriver.h \
     ../src/TorqueReporter.h \
     ../src/TrimeshGeom.h \
@@ -741,10 +759,14 @@ HEADERS += \
     MainWindowActions.h \
     MeshStore.h \
     Preferences.h \
+    RenderState.h \
     SimulationWidget.h \
+    SimulationWorker.h \
     StrokeFont.h \
     TextEditDialog.h \
     TrackBall.h \
+    TriangleBVH.h \
+    TripleBuffer.h \
     UniqueNameValidator.h \
     ViewControlWidget.h
 
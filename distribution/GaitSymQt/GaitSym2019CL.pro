@@ -269,6 +269,9 @@ SOURCES += \
     ../src/AMotorJoint.cpp \
     ../src/ArgParse.cpp \
     ../src/BallJoint.cpp \
+    ../src/BatchEvaluator.cpp \
+    ../src/BinaryDump.cpp \
+    ../src/BinaryModel.cpp \
     ../src/Body.cpp \
     ../src/BoxGeom.cpp \
     ../src/ButterworthFilter.cpp \
@@ -317,19 +320,23 @@ SOURCES += \
     ../src/PCA.cpp \
     ../src/PIDErrorInController.cpp \
     ../src/PIDMuscleLengthController.cpp \
+    ../src/PipelinedTCPClient.cpp \
     ../src/ParseXML.cpp \
     ../src/PlaneGeom.cpp \
     ../src/RayGeom.cpp \
     ../src/Reporter.cpp \
+    ../src/SharedXMLCache.cpp \
     ../src/Simulation.cpp \
     ../src/SliderJoint.cpp \
     ../src/SphereGeom.cpp \
     ../src/StackedBoxCarDriver.cpp \
     ../src/StepDriver.cpp \
+    ../src/StepProfiler.cpp \
     ../src/Strap.cpp \
     ../src/SwingClearanceAbortReporter.cpp \
     ../src/TCP.cpp \
     ../src/TegotaeDriver.cpp \
+    ../src/ThreadPool.cpp \
     ../src/ThreeHingeJointDriver.cpp \
     ../src/TorqueReporter.cpp \
     ../src/TrimeshGeom.cpp \
@@ -523,6 +530,9 @@ HEADERS += \
     ../src/AMotorJoint.h \
     ../src/ArgParse.h \
     ../src/BallJoint.h \
+    ../src/BatchEvaluator.h \
+    ../src/BinaryDump.h \
+    ../src/BinaryModel.h \
     ../src/Body.h \
     ../src/BoxGeom.h \
     ../src/ButterworthFilter.h \
@@ -573,22 +583,27 @@ HEADERS += \
     ../src/PGDMath.h \
     ../src/PIDErrorInController.h \
     ../src/PIDMuscleLengthController.h \
+    ../src/PipelinedTCPClient.h \
     ../src/ParseXML.h \
     ../src/PlaneGeom.h \
     ../src/RayGeom.h \
     ../src/Reporter.h \
     ../src/SimpleStrap.h \
+    ../src/SharedXMLCache.h \
     ../src/Simulation.h \
     ../src/SliderJoint.h \
     ../src/SmartEnum.h \
     ../src/SphereGeom.h \
     ../src/StackedBoxCarDriver.h \
+    ../src/StateBuffer.h \
     ../src/StepDriver.h \
+    ../src/StepProfiler.h \
     ../src/Strap.h \
     ../src/SwingClearanceAbortReporter.h \
     ../src/TCP.h \
     ../src/TCPIPMessage.h \
     ../src/TegotaeDriver.h \
+    ../src/ThreadPool.h \
     ../src/ThreeHingeJointDriver.h \
     ../src/TorqueReporter.h \
     ../src/TrimeshGeom.h \
@@ -21,6 +21,7 @@
 #include "Geom.h"
 #include "Muscle.h"
 #include "Driver.h"
+#include "SimulationWorker.h"
 
 #include "pystring.h"
 
@@ -187,9 +188,10 @@ MainWindow::MainWindow(QWidget *parent)
     // the treeWidgetElements needs to know about this window
     ui->treeWidgetElements->setMainWindow(this);
 
-    // set up the timer
-    m_timer = new QTimer(this);
-    connect(m_timer, SIGNAL(timeout()), this, SLOT(processOneThing()));
+    // set up the simulation thread
+    m_simulationWorker = new SimulationWorker(this);
+    connect(m_simulationWorker, SIGNAL(frameReady()), this, SLOT(handleSimulationFrame()), Qt::QueuedConnection);
+    connect(m_simulationWorker, SIGNAL(finished()), this, SLOT(handleSimulationFinished()), Qt::QueuedConnection);
 
     // zero the timer display
     QString time = QString("%1").arg(double(0), 0, 'f', 5);
@@ -220,7 +222,7 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    m_timer->stop();
+    stopSimulation();
 
     if (m_simulation) delete m_simulation;
     delete ui;
@@ -261,72 +263,110 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
 
 
-void MainWindow::processOneThing()
+void MainWindow::startSimulation(bool singleFrame)
 {
-    if (m_simulation)
+    if (m_simulation == nullptr || m_simulationWorker->isRunning()) return;
+    m_simulationWorker->setSimulation(m_simulation);
+    m_simulationWorker->setStepCount(m_stepCount);
+    m_simulationWorker->setFrameSkip(Preferences::valueInt("MovieSkip"));
+    m_simulationWorker->setRealTimeRatio(Preferences::valueDouble("SimulationRealTimeRatio", 0));
+    m_simulationWorker->setSingleFrame(singleFrame);
+    m_simulationWorker->setLockstep(m_movieFlag || m_saveOBJFileSequenceFlag);
+
+    // publish the current state first so that the widget never needs to read the simulation whilst it is running
+    TripleBuffer<RenderState> *renderBuffer = m_simulationWorker->renderBuffer();
+    renderBuffer->Back()->Capture(m_simulation, m_stepCount);
+    renderBuffer->Publish();
+    renderBuffer->Consume();
+    ui->widgetSimulation->setRenderState(renderBuffer->Front());
+
+    m_simulationWorker->start();
+}
+
+void MainWindow::stopSimulation()
+{
+    ui->actionRun->setChecked(false);
+    if (m_simulationWorker->isRunning() == false) return;
+    m_simulationWorker->requestStop();
+    m_simulationWorker->wait();
+    m_simulationWorker->applyPendingCommands(); // anything posted after the last step
+    m_stepCount = m_simulationWorker->stepCount();
+    // any frames still in the buffer are stale now and the widget can read the simulation directly
+    m_simulationWorker->renderBuffer()->Reset();
+    ui->widgetSimulation->setRenderState(nullptr);
+    ui->widgetSimulation->update();
+}
+
+bool MainWindow::simulationRunning() const
+{
+    return m_simulationWorker->isRunning();
+}
+
+void MainWindow::handleSimulationFrame()
+{
+    m_simulationWorker->acknowledgeFrame();
+    m_simulationWorker->setLockstep(m_movieFlag || m_saveOBJFileSequenceFlag);
+    TripleBuffer<RenderState> *renderBuffer = m_simulationWorker->renderBuffer();
+    if (m_simulation && renderBuffer->Consume())
     {
-        if (m_simulation->ShouldQuit() || m_simulation->TestForCatastrophy())
+        const RenderState *renderState = renderBuffer->Front();
+        ui->widgetSimulation->setRenderState(renderState);
+        handleTracking();
+        ui->widgetSimulation->update();
+        if (m_movieFlag)
         {
-            setStatusString(tr("Unable to start simulation"), 1);
-            ui->actionRun->setChecked(false);
-            m_mainWindowActions->run();
-            return;
+            ui->widgetSimulation->WriteMovieFrame();
         }
-
-        m_simulation->UpdateSimulation();
-        m_stepCount++;
-
-        if ((m_stepCount % size_t(Preferences::valueInt("MovieSkip"))) == 0)
+        if (m_saveOBJFileSequenceFlag)
         {
-            handleTracking();
-            if (m_stepFlag)
-            {
-                m_stepFlag = false;
-                m_timer->stop();
-            }
-            ui->widgetSimulation->getDrawMuscleMap()->clear(); // force a redraw of all muscles
-            ui->widgetSimulation->getDrawFluidSacMap()->clear(); // force a redraw of all fluid sacs
-            ui->widgetSimulation->update();
-            if (m_movieFlag)
-            {
-                ui->widgetSimulation->WriteMovieFrame();
-            }
-            if (m_saveOBJFileSequenceFlag)
-            {
-                QString filename = QString("%1%2").arg("Frame").arg(m_simulation->GetTime(), 12, 'f', 7, QChar('0'));
-                QString path = QDir(m_objFileSequenceFolder).filePath(filename);
-                ui->widgetSimulation->WriteCADFrame(path);
-            }
-            QString time = QString("%1").arg(m_simulation->GetTime(), 0, 'f', 5);
-            ui->lcdNumberTime->display(time);
-//            qDebug() << m_simulation->CalculateInstantaneousFitness() << "\n";
+            QString filename = QString("%1%2").arg("Frame").arg(renderState->time, 12, 'f', 7, QChar('0'));
+            QString path = QDir(m_objFileSequenceFolder).filePath(filename);
+            ui->widgetSimulation->WriteCADFrame(path);
         }
+        QString time = QString("%1").arg(renderState->time, 0, 'f', 5);
+        ui->lcdNumberTime->display(time);
+    }
+    m_simulationWorker->releaseFrame();
+}
 
-        if (m_simulation->ShouldQuit())
+void MainWindow::handleSimulationFinished()
+{
+    if (m_simulationWorker->isRunning()) return; // the simulation has already been restarted
+    m_simulationWorker->applyPendingCommands(); // anything posted after the last step
+    m_stepCount = m_simulationWorker->stepCount();
+    // the worker has stopped so the simulation can be read directly again
+    m_simulationWorker->renderBuffer()->Reset();
+    ui->widgetSimulation->setRenderState(nullptr);
+    if (m_simulation)
+    {
+        switch (m_simulationWorker->stopReason())
         {
+        case SimulationWorker::stopRequested:
+            break;
+        case SimulationWorker::steppedToFrame:
+            handleTracking();
+            break;
+        case SimulationWorker::unableToStart:
+            setStatusString(tr("Unable to start simulation"), 1);
+            ui->actionRun->setChecked(false);
+            break;
+        case SimulationWorker::simulationEnded:
             setStatusString(tr("Simulation ended normally"), 1);
             ui->textEditLog->append(QString("Fitness = %1\n").arg(m_simulation->CalculateInstantaneousFitness(), 0, 'f', 5));
             ui->textEditLog->append(QString("Time = %1\n").arg(m_simulation->GetTime(), 0, 'f', 5));
             ui->textEditLog->append(QString("Metabolic Energy = %1\n").arg(m_simulation->GetMetabolicEnergy(), 0, 'f', 5));
             ui->textEditLog->append(QString("Mechanical Energy = %1\n").arg(m_simulation->GetMechanicalEnergy(), 0, 'f', 5));
-            ui->widgetSimulation->update();
-            QString time = QString("%1").arg(m_simulation->GetTime(), 0, 'f', 5);
-            ui->lcdNumberTime->display(time);
             ui->actionRun->setChecked(false);
-            m_mainWindowActions->run();
-            return;
-        }
-        if (m_simulation->TestForCatastrophy())
-        {
+            break;
+        case SimulationWorker::simulationAborted:
             setStatusString(tr("Simulation aborted"), 1);
             ui->textEditLog->append(QString("Fitness = %1\n").arg(m_simulation->CalculateInstantaneousFitness(), 0, 'f', 5));
-            ui->widgetSimulation->update();
-            QString time = QString("%1").arg(m_simulation->GetTime(), 0, 'f', 5);
-            ui->lcdNumberTime->display(time);
             ui->actionRun->setChecked(false);
-            m_mainWindowActions->run();
-            return;
+            break;
         }
+        QString time = QString("%1").arg(m_simulation->GetTime(), 0, 'f', 5);
+        ui->lcdNumberTime->display(time);
+        ui->widgetSimulation->update();
     }
     updateEnable();
 }
@@ -345,10 +385,18 @@ void MainWindow::handleCommandLineArguments()
 void MainWindow::handleTracking()
 {
     if (!m_simulation) return;
-    Marker *marker = m_simulation->GetMarker(ui->comboBoxTrackingMarker->currentText().toStdString());
-    if (marker)
+    // the marker position comes from the render state when there is one because the simulation may be running
+    const Simulation *simulation = m_simulation;
+    auto markerList = simulation->GetMarkerList();
+    auto markerIter = markerList->find(ui->comboBoxTrackingMarker->currentText().toStdString());
+    if (markerIter != markerList->end())
     {
-        pgd::Vector3 position = marker->GetWorldPosition();
+        pgd::Vector3 position;
+        const RenderState *renderState = ui->widgetSimulation->renderState();
+        if (renderState && renderState->Matches(simulation))
+            position.Set(renderState->markerList[size_t(std::distance(markerList->begin(), markerIter))].position);
+        else
+            position = markerIter->second->GetWorldPosition();
         if (ui->radioButtonTrackingX->isChecked())
         {
             ui->widgetSimulation->setCOIx(float(position.x + ui->doubleSpinBoxTrackingOffset->value()));
@@ -460,7 +508,13 @@ void MainWindow::comboBoxMuscleColourMapCurrentTextChanged(const QString &text)
     Preferences::insert("StrapColourControl", static_cast<int>(colourControl));
     if (m_simulation)
     {
-        for (auto &&iter : *m_simulation->GetMuscleList()) iter.second->setStrapColourControl(colourControl);
+        auto command = [colourControl](Simulation *simulation)
+        {
+            for (auto &&iter : *simulation->GetMuscleList()) iter.second->setStrapColourControl(colourControl);
+        };
+        // the worker owns the simulation whilst it is running
+        if (m_simulationWorker->isRunning()) m_simulationWorker->postCommand(command);
+        else command(m_simulation);
     }
     ui->widgetSimulation->update();
 }
@@ -472,7 +526,10 @@ void MainWindow::spinboxSkip(int v)
 
 void MainWindow::spinboxTimeMax(double v)
 {
-    m_simulation->SetTimeLimit(v);
+    if (m_simulation == nullptr) return;
+    // the worker owns the simulation whilst it is running
+    if (m_simulationWorker->isRunning()) m_simulationWorker->postCommand([v](Simulation *simulation) { simulation->SetTimeLimit(v); });
+    else m_simulation->SetTimeLimit(v);
 }
 
 void MainWindow::spinboxFPSChanged(double v)
@@ -631,6 +688,12 @@ void MainWindow::reportOpenGLSize(int width, int height)
 
 void MainWindow::log(const QString &text)
 {
+    // the simulation can log from the worker thread
+    if (QThread::currentThread() != thread())
+    {
+        QMetaObject::invokeMethod(this, "log", Qt::QueuedConnection, Q_ARG(QString, text));
+        return;
+    }
     ui->textEditLog->append(text);
 }
 
@@ -646,14 +709,15 @@ QByteArray MainWindow::readResource(const QString &resource)
 
 void MainWindow::updateEnable()
 {
+    const Simulation *simulation = m_simulation; // this is called whilst the simulation is running so only use the read only accessors
     ui->actionOutput->setEnabled(m_simulation != nullptr);
     ui->actionRestart->setEnabled(m_simulation != nullptr && m_mode == runMode && m_noName == false && isWindowModified() == false);
     ui->actionSave->setEnabled(m_simulation != nullptr && m_noName == false && isWindowModified() == true);
     ui->actionSaveAs->setEnabled(m_simulation != nullptr);
     ui->actionRawXMLEditor->setEnabled(m_simulation != nullptr && m_mode == constructionMode);
     ui->actionRenameElement->setEnabled(m_simulation != nullptr && m_mode == constructionMode);
-    ui->actionCreateMirrorElements->setEnabled(m_simulation != nullptr && m_mode == constructionMode && m_simulation->GetBodyList()->size() > 0);
-    ui->actionCreateTestingDrivers->setEnabled(m_simulation != nullptr && m_mode == constructionMode && m_simulation->GetMuscleList()->size() > 0);
+    ui->actionCreateMirrorElements->setEnabled(m_simulation != nullptr && m_mode == constructionMode && simulation->GetBodyList()->size() > 0);
+    ui->actionCreateTestingDrivers->setEnabled(m_simulation != nullptr && m_mode == constructionMode && simulation->GetMuscleList()->size() > 0);
     ui->actionExportMarkers->setEnabled(m_simulation != nullptr);
     ui->actionStartWarehouseExport->setEnabled(m_simulation != nullptr && m_mode == runMode && isWindowModified() == false);
     ui->actionStopWarehouseExport->setEnabled(m_simulation != nullptr && m_mode == runMode && isWindowModified() == false);
@@ -667,16 +731,16 @@ void MainWindow::updateEnable()
     ui->actionStopOBJSequence->setEnabled(m_simulation != nullptr && m_mode == runMode && isWindowModified() == false);
     ui->actionImportMeshesAsBodies->setEnabled(m_simulation != nullptr && m_mode == constructionMode);
     ui->actionCreateBody->setEnabled(m_simulation != nullptr && m_mode == constructionMode);
-    ui->actionCreateMarker->setEnabled(m_simulation != nullptr && m_mode == constructionMode && m_simulation->GetBodyList()->size() > 0);
-    ui->actionCreateJoint->setEnabled(m_simulation != nullptr && m_mode == constructionMode && m_simulation->GetBodyList()->size() > 1 && m_simulation->GetMarkerList()->size() > 0);
-    ui->actionCreateMuscle->setEnabled(m_simulation != nullptr && m_mode == constructionMode && m_simulation->GetBodyList()->size() > 1 && m_simulation->GetMarkerList()->size() > 0);
-    ui->actionCreateGeom->setEnabled(m_simulation != nullptr && m_mode == constructionMode && m_simulation->GetBodyList()->size() > 0 && m_simulation->GetMarkerList()->size() > 0);
-    ui->actionCreateDriver->setEnabled(m_simulation != nullptr && m_mode == constructionMode && (m_simulation->GetMuscleList()->size() > 0 || m_simulation->GetControllerList()->size() > 0));
+    ui->actionCreateMarker->setEnabled(m_simulation != nullptr && m_mode == constructionMode && simulation->GetBodyList()->size() > 0);
+    ui->actionCreateJoint->setEnabled(m_simulation != nullptr && m_mode == constructionMode && simulation->GetBodyList()->size() > 1 && simulation->GetMarkerList()->size() > 0);
+    ui->actionCreateMuscle->setEnabled(m_simulation != nullptr && m_mode == constructionMode && simulation->GetBodyList()->size() > 1 && simulation->GetMarkerList()->size() > 0);
+    ui->actionCreateGeom->setEnabled(m_simulation != nullptr && m_mode == constructionMode && simulation->GetBodyList()->size() > 0 && simulation->GetMarkerList()->size() > 0);
+    ui->actionCreateDriver->setEnabled(m_simulation != nullptr && m_mode == constructionMode && (simulation->GetMuscleList()->size() > 0 || simulation->GetControllerList()->size() > 0));
     ui->actionEditGlobal->setEnabled(m_simulation != nullptr && m_mode == constructionMode);
-    ui->actionCreateAssembly->setEnabled(m_simulation != nullptr && m_simulation->GetBodyList()->size() > 0);
+    ui->actionCreateAssembly->setEnabled(m_simulation != nullptr && simulation->GetBodyList()->size() > 0);
     ui->actionDeleteAssembly->setEnabled(m_simulation != nullptr && m_simulation->HasAssembly());
-    ui->actionConstructionMode->setEnabled(m_simulation != nullptr && m_mode == runMode && m_stepCount == 0);
-    ui->actionRunMode->setEnabled(m_simulation != nullptr && m_mode == constructionMode && m_simulation->GetBodyList()->size() > 0);
+    ui->actionConstructionMode->setEnabled(m_simulation != nullptr && m_mode == runMode && m_stepCount == 0 && simulationRunning() == false);
+    ui->actionRunMode->setEnabled(m_simulation != nullptr && m_mode == constructionMode && simulation->GetBodyList()->size() > 0);
 }
 
 
@@ -21,6 +21,7 @@ class Simulation;
 class SimulationWidget;
 class QTreeWidgetItem;
 class MainWindowActions;
+class SimulationWorker;
 
 class MainWindow : public QMainWindow
 {
@@ -38,8 +39,13 @@ public:
     Simulation *simulation() const;
     SimulationWidget *simulationWidget() const;
 
+    void startSimulation(bool singleFrame);
+    void stopSimulation();
+    bool simulationRunning() const;
+
 public slots:
-    void processOneThing();
+    void handleSimulationFrame();
+    void handleSimulationFinished();
     void handleCommandLineArguments();
 
     void comboBoxMeshDisplayMapCurrentTextChanged(const QString &text);
@@ -104,11 +110,10 @@ private:
     bool m_movieFlag = false;
     bool m_saveOBJFileSequenceFlag = false;
     QString m_objFileSequenceFolder;
-    bool m_stepFlag = false;
     uint64_t m_stepCount = 0;
     int m_logLevel = 1;
 
-    QTimer *m_timer = nullptr;
+    SimulationWorker *m_simulationWorker = nullptr;
     Simulation *m_simulation = nullptr;
 
     Mode m_mode = constructionMode;
@@ -88,8 +88,7 @@ void MainWindowActions::menuOpen()
 void MainWindowActions::menuOpen(const QString &fileName, const QByteArray *fileData)
 {
     // dispose any simulation cleanly
-    m_mainWindow->m_timer->stop();
-    m_mainWindow->ui->actionRun->setChecked(false);
+    m_mainWindow->stopSimulation();
     m_mainWindow->m_movieFlag = false;
     if (m_mainWindow->ui->widgetSimulation->aviWriter()) menuStopAVISave();
     if (m_mainWindow->m_simulation)
@@ -99,7 +98,6 @@ void MainWindowActions::menuOpen(const QString &fileName, const QByteArray *file
         m_mainWindow->ui->widgetSimulation->setSimulation(m_mainWindow->m_simulation);
     }
     m_mainWindow->m_stepCount = 0;
-    m_mainWindow->m_stepFlag = false;
 
     m_mainWindow->m_configFile.setFile(fileName);
     QDir::setCurrent(m_mainWindow->m_configFile.absolutePath());
@@ -132,6 +130,7 @@ void MainWindowActions::menuOpen(const QString &fileName, const QByteArray *file
         m_mainWindow->m_simulation->SetMainWindow(m_mainWindow);
         errorMessage = m_mainWindow->m_simulation->LoadModel(file.GetRawData(), file.GetSize());
     }
+    if (errorMessage == nullptr) m_mainWindow->m_simulation->SetNumberOfThreads(size_t(Preferences::valueInt("SimulationThreads", 1)));
     if (errorMessage)
     {
         m_mainWindow->setStatusString(QString::fromStdString(*errorMessage), 0);
@@ -237,6 +236,7 @@ void MainWindowActions::menuRestart()
 
 void MainWindowActions::menuSaveAs()
 {
+    m_mainWindow->stopSimulation();
     QString fileName;
     if (m_mainWindow->m_configFile.absoluteFilePath().isEmpty())
     {
@@ -299,6 +299,7 @@ void MainWindowActions::menuSaveAs()
 
 void MainWindowActions::menuSave()
 {
+    m_mainWindow->stopSimulation();
     if (m_mainWindow->m_noName) return;
     if (m_mainWindow->m_mode == MainWindow::constructionMode) // need to put everything into run mode to save properly
     {
@@ -352,19 +353,20 @@ void MainWindowActions::run()
 {
     if (m_mainWindow->ui->actionRun->isChecked())
     {
-        if (m_mainWindow->m_simulation) m_mainWindow->m_timer->start();
+        m_mainWindow->startSimulation(false);
         m_mainWindow->setStatusString(tr("Simulation running"), 1);
     }
     else
     {
-        m_mainWindow->m_timer->stop();
+        m_mainWindow->stopSimulation();
         m_mainWindow->setStatusString(tr("Simulation stopped"), 1);
     }
+    m_mainWindow->updateEnable();
 }
 void MainWindowActions::step()
 {
-    m_mainWindow->m_stepFlag = true;
-    if (m_mainWindow->m_simulation) m_mainWindow->m_timer->start();
+    if (m_mainWindow->simulationRunning()) return;
+    m_mainWindow->startSimulation(true);
     m_mainWindow->setStatusString(tr("Simulation stepped"), 2);
 }
 
@@ -450,6 +452,7 @@ void MainWindowActions::menuPreferences()
         m_mainWindow->ui->widgetSimulation->setCursor3DNudge(float(Preferences::valueDouble("CursorNudge")));
         m_mainWindow->ui->widgetSimulation->setFrontClip(float(Preferences::valueDouble("CameraFrontClip")));
         m_mainWindow->ui->widgetSimulation->setBackClip(float(Preferences::valueDouble("CameraBackClip")));
+        m_mainWindow->ui->widgetSimulation->setDisplayFrameTime(Preferences::valueBool("DisplayFrameTime"));
 
         m_mainWindow->ui->widgetSimulation->update();
 
@@ -459,6 +462,7 @@ void MainWindowActions::menuPreferences()
 
 void MainWindowActions::menuOutputs()
 {
+    m_mainWindow->stopSimulation();
     if (m_mainWindow->m_simulation == nullptr) return;
     DialogOutputSelect dialogOutputSelect(m_mainWindow);
     dialogOutputSelect.setSimulation(m_mainWindow->m_simulation);
@@ -635,6 +639,7 @@ void MainWindowActions::menuStopOBJSequenceSave()
 
 void MainWindowActions::menuNew()
 {
+    m_mainWindow->stopSimulation();
     if (m_mainWindow->isWindowModified())
     {
         QMessageBox msgBox;
@@ -667,13 +672,12 @@ void MainWindowActions::menuNew()
         m_mainWindow->m_simulation = nullptr;
         m_mainWindow->ui->widgetSimulation->setSimulation(m_mainWindow->m_simulation);
         m_mainWindow->m_stepCount = 0;
-        m_mainWindow->ui->actionRun->setChecked(false);
-        m_mainWindow->m_timer->stop();
         m_mainWindow->m_simulation = new Simulation();
         std::unique_ptr<Global> newGlobal = dialogGlobal.outputGlobal();
         newGlobal->setSimulation(m_mainWindow->m_simulation);
         m_mainWindow->m_simulation->SetGlobal(std::move(newGlobal));
         m_mainWindow->m_simulation->SetMainWindow(m_mainWindow);
+        m_mainWindow->m_simulation->SetNumberOfThreads(size_t(Preferences::valueInt("SimulationThreads", 1)));
         m_mainWindow->ui->widgetSimulation->setSimulation(m_mainWindow->m_simulation);
         m_mainWindow->ui->widgetSimulation->update();
         m_mainWindow->ui->treeWidgetElements->setSimulation(m_mainWindow->m_simulation);
@@ -697,6 +701,7 @@ void MainWindowActions::menuNew()
 
 void MainWindowActions::menuStartWarehouseExport()
 {
+    m_mainWindow->stopSimulation();
     if (m_mainWindow->m_simulation == nullptr) return;
 
     QFileInfo info(Preferences::valueQString("LastFileOpened"));
@@ -712,6 +717,7 @@ void MainWindowActions::menuStartWarehouseExport()
 
 void MainWindowActions::menuStopWarehouseExport()
 {
+    m_mainWindow->stopSimulation();
     if (m_mainWindow->m_simulation == nullptr) return;
 
     m_mainWindow->ui->actionStartWarehouseExport->setEnabled(true);
@@ -819,6 +825,7 @@ void MainWindowActions::menuImportMeshes()
     {
         m_mainWindow->log(QString::fromStdString(errorList[i] + "\n"s));
     }
+    m_mainWindow->m_simulation->InvalidateUpdateLists();
     m_mainWindow->setWindowModified(true);
     m_mainWindow->updateEnable();
     m_mainWindow->updateComboBoxTrackingMarker();
@@ -828,6 +835,7 @@ void MainWindowActions::menuImportMeshes()
 
 void MainWindowActions::menuImportWarehouse()
 {
+    m_mainWindow->stopSimulation();
     if (m_mainWindow->m_simulation == nullptr) return;
     QString fileName = QFileDialog::getOpenFileName(m_mainWindow, tr("Open Warehouse File"), "", tr("Warehouse Files (*.txt);;Any File (*.* *)"), nullptr);
 
@@ -910,6 +918,7 @@ void MainWindowActions::menuCreateEditJoint(Joint *joint)
             }
             m_mainWindow->setStatusString(QString("Joint edited: %1").arg(QString::fromStdString(replacementJointName)), 1);
         }
+        m_mainWindow->m_simulation->InvalidateUpdateLists();
         m_mainWindow->setWindowModified(true);
         m_mainWindow->updateEnable();
         m_mainWindow->ui->widgetSimulation->update();
@@ -997,6 +1006,7 @@ void MainWindowActions::menuCreateEditBody(Body *body)
                 }
              }
         }
+        m_mainWindow->m_simulation->InvalidateUpdateLists();
         m_mainWindow->setWindowModified(true);
         m_mainWindow->updateEnable();
         m_mainWindow->ui->widgetSimulation->update();
@@ -1110,6 +1120,7 @@ void MainWindowActions::menuCreateEditMuscle(Muscle *muscle)
             m_mainWindow->setStatusString(QString("Muscle edited: %1").arg(QString::fromStdString(replacementMuscleName)), 1);
         }
 
+        m_mainWindow->m_simulation->InvalidateUpdateLists();
         m_mainWindow->setWindowModified(true);
         Muscle::StrapColourControl colourControl = Muscle::fixedColour;
         QString text = m_mainWindow->ui->comboBoxMuscleColourMap->currentText();
@@ -1160,6 +1171,7 @@ void MainWindowActions::menuCreateEditGeom(Geom *geom)
             (*m_mainWindow->m_simulation->GetGeomList())[replacementGeomName] = std::move(replacementGeom);
             m_mainWindow->setStatusString(QString("Geom edited: %1").arg(QString::fromStdString(replacementGeomName)), 1);
         }
+        m_mainWindow->m_simulation->InvalidateUpdateLists();
         m_mainWindow->setWindowModified(true);
         m_mainWindow->updateEnable();
         m_mainWindow->ui->widgetSimulation->update();
@@ -1206,6 +1218,7 @@ void MainWindowActions::menuCreateEditDriver(Driver *driver)
             (*m_mainWindow->m_simulation->GetDriverList())[replacementDriverName] = std::move(replacementDriver);
             m_mainWindow->setStatusString(QString("Driver edited: %1").arg(QString::fromStdString(replacementDriverName)), 1);
         }
+        m_mainWindow->m_simulation->InvalidateUpdateLists();
         m_mainWindow->setWindowModified(true);
         m_mainWindow->updateEnable();
         m_mainWindow->ui->widgetSimulation->update();
@@ -1245,6 +1258,7 @@ void MainWindowActions::menuEditGlobal()
 
 void MainWindowActions::enterRunMode()
 {
+    m_mainWindow->stopSimulation();
     Q_ASSERT_X(m_mainWindow->m_simulation, "MainWindowActions::enterRunMode", "m_mainWindow->m_simulation undefined");
     m_mainWindow->m_mode = MainWindow::runMode;
     for (auto &&it : *m_mainWindow->m_simulation->GetBodyList()) it.second->EnterRunMode();
@@ -1261,6 +1275,7 @@ void MainWindowActions::enterRunMode()
 
 void MainWindowActions::enterConstructionMode()
 {
+    m_mainWindow->stopSimulation();
     Q_ASSERT_X(m_mainWindow->m_simulation, "MainWindowActions::enterConstructionMode", "m_mainWindow->m_simulation undefined");
     Q_ASSERT_X(m_mainWindow->m_stepCount == 0, "MainWindowActions::enterConstructionMode", "m_mainWindow->m_stepCount not zero");
     m_mainWindow->m_mode = MainWindow::constructionMode;
@@ -1278,6 +1293,7 @@ void MainWindowActions::enterConstructionMode()
 
 void MainWindowActions::menuCreateAssembly()
 {
+    m_mainWindow->stopSimulation();
     Q_ASSERT_X(m_mainWindow->m_simulation, "MainWindowActions::menuCreateAssembly", "m_mainWindow->m_simulation undefined");
     DialogAssembly dialogAssembly(m_mainWindow);
     dialogAssembly.setSimulation(m_mainWindow->m_simulation);
@@ -1290,6 +1306,7 @@ void MainWindowActions::menuCreateAssembly()
     if (status == QDialog::Accepted)
     {
         m_mainWindow->setStatusString(tr("Assembly constraints created"), 2);
+        m_mainWindow->m_simulation->InvalidateUpdateLists();
         m_mainWindow->setWindowModified(true);
     }
     else
@@ -1302,6 +1319,7 @@ void MainWindowActions::menuCreateAssembly()
 
 void MainWindowActions::menuDeleteAssembly()
 {
+    m_mainWindow->stopSimulation();
     int ret = QMessageBox::warning(m_mainWindow, tr("Delete Assembly"), tr("This action cannot be undone.\nAre you sure you want to continue?"), QMessageBox::Ok | QMessageBox::Cancel, QMessageBox::Cancel);
     if (ret == QMessageBox::Ok)
     {
@@ -1340,6 +1358,7 @@ void MainWindowActions::menuDeleteAssembly()
 
 void MainWindowActions::menuExportMarkers()
 {
+    m_mainWindow->stopSimulation();
     Q_ASSERT_X(m_mainWindow->m_simulation, "MainWindowActions::menuExportMarkers", "m_mainWindow->m_simulation undefined");
     DialogMarkerImportExport dialogMarkerImportExport(m_mainWindow);
     dialogMarkerImportExport.setSimulation(m_mainWindow->m_simulation);
@@ -1548,6 +1567,7 @@ void MainWindowActions::menuRename()
 
 void MainWindowActions::elementInfo(const QString &elementType, const QString &elementName)
 {
+    m_mainWindow->stopSimulation();
     DialogInfo dialog(m_mainWindow);
     dialog.useXMLSyntaxHighlighter();
     NamedObject *element = m_mainWindow->m_simulation->GetNamedObject(elementName.toStdString());
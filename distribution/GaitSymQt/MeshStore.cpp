@@ -10,6 +10,17 @@
 #include "MeshStore.h"
 #include "FacetedObject.h"
 
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+#include <cstring>
+#include <algorithm>
+
 MeshStore FacetedObject::m_meshStore;
 
 MeshStore::MeshStore()
@@ -41,9 +52,10 @@ MeshStoreObject *MeshStore::getMesh(const std::string &path)
 }
 
 
-void MeshStore::addMesh(const MeshStoreObject &meshStoreObject)
+// returns nullptr if the mesh is too big to store
+MeshStoreObject *MeshStore::addMesh(const MeshStoreObject &meshStoreObject)
 {
-    if (meshStoreObject.size() > m_targetMemory) return;
+    if (meshStoreObject.size() > m_targetMemory) return nullptr;
 
     auto mesh = std::make_unique<MeshStoreObject>();
     *mesh = meshStoreObject;
@@ -58,17 +70,19 @@ void MeshStore::addMesh(const MeshStoreObject &meshStoreObject)
     m_lastAccessedMapByTime[m_timeCount] = mesh->path;
     m_timeCount++;
 
+    MeshStoreObject *storedMesh = mesh.get();
     m_meshMap[meshStoreObject.path] = std::move(mesh);
+    return storedMesh;
 }
 
-void MeshStore::addMesh(const std::string &path, const std::vector<double> &vertexList, const std::vector<double> &normalList,
+MeshStoreObject *MeshStore::addMesh(const std::string &path, const std::vector<double> &vertexList, const std::vector<double> &normalList,
                         const std::vector<double> &colourList, const std::vector<double> &uvList, const dVector3 &lowerBound, const dVector3 &upperBound)
 {
     if ((vertexList.size() * sizeof(double) +
          normalList.size() * sizeof(double) +
          colourList.size() * sizeof(double) +
          uvList.size() * sizeof(double) +
-         sizeof(MeshStoreObject)) > m_targetMemory) return;
+         sizeof(MeshStoreObject)) > m_targetMemory) return nullptr;
 
     auto mesh = std::make_unique<MeshStoreObject>();
     mesh->path = path;
@@ -93,7 +107,9 @@ void MeshStore::addMesh(const std::string &path, const std::vector<double> &vert
     m_lastAccessedMapByTime[m_timeCount] = mesh->path;
     m_timeCount++;
 
+    MeshStoreObject *storedMesh = mesh.get();
     m_meshMap[path] = std::move(mesh);
+    return storedMesh;
 }
 
 uint64_t MeshStore::getCurrentMemory()
@@ -126,6 +142,142 @@ void MeshStore::setTargetMemory(double targetMemoryFraction)
 }
 
 
+// cache file layout (native byte order, everything 8 byte aligned)
+// header, then for each dependency the size, modification time, path length and path padded to 8 bytes,
+// then the vertex, normal, colour and UV lists as doubles so that a cached mesh is identical to a parsed one
+namespace
+{
+const uint64_t meshCacheMagic = 0x4853454d53544147; // "GATSMESH" when read as little endian
+const uint32_t meshCacheVersion = 1;
+
+struct MeshCacheHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t numDependencies;
+    uint64_t listSizes[4];
+    double lowerBound[3];
+    double upperBound[3];
+};
+
+size_t PaddedLength(size_t length)
+{
+    return (length + 7) & ~size_t(7);
+}
+}
+
+std::string MeshStore::cacheFileName(const std::string &path)
+{
+    QString absolutePath = QFileInfo(QString::fromStdString(path)).absoluteFilePath();
+    QString hash = QString::fromLatin1(QCryptographicHash::hash(absolutePath.toUtf8(), QCryptographicHash::Sha1).toHex());
+    QString folder = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/meshes";
+    return QDir(folder).filePath(hash + ".gsmesh").toStdString();
+}
+
+bool MeshStore::fileStamp(const std::string &path, int64_t *size, int64_t *modified)
+{
+    QFileInfo fileInfo(QString::fromStdString(path));
+    if (!fileInfo.exists()) return false;
+    *size = fileInfo.size();
+    *modified = fileInfo.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+// returns false if there is no cache file or any of the files it was made from have changed
+bool MeshStore::readCacheFile(const std::string &path, MeshStoreObject *meshStoreObject)
+{
+    QFile file(QString::fromStdString(cacheFileName(path)));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(MeshCacheHeader))) return false;
+    const uchar *data = file.map(0, fileSize);
+    if (!data) return false;
+    const uchar *end = data + fileSize;
+
+    bool valid = false;
+    const uchar *ptr = data;
+    MeshCacheHeader header;
+    std::memcpy(&header, ptr, sizeof(header));
+    ptr += sizeof(header);
+    if (header.magic == meshCacheMagic && header.version == meshCacheVersion && header.numDependencies > 0)
+    {
+        valid = true;
+        for (uint32_t i = 0; i < header.numDependencies && valid; i++)
+        {
+            int64_t stamp[3]; // size, modified, path length
+            if (end - ptr < qint64(sizeof(stamp))) { valid = false; break; }
+            std::memcpy(stamp, ptr, sizeof(stamp));
+            ptr += sizeof(stamp);
+            if (stamp[2] < 0 || end - ptr < qint64(PaddedLength(size_t(stamp[2])))) { valid = false; break; }
+            std::string dependency(reinterpret_cast<const char *>(ptr), size_t(stamp[2]));
+            ptr += PaddedLength(size_t(stamp[2]));
+            if (i == 0 && QFileInfo(QString::fromStdString(dependency)) != QFileInfo(QString::fromStdString(path))) valid = false; // hash collision
+            int64_t size, modified;
+            if (!fileStamp(dependency, &size, &modified) || size != stamp[0] || modified != stamp[1]) valid = false;
+        }
+        uint64_t totalDoubles = header.listSizes[0] + header.listSizes[1] + header.listSizes[2] + header.listSizes[3];
+        if (valid && uint64_t(end - ptr) != totalDoubles * sizeof(double)) valid = false;
+    }
+    if (valid)
+    {
+        std::vector<double> *lists[4] = {&meshStoreObject->vertexList, &meshStoreObject->normalList, &meshStoreObject->colourList, &meshStoreObject->uvList};
+        for (size_t i = 0; i < 4; i++)
+        {
+            lists[i]->resize(header.listSizes[i]);
+            std::memcpy(lists[i]->data(), ptr, header.listSizes[i] * sizeof(double));
+            ptr += header.listSizes[i] * sizeof(double);
+        }
+        meshStoreObject->path = path;
+        std::copy_n(header.lowerBound, 3, meshStoreObject->lowerBound);
+        std::copy_n(header.upperBound, 3, meshStoreObject->upperBound);
+    }
+    file.unmap(const_cast<uchar *>(data));
+    return valid;
+}
+
+// the file is written to a temporary and renamed so a partly written cache file is never read
+bool MeshStore::writeCacheFile(const std::vector<std::string> &dependencies, const std::vector<double> &vertexList, const std::vector<double> &normalList,
+                               const std::vector<double> &colourList, const std::vector<double> &uvList,
+                               const dVector3 &lowerBound, const dVector3 &upperBound)
+{
+    if (dependencies.size() == 0) return false;
+    MeshCacheHeader header = {};
+    header.magic = meshCacheMagic;
+    header.version = meshCacheVersion;
+    header.numDependencies = uint32_t(dependencies.size());
+    const std::vector<double> *lists[4] = {&vertexList, &normalList, &colourList, &uvList};
+    for (size_t i = 0; i < 4; i++) header.listSizes[i] = lists[i]->size();
+    std::copy_n(lowerBound, 3, header.lowerBound);
+    std::copy_n(upperBound, 3, header.upperBound);
+
+    QByteArray dependencyData;
+    for (auto &&dependency : dependencies)
+    {
+        std::string absolutePath = QFileInfo(QString::fromStdString(dependency)).absoluteFilePath().toStdString();
+        int64_t stamp[3];
+        if (!fileStamp(absolutePath, &stamp[0], &stamp[1])) return false;
+        stamp[2] = int64_t(absolutePath.size());
+        dependencyData.append(reinterpret_cast<const char *>(stamp), sizeof(stamp));
+        dependencyData.append(absolutePath.data(), int(absolutePath.size()));
+        dependencyData.append(int(PaddedLength(absolutePath.size()) - absolutePath.size()), '\0');
+    }
+
+    std::string cacheFile = cacheFileName(dependencies[0]);
+    if (!QDir().mkpath(QFileInfo(QString::fromStdString(cacheFile)).absolutePath())) return false;
+    QSaveFile file(QString::fromStdString(cacheFile));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(dependencyData);
+    for (size_t i = 0; i < 4; i++) file.write(reinterpret_cast<const char *>(lists[i]->data()), qint64(lists[i]->size() * sizeof(double)));
+    return file.commit();
+}
+
+void MeshStore::clearCacheFiles()
+{
+    QDir folder(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/meshes");
+    if (folder.exists()) folder.removeRecursively();
+}
+
 #if defined(_WIN32) || defined(WIN32)
 #include <Windows.h>
 
@@ -10,6 +10,8 @@
 #ifndef MESHSTORE_H
 #define MESHSTORE_H
 
+#include "TriangleBVH.h"
+
 #include "ode/ode.h"
 
 #include <vector>
@@ -26,6 +28,7 @@ struct MeshStoreObject
                 normalList.size() * sizeof(double) +
                 colourList.size() * sizeof(double) +
                 uvList.size() * sizeof(double) +
+                bvh->memoryUsage() +
                 sizeof(MeshStoreObject));
     }
     std::string path;
@@ -35,6 +38,7 @@ struct MeshStoreObject
     std::vector<double> uvList;
     dVector3 lowerBound = {DBL_MAX, DBL_MAX, DBL_MAX, 0};
     dVector3 upperBound = {-DBL_MAX, -DBL_MAX, -DBL_MAX, 0};
+    std::shared_ptr<TriangleBVH> bvh = std::make_shared<TriangleBVH>(); // built on first use and shared by every object loaded from this mesh
 };
 
 class MeshStore
@@ -43,12 +47,20 @@ public:
     MeshStore();
 
     MeshStoreObject *getMesh(const std::string &path);
-    void addMesh(const MeshStoreObject &meshStoreObject);
-    void addMesh(const std::string &path, const std::vector<double> &vertexList, const std::vector<double> &normalList,
+    MeshStoreObject *addMesh(const MeshStoreObject &meshStoreObject);
+    MeshStoreObject *addMesh(const std::string &path, const std::vector<double> &vertexList, const std::vector<double> &normalList,
                  const std::vector<double> &colourList, const std::vector<double> &uvList,
                  const dVector3 &lowerBound, const dVector3 &upperBound);
     void clear();
 
+    // persistent cache of parsed meshes so that text mesh files only need parsing once
+    // dependencies are the source file followed by any files it includes (e.g. OBJ materials)
+    static bool readCacheFile(const std::string &path, MeshStoreObject *meshStoreObject);
+    static bool writeCacheFile(const std::vector<std::string> &dependencies, const std::vector<double> &vertexList, const std::vector<double> &normalList,
+                               const std::vector<double> &colourList, const std::vector<double> &uvList,
+                               const dVector3 &lowerBound, const dVector3 &upperBound);
+    static void clearCacheFiles();
+
     uint64_t getCurrentMemory();
     void setTargetMemory(uint64_t targetMemory);
     void setTargetMemory(double targetMemoryFraction);
@@ -56,6 +68,9 @@ public:
 
 
 private:
+    static std::string cacheFileName(const std::string &path);
+    static bool fileStamp(const std::string &path, int64_t *size, int64_t *modified);
+
     std::unordered_map<std::string, std::unique_ptr<MeshStoreObject>> m_meshMap;
     std::map<uint64_t, std::string> m_lastAccessedMapByTime;
     std::unordered_map<std::string, uint64_t> m_lastAccessedMapByName;
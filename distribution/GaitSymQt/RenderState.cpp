@@ -0,0 +1,103 @@
+/*
+ *  RenderState.cpp
+ *  GaitSymODE2019
+ *
+ *  Copy of the parts of the simulation state that change while it runs and
+ *  are needed for drawing
+ *
+ */
+
+#include "RenderState.h"
+#include "DrawMuscle.h"
+#include "DrawFluidSac.h"
+
+#include "Simulation.h"
+#include "Body.h"
+#include "Joint.h"
+#include "FixedJoint.h"
+#include "Geom.h"
+#include "Marker.h"
+#include "Muscle.h"
+#include "FluidSac.h"
+
+#include <algorithm>
+
+static void CapturePose(const Marker *marker, RenderState::Pose *pose)
+{
+    pgd::Vector3 p = marker->GetWorldPosition();
+    pgd::Quaternion q = marker->GetWorldQuaternion();
+    pose->position[0] = p.x; pose->position[1] = p.y; pose->position[2] = p.z;
+    pose->quaternion[0] = q.n; pose->quaternion[1] = q.x; pose->quaternion[2] = q.y; pose->quaternion[3] = q.z;
+}
+
+// the vectors are resized rather than cleared so the buffers keep their allocations from one capture to the next
+void RenderState::Capture(Simulation *simulation, uint64_t stepCount)
+{
+    const Simulation *readOnlySimulation = simulation; // the const accessors do not flag the update lists as dirty
+    this->time = simulation->GetTime();
+    this->stepCount = stepCount;
+
+    auto bodies = readOnlySimulation->GetBodyList();
+    bodyList.resize(bodies->size());
+    size_t index = 0;
+    for (auto &&it : *bodies)
+    {
+        std::copy_n(it.second->GetPosition(), 3, bodyList[index].position);
+        std::copy_n(it.second->GetQuaternion(), 4, bodyList[index].quaternion);
+        index++;
+    }
+
+    auto joints = readOnlySimulation->GetJointList();
+    jointList.resize(joints->size());
+    index = 0;
+    for (auto &&it : *joints)
+    {
+        CapturePose(it.second->body1Marker(), &jointList[index].pose);
+        FixedJoint *fixedJoint = dynamic_cast<FixedJoint *>(it.second.get());
+        if (fixedJoint && fixedJoint->GetStressCalculationType() != FixedJoint::none)
+        {
+            // always copied because the consumer might skip the capture where it changed
+            if (fixedJoint->CalculatePixmapNeeded()) fixedJoint->CalculatePixmap();
+            jointList[index].pixMap = fixedJoint->pixMap();
+        }
+        else
+        {
+            jointList[index].pixMap.clear();
+        }
+        index++;
+    }
+
+    auto geoms = readOnlySimulation->GetGeomList();
+    geomList.resize(geoms->size());
+    index = 0;
+    for (auto &&it : *geoms) CapturePose(it.second->geomMarker(), &geomList[index++]);
+
+    auto markers = readOnlySimulation->GetMarkerList();
+    markerList.resize(markers->size());
+    index = 0;
+    for (auto &&it : *markers) CapturePose(it.second.get(), &markerList[index++]);
+
+    auto muscles = readOnlySimulation->GetMuscleList();
+    muscleList.resize(muscles->size());
+    index = 0;
+    for (auto &&it : *muscles) DrawMuscle::CaptureState(it.second.get(), &muscleList[index++]);
+
+    auto fluidSacs = readOnlySimulation->GetFluidSacList();
+    fluidSacList.resize(fluidSacs->size());
+    index = 0;
+    for (auto &&it : *fluidSacs) DrawFluidSac::CaptureState(it.second.get(), &fluidSacList[index++]);
+
+    valid = true;
+}
+
+// the element lists cannot change whilst the simulation is running so matching sizes means matching elements
+bool RenderState::Matches(const Simulation *simulation) const
+{
+    return valid &&
+            bodyList.size() == simulation->GetBodyList()->size() &&
+            jointList.size() == simulation->GetJointList()->size() &&
+            geomList.size() == simulation->GetGeomList()->size() &&
+            markerList.size() == simulation->GetMarkerList()->size() &&
+            muscleList.size() == simulation->GetMuscleList()->size() &&
+            fluidSacList.size() == simulation->GetFluidSacList()->size();
+}
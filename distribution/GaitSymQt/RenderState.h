@@ -0,0 +1,69 @@
+/*
+ *  RenderState.h
+ *  GaitSymODE2019
+ *
+ *  Copy of the parts of the simulation state that change while it runs and
+ *  are needed for drawing. It is filled on whichever thread is stepping the
+ *  simulation so that the drawing code never reads a simulation that is
+ *  being updated. The lists are in the same order as the simulation maps.
+ *
+ */
+
+#ifndef RENDERSTATE_H
+#define RENDERSTATE_H
+
+#include "PGDMath.h"
+
+#include <vector>
+#include <cstdint>
+
+class Simulation;
+
+struct RenderState
+{
+    struct Pose
+    {
+        double position[3] = {0, 0, 0};
+        double quaternion[4] = {1, 0, 0, 0};
+    };
+
+    struct JointState
+    {
+        Pose pose;
+        std::vector<unsigned char> pixMap; // empty unless the joint is calculating stress
+    };
+
+    struct MuscleState
+    {
+        std::vector<pgd::Vector3> path;
+        bool hasCylinder = false;
+        pgd::Vector3 cylinderEnd0;
+        pgd::Vector3 cylinderEnd1;
+        double cylinderRadius = 0;
+        double colourValue = 0; // value looked up in the colour map when the strap colour is not fixed
+        std::vector<pgd::Vector3> forceOrigins;
+        std::vector<pgd::Vector3> forceVectors; // already multiplied by the tension
+    };
+
+    struct FluidSacState
+    {
+        std::vector<double> vertices; // 9 values per triangle
+        std::vector<pgd::Vector3> forceOrigins;
+        std::vector<pgd::Vector3> forceVectors;
+    };
+
+    void Capture(Simulation *simulation, uint64_t stepCount);
+    bool Matches(const Simulation *simulation) const;
+
+    bool valid = false;
+    double time = 0;
+    uint64_t stepCount = 0;
+    std::vector<Pose> bodyList;
+    std::vector<JointState> jointList;
+    std::vector<Pose> geomList;
+    std::vector<Pose> markerList;
+    std::vector<MuscleState> muscleList;
+    std::vector<FluidSacState> fluidSacList;
+};
+
+#endif // RENDERSTATE_H
@@ -62,6 +62,7 @@ SimulationWidget::SimulationWidget(QWidget *parent)
     m_axesScale = Preferences::valueFloat("GlobalAxesSize");
     m_cursorRadius = Preferences::valueFloat("CursorRadius");
     m_cursor3DNudge = Preferences::valueFloat("CursorNudge");
+    m_displayFrameTime = Preferences::valueBool("DisplayFrameTime", false);
 
     m_cursor3D = std::make_unique<FacetedSphere>(1, m_cursorLevel, m_cursorColour, 1);
     m_globalAxes = std::make_unique<FacetedObject>();
@@ -86,11 +87,17 @@ void SimulationWidget::cleanup()
         delete m_facetedObjectShader;
         m_facetedObjectShader = nullptr;
     }
+    if (m_facetedObjectInstancedShader)
+    {
+        delete m_facetedObjectInstancedShader;
+        m_facetedObjectInstancedShader = nullptr;
+    }
     if (m_fixedColourObjectShader)
     {
         delete m_fixedColourObjectShader;
         m_fixedColourObjectShader = nullptr;
     }
+    m_instanceBuffer.destroy();
     if (m_aviWriter)
     {
         delete m_aviWriter;
@@ -154,6 +161,19 @@ void SimulationWidget::initializeGL()
 
     m_facetedObjectShader->release();
 
+    m_facetedObjectInstancedShader = new QOpenGLShaderProgram();
+    m_facetedObjectInstancedShader->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/opengl/vertex_shader_instanced.glsl");
+    m_facetedObjectInstancedShader->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/opengl/fragment_shader.glsl");
+    m_facetedObjectInstancedShader->bindAttributeLocation("vertex", 0);
+    m_facetedObjectInstancedShader->bindAttributeLocation("vertexNormal", 1);
+    m_facetedObjectInstancedShader->bindAttributeLocation("vertexColour", 2);
+    m_facetedObjectInstancedShader->bindAttributeLocation("vertexUV", 3);
+    m_facetedObjectInstancedShader->bindAttributeLocation("instanceModel", 4); // a mat4 so it uses locations 4 to 7
+    m_facetedObjectInstancedShader->link();
+
+    m_instanceBuffer.create();
+    m_instanceBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+
     m_fixedColourObjectShader = new QOpenGLShaderProgram();
     m_fixedColourObjectShader->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/opengl/vertex_shader_2.glsl");
     m_fixedColourObjectShader->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/opengl/fragment_shader_2.glsl");
@@ -171,6 +191,12 @@ void SimulationWidget::initializeGL()
 
 void SimulationWidget::paintGL()
 {
+    // frame timings are smoothed so that the overlay is readable
+    QElapsedTimer drawTimer;
+    drawTimer.start();
+    if (m_frameTimer.isValid()) m_frameInterval = 0.9 * m_frameInterval + 0.1 * double(m_frameTimer.nsecsElapsed()) / 1e6;
+    m_frameTimer.start();
+
     QOpenGLVertexArrayObject::Binder vaoBinder(&m_vao);
 
     glClearColor(GLclampf(m_backgroundColour.redF()), GLclampf(m_backgroundColour.greenF()), GLclampf(m_backgroundColour.blueF()), GLclampf(m_backgroundColour.alphaF()));
@@ -248,7 +274,16 @@ void SimulationWidget::paintGL()
         strokeFont.AddCircle(centreX, centreY, 0, radius, 180);
     }
 
+    if (m_displayFrameTime)
+    {
+        // the draw time shown is from the previous frame since this one is not finished yet
+        QByteArray frameTimeText = QString("Draw %1 ms Frame %2 ms").arg(m_drawTime, 0, 'f', 1).arg(m_frameInterval, 0, 'f', 1).toUtf8();
+        float characterSize = 12;
+        strokeFont.StrokeString(frameTimeText.constData(), frameTimeText.size(), characterSize, float(height()) - characterSize, characterSize, characterSize, 0, 2, nullptr, nullptr);
+    }
+
    strokeFont.Draw();
+   m_drawTime = 0.9 * m_drawTime + 0.1 * double(drawTimer.nsecsElapsed()) / 1e6;
 }
 
 void SimulationWidget::resizeGL(int width, int height)
@@ -842,7 +877,23 @@ bool SimulationWidget::DeleteDrawBody(const std::string &bodyName)
 void SimulationWidget::drawModel()
 {
     if (!m_simulation) return;
-    auto bodyList = m_simulation->GetBodyList();
+    // the simulation may be running on another thread so everything that changes during a run comes from the render state
+    // and the element lists are only read through the const accessors
+    const Simulation *simulation = m_simulation;
+    const RenderState *renderState = m_renderState;
+    if (!renderState || !renderState->Matches(simulation))
+    {
+        m_captureState.Capture(m_simulation, 0);
+        renderState = &m_captureState;
+    }
+    // muscles and fluid sacs are updated in place whenever there is a new frame
+    bool newFrame = (renderState != m_lastDrawnState || renderState->stepCount != m_lastDrawnStepCount);
+    m_lastDrawnState = renderState;
+    m_lastDrawnStepCount = renderState->stepCount;
+    size_t stateIndex;
+    m_collectInstances = true;
+
+    auto bodyList = simulation->GetBodyList();
     auto drawBodyMapIter = m_drawBodyMap.begin();
     while (drawBodyMapIter != m_drawBodyMap.end())
     {
@@ -853,6 +904,7 @@ void SimulationWidget::drawModel()
         }
         else drawBodyMapIter++;
     }
+    stateIndex = 0;
     for (auto &&iter : *bodyList)
     {
         std::map<std::string, DrawBody *>::iterator it = m_drawBodyMap.find(iter.first);
@@ -865,7 +917,7 @@ void SimulationWidget::drawModel()
             m_drawBodyMap[iter.first] = drawBody;
             it = m_drawBodyMap.find(iter.first);
         }
-        it->second->updateEntityPose();
+        it->second->updateEntityPose(renderState->bodyList[stateIndex++]);
         it->second->axes()->setVisible(iter.second->visible());
         it->second->meshEntity1()->setVisible(m_drawBodyMesh1 && iter.second->visible());
         it->second->meshEntity2()->setVisible(m_drawBodyMesh2 && iter.second->visible());
@@ -873,7 +925,7 @@ void SimulationWidget::drawModel()
         it->second->Draw();
     }
 
-    auto jointList = m_simulation->GetJointList();
+    auto jointList = simulation->GetJointList();
     auto drawJointMapIter = m_drawJointMap.begin();
     while (drawJointMapIter != m_drawJointMap.end())
     {
@@ -884,6 +936,7 @@ void SimulationWidget::drawModel()
         }
         else drawJointMapIter++;
     }
+    stateIndex = 0;
     for (auto &&iter : *jointList)
     {
         std::map<std::string, DrawJoint *>::iterator it = m_drawJointMap.find(iter.first);
@@ -896,12 +949,12 @@ void SimulationWidget::drawModel()
             m_drawJointMap[iter.first] = drawJoint;
             it = m_drawJointMap.find(iter.first);
         }
-        it->second->updateEntityPose();
+        it->second->updateEntityPose(renderState->jointList[stateIndex++]);
         it->second->setVisible(iter.second->visible());
         it->second->Draw();
     }
 
-    auto geomList = m_simulation->GetGeomList();
+    auto geomList = simulation->GetGeomList();
     auto drawGeomMapIter = m_drawGeomMap.begin();
     while (drawGeomMapIter != m_drawGeomMap.end())
     {
@@ -912,6 +965,7 @@ void SimulationWidget::drawModel()
         }
         else drawGeomMapIter++;
     }
+    stateIndex = 0;
     for (auto &&iter : *geomList)
     {
         auto it = m_drawGeomMap.find(iter.first);
@@ -924,12 +978,12 @@ void SimulationWidget::drawModel()
             m_drawGeomMap[iter.first] = drawGeom;
             it = m_drawGeomMap.find(iter.first);
         }
-        it->second->updateEntityPose();
+        it->second->updateEntityPose(renderState->geomList[stateIndex++]);
         it->second->setVisible(iter.second->visible());
         it->second->Draw();
     }
 
-    auto markerList = m_simulation->GetMarkerList();
+    auto markerList = simulation->GetMarkerList();
     auto drawMarkerMapIter = m_drawMarkerMap.begin();
     while (drawMarkerMapIter != m_drawMarkerMap.end())
     {
@@ -940,6 +994,7 @@ void SimulationWidget::drawModel()
         }
         else drawMarkerMapIter++;
     }
+    stateIndex = 0;
     for (auto &&iter : *markerList)
     {
         auto it = m_drawMarkerMap.find(iter.first);
@@ -952,12 +1007,12 @@ void SimulationWidget::drawModel()
             m_drawMarkerMap[iter.first] = drawMarker;
             it = m_drawMarkerMap.find(iter.first);
         }
-        it->second->updateEntityPose();
+        it->second->updateEntityPose(renderState->markerList[stateIndex++]);
         it->second->setVisible(iter.second->visible());
         it->second->Draw();
     }
 
-    auto muscleList = m_simulation->GetMuscleList();
+    auto muscleList = simulation->GetMuscleList();
     auto drawMuscleMapIter = m_drawMuscleMap.begin();
     while (drawMuscleMapIter != m_drawMuscleMap.end())
     {
@@ -968,23 +1023,28 @@ void SimulationWidget::drawModel()
         }
         else drawMuscleMapIter++;
     }
+    stateIndex = 0;
     for (auto &&iter : *muscleList)
     {
         auto it = m_drawMuscleMap.find(iter.first);
-        if (it == m_drawMuscleMap.end() || it->second->muscle() != iter.second.get())
+        bool rebuild = (it == m_drawMuscleMap.end() || it->second->muscle() != iter.second.get());
+        if (!rebuild && newFrame) rebuild = !it->second->updateEntityState(renderState->muscleList[stateIndex]);
+        if (rebuild)
         {
             if (it != m_drawMuscleMap.end()) delete it->second;
             DrawMuscle *drawMuscle = new DrawMuscle();
             drawMuscle->setMuscle(iter.second.get());
+            drawMuscle->setMuscleState(&renderState->muscleList[stateIndex]);
             drawMuscle->initialise(this);
             m_drawMuscleMap[iter.first] = drawMuscle;
             it = m_drawMuscleMap.find(iter.first);
         }
+        stateIndex++;
         it->second->setVisible(iter.second->visible());
         it->second->Draw();
     }
 
-    auto fluidSacList = m_simulation->GetFluidSacList();
+    auto fluidSacList = simulation->GetFluidSacList();
     auto drawFluidSacMapIter = m_drawFluidSacMap.begin();
     while (drawFluidSacMapIter != m_drawFluidSacMap.end())
     {
@@ -995,22 +1055,29 @@ void SimulationWidget::drawModel()
         }
         else drawFluidSacMapIter++;
     }
+    stateIndex = 0;
     for (auto &&iter : *fluidSacList)
     {
         auto it = m_drawFluidSacMap.find(iter.first);
-        if (it == m_drawFluidSacMap.end() || it->second->fluidSac() != iter.second.get())
+        bool rebuild = (it == m_drawFluidSacMap.end() || it->second->fluidSac() != iter.second.get());
+        if (!rebuild && newFrame) rebuild = !it->second->updateEntityState(renderState->fluidSacList[stateIndex]);
+        if (rebuild)
         {
             if (it != m_drawFluidSacMap.end()) delete it->second;
             DrawFluidSac *drawFluidSac = new DrawFluidSac();
             drawFluidSac->setFluidSac(iter.second.get());
+            drawFluidSac->setFluidSacState(&renderState->fluidSacList[stateIndex]);
             drawFluidSac->initialise(this);
             m_drawFluidSacMap[iter.first] = drawFluidSac;
             it = m_drawFluidSacMap.find(iter.first);
         }
+        stateIndex++;
         it->second->setVisible(iter.second->visible());
         it->second->Draw();
     }
 
+    drawInstanceBatches();
+
     m_drawables.clear();
     for (auto &&it : m_drawBodyMap) m_drawables.push_back(it.second);
     for (auto &&it : m_drawJointMap) m_drawables.push_back(it.second);
@@ -1269,6 +1336,16 @@ void SimulationWidget::setHalfTransparency(bool halfTransparency)
     m_halfTransparency = halfTransparency;
 }
 
+bool SimulationWidget::displayFrameTime() const
+{
+    return m_displayFrameTime;
+}
+
+void SimulationWidget::setDisplayFrameTime(bool displayFrameTime)
+{
+    m_displayFrameTime = displayFrameTime;
+}
+
 bool SimulationWidget::normals() const
 {
     return m_normals;
@@ -1345,6 +1422,19 @@ void SimulationWidget::setSimulation(Simulation *simulation)
     m_drawMarkerMap.clear();
     m_drawables.clear();
     m_simulation = simulation;
+    m_renderState = nullptr;
+    m_captureState.valid = false;
+    m_lastDrawnState = nullptr;
+}
+
+const RenderState *SimulationWidget::renderState() const
+{
+    return m_renderState;
+}
+
+void SimulationWidget::setRenderState(const RenderState *renderState)
+{
+    m_renderState = renderState;
 }
 
 bool SimulationWidget::wireFrame() const
@@ -1492,9 +1582,38 @@ QOpenGLShaderProgram *SimulationWidget::facetedObjectShader() const
     return m_facetedObjectShader;
 }
 
+QOpenGLShaderProgram *SimulationWidget::facetedObjectInstancedShader() const
+{
+    return m_facetedObjectInstancedShader;
+}
+
 QOpenGLShaderProgram *SimulationWidget::fixedColourObjectShader() const
 {
     return m_fixedColourObjectShader;
 }
 
+// called by FacetedObject::Draw whilst the model is being drawn
+// returns false if the object should be drawn immediately
+// transparent objects are not batched because that would change the drawing order
+bool SimulationWidget::queueInstance(FacetedObject *facetedObject)
+{
+    if (m_collectInstances == false || facetedObject->blendColour().alpha() != 255) return false;
+    auto key = std::make_tuple(facetedObject->instanceKey(), facetedObject->blendColour().rgba(), facetedObject->blendFraction(), facetedObject->decal());
+    m_instanceBatches[key].push_back(facetedObject);
+    return true;
+}
+
+// the vectors are cleared rather than erased so that they keep their memory for the next frame
+void SimulationWidget::drawInstanceBatches()
+{
+    m_collectInstances = false;
+    for (auto &&it : m_instanceBatches)
+    {
+        std::vector<FacetedObject *> &instances = it.second;
+        if (instances.size() == 1) instances[0]->Draw();
+        else if (instances.size() > 1) instances[0]->DrawInstances(instances, &m_instanceBuffer);
+        instances.clear();
+    }
+}
+
 
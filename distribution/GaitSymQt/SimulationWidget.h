@@ -4,6 +4,7 @@
 #include "PGDMath.h"
 #include "StrokeFont.h"
 #include "IntersectionHits.h"
+#include "RenderState.h"
 
 #include <QOpenGLWidget>
 #include <QElapsedTimer>
@@ -16,6 +17,7 @@
 
 #include <memory>
 #include <map>
+#include <tuple>
 
 class Simulation;
 class FacetedObject;
@@ -55,6 +57,10 @@ public:
     Simulation *simulation() const;
     void setSimulation(Simulation *simulation);
 
+    // when set the model is drawn from this state rather than from the simulation itself
+    const RenderState *renderState() const;
+    void setRenderState(const RenderState *renderState);
+
     bool wireFrame() const;
     void setWireFrame(bool wireFrame);
 
@@ -121,6 +127,9 @@ public:
     bool halfTransparency() const;
     void setHalfTransparency(bool halfTransparency);
 
+    bool displayFrameTime() const;
+    void setDisplayFrameTime(bool displayFrameTime);
+
     int WriteStillFrame(const QString &filename);
     int WriteMovieFrame();
     int WriteCADFrame(const QString &pathname);
@@ -149,7 +158,9 @@ public:
     void setMainWindow(MainWindow *mainWindow);
 
     QOpenGLShaderProgram *facetedObjectShader() const;
+    QOpenGLShaderProgram *facetedObjectInstancedShader() const;
     QOpenGLShaderProgram *fixedColourObjectShader() const;
+    bool queueInstance(FacetedObject *facetedObject);
     QMatrix4x4 proj() const;
     QMatrix4x4 view() const;
 
@@ -213,11 +224,22 @@ protected:
 private:
     void SetupLights();
     void drawModel();
+    void drawInstanceBatches();
     bool intersectModel(float winX, float winY);
 
     Simulation *m_simulation = nullptr;
     MainWindow *m_mainWindow = nullptr;
 
+    const RenderState *m_renderState = nullptr;
+    RenderState m_captureState;
+    const RenderState *m_lastDrawnState = nullptr;
+    uint64_t m_lastDrawnStepCount = 0;
+
+    bool m_displayFrameTime = false;
+    QElapsedTimer m_frameTimer;
+    double m_frameInterval = 0;
+    double m_drawTime = 0;
+
     bool m_wireFrame = false;
     bool m_boundingBox = false;
     bool m_boundingBoxBuffers = false;
@@ -288,7 +310,12 @@ private:
 
     QOpenGLVertexArrayObject m_vao;
     QOpenGLShaderProgram *m_facetedObjectShader = nullptr;
+    QOpenGLShaderProgram *m_facetedObjectInstancedShader = nullptr;
     QOpenGLShaderProgram *m_fixedColourObjectShader = nullptr;
+    QOpenGLBuffer m_instanceBuffer;
+    // batches are keyed by instance key, blend colour, blend fraction and decal
+    std::map<std::tuple<std::string, QRgb, double, double>, std::vector<FacetedObject *>> m_instanceBatches;
+    bool m_collectInstances = false;
     QMatrix4x4 m_proj;
     QMatrix4x4 m_view;
     QMatrix4x4 m_model;
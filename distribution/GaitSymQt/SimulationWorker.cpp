@@ -0,0 +1,174 @@
+/*
+ *  SimulationWorker.cpp
+ *  GaitSymODE2019
+ *
+ *  Thread that steps the simulation for the GUI and publishes what is
+ *  needed for drawing into a triple buffered RenderState
+ *
+ */
+
+#include "SimulationWorker.h"
+
+#include "Simulation.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+SimulationWorker::SimulationWorker(QObject *parent) : QThread(parent)
+{
+}
+
+SimulationWorker::~SimulationWorker()
+{
+    requestStop();
+    wait();
+}
+
+void SimulationWorker::setSimulation(Simulation *simulation)
+{
+    Q_ASSERT_X(!isRunning(), "SimulationWorker::setSimulation", "worker is running");
+    if (simulation != m_simulation)
+    {
+        QMutexLocker locker(&m_commandMutex);
+        m_pendingCommands.clear(); // these were meant for the old simulation
+    }
+    m_simulation = simulation;
+    m_renderBuffer.Reset();
+}
+
+void SimulationWorker::setStepCount(uint64_t stepCount)
+{
+    m_stepCount = stepCount;
+}
+
+void SimulationWorker::setFrameSkip(int frameSkip)
+{
+    m_frameSkip = std::max(frameSkip, 1);
+}
+
+void SimulationWorker::setRealTimeRatio(double realTimeRatio)
+{
+    m_realTimeRatio = realTimeRatio;
+}
+
+void SimulationWorker::setLockstep(bool lockstep)
+{
+    m_lockstep = lockstep;
+}
+
+void SimulationWorker::setSingleFrame(bool singleFrame)
+{
+    m_singleFrame = singleFrame;
+}
+
+uint64_t SimulationWorker::stepCount() const
+{
+    return m_stepCount;
+}
+
+SimulationWorker::StopReason SimulationWorker::stopReason() const
+{
+    return m_stopReason;
+}
+
+TripleBuffer<RenderState> *SimulationWorker::renderBuffer()
+{
+    return &m_renderBuffer;
+}
+
+void SimulationWorker::requestStop()
+{
+    m_stopRequested = true;
+    m_frameSemaphore.release(); // in case the worker is waiting for a lockstep frame
+}
+
+// called at the start of the frameReady handler so that any frame published after this point gets a new signal
+void SimulationWorker::acknowledgeFrame()
+{
+    m_framePending = false;
+}
+
+// called at the end of the frameReady handler to let a lockstep worker continue
+void SimulationWorker::releaseFrame()
+{
+    if (m_waitingForFrame.exchange(false)) m_frameSemaphore.release();
+}
+
+void SimulationWorker::postCommand(std::function<void(Simulation *)> command)
+{
+    QMutexLocker locker(&m_commandMutex);
+    m_pendingCommands.push_back(std::move(command));
+}
+
+void SimulationWorker::applyPendingCommands()
+{
+    std::vector<std::function<void(Simulation *)>> commands;
+    {
+        QMutexLocker locker(&m_commandMutex);
+        commands.swap(m_pendingCommands);
+    }
+    if (!m_simulation) return;
+    for (auto &&command : commands) command(m_simulation);
+}
+
+void SimulationWorker::run()
+{
+    if (!m_simulation) return;
+    m_stopRequested = false;
+    m_framePending = false;
+    m_waitingForFrame = false;
+    m_frameSemaphore.tryAcquire(m_frameSemaphore.available()); // discard any releases left over from the last run
+    m_stopReason = stopRequested;
+    applyPendingCommands();
+
+    if (m_simulation->ShouldQuit() || m_simulation->TestForCatastrophy())
+    {
+        m_stopReason = unableToStart;
+        return;
+    }
+
+    QElapsedTimer elapsedTimer;
+    elapsedTimer.start();
+    double startTime = m_simulation->GetTime();
+    while (!m_stopRequested)
+    {
+        applyPendingCommands();
+        m_simulation->UpdateSimulation();
+        m_stepCount++;
+
+        if (m_simulation->ShouldQuit()) m_stopReason = simulationEnded;
+        else if (m_simulation->TestForCatastrophy()) m_stopReason = simulationAborted;
+
+        if ((m_stepCount % uint64_t(m_frameSkip)) == 0 || m_stopReason != stopRequested)
+        {
+            publishFrame();
+            if (m_stopReason != stopRequested) break;
+            if (m_singleFrame)
+            {
+                m_stopReason = steppedToFrame;
+                break;
+            }
+            if (m_realTimeRatio > 0)
+            {
+                // throttling is only done once per frame since the sleep granularity is much coarser than a step
+                qint64 targetMilliseconds = qint64(1000.0 * (m_simulation->GetTime() - startTime) / m_realTimeRatio);
+                while (!m_stopRequested && elapsedTimer.elapsed() < targetMilliseconds)
+                    msleep(std::min(static_cast<unsigned long>(targetMilliseconds - elapsedTimer.elapsed()), 10ul));
+            }
+        }
+    }
+}
+
+void SimulationWorker::publishFrame()
+{
+    m_renderBuffer.Back()->Capture(m_simulation, m_stepCount);
+    m_renderBuffer.Publish();
+    // movie and OBJ sequence output need every frame so the worker waits for the GUI
+    // and this has to be flagged before the signal so that the handler knows to release it
+    bool lockstep = m_lockstep;
+    if (lockstep) m_waitingForFrame = true;
+    // only one signal is ever queued so a slow GUI just sees the most recent frame
+    if (m_framePending.exchange(true) == false) emit frameReady();
+    if (lockstep) m_frameSemaphore.acquire();
+}
@@ -0,0 +1,86 @@
+/*
+ *  SimulationWorker.h
+ *  GaitSymODE2019
+ *
+ *  Thread that steps the simulation for the GUI and publishes what is
+ *  needed for drawing into a triple buffered RenderState
+ *
+ */
+
+#ifndef SIMULATIONWORKER_H
+#define SIMULATIONWORKER_H
+
+#include "TripleBuffer.h"
+#include "RenderState.h"
+
+#include <QThread>
+#include <QSemaphore>
+#include <QMutex>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+class Simulation;
+
+class SimulationWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    SimulationWorker(QObject *parent = nullptr);
+    virtual ~SimulationWorker() Q_DECL_OVERRIDE;
+
+    enum StopReason { stopRequested, steppedToFrame, simulationEnded, simulationAborted, unableToStart };
+
+    // these must only be called when the thread is not running
+    void setSimulation(Simulation *simulation);
+    void setStepCount(uint64_t stepCount);
+    void setFrameSkip(int frameSkip);
+    void setRealTimeRatio(double realTimeRatio);
+    void setSingleFrame(bool singleFrame);
+
+    // in lockstep mode the worker waits for each frame to be handled before continuing
+    void setLockstep(bool lockstep);
+
+    uint64_t stepCount() const;
+    StopReason stopReason() const;
+    TripleBuffer<RenderState> *renderBuffer();
+
+    // called from the GUI thread
+    void requestStop();
+    void acknowledgeFrame();
+    void releaseFrame();
+
+    // anything that changes the simulation whilst the worker is running has to be queued
+    // and the worker applies it between steps
+    void postCommand(std::function<void(Simulation *)> command);
+    // this must only be called when the thread is not running
+    void applyPendingCommands();
+
+signals:
+    void frameReady();
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    void publishFrame();
+
+    Simulation *m_simulation = nullptr;
+    TripleBuffer<RenderState> m_renderBuffer;
+    QSemaphore m_frameSemaphore;
+    QMutex m_commandMutex;
+    std::vector<std::function<void(Simulation *)>> m_pendingCommands;
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<bool> m_framePending{false};
+    std::atomic<bool> m_waitingForFrame{false};
+    std::atomic<bool> m_lockstep{false};
+    std::atomic<uint64_t> m_stepCount{0};
+    StopReason m_stopReason = stopRequested;
+    int m_frameSkip = 1;
+    double m_realTimeRatio = 0;
+    bool m_singleFrame = false;
+};
+
+#endif // SIMULATIONWORKER_H
@@ -0,0 +1,217 @@
+/*
+ *  TriangleBVH.cpp
+ *  GaitSymODE2019
+ *
+ *  Bounding volume hierarchy over a packed triangle list built with the
+ *  binned surface area heuristic
+ *
+ */
+
+#include "TriangleBVH.h"
+
+#include <cfloat>
+#include <numeric>
+
+namespace
+{
+
+struct Bounds
+{
+    double lower[3] = {DBL_MAX, DBL_MAX, DBL_MAX};
+    double upper[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+
+    void Grow(const double *p)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            lower[i] = std::min(lower[i], p[i]);
+            upper[i] = std::max(upper[i], p[i]);
+        }
+    }
+    void Grow(const Bounds &b)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            lower[i] = std::min(lower[i], b.lower[i]);
+            upper[i] = std::max(upper[i], b.upper[i]);
+        }
+    }
+    double HalfArea() const
+    {
+        if (lower[0] > upper[0]) return 0;
+        double dx = upper[0] - lower[0], dy = upper[1] - lower[1], dz = upper[2] - lower[2];
+        return dx * dy + dy * dz + dz * dx;
+    }
+};
+
+struct BuildTask
+{
+    uint32_t first;
+    uint32_t count;
+    uint32_t parent;
+    uint32_t depth;
+    bool isRight;
+};
+
+// the node bounds are stored as floats so they are rounded outwards to stay conservative
+float RoundDown(double v)
+{
+    float f = float(v);
+    if (double(f) > v) f = std::nextafter(f, -FLT_MAX);
+    return f;
+}
+
+float RoundUp(double v)
+{
+    float f = float(v);
+    if (double(f) < v) f = std::nextafter(f, FLT_MAX);
+    return f;
+}
+
+}
+
+TriangleBVH::TriangleBVH()
+{
+}
+
+void TriangleBVH::Build(const double *vertexList, size_t numTriangles)
+{
+    const uint32_t maxLeafSize = 4; // always a leaf at or below this
+    const uint32_t maxSAHLeafSize = 16; // above this a median split is used if the SAH does not find a useful split
+    const uint32_t maxDepth = 60; // must be less than the traversal stack size
+    const int numBins = 16;
+    const double traversalCost = 1.0; // relative to a triangle test
+
+    m_nodes.clear();
+    m_triangleIndex.clear();
+    m_built = true;
+    if (numTriangles == 0) return;
+
+    std::vector<Bounds> triangleBounds(numTriangles);
+    std::vector<double> centroids(numTriangles * 3);
+    for (size_t i = 0; i < numTriangles; i++)
+    {
+        const double *triangle = vertexList + i * 9;
+        for (int j = 0; j < 3; j++) triangleBounds[i].Grow(triangle + j * 3);
+        for (int j = 0; j < 3; j++) centroids[i * 3 + size_t(j)] = (triangle[j] + triangle[j + 3] + triangle[j + 6]) / 3;
+    }
+    m_triangleIndex.resize(numTriangles);
+    std::iota(m_triangleIndex.begin(), m_triangleIndex.end(), 0);
+    m_nodes.reserve(numTriangles * 2);
+
+    // depth first so that a left child is always created straight after its parent
+    std::vector<BuildTask> tasks;
+    tasks.push_back({0, uint32_t(numTriangles), 0, 0, false});
+    while (tasks.size())
+    {
+        BuildTask task = tasks.back();
+        tasks.pop_back();
+        uint32_t nodeIndex = uint32_t(m_nodes.size());
+        m_nodes.push_back(Node());
+        if (task.isRight) m_nodes[task.parent].first = nodeIndex;
+
+        Bounds bounds, centroidBounds;
+        for (uint32_t i = task.first; i < task.first + task.count; i++)
+        {
+            bounds.Grow(triangleBounds[m_triangleIndex[i]]);
+            centroidBounds.Grow(&centroids[m_triangleIndex[i] * 3]);
+        }
+        Node &node = m_nodes[nodeIndex];
+        for (int i = 0; i < 3; i++)
+        {
+            node.lowerBound[i] = RoundDown(bounds.lower[i]);
+            node.upperBound[i] = RoundUp(bounds.upper[i]);
+        }
+        node.first = task.first;
+        node.count = task.count;
+        if (task.count <= maxLeafSize || task.depth >= maxDepth) continue;
+
+        // find the cheapest binned split over all three axes
+        double bestCost = double(task.count);
+        int bestAxis = -1;
+        int bestSplit = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            double extent = centroidBounds.upper[axis] - centroidBounds.lower[axis];
+            if (extent <= 0) continue;
+            double scale = numBins / extent;
+            Bounds binBounds[numBins];
+            uint32_t binCounts[numBins] = {};
+            for (uint32_t i = task.first; i < task.first + task.count; i++)
+            {
+                uint32_t triangle = m_triangleIndex[i];
+                int bin = std::min(numBins - 1, int((centroids[triangle * 3 + uint32_t(axis)] - centroidBounds.lower[axis]) * scale));
+                binCounts[bin]++;
+                binBounds[bin].Grow(triangleBounds[triangle]);
+            }
+            // sweep from the right to get the area and count to the right of each split plane
+            double rightArea[numBins];
+            uint32_t rightCount[numBins];
+            Bounds accumulated;
+            uint32_t count = 0;
+            for (int bin = numBins - 1; bin > 0; bin--)
+            {
+                accumulated.Grow(binBounds[bin]);
+                count += binCounts[bin];
+                rightArea[bin] = accumulated.HalfArea();
+                rightCount[bin] = count;
+            }
+            accumulated = Bounds();
+            count = 0;
+            double parentArea = bounds.HalfArea();
+            for (int split = 1; split < numBins; split++)
+            {
+                accumulated.Grow(binBounds[split - 1]);
+                count += binCounts[split - 1];
+                if (count == 0 || rightCount[split] == 0) continue;
+                double cost = traversalCost + (accumulated.HalfArea() * count + rightArea[split] * rightCount[split]) / parentArea;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        uint32_t *first = m_triangleIndex.data() + task.first;
+        uint32_t *last = first + task.count;
+        uint32_t *middle;
+        if (bestAxis >= 0)
+        {
+            double lower = centroidBounds.lower[bestAxis];
+            double scale = numBins / (centroidBounds.upper[bestAxis] - lower);
+            middle = std::partition(first, last, [&](uint32_t triangle)
+            {
+                return std::min(numBins - 1, int((centroids[triangle * 3 + uint32_t(bestAxis)] - lower) * scale)) < bestSplit;
+            });
+        }
+        else
+        {
+            if (task.count <= maxSAHLeafSize) continue;
+            int axis = 0;
+            for (int i = 1; i < 3; i++)
+                if (centroidBounds.upper[i] - centroidBounds.lower[i] > centroidBounds.upper[axis] - centroidBounds.lower[axis]) axis = i;
+            if (centroidBounds.upper[axis] <= centroidBounds.lower[axis]) continue; // all the centroids are in the same place
+            middle = first + task.count / 2;
+            std::nth_element(first, middle, last, [&](uint32_t a, uint32_t b) { return centroids[a * 3 + uint32_t(axis)] < centroids[b * 3 + uint32_t(axis)]; });
+        }
+
+        uint32_t leftCount = uint32_t(middle - first);
+        node.count = 0;
+        // pushed in reverse so the left child is built next
+        tasks.push_back({task.first + leftCount, task.count - leftCount, nodeIndex, task.depth + 1, true});
+        tasks.push_back({task.first, leftCount, nodeIndex, task.depth + 1, false});
+    }
+    m_nodes.shrink_to_fit();
+}
+
+bool TriangleBVH::built() const
+{
+    return m_built;
+}
+
+size_t TriangleBVH::memoryUsage() const
+{
+    return m_nodes.capacity() * sizeof(Node) + m_triangleIndex.capacity() * sizeof(uint32_t) + sizeof(TriangleBVH);
+}
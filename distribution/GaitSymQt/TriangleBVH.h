@@ -0,0 +1,110 @@
+/*
+ *  TriangleBVH.h
+ *  GaitSymODE2019
+ *
+ *  Bounding volume hierarchy over a packed triangle list (9 doubles per
+ *  triangle) built with the binned surface area heuristic. It is used to
+ *  find the triangles a pick ray might hit without testing all of them.
+ *
+ */
+
+#ifndef TRIANGLEBVH_H
+#define TRIANGLEBVH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+class TriangleBVH
+{
+public:
+    TriangleBVH();
+
+    void Build(const double *vertexList, size_t numTriangles);
+    bool built() const;
+    size_t memoryUsage() const;
+
+    // calls test(triangleIndex) for every triangle in a leaf whose box the ray passes through
+    // near boxes are visited before far ones and test can return false to stop the traversal
+    template <typename TriangleTest> void Traverse(const double rayOrigin[3], const double rayVector[3], TriangleTest test) const;
+
+private:
+    // 32 bytes so two nodes fit in a cache line
+    // leaves have count > 0 and their triangles start at m_triangleIndex[first]
+    // inner nodes have count == 0, the left child immediately follows the node and the right child is at first
+    struct Node
+    {
+        float lowerBound[3];
+        uint32_t first;
+        float upperBound[3];
+        uint32_t count;
+    };
+
+    static bool HitNode(const Node &node, const double rayOrigin[3], const double inverseVector[3], double *tNear);
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_triangleIndex;
+    bool m_built = false;
+};
+
+// slab test with the inverse direction precalculated
+// fmin and fmax drop the NaN produced when the origin lies on a slab of an axis parallel ray
+inline bool TriangleBVH::HitNode(const Node &node, const double rayOrigin[3], const double inverseVector[3], double *tNear)
+{
+    double tMin = 0;
+    double tMax = HUGE_VAL;
+    for (int i = 0; i < 3; i++)
+    {
+        double t1 = (double(node.lowerBound[i]) - rayOrigin[i]) * inverseVector[i];
+        double t2 = (double(node.upperBound[i]) - rayOrigin[i]) * inverseVector[i];
+        tMin = std::fmax(tMin, std::fmin(t1, t2));
+        tMax = std::fmin(tMax, std::fmax(t1, t2));
+    }
+    *tNear = tMin;
+    return tMin <= tMax;
+}
+
+template <typename TriangleTest> void TriangleBVH::Traverse(const double rayOrigin[3], const double rayVector[3], TriangleTest test) const
+{
+    if (m_nodes.size() == 0) return;
+    double inverseVector[3] = {1.0 / rayVector[0], 1.0 / rayVector[1], 1.0 / rayVector[2]};
+    double tNear, tLeft, tRight;
+    if (!HitNode(m_nodes[0], rayOrigin, inverseVector, &tNear)) return;
+
+    uint32_t stack[64];
+    size_t stackSize = 0;
+    uint32_t nodeIndex = 0;
+    while (true)
+    {
+        const Node &node = m_nodes[nodeIndex];
+        if (node.count)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                if (!test(size_t(m_triangleIndex[i]))) return;
+            }
+        }
+        else
+        {
+            uint32_t left = nodeIndex + 1;
+            uint32_t right = node.first;
+            bool hitLeft = HitNode(m_nodes[left], rayOrigin, inverseVector, &tLeft);
+            bool hitRight = HitNode(m_nodes[right], rayOrigin, inverseVector, &tRight);
+            if (hitLeft && hitRight)
+            {
+                if (tRight < tLeft) std::swap(left, right);
+                stack[stackSize++] = right;
+                nodeIndex = left;
+                continue;
+            }
+            if (hitLeft) { nodeIndex = left; continue; }
+            if (hitRight) { nodeIndex = right; continue; }
+        }
+        if (stackSize == 0) return;
+        nodeIndex = stack[--stackSize];
+    }
+}
+
+#endif // TRIANGLEBVH_H
@@ -0,0 +1,58 @@
+/*
+ *  TripleBuffer.h
+ *  GaitSymODE2019
+ *
+ *  Lock free single producer single consumer triple buffer. The producer
+ *  always has a buffer to write into and the consumer always has a complete
+ *  buffer to read so neither ever waits for the other. Intermediate buffers
+ *  are dropped if the producer is faster than the consumer.
+ *
+ */
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+template <typename T> class TripleBuffer
+{
+public:
+    TripleBuffer() {}
+
+    // producer side: fill Back() then call Publish()
+    T *Back() { return &m_buffers[m_backIndex]; }
+    void Publish()
+    {
+        int previous = m_middle.exchange(m_backIndex | m_dirtyBit, std::memory_order_acq_rel);
+        m_backIndex = previous & m_indexMask;
+    }
+
+    // consumer side: Consume() returns true if Front() now holds a newer buffer
+    bool Consume()
+    {
+        if ((m_middle.load(std::memory_order_acquire) & m_dirtyBit) == 0) return false;
+        int previous = m_middle.exchange(m_frontIndex, std::memory_order_acq_rel);
+        m_frontIndex = previous & m_indexMask;
+        return true;
+    }
+    const T *Front() const { return &m_buffers[m_frontIndex]; }
+
+    // only safe when neither side is active
+    void Reset()
+    {
+        m_backIndex = 0;
+        m_frontIndex = 1;
+        m_middle.store(2, std::memory_order_release);
+    }
+
+private:
+    static const int m_dirtyBit = 4;
+    static const int m_indexMask = 3;
+
+    T m_buffers[3];
+    int m_backIndex = 0; // only touched by the producer
+    int m_frontIndex = 1; // only touched by the consumer
+    std::atomic<int> m_middle{2}; // the buffer in transit plus the dirty bit
+};
+
+#endif // TRIPLEBUFFER_H
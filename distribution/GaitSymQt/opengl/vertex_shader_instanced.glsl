@@ -0,0 +1,43 @@
+#version 330 core
+
+// same as vertex_shader.glsl except that the model matrix comes from a per instance attribute
+
+uniform highp mat4 viewMatrix;
+uniform highp mat4 projMatrix;
+
+uniform highp vec4 lightPosition;
+
+uniform highp float decal;
+
+in highp vec4 vertex;
+in highp vec3 vertexNormal;
+in highp vec4 vertexColour;
+in highp vec2 vertexUV;
+in highp mat4 instanceModel;
+
+out highp vec3 normalFrag;
+out highp vec3 eyeFrag;
+out highp vec3 lightDirFrag;
+out highp vec4 colourFrag;
+out highp vec2 uvFrag;
+
+void main ()
+{
+    mat4 mvMatrix = viewMatrix * instanceModel;
+    mat3 normalMatrix = transpose(inverse(mat3(mvMatrix)));
+    vec4 pos = mvMatrix * vertex;
+
+    // this is part 1 of a generic Phong shading model shader
+    normalFrag = normalize(normalMatrix * vertexNormal);
+    lightDirFrag = vec3(lightPosition - pos);
+    eyeFrag = vec3(-pos);
+    colourFrag = vertexColour;
+    // end of Phong section
+
+    // see vertex_shader.glsl for the decal offset
+    vec4 preDecalPos = projMatrix * pos;
+    preDecalPos.z -= decal * 4.768371584e-07;
+    gl_Position = preDecalPos;
+
+    uvFrag = vertexUV;
+}
@@ -0,0 +1,93 @@
+/*
+ *  CollisionBenchmark.cpp
+ *  GaitSym2019
+ *
+ *  Times the collision detection phase of the simulation step on its own.
+ *  The model is run for a number of settling steps first so that it is in a
+ *  contact heavy configuration (e.g. the quadrupedal chimpanzee with both hands
+ *  and feet on the ground) and then Simulation::UpdateContacts is called
+ *  repeatedly without stepping the world
+ *
+ *  e.g. bin/gaitsym_collision_benchmark ../models/chimpanzee_model/*.xml
+ *
+ */
+
+#include "Simulation.h"
+#include "DataFile.h"
+#include "GSUtil.h"
+#include "ArgParse.h"
+#include "Geom.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+
+#define MAX_ARGS 4096
+
+using namespace std::string_literals;
+
+int main(int argc, const char **argv)
+{
+    ArgParse argparse;
+    argparse.Initialise(argc, argv, "Benchmark of the collision detection phase. Usage: gaitsym_collision_benchmark [options] model.xml [model.xml ...]"s, MAX_ARGS, 1);
+    argparse.AddArgument("-ss"s, "--settlingSteps"s, "Number of steps to run before timing"s, "1000"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-nc"s, "--numberOfCalls"s, "Number of collision detection calls to time"s, "100000"s, 1, false, ArgParse::Int);
+    if (argparse.Parse())
+    {
+        argparse.Usage();
+        return 1;
+    }
+    int settlingSteps = 1000;
+    int numberOfCalls = 100000;
+    std::vector<std::string> modelList;
+    argparse.Get("--settlingSteps"s, &settlingSteps);
+    argparse.Get("--numberOfCalls"s, &numberOfCalls);
+    argparse.Get(&modelList);
+    if (numberOfCalls < 1) numberOfCalls = 1;
+
+    int failures = 0;
+    for (auto &&model : modelList)
+    {
+        DataFile myFile;
+        if (myFile.ReadFile(model))
+        {
+            std::cerr << "Error reading \"" << model << "\"\n";
+            failures++;
+            continue;
+        }
+        std::unique_ptr<Simulation> simulation = std::make_unique<Simulation>();
+        std::string *errorMessage = simulation->LoadModel(myFile.GetRawData(), myFile.GetSize());
+        if (errorMessage)
+        {
+            std::cerr << "Error loading \"" << model << "\"\n" << *errorMessage << "\n";
+            failures++;
+            continue;
+        }
+
+        for (int i = 0; i < settlingSteps; i++)
+        {
+            if (simulation->ShouldQuit() || simulation->TestForCatastrophy()) break;
+            simulation->UpdateSimulation();
+        }
+
+        size_t contactGeoms = 0;
+        for (auto &&it : *simulation->GetGeomList()) if (it.second->GetGeomLocation() != Geom::environment) contactGeoms++;
+
+        double startTime = GSUtil::GetTime();
+        size_t totalContacts = 0;
+        for (int i = 0; i < numberOfCalls; i++)
+        {
+            simulation->UpdateContacts();
+            totalContacts += simulation->GetContactList()->size();
+        }
+        double collisionTime = GSUtil::GetTime() - startTime;
+
+        std::cout << "Model: " << model << "\n";
+        std::cout << "Simulation time: " << simulation->GetTime() << " Non-environment geoms: " << contactGeoms << "\n";
+        std::cout << "Contacts per call: " << double(totalContacts) / numberOfCalls << "\n";
+        std::cout << "Collision detection time: " << collisionTime / numberOfCalls * 1e6 << " us per call\n\n";
+    }
+
+    return failures;
+}
@@ -0,0 +1,194 @@
+/*
+ *  GaitSymBenchmark.cpp
+ *  GaitSym2019
+ *
+ *  Reproducible whole simulation benchmark (make gaitsym_bench)
+ *  Each model is run for a fixed number of steps with both the World and the Quick
+ *  step types and the program reports the steps per second, the cost of each muscle
+ *  update and of each contact, the number of heap allocations per step, and a hash
+ *  of the final state so that an optimisation can be checked for bit exactness
+ *  With no model arguments it runs the bundled chimpanzee and human models
+ *
+ *  e.g. bin/gaitsym_bench
+ *       bin/gaitsym_bench -ns 100000 ../models/human_model/*.xml
+ *
+ */
+
+#include "Simulation.h"
+#include "StepProfiler.h"
+#include "DataFile.h"
+#include "GSUtil.h"
+#include "ArgParse.h"
+#include "Global.h"
+#include "Body.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+
+#define MAX_ARGS 4096
+
+using namespace std::string_literals;
+
+// every operator new in the program is counted (ODE uses its own allocator so it is not included)
+static std::atomic<uint64_t> gAllocationCount(0);
+
+void *operator new(std::size_t size)
+{
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t /* size */) noexcept
+{
+    std::free(ptr);
+}
+
+// 64 bit FNV-1a hash of the dynamic state of all the bodies and the energy totals
+static uint64_t StateHash(Simulation *simulation)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    auto add = [&hash](const double *values, size_t n)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(values);
+        for (size_t i = 0; i < n * sizeof(double); i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3;
+        }
+    };
+    for (auto &&it : *simulation->GetBodyList())
+    {
+        dBodyID bodyID = it.second->GetBodyID();
+        add(dBodyGetPosition(bodyID), 3);
+        add(dBodyGetQuaternion(bodyID), 4);
+        add(dBodyGetLinearVel(bodyID), 3);
+        add(dBodyGetAngularVel(bodyID), 3);
+    }
+    double values[3] = {simulation->GetTime(), simulation->GetMechanicalEnergy(), simulation->GetMetabolicEnergy()};
+    add(values, 3);
+    return hash;
+}
+
+static std::unique_ptr<Simulation> LoadSimulation(DataFile *file, const std::string &model, Global::StepType stepType, int numberOfThreads)
+{
+    // the quick step solver reorders the constraints using the ODE random number generator
+    // so the seed is reset to make every run of the same model identical
+    dRandSetSeed(0);
+    std::unique_ptr<Simulation> simulation = std::make_unique<Simulation>();
+    std::string *errorMessage = simulation->LoadModel(file->GetRawData(), file->GetSize());
+    if (errorMessage)
+    {
+        std::cerr << "Error loading \"" << model << "\"\n" << *errorMessage << "\n";
+        return nullptr;
+    }
+    simulation->GetGlobal()->setStepType(stepType);
+    if (numberOfThreads > 1) simulation->SetNumberOfThreads(size_t(numberOfThreads));
+    return simulation;
+}
+
+int main(int argc, const char **argv)
+{
+    ArgParse argparse;
+    argparse.Initialise(argc, argv, "Whole simulation benchmark. Usage: gaitsym_bench [options] [model.xml ...]"s, MAX_ARGS, 0);
+    argparse.AddArgument("-ns"s, "--numberOfSteps"s, "Number of steps to run for each model and step type"s, "10000"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-nt"s, "--numberOfThreads"s, "Number of threads used within each simulation step"s, "1"s, 1, false, ArgParse::Int);
+    if (argparse.Parse())
+    {
+        argparse.Usage();
+        return 1;
+    }
+    int numberOfSteps = 10000;
+    int numberOfThreads = 1;
+    std::vector<std::string> modelList;
+    argparse.Get("--numberOfSteps"s, &numberOfSteps);
+    argparse.Get("--numberOfThreads"s, &numberOfThreads);
+    argparse.Get(&modelList);
+    if (numberOfSteps < 1) numberOfSteps = 1;
+    if (modelList.size() == 0)
+    {
+        modelList.push_back("../models/chimpanzee_model/PosableQuadrupedalChimpComplete_SlackAtStartPosition_2019_World_AP_converted_output.xml"s);
+        modelList.push_back("../models/human_model/BestGenome_000000990256_world_foot_rotated_edit_gaitsym2019_v2_output.xml"s);
+    }
+
+    int failures = 0;
+    for (auto &&model : modelList)
+    {
+        DataFile myFile;
+        if (myFile.ReadFile(model))
+        {
+            std::cerr << "Error reading \"" << model << "\"\n";
+            failures++;
+            continue;
+        }
+
+        std::cout << "Model: " << model << "\n";
+        for (size_t stepTypeIndex = 0; stepTypeIndex < Global::stepTypeCount; stepTypeIndex++)
+        {
+            Global::StepType stepType = Global::StepType(stepTypeIndex);
+
+            // timed run with nothing else attached
+            std::unique_ptr<Simulation> simulation = LoadSimulation(&myFile, model, stepType, numberOfThreads);
+            if (!simulation)
+            {
+                failures++;
+                break;
+            }
+            uint64_t startAllocations = gAllocationCount.load();
+            double startTime = GSUtil::GetTime();
+            int stepsRun = 0;
+            for (; stepsRun < numberOfSteps; stepsRun++)
+            {
+                if (simulation->ShouldQuit() || simulation->TestForCatastrophy()) break;
+                simulation->UpdateSimulation();
+            }
+            double runTime = GSUtil::GetTime() - startTime;
+            uint64_t allocations = gAllocationCount.load() - startAllocations;
+            uint64_t stateHash = StateHash(simulation.get());
+            size_t numberOfMuscles = simulation->GetMuscleList()->size();
+
+            // second run with the step profiler attached for the per muscle and per contact costs
+            simulation = LoadSimulation(&myFile, model, stepType, numberOfThreads);
+            StepProfiler profiler;
+            simulation->SetStepProfiler(&profiler);
+            uint64_t totalContacts = 0;
+            for (int i = 0; i < stepsRun; i++)
+            {
+                if (simulation->ShouldQuit() || simulation->TestForCatastrophy()) break;
+                simulation->UpdateSimulation();
+                totalContacts += simulation->GetContactList()->size();
+            }
+            if (StateHash(simulation.get()) != stateHash)
+            {
+                std::cerr << "Error: profiled run of \"" << model << "\" does not match the timed run\n";
+                failures++;
+            }
+            double muscleTime = profiler.phaseTime(StepProfiler::Muscles);
+            double collisionTime = profiler.phaseTime(StepProfiler::Collisions);
+
+            std::cout << "Step type: " << Global::stepTypeStrings(stepType) << " Steps: " << stepsRun << " Muscles: " << numberOfMuscles << " Contacts per step: " << double(totalContacts) / std::max(stepsRun, 1) << "\n";
+            std::cout << "Steps per second: " << stepsRun / runTime << "\n";
+            std::cout << "ns per muscle update: " << (numberOfMuscles && stepsRun ? muscleTime / (double(numberOfMuscles) * stepsRun) * 1e9 : 0) << "\n";
+            std::cout << "ns per contact: " << (totalContacts ? collisionTime / double(totalContacts) * 1e9 : 0) << "\n";
+            std::cout << "Allocations: " << allocations << " (" << double(allocations) / std::max(stepsRun, 1) << " per step)\n";
+            std::cout << "State hash: " << std::hex << std::setw(16) << std::setfill('0') << stateHash << std::dec << std::setfill(' ') << "\n";
+        }
+        std::cout << "\n";
+    }
+
+    return failures;
+}
@@ -0,0 +1,166 @@
+/*
+ *  SnapshotBenchmark.cpp
+ *  GaitSym2019
+ *
+ *  Compares the time taken to construct a simulation from its XML file with the
+ *  time taken to reset it using Simulation::RestoreSnapshot, and checks that a
+ *  restored simulation runs identically to a freshly loaded one and that a
+ *  damaged snapshot is rejected
+ *
+ *  e.g. bin/gaitsym_snapshot_benchmark ../models/chimpanzee_model/*.xml ../models/human_model/*.xml
+ *
+ */
+
+#include "Simulation.h"
+#include "StateBuffer.h"
+#include "DataFile.h"
+#include "GSUtil.h"
+#include "ArgParse.h"
+#include "Body.h"
+#include "Muscle.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+
+#define MAX_ARGS 4096
+
+using namespace std::string_literals;
+
+static std::vector<double> BodyState(Simulation *simulation)
+{
+    std::vector<double> state;
+    for (auto &&it : *simulation->GetBodyList())
+    {
+        dBodyID bodyID = it.second->GetBodyID();
+        state.insert(state.end(), dBodyGetPosition(bodyID), dBodyGetPosition(bodyID) + 3);
+        state.insert(state.end(), dBodyGetQuaternion(bodyID), dBodyGetQuaternion(bodyID) + 4);
+        state.insert(state.end(), dBodyGetLinearVel(bodyID), dBodyGetLinearVel(bodyID) + 3);
+        state.insert(state.end(), dBodyGetAngularVel(bodyID), dBodyGetAngularVel(bodyID) + 3);
+    }
+    state.push_back(simulation->GetMechanicalEnergy());
+    state.push_back(simulation->GetMetabolicEnergy());
+    state.push_back(simulation->CalculateInstantaneousFitness());
+    return state;
+}
+
+static void RunSteps(Simulation *simulation, int numberOfSteps)
+{
+    for (int i = 0; i < numberOfSteps; i++)
+    {
+        if (simulation->ShouldQuit() || simulation->TestForCatastrophy()) break;
+        simulation->UpdateSimulation();
+    }
+}
+
+int main(int argc, const char **argv)
+{
+    ArgParse argparse;
+    argparse.Initialise(argc, argv, "Benchmark of model construction against snapshot restore. Usage: gaitsym_snapshot_benchmark [options] model.xml [model.xml ...]"s, MAX_ARGS, 1);
+    argparse.AddArgument("-ns"s, "--numberOfSteps"s, "Number of steps to run between restores"s, "1000"s, 1, false, ArgParse::Int);
+    argparse.AddArgument("-nr"s, "--numberOfRepeats"s, "Number of times each measurement is repeated"s, "10"s, 1, false, ArgParse::Int);
+    if (argparse.Parse())
+    {
+        argparse.Usage();
+        return 1;
+    }
+    int numberOfSteps = 1000;
+    int numberOfRepeats = 10;
+    std::vector<std::string> modelList;
+    argparse.Get("--numberOfSteps"s, &numberOfSteps);
+    argparse.Get("--numberOfRepeats"s, &numberOfRepeats);
+    argparse.Get(&modelList);
+    if (numberOfRepeats < 1) numberOfRepeats = 1;
+
+    int failures = 0;
+    for (auto &&model : modelList)
+    {
+        DataFile myFile;
+        if (myFile.ReadFile(model))
+        {
+            std::cerr << "Error reading \"" << model << "\"\n";
+            failures++;
+            continue;
+        }
+
+        // construction time
+        std::unique_ptr<Simulation> simulation;
+        double constructionTime = 0;
+        bool loadError = false;
+        for (int i = 0; i < numberOfRepeats; i++)
+        {
+            simulation.reset();
+            double startTime = GSUtil::GetTime();
+            simulation = std::make_unique<Simulation>();
+            std::string *errorMessage = simulation->LoadModel(myFile.GetRawData(), myFile.GetSize());
+            constructionTime += GSUtil::GetTime() - startTime;
+            if (errorMessage)
+            {
+                std::cerr << "Error loading \"" << model << "\"\n" << *errorMessage << "\n";
+                loadError = true;
+                break;
+            }
+        }
+        if (loadError)
+        {
+            failures++;
+            continue;
+        }
+        constructionTime /= numberOfRepeats;
+
+        // reference run from a freshly loaded model
+        StateBuffer snapshot;
+        double startTime = GSUtil::GetTime();
+        simulation->SaveSnapshot(&snapshot);
+        double snapshotTime = GSUtil::GetTime() - startTime;
+        RunSteps(simulation.get(), numberOfSteps);
+        std::vector<double> referenceState = BodyState(simulation.get());
+
+        // restore time and check that the restored runs match
+        double restoreTime = 0;
+        bool identical = true;
+        for (int i = 0; i < numberOfRepeats; i++)
+        {
+            startTime = GSUtil::GetTime();
+            std::string *errorMessage = simulation->RestoreSnapshot(&snapshot);
+            restoreTime += GSUtil::GetTime() - startTime;
+            if (errorMessage)
+            {
+                std::cerr << "Error restoring \"" << model << "\"\n" << *errorMessage << "\n";
+                identical = false;
+                break;
+            }
+            RunSteps(simulation.get(), numberOfSteps);
+            if (BodyState(simulation.get()) != referenceState) identical = false;
+        }
+        restoreTime /= numberOfRepeats;
+        if (identical == false) failures++;
+
+        // a damaged snapshot must be rejected without changing the simulation
+        // damage to the payload is only found by the MD5 so that case restores with validation switched on
+        bool rejected = true;
+        std::vector<double> currentState = BodyState(simulation.get());
+        StateBuffer damaged = snapshot;
+        char lastByte;
+        std::memcpy(&lastByte, snapshot.data() + snapshot.size() - 1, 1);
+        damaged.Overwrite(snapshot.size() - 1, char(~lastByte));
+        if (simulation->RestoreSnapshot(&damaged, true) == nullptr || BodyState(simulation.get()) != currentState) rejected = false;
+        damaged = snapshot;
+        damaged.Overwrite(2 * sizeof(uint32_t), uint64_t(snapshot.size() + 1));
+        if (simulation->RestoreSnapshot(&damaged) == nullptr || BodyState(simulation.get()) != currentState) rejected = false;
+        if (rejected == false) failures++;
+
+        std::cout << "Model: " << model << "\n";
+        std::cout << "Bodies: " << simulation->GetBodyList()->size() << " Muscles: " << simulation->GetMuscleList()->size() << " Snapshot size: " << snapshot.size() << " bytes\n";
+        std::cout << "Construction time: " << constructionTime * 1e3 << " ms\n";
+        std::cout << "Snapshot time: " << snapshotTime * 1e6 << " us\n";
+        std::cout << "Restore time: " << restoreTime * 1e6 << " us\n";
+        std::cout << "Speedup: " << constructionTime / restoreTime << "\n";
+        std::cout << "Restored runs of " << numberOfSteps << " steps: " << (identical ? "identical" : "DIFFERENT") << "\n";
+        std::cout << "Damaged snapshots: " << (rejected ? "rejected" : "ACCEPTED") << "\n\n";
+    }
+
+    return failures;
+}
@@ -30,7 +30,12 @@
 //****************************************************************************
 // random numbers
 
+#if dTHREADING_INTF_DISABLED
+// without the threading interface each thread gets its own generator so that independent worlds can be stepped concurrently
+static thread_local duint32 seed = 0;
+#else
 static volatile duint32 seed = 0;
+#endif
 
 unsigned long dRand()
 {
@@ -176,9 +176,30 @@ dxWorldProcessContext *dxWorld::UnsafeGetWorldProcessingContext() const
     return wmem->GetWorldProcessingContext();
 }
 
+// GaitSym2019 steps several worlds at once in different threads and the self-threaded implementation
+// is not thread safe so each thread gets its own default implementation the first time it steps a world
+struct dxThreadDefaultThreading
+{
+    dThreadingImplementationID impl = NULL;
+    const dThreadingFunctionsInfo *functions = NULL;
+    ~dxThreadDefaultThreading() { if (impl != NULL) dThreadingFreeImplementation(impl); }
+};
+static thread_local dxThreadDefaultThreading g_thread_default_threading;
+
 const dxThreadingFunctionsInfo *dxWorld::RetrieveThreadingDefaultImpl(dThreadingImplementationID &out_default_impl)
 {
-    out_default_impl = g_world_default_threading_impl;
-    return g_world_default_threading_functions;
+    if (g_thread_default_threading.impl == NULL)
+    {
+        dThreadingImplementationID threading_impl = dThreadingAllocateSelfThreadedImplementation();
+        if (threading_impl == NULL)
+        {
+            out_default_impl = g_world_default_threading_impl;
+            return g_world_default_threading_functions;
+        }
+        g_thread_default_threading.functions = dThreadingImplementationGetFunctions(threading_impl);
+        g_thread_default_threading.impl = threading_impl;
+    }
+    out_default_impl = g_thread_default_threading.impl;
+    return g_thread_default_threading.functions;
 }
 
@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import sys
+import os
+import argparse
+import re
+import struct
+
+def convert_binary_dump():
+
+    parser = argparse.ArgumentParser(description="Convert a GaitSym binary dump file (gaitsym_2019 --binaryDump) into the individual tab delimited dump files")
+    parser.add_argument("-i", "--input_dump_file", required=True, help="the input binary dump file")
+    parser.add_argument("-o", "--output_folder", required=False, default=".", help="the folder for the output files [.]")
+    parser.add_argument("-e", "--extension", required=False, default=".tab", help="the extension added to each object name [.tab]")
+    parser.add_argument("-l", "--object_list", nargs="+", default=[], help="only convert these objects")
+    parser.add_argument("-f", "--force", action="store_true", help="force overwrite of destination files")
+    parser.add_argument("-v", "--verbose", action="store_true", help="write out more information whilst processing")
+    args = parser.parse_args()
+
+    if args.verbose:
+        pretty_print_sys_argv(sys.argv)
+        pretty_print_argparse_args(args)
+
+    # preflight
+    if not os.path.exists(args.input_dump_file):
+        print("Error: \"%s\" missing" % (args.input_dump_file))
+        sys.exit(1)
+    if not os.path.isdir(args.output_folder):
+        print("Error: \"%s\" is not a folder" % (args.output_folder))
+        sys.exit(1)
+
+    with open(args.input_dump_file, "rb") as f_in:
+        (objects, record_size, byte_order) = read_header(f_in, args.input_dump_file)
+        if args.object_list:
+            selected = [o for o in objects if o[0] in args.object_list]
+        else:
+            selected = objects
+        output_files = []
+        for (name, column_names, offset) in selected:
+            output_file = os.path.join(args.output_folder, name + args.extension)
+            if os.path.exists(output_file) and not args.force:
+                print("Error: \"%s\" exists. Use --force to overwrite" % (output_file))
+                sys.exit(1)
+            if args.verbose:
+                print("Writing \"%s\" %d columns" % (output_file, len(column_names)))
+            f_out = open(output_file, "w", newline="\n")
+            f_out.write("\t".join(["Time"] + column_names) + "\n")
+            output_files.append((f_out, offset, len(column_names)))
+
+        # the records are written as native doubles and the text dumps use C++ scientific format with precision 17
+        record_format = "%s%dd" % (byte_order, record_size)
+        record_bytes = struct.calcsize(record_format)
+        record_count = 0
+        while True:
+            data = f_in.read(record_bytes)
+            if len(data) < record_bytes:
+                break
+            record = struct.unpack(record_format, data)
+            for (f_out, offset, n_columns) in output_files:
+                f_out.write("\t".join("%.17e" % (v) for v in (record[0],) + record[offset: offset + n_columns]) + "\n")
+            record_count += 1
+
+        for (f_out, offset, n_columns) in output_files:
+            f_out.close()
+        if args.verbose:
+            print("%d records converted" % (record_count))
+
+def read_header(f_in, filename):
+    magic = f_in.read(8)
+    if magic != b"GSBDUMP2":
+        print("Error: \"%s\" is not a GaitSym binary dump file" % (filename))
+        sys.exit(1)
+    # the byte order marker is 0x0102030405060708 in the byte order of the machine that wrote the file
+    marker = f_in.read(8)
+    byte_order = None
+    for test_order in ("<", ">"):
+        if len(marker) == 8 and struct.unpack(test_order + "Q", marker)[0] == 0x0102030405060708:
+            byte_order = test_order
+    if byte_order is None:
+        print("Error: \"%s\" has an unrecognised byte order marker" % (filename))
+        sys.exit(1)
+    n_objects = read_integer(f_in, byte_order)
+    objects = []
+    offset = 1 # column 0 is the time
+    for i in range(0, n_objects):
+        name = read_string(f_in, byte_order)
+        n_columns = read_integer(f_in, byte_order)
+        column_names = []
+        for j in range(0, n_columns):
+            column_names.append(read_string(f_in, byte_order))
+        objects.append((name, column_names, offset))
+        offset += n_columns
+    return (objects, offset, byte_order)
+
+def read_integer(f_in, byte_order):
+    return struct.unpack(byte_order + "Q", f_in.read(8))[0]
+
+def read_string(f_in, byte_order):
+    length = read_integer(f_in, byte_order)
+    return f_in.read(length).decode("utf-8")
+
+def pretty_print_sys_argv(sys_argv):
+    quoted_sys_argv = quoted_if_necessary(sys_argv)
+    print((" ".join(quoted_sys_argv)))
+
+def pretty_print_argparse_args(argparse_args):
+    for arg in vars(argparse_args):
+        print(("%s: %s" % (arg, getattr(argparse_args, arg))))
+
+def quoted_if_necessary(input_list):
+    output_list = []
+    for item in input_list:
+        if re.search(r"[^a-zA-Z0-9_.-]", item): # note inside [] backslash quoting does not work so a minus sign to match must occur last
+            item = "\"" + item + "\""
+        output_list.append(item)
+    return output_list
+
+# program starts here
+if __name__ == "__main__":
+    convert_binary_dump()
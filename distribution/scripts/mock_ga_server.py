@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+# A minimal GA server for testing gaitsym_2019_tcp. It sends the same genome for every job and
+# prints the scores that come back. It speaks both the classic one genome per connection protocol
+# and the persistent protocol used with --persistentConnection (see src/PipelinedTCPClient.h)
+
+import sys
+import os
+import argparse
+import re
+import struct
+import socket
+import hashlib
+import threading
+import time
+
+def mock_ga_server():
+
+    parser = argparse.ArgumentParser(description="Minimal GA server for testing gaitsym_2019_tcp in both the classic and the persistent (--persistentConnection) modes")
+    parser.add_argument("-i", "--input_xml_file", required=True, help="the base XML file sent to the clients")
+    parser.add_argument("-p", "--port", type=int, default=8086, help="the port to listen on [8086]")
+    parser.add_argument("-n", "--number_of_jobs", type=int, default=10, help="the number of genomes to send [10]")
+    parser.add_argument("-g", "--genes", type=float, nargs="+", default=[0.0, 0.0], help="the genome sent for every job [0 0]")
+    parser.add_argument("-s", "--send_stop", action="store_true", help="persistent mode only: send \"stop\" once all the genomes have been sent rather than empty job lists")
+    parser.add_argument("-t", "--timeout", type=float, default=60.0, help="give up after this many seconds [60]")
+    parser.add_argument("-v", "--verbose", action="store_true", help="write out more information whilst processing")
+    args = parser.parse_args()
+
+    if args.verbose:
+        pretty_print_sys_argv(sys.argv)
+        pretty_print_argparse_args(args)
+
+    # preflight
+    if not os.path.exists(args.input_xml_file):
+        print("Error: \"%s\" missing" % (args.input_xml_file))
+        sys.exit(1)
+
+    with open(args.input_xml_file, "rb") as f_in:
+        xml = f_in.read() + b"\0" # the terminating zero is sent and included in the md5
+    server = MockServer(xml, args.number_of_jobs, args.genes, args.send_stop, args.verbose)
+
+    listener = socket.socket()
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind(("", args.port))
+    listener.listen(16)
+    listener.settimeout(1.0)
+    start = time.time()
+    while time.time() - start < args.timeout and not server.done():
+        try:
+            (connection, address) = listener.accept()
+        except socket.timeout:
+            continue
+        threading.Thread(target=server.handle, args=(connection,), daemon=True).start()
+    time.sleep(0.5) # let any final results arrive
+
+    scores = sorted(set(r[1] for r in server.results))
+    print("issued %d results %d pruned %d distinct scores %s" % (server.issued, len(server.results), sum(1 for r in server.results if r[2]), scores))
+
+class MockServer:
+
+    header_size = 64
+
+    def __init__(self, xml, number_of_jobs, genes, send_stop, verbose):
+        self.xml = xml
+        self.md5 = struct.unpack("<4I", hashlib.md5(xml).digest())
+        self.number_of_jobs = number_of_jobs
+        self.genome = struct.pack("<%dd" % len(genes), *genes)
+        self.number_of_genes = len(genes)
+        self.send_stop = send_stop
+        self.verbose = verbose
+        self.issued = 0
+        self.results = [] # (runID, score, pruned)
+        self.lock = threading.Lock()
+
+    def done(self):
+        with self.lock:
+            return len(self.results) >= self.number_of_jobs
+
+    def next_run_ids(self, count):
+        with self.lock:
+            n = max(0, min(count, self.number_of_jobs - self.issued))
+            run_ids = list(range(self.issued + 1, self.issued + 1 + n))
+            self.issued += n
+        return run_ids
+
+    def add_result(self, run_id, score, pruned):
+        with self.lock:
+            self.results.append((run_id, score, pruned))
+        if self.verbose:
+            print("runID %d score %.17g%s" % (run_id, score, " pruned" if pruned else ""))
+
+    def handle(self, connection):
+        try:
+            while True:
+                (text, length, run_id, score) = read_header(connection)
+                # classic protocol, one genome per connection
+                if text == "req_xml_length":
+                    connection.sendall(make_header("xml_length", len(self.xml), 0, 0.0, self.md5))
+                elif text == "req_xml_data":
+                    connection.sendall(self.xml)
+                elif text == "req_send_length":
+                    run_ids = self.next_run_ids(1)
+                    if not run_ids:
+                        return
+                    connection.sendall(make_header("send_length", len(self.genome), run_ids[0], -sys.float_info.max, self.md5))
+                elif text == "req_send_data":
+                    connection.sendall(self.genome)
+                elif text == "result" or text == "result_pruned":
+                    if text == "result_pruned":
+                        recv_all(connection, 8) # the pruned time
+                    self.add_result(run_id, score, text == "result_pruned")
+                    return
+                # persistent protocol
+                elif text == "req_jobs":
+                    run_ids = self.next_run_ids(length)
+                    if not run_ids and self.send_stop:
+                        connection.sendall(make_header("stop"))
+                        continue
+                    payload = b"".join(struct.pack("<6Id", r, self.number_of_genes, *self.md5, -sys.float_info.max) + self.genome for r in run_ids)
+                    connection.sendall(make_header("jobs", len(payload), len(run_ids)) + payload)
+                elif text == "req_xml":
+                    connection.sendall(make_header("xml", len(self.xml), 0, 0.0, self.md5) + self.xml)
+                elif text == "results":
+                    payload = recv_all(connection, length)
+                    for i in range(run_id):
+                        (r, pruned, m0, m1, m2, m3, s, pruned_time) = struct.unpack("<6I2d", payload[i * 40:(i + 1) * 40])
+                        self.add_result(r, s, pruned != 0)
+                else:
+                    print("Error: unknown message \"%s\"" % (text))
+                    return
+        except EOFError:
+            return
+        finally:
+            connection.close()
+
+# the standard 64 byte header: char text[32], uint32 length, uint32 runID, double score, uint32 md5[4]
+def make_header(text, length=0, run_id=0, score=0.0, md5=(0, 0, 0, 0)):
+    return text.encode("utf-8").ljust(32, b"\0") + struct.pack("<2Id4I", length, run_id, score, *md5)
+
+def read_header(connection):
+    header = recv_all(connection, MockServer.header_size)
+    text = header[0:32].split(b"\0")[0].decode("utf-8")
+    (length, run_id, score) = struct.unpack("<2Id", header[32:48])
+    return (text, length, run_id, score)
+
+def recv_all(connection, length):
+    data = b""
+    while len(data) < length:
+        block = connection.recv(length - len(data))
+        if not block:
+            raise EOFError
+        data += block
+    return data
+
+def pretty_print_sys_argv(sys_argv):
+    quoted_sys_argv = quoted_if_necessary(sys_argv)
+    print((" ".join(quoted_sys_argv)))
+
+def pretty_print_argparse_args(argparse_args):
+    for arg in vars(argparse_args):
+        print(("%s: %s" % (arg, getattr(argparse_args, arg))))
+
+def quoted_if_necessary(input_list):
+    output_list = []
+    for item in input_list:
+        if re.search(r"[^a-zA-Z0-9_.-]", item): # note inside [] backslash quoting does not work so a minus sign to match must occur last
+            item = "\"" + item + "\""
+        output_list.append(item)
+    return output_list
+
+# program starts here
+if __name__ == "__main__":
+    mock_ga_server()
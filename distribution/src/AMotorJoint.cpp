@@ -16,6 +16,7 @@
 
 #include "ode/ode.h"
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 #include <limits>
@@ -391,5 +392,27 @@ std::string AMotorJoint::dumpToString()
     return ss.str();
 }
 
+void AMotorJoint::saveState(StateBuffer *state)
+{
+    Joint::saveState(state);
+    state->Write(m_lastDeltaAxis);
+    state->Write(m_deltaAxis);
+    state->Write(m_deltaAngle);
+    state->Write(m_currentQuaternion);
+    state->Write(m_lastQuaternion);
+    state->Write(m_lastToCurrent);
+    state->Write(m_firstTime);
+}
 
+void AMotorJoint::restoreState(StateBuffer *state)
+{
+    Joint::restoreState(state);
+    state->Read(&m_lastDeltaAxis);
+    state->Read(&m_deltaAxis);
+    state->Read(&m_deltaAngle);
+    state->Read(&m_currentQuaternion);
+    state->Read(&m_lastQuaternion);
+    state->Read(&m_lastToCurrent);
+    state->Read(&m_firstTime);
+}
 
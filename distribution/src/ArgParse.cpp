@@ -15,6 +15,7 @@
 #include <map>
 #include <algorithm>
 #include <cstdlib>
+#include <cctype>
 #include <regex>
 
 using namespace std::string_literals;
@@ -78,7 +79,8 @@ int ArgParse::Parse()
     std::vector<size_t> locations;
     for (size_t i = 0; i < m_rawArguments.size(); i++)
     {
-        if (pystring::startswith(m_rawArguments[i], "-"s))
+        // negative numbers are values rather than options
+        if (pystring::startswith(m_rawArguments[i], "-"s) && !(m_rawArguments[i].size() > 1 && (std::isdigit(static_cast<unsigned char>(m_rawArguments[i][1])) || m_rawArguments[i][1] == '.')))
         {
             arguments.push_back(m_rawArguments[i]);
             locations.push_back(i);
@@ -173,6 +175,16 @@ int ArgParse::Parse()
             }
         }
     }
+    // with no options at all every argument is an end argument
+    if (arguments.size() == 0)
+    {
+        m_endArguments = m_rawArguments;
+        if (m_endArguments.size() < m_minNumEndArguments || m_endArguments.size() > m_maxNumEndArguments)
+        {
+            m_lastError = "Between "s + std::to_string(m_minNumEndArguments) + " and "s + std::to_string(m_maxNumEndArguments) + " end arguments required: "s + std::to_string(m_endArguments.size()) + " found."s;
+            return __LINE__;
+        }
+    }
     bool helpFlag;
     Get("--help"s, &helpFlag);
     if (helpFlag)
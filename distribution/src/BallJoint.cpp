@@ -15,6 +15,7 @@
 #include "Marker.h"
 
 #include "ode/ode.h"
+#include "StateBuffer.h"
 
 #include <cassert>
 #include <cstdlib>
@@ -370,5 +371,15 @@ std::string BallJoint::dumpToString()
     return ss.str();
 }
 
+void BallJoint::saveState(StateBuffer *state)
+{
+    Joint::saveState(state);
+    state->Write(m_MotorJointFeedback);
+}
 
+void BallJoint::restoreState(StateBuffer *state)
+{
+    Joint::restoreState(state);
+    state->Read(&m_MotorJointFeedback);
+}
 
@@ -0,0 +1,230 @@
+/*
+ *  BatchEvaluator.cpp
+ *  GaitSym2019
+ *
+ *  Runs a pool of worker threads that each own their own Simulation (and
+ *  therefore their own ODE world) and evaluate genomes from a shared queue
+ *
+ */
+
+#include "BatchEvaluator.h"
+#include "XMLConverter.h"
+#include "SharedXMLCache.h"
+#include "Simulation.h"
+#include "Geom.h"
+#include "GSUtil.h"
+
+#include "ode/ode.h"
+
+#include <iostream>
+#include <chrono>
+
+using namespace std::string_literals;
+
+BatchEvaluator::BatchEvaluator()
+{
+}
+
+BatchEvaluator::~BatchEvaluator()
+{
+    Stop();
+}
+
+void BatchEvaluator::Start(size_t numberOfThreads)
+{
+    // holding a reference to ODE stops it being finalised and reinitialised as each simulation is destroyed
+    // and manual thread cleanup is required for the workers to release their thread data
+    dInitODE2(dInitFlagManualThreadCleanup);
+    m_stopFlag = false;
+    m_numberOfThreads = numberOfThreads;
+    for (size_t i = 0; i < numberOfThreads; i++) m_workerList.push_back(std::thread(&BatchEvaluator::Worker, this));
+}
+
+void BatchEvaluator::Stop()
+{
+    if (m_workerList.size() == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopFlag = true;
+    }
+    m_jobAvailable.notify_all();
+    for (auto &&it : m_workerList) it.join();
+    m_workerList.clear();
+    // jobs that never started are returned as errors so that the caller can still reply for them
+    for (auto &&job : m_jobQueue)
+    {
+        Result result;
+        result.runID = job->runID;
+        std::copy(std::begin(job->md5), std::end(job->md5), std::begin(result.md5));
+        result.error = true;
+        result.score = -DBL_MAX;
+        m_resultQueue.push_back(result);
+    }
+    m_jobQueue.clear();
+    dCloseODE();
+}
+
+void BatchEvaluator::SubmitJob(std::unique_ptr<Job> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_jobQueue.push_back(std::move(job));
+        m_outstandingJobs++;
+    }
+    m_jobAvailable.notify_one();
+}
+
+bool BatchEvaluator::GetResult(Result *result, double timeout)
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    if (m_resultQueue.size() == 0)
+    {
+        m_resultAvailable.wait_for(lock, std::chrono::duration<double>(timeout), [this]{ return m_resultQueue.size() > 0; });
+        if (m_resultQueue.size() == 0) return false;
+    }
+    *result = m_resultQueue.front();
+    m_resultQueue.pop_front();
+    m_outstandingJobs--;
+    return true;
+}
+
+size_t BatchEvaluator::outstandingJobs()
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_outstandingJobs;
+}
+
+void BatchEvaluator::Worker()
+{
+    dAllocateODEDataForThread(dAllocateMaskAll);
+    XMLConverter xmlConverter;
+    SharedXMLCache sharedXMLCache;
+    sharedXMLCache.setCacheFolder(m_sharedXMLCacheFolder);
+    std::shared_ptr<const std::string> currentBaseXML;
+    while (true)
+    {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_jobAvailable.wait(lock, [this]{ return m_stopFlag || m_jobQueue.size() > 0; });
+            if (m_stopFlag) break;
+            job = std::move(m_jobQueue.front());
+            m_jobQueue.pop_front();
+        }
+
+        // each worker keeps its own pre-parsed copy of the base XML and only reloads it when it changes
+        if (job->baseXML != currentBaseXML)
+        {
+            currentBaseXML = job->baseXML;
+            // the node local cache has the pre-parsed version if anything on this machine has already loaded it
+            if (sharedXMLCache.Load(job->md5, &xmlConverter))
+                xmlConverter.LoadBaseXMLString(currentBaseXML->data(), currentBaseXML->size());
+            sharedXMLCache.Close();
+        }
+
+        Result result;
+        result.runID = job->runID;
+        std::copy(std::begin(job->md5), std::end(job->md5), std::begin(result.md5));
+        Evaluate(&xmlConverter, *job, &result);
+
+        {
+            std::lock_guard<std::mutex> lock(m_queueMutex);
+            m_resultQueue.push_back(result);
+        }
+        m_resultAvailable.notify_one();
+    }
+    dCleanupODEAllDataForThread();
+}
+
+void BatchEvaluator::Evaluate(XMLConverter *xmlConverter, const Job &job, Result *result)
+{
+    std::vector<double> genome = job.genome;
+    xmlConverter->ApplyGenome(int(genome.size()), genome.data());
+    std::string xmlText;
+    if (xmlConverter->ApplyParameterMap())
+    {
+        // no parameter map so fall back to the full XML text
+        size_t xmlLen;
+        const char *xmlPtr = xmlConverter->GetFormattedXML(&xmlLen);
+        xmlText.assign(xmlPtr, xmlLen);
+    }
+
+    // the ODE random number generator is per thread so reset it to make the result independent of the job order
+    dRandSetSeed(0);
+
+    std::unique_ptr<Simulation> simulation;
+    {
+        std::lock_guard<std::mutex> lock(m_simulationLifetimeMutex);
+        simulation = std::make_unique<Simulation>();
+    }
+    if (m_inputWarehouseFilename.size()) simulation->AddWarehouse(m_inputWarehouseFilename);
+    std::string *errorMessage;
+    std::string trimeshError;
+    if (xmlConverter->ParameterMapValid()) errorMessage = simulation->LoadModel(xmlConverter->ParameterMapElementList());
+    else errorMessage = simulation->LoadModel(xmlText.data(), xmlText.size());
+    if (errorMessage == nullptr && m_numberOfThreads > 1)
+    {
+        // without thread local storage the ODE trimesh collider caches are shared between threads
+        for (auto &&it : *simulation->GetGeomList())
+        {
+            if (dGeomGetClass(it.second->GetGeomID()) == dTriMeshClass)
+            {
+                trimeshError = "Error: BatchEvaluator cannot run models containing trimesh geoms with more than one thread"s;
+                errorMessage = &trimeshError;
+                break;
+            }
+        }
+    }
+
+    if (errorMessage)
+    {
+        // the result is still returned so that the caller can reply with the worst possible score
+        std::cerr << *errorMessage << "\n";
+        result->error = true;
+        result->score = -DBL_MAX;
+    }
+    else
+    {
+        if (m_simulationTimeLimit >= 0) simulation->SetTimeLimit(m_simulationTimeLimit);
+        if (m_warehouseFailDistanceAbort != 0) simulation->SetWarehouseFailDistanceAbort(m_warehouseFailDistanceAbort);
+        simulation->SetScoreToBeat(job.scoreToBeat);
+
+        double startTime = GSUtil::GetTime();
+        while (simulation->ShouldQuit() == false)
+        {
+            simulation->UpdateSimulation();
+            if (simulation->TestForCatastrophy()) break;
+        }
+        result->CPUTimeSimulation = GSUtil::GetTime() - startTime;
+        result->score = simulation->CalculateInstantaneousFitness();
+        result->time = simulation->GetTime();
+        result->stepCount = simulation->GetStepCount();
+        result->mechanicalEnergy = simulation->GetMechanicalEnergy();
+        result->metabolicEnergy = simulation->GetMetabolicEnergy();
+        result->pruned = simulation->GetPruned();
+        result->prunedTime = simulation->GetPrunedTime();
+    }
+
+    std::lock_guard<std::mutex> lock(m_simulationLifetimeMutex);
+    simulation.reset();
+}
+
+void BatchEvaluator::setSimulationTimeLimit(double simulationTimeLimit)
+{
+    m_simulationTimeLimit = simulationTimeLimit;
+}
+
+void BatchEvaluator::setWarehouseFailDistanceAbort(double warehouseFailDistanceAbort)
+{
+    m_warehouseFailDistanceAbort = warehouseFailDistanceAbort;
+}
+
+void BatchEvaluator::setInputWarehouseFilename(const std::string &inputWarehouseFilename)
+{
+    m_inputWarehouseFilename = inputWarehouseFilename;
+}
+
+void BatchEvaluator::setSharedXMLCacheFolder(const std::string &sharedXMLCacheFolder)
+{
+    m_sharedXMLCacheFolder = sharedXMLCacheFolder;
+}
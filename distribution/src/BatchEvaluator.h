@@ -0,0 +1,96 @@
+/*
+ *  BatchEvaluator.h
+ *  GaitSym2019
+ *
+ *  Runs a pool of worker threads that each own their own Simulation (and
+ *  therefore their own ODE world) and evaluate genomes from a shared queue
+ *
+ *  Only the base XML text is shared between the workers. Each simulation still
+ *  loads its own meshes and data target tables, and models containing trimesh
+ *  geoms are refused with more than one thread because the ODE trimesh collider
+ *  caches are not thread safe in this build
+ *
+ */
+
+#ifndef BATCHEVALUATOR_H
+#define BATCHEVALUATOR_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cfloat>
+
+class XMLConverter;
+
+class BatchEvaluator
+{
+public:
+    BatchEvaluator();
+    ~BatchEvaluator();
+
+    // the base XML is shared read only between all the jobs that use it
+    struct Job
+    {
+        uint32_t runID = 0;
+        unsigned int md5[4] = {};
+        std::shared_ptr<const std::string> baseXML;
+        std::vector<double> genome;
+        double scoreToBeat = -DBL_MAX;
+    };
+
+    struct Result
+    {
+        uint32_t runID = 0;
+        unsigned int md5[4] = {};
+        bool error = false; // the genome could not be evaluated and score is -DBL_MAX
+        double score = 0;
+        double time = 0;
+        int64_t stepCount = 0;
+        double mechanicalEnergy = 0;
+        double metabolicEnergy = 0;
+        double CPUTimeSimulation = 0;
+        bool pruned = false;
+        double prunedTime = 0;
+    };
+
+    void Start(size_t numberOfThreads);
+    void Stop(); // running jobs are finished and queued jobs become error results that can still be collected
+
+    void SubmitJob(std::unique_ptr<Job> job);
+    bool GetResult(Result *result, double timeout); // returns true if a result is available within the timeout (s)
+    size_t outstandingJobs();
+
+    void setSimulationTimeLimit(double simulationTimeLimit);
+    void setWarehouseFailDistanceAbort(double warehouseFailDistanceAbort);
+    void setInputWarehouseFilename(const std::string &inputWarehouseFilename);
+    void setSharedXMLCacheFolder(const std::string &sharedXMLCacheFolder); // empty to disable
+
+private:
+    void Worker();
+    void Evaluate(XMLConverter *xmlConverter, const Job &job, Result *result);
+
+    std::vector<std::thread> m_workerList;
+    size_t m_numberOfThreads = 0;
+    std::deque<std::unique_ptr<Job>> m_jobQueue;
+    std::deque<Result> m_resultQueue;
+    size_t m_outstandingJobs = 0;
+    bool m_stopFlag = false;
+    std::mutex m_queueMutex;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_resultAvailable;
+
+    // ODE initialisation is reference counted but not thread safe so simulations are created and destroyed with this held
+    std::mutex m_simulationLifetimeMutex;
+
+    double m_simulationTimeLimit = -1;
+    double m_warehouseFailDistanceAbort = 0;
+    std::string m_inputWarehouseFilename;
+    std::string m_sharedXMLCacheFolder;
+};
+
+#endif // BATCHEVALUATOR_H
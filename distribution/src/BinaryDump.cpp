@@ -0,0 +1,102 @@
+/*
+ *  BinaryDump.cpp
+ *  GaitSym2019
+ *
+ *  Writes the dump output from many objects into a single columnar binary file
+ *  The file starts with a header listing each object and the names of its columns
+ *  followed by fixed width records of native doubles (time then every object's columns)
+ *  A byte order marker after the magic lets readers detect the endianness of the writer
+ *  scripts/convert_binary_dump.py converts the file back to the per object tab files
+ *
+ */
+
+#include "BinaryDump.h"
+#include "DataFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace std::string_literals;
+
+BinaryDump::BinaryDump()
+{
+}
+
+BinaryDump::~BinaryDump()
+{
+    Close();
+}
+
+std::string *BinaryDump::Open(const std::string &filename)
+{
+#if defined _WIN32 && defined _MSC_VER // required because windows and visual studio require wstring for full filename support
+    m_file.open(DataFile::ConvertUTF8ToWide(filename), std::ios::binary);
+#else
+    m_file.open(filename, std::ios::binary);
+#endif
+    if (!m_file.is_open())
+    {
+        m_lastError = "Error: BinaryDump unable to open \""s + filename + "\""s;
+        return &m_lastError;
+    }
+    m_buffer.reserve(m_bufferLimit);
+    return nullptr;
+}
+
+void BinaryDump::Close()
+{
+    if (!m_file.is_open()) return;
+    if (!m_headerWritten) WriteHeader();
+    Flush();
+    m_file.close();
+}
+
+void BinaryDump::AddObject(const std::string &name, const std::vector<std::string> &columnNames)
+{
+    m_objectNames.push_back(name);
+    m_objectColumnNames.push_back(columnNames);
+    m_recordSize += columnNames.size();
+}
+
+void BinaryDump::WriteRecord(double time, const std::vector<double> &values)
+{
+    if (!m_headerWritten) WriteHeader();
+    // a short record would desynchronise every following record so pad or truncate to the header layout
+    m_buffer.push_back(time);
+    size_t n = std::min(values.size(), m_recordSize - 1);
+    m_buffer.insert(m_buffer.end(), values.begin(), values.begin() + long(n));
+    for (size_t i = n + 1; i < m_recordSize; i++) m_buffer.push_back(0);
+    if (m_buffer.size() >= m_bufferLimit) Flush();
+}
+
+size_t BinaryDump::recordSize() const
+{
+    return m_recordSize;
+}
+
+// header layout (all integers are uint64_t):
+// magic (8 bytes), byte order marker (0x0102030405060708 written natively), number of objects
+// then for each object: name length, name, number of columns, and for each column: name length, name
+void BinaryDump::WriteHeader()
+{
+    auto writeInteger = [this](uint64_t v) { m_file.write(reinterpret_cast<const char *>(&v), sizeof(v)); };
+    auto writeString = [this, &writeInteger](const std::string &s) { writeInteger(s.size()); m_file.write(s.data(), std::streamsize(s.size())); };
+    m_file.write(magic(), std::streamsize(strlen(magic())));
+    writeInteger(byteOrderMarker());
+    writeInteger(m_objectNames.size());
+    for (size_t i = 0; i < m_objectNames.size(); i++)
+    {
+        writeString(m_objectNames[i]);
+        writeInteger(m_objectColumnNames[i].size());
+        for (auto &&it : m_objectColumnNames[i]) writeString(it);
+    }
+    m_headerWritten = true;
+}
+
+void BinaryDump::Flush()
+{
+    if (m_buffer.size() == 0) return;
+    m_file.write(reinterpret_cast<const char *>(m_buffer.data()), std::streamsize(m_buffer.size() * sizeof(double)));
+    m_buffer.clear();
+}
@@ -0,0 +1,54 @@
+/*
+ *  BinaryDump.h
+ *  GaitSym2019
+ *
+ *  Writes the dump output from many objects into a single columnar binary file
+ *  The file starts with a header listing each object and the names of its columns
+ *  followed by fixed width records of native doubles (time then every object's columns)
+ *  A byte order marker after the magic lets readers detect the endianness of the writer
+ *  scripts/convert_binary_dump.py converts the file back to the per object tab files
+ *
+ */
+
+#ifndef BINARYDUMP_H
+#define BINARYDUMP_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+class BinaryDump
+{
+public:
+    BinaryDump();
+    ~BinaryDump();
+
+    // returns nullptr on success and an error message on failure
+    std::string *Open(const std::string &filename);
+    void Close();
+
+    // all the objects must be added before the first record is written
+    void AddObject(const std::string &name, const std::vector<std::string> &columnNames);
+    void WriteRecord(double time, const std::vector<double> &values);
+
+    size_t recordSize() const;
+
+    static const char *magic() { return "GSBDUMP2"; }
+    static uint64_t byteOrderMarker() { return 0x0102030405060708; }
+
+private:
+    void WriteHeader();
+    void Flush();
+
+    std::ofstream m_file;
+    std::string m_lastError;
+    std::vector<std::string> m_objectNames;
+    std::vector<std::vector<std::string>> m_objectColumnNames;
+    size_t m_recordSize = 1;
+    bool m_headerWritten = false;
+    std::vector<double> m_buffer;
+    size_t m_bufferLimit = 1 << 17; // doubles (1 MB)
+};
+
+#endif // BINARYDUMP_H
@@ -0,0 +1,197 @@
+/*
+ *  BinaryModel.cpp
+ *  GaitSym2019
+ *
+ *  Compact binary alternative to the XML model file that Simulation::LoadModel can read
+ *  without rapidxml
+ *
+ */
+
+#include "BinaryModel.h"
+#include "GSUtil.h"
+
+#include <cstring>
+#include <map>
+#include <set>
+
+using namespace std::string_literals;
+
+static const char gBinaryModelMagic[8] = {'G', 'S', 'B', 'M', 'O', 'D', 'E', 'L'};
+
+// the attributes that can hold long lists of numbers
+static const std::map<std::string, std::set<std::string>> gNumericAttributes =
+{
+    {"DATATARGET"s, {"TargetTimes"s, "TargetValues"s}},
+    {"DRIVER"s, {"Delays"s, "Widths"s, "Heights"s, "Values"s, "Durations"s}}
+};
+
+BinaryModel::BinaryModel()
+{
+}
+
+BinaryModel::~BinaryModel()
+{
+}
+
+bool BinaryModel::IsBinaryModel(const char *buffer, size_t length)
+{
+    return length >= sizeof(gBinaryModelMagic) && memcmp(buffer, gBinaryModelMagic, sizeof(gBinaryModelMagic)) == 0;
+}
+
+std::string *BinaryModel::Read(const char *buffer, size_t length, std::vector<std::unique_ptr<ParseXML::XMLElement>> *elementList)
+{
+    elementList->clear();
+    if (!IsBinaryModel(buffer, length))
+    {
+        setLastError("Error: BinaryModel::Read - not a binary model file"s);
+        return lastErrorPtr();
+    }
+    size_t offset = sizeof(gBinaryModelMagic);
+    auto readInteger = [buffer, length, &offset](uint64_t *value) -> bool
+    {
+        if (length - offset < sizeof(uint64_t)) return false;
+        memcpy(value, buffer + offset, sizeof(uint64_t));
+        offset += sizeof(uint64_t);
+        return true;
+    };
+    auto readString = [buffer, length, &offset, &readInteger](std::string *value) -> bool
+    {
+        uint64_t stringLength;
+        if (!readInteger(&stringLength) || stringLength > length - offset) return false;
+        value->assign(buffer + offset, size_t(stringLength));
+        offset += size_t(stringLength);
+        return true;
+    };
+    auto readDoubles = [buffer, length, &offset, &readInteger](std::vector<double> *values) -> bool
+    {
+        uint64_t count;
+        if (!readInteger(&count) || count > (length - offset) / sizeof(double)) return false;
+        values->resize(size_t(count));
+        if (count) memcpy(values->data(), buffer + offset, size_t(count) * sizeof(double));
+        offset += size_t(count) * sizeof(double);
+        return true;
+    };
+
+    uint32_t version;
+    uint64_t elementCount;
+    if (length - offset < sizeof(uint32_t))
+    {
+        setLastError("Error: BinaryModel::Read - file truncated"s);
+        return lastErrorPtr();
+    }
+    memcpy(&version, buffer + offset, sizeof(uint32_t));
+    offset += sizeof(uint32_t);
+    if (version != Version)
+    {
+        setLastError("Error: BinaryModel::Read - version "s + std::to_string(version) + " not supported (expected "s + std::to_string(int(Version)) + ")"s);
+        return lastErrorPtr();
+    }
+    if (!readInteger(&elementCount))
+    {
+        setLastError("Error: BinaryModel::Read - file truncated"s);
+        return lastErrorPtr();
+    }
+    for (uint64_t i = 0; i < elementCount; i++)
+    {
+        auto element = std::make_unique<ParseXML::XMLElement>();
+        uint64_t attributeCount, numericAttributeCount;
+        bool ok = readString(&element->tag) && readInteger(&attributeCount);
+        for (uint64_t j = 0; ok && j < attributeCount; j++)
+        {
+            std::string name, value;
+            ok = readString(&name) && readString(&value);
+            element->attributes[name] = std::move(value);
+        }
+        ok = ok && readInteger(&numericAttributeCount);
+        for (uint64_t j = 0; ok && j < numericAttributeCount; j++)
+        {
+            std::string name;
+            ok = readString(&name) && readDoubles(&element->numericAttributes[name]);
+        }
+        if (!ok)
+        {
+            elementList->clear();
+            setLastError("Error: BinaryModel::Read - file truncated in element "s + std::to_string(i));
+            return lastErrorPtr();
+        }
+        elementList->push_back(std::move(element));
+    }
+    return nullptr;
+}
+
+void BinaryModel::Write(const std::vector<std::unique_ptr<ParseXML::XMLElement>> &elementList, std::string *data)
+{
+    data->assign(gBinaryModelMagic, sizeof(gBinaryModelMagic));
+    auto appendInteger = [data](uint64_t value) { data->append(reinterpret_cast<const char *>(&value), sizeof(value)); };
+    auto appendString = [data, &appendInteger](const std::string &value) { appendInteger(value.size()); data->append(value); };
+    uint32_t version = Version;
+    data->append(reinterpret_cast<const char *>(&version), sizeof(version));
+    appendInteger(elementList.size());
+    for (auto &&element : elementList)
+    {
+        appendString(element->tag);
+        appendInteger(element->attributes.size());
+        for (auto &&attribute : element->attributes)
+        {
+            appendString(attribute.first);
+            appendString(attribute.second);
+        }
+        appendInteger(element->numericAttributes.size());
+        for (auto &&attribute : element->numericAttributes)
+        {
+            appendString(attribute.first);
+            appendInteger(attribute.second.size());
+            data->append(reinterpret_cast<const char *>(attribute.second.data()), attribute.second.size() * sizeof(double));
+        }
+    }
+}
+
+std::string *BinaryModel::ConvertFromXML(const char *buffer, size_t length, std::string *data)
+{
+    ParseXML parseXML;
+    std::string *errorMessage = parseXML.LoadModel(buffer, length, "GAITSYM2019"s);
+    if (errorMessage)
+    {
+        setLastError(*errorMessage);
+        return lastErrorPtr();
+    }
+    for (auto &&element : *parseXML.elementList()) ConvertToNumeric(element.get());
+    Write(*parseXML.elementList(), data);
+    return nullptr;
+}
+
+std::string *BinaryModel::ConvertToXML(const char *buffer, size_t length, std::string *xml)
+{
+    std::vector<std::unique_ptr<ParseXML::XMLElement>> elementList;
+    if (Read(buffer, length, &elementList)) return lastErrorPtr();
+    ParseXML parseXML;
+    for (auto &&element : elementList)
+    {
+        ConvertToText(element.get());
+        parseXML.AddElement(element->tag, element->attributes);
+    }
+    *xml = parseXML.SaveModel();
+    return nullptr;
+}
+
+void BinaryModel::ConvertToNumeric(ParseXML::XMLElement *element)
+{
+    auto tagIt = gNumericAttributes.find(element->tag);
+    if (tagIt == gNumericAttributes.end()) return;
+    for (auto &&name : tagIt->second)
+    {
+        auto it = element->attributes.find(name);
+        if (it == element->attributes.end()) continue;
+        std::vector<double> values;
+        GSUtil::Double(it->second, &values);
+        if (values.size() != size_t(GSUtil::CountTokens(it->second.c_str()))) continue; // anything odd is left as text so that it is read exactly as before
+        element->numericAttributes[name] = std::move(values);
+        element->attributes.erase(it);
+    }
+}
+
+void BinaryModel::ConvertToText(ParseXML::XMLElement *element)
+{
+    for (auto &&it : element->numericAttributes) GSUtil::ToString(it.second.data(), it.second.size(), &element->attributes[it.first]);
+    element->numericAttributes.clear();
+}
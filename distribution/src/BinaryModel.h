@@ -0,0 +1,52 @@
+/*
+ *  BinaryModel.h
+ *  GaitSym2019
+ *
+ *  Compact binary alternative to the XML model file that Simulation::LoadModel can read
+ *  without rapidxml. It holds the same list of elements as ParseXML but the long numeric
+ *  arrays (data target samples, boxcar stacks, step values etc.) are stored already converted
+ *  so that createFromAttributes does not have to tokenise and convert them again
+ *
+ *  File layout (native byte order):
+ *  char magic[8] "GSBMODEL", uint32 version, uint64 number of elements
+ *  for each element: string tag, uint64 number of text attributes, then string name, string value for each,
+ *  uint64 number of numeric attributes, then string name, uint64 number of values, double values[] for each
+ *  where a string is a uint64 length followed by the characters
+ *
+ */
+
+#ifndef BINARYMODEL_H
+#define BINARYMODEL_H
+
+#include "NamedObject.h"
+#include "ParseXML.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class BinaryModel : NamedObject
+{
+public:
+    BinaryModel();
+    virtual ~BinaryModel();
+
+    enum { Version = 1 };
+
+    static bool IsBinaryModel(const char *buffer, size_t length);
+
+    std::string *Read(const char *buffer, size_t length, std::vector<std::unique_ptr<ParseXML::XMLElement>> *elementList);
+    static void Write(const std::vector<std::unique_ptr<ParseXML::XMLElement>> &elementList, std::string *data);
+
+    // whole file conversions in both directions
+    std::string *ConvertFromXML(const char *buffer, size_t length, std::string *data);
+    std::string *ConvertToXML(const char *buffer, size_t length, std::string *xml);
+
+    // move the known array attributes between text and numbers
+    // an attribute is only made numeric if every token converts exactly so the text is never needed again
+    static void ConvertToNumeric(ParseXML::XMLElement *element);
+    static void ConvertToText(ParseXML::XMLElement *element);
+};
+
+#endif // BINARYMODEL_H
@@ -18,8 +18,10 @@
 #include "ode/ode.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <iostream>
+#include <algorithm>
 #include <string>
 #include <string.h>
 #include <cmath>
@@ -419,6 +421,39 @@ dBodyID Body::GetBodyID() const
     return m_bodyID;
 }
 
+// this uses the same arithmetic as dBodyAddForceAtPos but the forces are summed here before they are added
+// to the ODE body accumulators so the result only matches applying the forces one at a time to within roundoff
+void Body::AccumulateForceAtPos(double fx, double fy, double fz, const double *point)
+{
+    if (m_accumulatedForceValid == false)
+    {
+        std::fill_n(m_accumulatedForce, dV3E__MAX, 0);
+        std::fill_n(m_accumulatedTorque, dV3E__MAX, 0);
+        m_accumulatedForcePosition = dBodyGetPosition(m_bodyID);
+        m_accumulatedForceValid = true;
+    }
+    const double *position = m_accumulatedForcePosition;
+    dVector3 f, q;
+    f[0] = fx;
+    f[1] = fy;
+    f[2] = fz;
+    q[0] = point[0] - position[0];
+    q[1] = point[1] - position[1];
+    q[2] = point[2] - position[2];
+    m_accumulatedForce[0] += fx;
+    m_accumulatedForce[1] += fy;
+    m_accumulatedForce[2] += fz;
+    dAddVectorCross3(m_accumulatedTorque, q, f);
+}
+
+void Body::ApplyAccumulatedForce()
+{
+    if (m_accumulatedForceValid == false) return;
+    dBodyAddForce(m_bodyID, m_accumulatedForce[0], m_accumulatedForce[1], m_accumulatedForce[2]);
+    dBodyAddTorque(m_bodyID, m_accumulatedTorque[0], m_accumulatedTorque[1], m_accumulatedTorque[2]);
+    m_accumulatedForceValid = false;
+}
+
 void Body::SetMass(const dMass *mass)
 {
     dBodySetMass(m_bodyID, mass);
@@ -593,6 +628,23 @@ double Body::GetProjectedAngle(const pgd::Vector3 &planeNormal, const pgd::Vecto
     return angle;
 }
 
+std::vector<std::string> Body::dumpNames()
+{
+    return {"XP"s, "YP"s, "ZP"s, "XV"s, "YV"s, "ZV"s, "QW"s, "QX"s, "QY"s, "QZ"s, "RVX"s, "RVY"s, "RVZ"s, "LKEX"s, "LKEY"s, "LKEZ"s, "RKE"s, "GPE"s};
+}
+
+void Body::dumpValues(std::vector<double> *values)
+{
+    const double *p = GetPosition();
+    const double *v = GetLinearVelocity();
+    const double *q = GetQuaternion();
+    const double *rv = GetAngularVelocity();
+    dVector3 ke;
+    GetLinearKineticEnergy(ke);
+    values->insert(values->end(), {p[0], p[1], p[2], v[0], v[1], v[2], q[0], q[1], q[2], q[3], rv[0], rv[1], rv[2],
+                                   ke[0], ke[1], ke[2], GetRotationalKineticEnergy(), GetGravitationalPotentialEnergy()});
+}
+
 std::string Body::dumpToString()
 {
     std::stringstream ss;
@@ -1007,3 +1059,40 @@ const double *Body::GetInitialQuaternion()
 {
     return m_initialQuaternion;
 }
+
+void Body::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    state->Write(dBodyGetPosition(m_bodyID), 3);
+    state->Write(dBodyGetQuaternion(m_bodyID), 4);
+    state->Write(dBodyGetRotation(m_bodyID), 12);
+    state->Write(dBodyGetLinearVel(m_bodyID), 3);
+    state->Write(dBodyGetAngularVel(m_bodyID), 3);
+    state->Write(dBodyGetForce(m_bodyID), 3);
+    state->Write(dBodyGetTorque(m_bodyID), 3);
+}
+
+void Body::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    dVector3 v;
+    dQuaternion q;
+    dMatrix3 R;
+    state->Read(v, 3);
+    dBodySetPosition(m_bodyID, v[0], v[1], v[2]);
+    state->Read(q, 4);
+    state->Read(R, 12);
+    dBodySetQuaternion(m_bodyID, q);
+    // dBodySetQuaternion renormalises which can alter the last bit so copy the exact values back
+    std::copy_n(q, 4, const_cast<dReal *>(dBodyGetQuaternion(m_bodyID)));
+    std::copy_n(R, 12, const_cast<dReal *>(dBodyGetRotation(m_bodyID)));
+    state->Read(v, 3);
+    dBodySetLinearVel(m_bodyID, v[0], v[1], v[2]);
+    state->Read(v, 3);
+    dBodySetAngularVel(m_bodyID, v[0], v[1], v[2]);
+    state->Read(v, 3);
+    dBodySetForce(m_bodyID, v[0], v[1], v[2]);
+    state->Read(v, 3);
+    dBodySetTorque(m_bodyID, v[0], v[1], v[2]);
+}
+
@@ -110,6 +110,10 @@ public:
     const double *GetInitialQuaternion();
 
     LimitTestResult TestLimits();
+
+    // forces from muscles and fluid sacs are summed here and passed to ODE once per step
+    void AccumulateForceAtPos(double fx, double fy, double fz, const double *point);
+    void ApplyAccumulatedForce();
     int SanityCheck(Body *otherBody, Simulation::AxisType axis, const std::string &sanityCheckLeft, const std::string &sanityCheckRight);
 
     void EnterConstructionMode();
@@ -135,9 +139,13 @@ public:
     std::string GetGraphicFile3() const { return m_graphicFile3; }
 
     virtual std::string dumpToString();
+    virtual std::vector<std::string> dumpNames();
+    virtual void dumpValues(std::vector<double> *values);
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 private:
 
@@ -172,6 +180,11 @@ private:
 
     bool m_constructionMode = false;
 
+    dVector3 m_accumulatedForce = {0, 0, 0, 0};
+    dVector3 m_accumulatedTorque = {0, 0, 0, 0};
+    const double *m_accumulatedForcePosition = nullptr;
+    bool m_accumulatedForceValid = false;
+
 
 
 };
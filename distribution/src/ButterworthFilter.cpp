@@ -10,6 +10,7 @@
  */
 
 #include "ButterworthFilter.h"
+#include "StateBuffer.h"
 #include <cmath>
 
 #ifndef M_PI
@@ -96,23 +97,9 @@ void ButterworthFilter::CalculateCoefficients(double cutoffFrequency, double sam
     m_a2 = -(1.0 - q * ita + ita * ita) * m_b0;
 }
 
-double SharedButterworthFilter::m_cutoffFrequency;
-double SharedButterworthFilter::m_samplingFrequency;
-double SharedButterworthFilter::m_b0;
-double SharedButterworthFilter::m_b1;
-double SharedButterworthFilter::m_b2;
-double SharedButterworthFilter::m_a1;
-double SharedButterworthFilter::m_a2;
-
-SharedButterworthFilter::SharedButterworthFilter() : Filter()
+SharedButterworthFilter::SharedButterworthFilter(Coefficients *coefficients) : Filter()
 {
-    m_cutoffFrequency = 0;
-    m_samplingFrequency = 0;
-    m_b0 = 0;
-    m_b1 = 0;
-    m_b2 = 0;
-    m_a1 = 0;
-    m_a2 = 0;
+    m_coefficients = coefficients;
     m_xnminus1 = 0;
     m_xnminus2 = 0;
     m_yn = 0;
@@ -120,15 +107,16 @@ SharedButterworthFilter::SharedButterworthFilter() : Filter()
     m_ynminus2 = 0;
 }
 
-SharedButterworthFilter::SharedButterworthFilter(double cutoffFrequency, double samplingFrequency) : Filter()
+SharedButterworthFilter::SharedButterworthFilter(Coefficients *coefficients, double cutoffFrequency, double samplingFrequency) : Filter()
 {
+    m_coefficients = coefficients;
     setXn(0);
     m_xnminus1 = 0;
     m_xnminus2 = 0;
     m_yn = 0;
     m_ynminus1 = 0;
     m_ynminus2 = 0;
-    CalculateCoefficients(cutoffFrequency, samplingFrequency);
+    CalculateCoefficients(m_coefficients, cutoffFrequency, samplingFrequency);
 }
 
 double SharedButterworthFilter::yn() const
@@ -138,12 +126,12 @@ double SharedButterworthFilter::yn() const
 
 double SharedButterworthFilter::cutoffFrequency() const
 {
-    return m_cutoffFrequency;
+    return m_coefficients->cutoffFrequency;
 }
 
 double SharedButterworthFilter::samplingFrequency() const
 {
-    return m_samplingFrequency;
+    return m_coefficients->samplingFrequency;
 }
 
 void SharedButterworthFilter::AddNewSample(double x)
@@ -156,7 +144,8 @@ void SharedButterworthFilter::AddNewSample(double x)
     m_ynminus1 = m_yn;
 
     // and calculate the new yn value
-    m_yn  =  m_b0*xn() + m_b1*m_xnminus1 + m_b2*m_xnminus2 + m_a1*m_ynminus1 + m_a2*m_ynminus2;
+    const Coefficients *c = m_coefficients;
+    m_yn  =  c->b0*xn() + c->b1*m_xnminus1 + c->b2*m_xnminus2 + c->a1*m_ynminus1 + c->a2*m_ynminus2;
 }
 
 double SharedButterworthFilter::Output()
@@ -164,20 +153,59 @@ double SharedButterworthFilter::Output()
     return m_yn;
 }
 
-void SharedButterworthFilter::CalculateCoefficients(double cutoffFrequency, double samplingFrequency)
+void SharedButterworthFilter::CalculateCoefficients(Coefficients *coefficients, double cutoffFrequency, double samplingFrequency)
 {
     // calculate the 2nd Order Butterworth Low Pass Filter coefficients for the IIR filter
     // y(n)  =  b0*x(n) + b1*x(n-1) + b2*x(n-2) + a1*y(n-1) + a2*y(n-2)
-    m_cutoffFrequency = cutoffFrequency;
-    m_samplingFrequency = samplingFrequency;
-    double ff = m_cutoffFrequency / m_samplingFrequency;
+    coefficients->cutoffFrequency = cutoffFrequency;
+    coefficients->samplingFrequency = samplingFrequency;
+    double ff = cutoffFrequency / samplingFrequency;
     const double ita = 1.0 / tan(M_PI * ff);
     const double q = M_SQRT2;
-    m_b0 = 1.0 / (1.0 + q*ita + ita*ita);
-    m_b1 = 2 * m_b0;
-    m_b2 = m_b0;
-    m_a1 = 2.0 * (ita * ita - 1.0) * m_b0;
-    m_a2 = -(1.0 - q * ita + ita * ita) * m_b0;
+    coefficients->b0 = 1.0 / (1.0 + q*ita + ita*ita);
+    coefficients->b1 = 2 * coefficients->b0;
+    coefficients->b2 = coefficients->b0;
+    coefficients->a1 = 2.0 * (ita * ita - 1.0) * coefficients->b0;
+    coefficients->a2 = -(1.0 - q * ita + ita * ita) * coefficients->b0;
 }
 
+void ButterworthFilter::saveState(StateBuffer *state)
+{
+    Filter::saveState(state);
+    state->Write(m_xnminus1);
+    state->Write(m_xnminus2);
+    state->Write(m_yn);
+    state->Write(m_ynminus1);
+    state->Write(m_ynminus2);
+}
+
+void ButterworthFilter::restoreState(StateBuffer *state)
+{
+    Filter::restoreState(state);
+    state->Read(&m_xnminus1);
+    state->Read(&m_xnminus2);
+    state->Read(&m_yn);
+    state->Read(&m_ynminus1);
+    state->Read(&m_ynminus2);
+}
+
+void SharedButterworthFilter::saveState(StateBuffer *state)
+{
+    Filter::saveState(state);
+    state->Write(m_xnminus1);
+    state->Write(m_xnminus2);
+    state->Write(m_yn);
+    state->Write(m_ynminus1);
+    state->Write(m_ynminus2);
+}
+
+void SharedButterworthFilter::restoreState(StateBuffer *state)
+{
+    Filter::restoreState(state);
+    state->Read(&m_xnminus1);
+    state->Read(&m_xnminus2);
+    state->Read(&m_yn);
+    state->Read(&m_ynminus1);
+    state->Read(&m_ynminus2);
+}
 
@@ -22,6 +22,8 @@ public:
 
     virtual void AddNewSample(double x);
     virtual double Output();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     void CalculateCoefficients(double cutoffFrequency, double samplingFrequency);
 
@@ -49,13 +51,27 @@ private:
 class SharedButterworthFilter : public Filter
 {
 public:
-    SharedButterworthFilter();
-    SharedButterworthFilter(double cutoffFrequency, double samplingFrequency);
+    // all the filters that use the same coefficients share them so the last values calculated are used by all of them
+    struct Coefficients
+    {
+        double cutoffFrequency = 0;
+        double samplingFrequency = 0;
+        double b0 = 0;
+        double b1 = 0;
+        double b2 = 0;
+        double a1 = 0;
+        double a2 = 0;
+    };
+
+    SharedButterworthFilter(Coefficients *coefficients);
+    SharedButterworthFilter(Coefficients *coefficients, double cutoffFrequency, double samplingFrequency);
 
     virtual void AddNewSample(double x);
     virtual double Output();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
-    static void CalculateCoefficients(double cutoffFrequency, double samplingFrequency);
+    static void CalculateCoefficients(Coefficients *coefficients, double cutoffFrequency, double samplingFrequency);
 
     double yn() const;
 
@@ -64,13 +80,7 @@ public:
 
 private:
 
-    static double m_cutoffFrequency;
-    static double m_samplingFrequency;
-    static double m_b0;
-    static double m_b1;
-    static double m_b2;
-    static double m_a1;
-    static double m_a2;
+    Coefficients *m_coefficients;
     double m_xnminus1;
     double m_xnminus2;
     double m_yn;
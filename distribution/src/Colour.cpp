@@ -80,7 +80,7 @@ bool Colour::SetColourFromString(const std::string &str, Colour *stringColour)
 
 bool Colour::IsNumber(const std::string &s)
 {
-    std::regex e("^([+-]?)(?=[0-9]|\\.[0-9])[0-9]*(\\.[0-9]*)?([Ee]([+-]?[0-9]+))?$");
+    static const std::regex e("^([+-]?)(?=[0-9]|\\.[0-9])[0-9]*(\\.[0-9]*)?([Ee]([+-]?[0-9]+))?$"); // static because regex compilation is very slow
     return std::regex_match (s, e);
 }
 
@@ -126,7 +126,7 @@ void Colour::setAlpha(float alpha)
 
 bool Colour::IsInt(const std::string &s)
 {
-    std::regex e("^(?:(0[xX][a-fA-F0-9]+(?:[uU](?:ll|LL|[lL])?|(?:ll|LL|[lL])[uU]?)?)"           // Hexadecimal
+    static const std::regex e("^(?:(0[xX][a-fA-F0-9]+(?:[uU](?:ll|LL|[lL])?|(?:ll|LL|[lL])[uU]?)?)"           // Hexadecimal
                  "|([1-9][0-9]*(?:[uU](?:ll|LL|[lL])?|(?:ll|LL|[lL])[uU]?)?)"                    // Decimal
                  "|(0[0-7]*(?:[uU](?:ll|LL|[lL])?|(?:ll|LL|[lL])[uU]?)?))$"s);                   // Octal
     return std::regex_match (s, e);
@@ -9,6 +9,7 @@
 
 #include "Controller.h"
 #include "Simulation.h"
+#include "StateBuffer.h"
 
 #include <fstream>
 #include <sstream>
@@ -55,3 +56,16 @@ void Controller::appendToAttributes()
 {
     Driver::appendToAttributes();
 }
+
+void Controller::saveState(StateBuffer *state)
+{
+    Driver::saveState(state);
+    Drivable::saveState(state);
+}
+
+void Controller::restoreState(StateBuffer *state)
+{
+    Driver::restoreState(state);
+    Drivable::restoreState(state);
+}
+
@@ -22,6 +22,8 @@ public:
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 };
 
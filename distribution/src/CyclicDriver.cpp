@@ -12,6 +12,7 @@
 #include "CyclicDriver.h"
 #include "GSUtil.h"
 #include "Simulation.h"
+#include "StateBuffer.h"
 
 #include <algorithm>
 #include <cassert>
@@ -80,14 +81,10 @@ std::string *CyclicDriver::createFromAttributes()
 {
     if (Driver::createFromAttributes()) return lastErrorPtr();
 
-    std::string buf;
-    buf.reserve(100000);
-    if (findAttribute("Values"s, &buf) == nullptr) return lastErrorPtr();
     std::vector<double> values;
-    GSUtil::Double(buf, &values);
-    if (findAttribute("Durations"s, &buf) == nullptr) return lastErrorPtr();
+    if (findAttribute("Values"s, &values) == nullptr) return lastErrorPtr();
     std::vector<double> durations;
-    GSUtil::Double(buf, &durations);
+    if (findAttribute("Durations"s, &durations) == nullptr) return lastErrorPtr();
     if (values.size() != durations.size())
     {
         setLastError("StepDriver ID=\""s + name() + "\" number of values ("s + std::to_string(values.size()) + ") must match number of durations ("s + std::to_string(durations.size()) + ")"s);
@@ -100,6 +97,7 @@ std::string *CyclicDriver::createFromAttributes()
     for (size_t i =0; i < m_durationList.size(); i++) m_changeTimes[i + 1] = m_changeTimes[i] + m_durationList[i];
     m_changeTimes[m_durationList.size() + 1] = DBL_MAX;
 
+    std::string buf;
     if (findAttribute("PhaseDelay"s, &buf) == nullptr) return lastErrorPtr();
     m_PhaseDelay =  GSUtil::Double(buf);
 
@@ -137,3 +135,16 @@ void CyclicDriver::setDurationList(const std::vector<double> &durationList)
 {
     m_durationList = durationList;
 }
+
+void CyclicDriver::saveState(StateBuffer *state)
+{
+    Driver::saveState(state);
+    state->Write(m_index);
+}
+
+void CyclicDriver::restoreState(StateBuffer *state)
+{
+    Driver::restoreState(state);
+    state->Read(&m_index);
+}
+
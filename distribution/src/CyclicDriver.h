@@ -24,6 +24,8 @@ public:
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     std::vector<double> valueList() const;
     void setValueList(const std::vector<double> &valueList);
@@ -14,6 +14,7 @@
 #include "Simulation.h"
 #include "GSUtil.h"
 #include "Marker.h"
+#include "StateBuffer.h"
 
 #include <cmath>
 #include <string.h>
@@ -612,3 +613,19 @@ void CylinderWrapStrap::appendToAttributes()
     setAttribute("CylinderRadius"s, *GSUtil::ToString(m_cylinderRadius, &buf));
 }
 
+void CylinderWrapStrap::saveState(StateBuffer *state)
+{
+    Strap::saveState(state);
+    state->Write(m_wrapStatus);
+    state->Write(m_pathCoordinates);
+    state->Write(m_numPathCoordinates);
+}
+
+void CylinderWrapStrap::restoreState(StateBuffer *state)
+{
+    Strap::restoreState(state);
+    state->Read(&m_wrapStatus);
+    state->Read(&m_pathCoordinates);
+    state->Read(&m_numPathCoordinates);
+}
+
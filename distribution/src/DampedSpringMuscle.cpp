@@ -17,6 +17,7 @@
 #include "NPointStrap.h"
 #include "CylinderWrapStrap.h"
 #include "TwoCylinderWrapStrap.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 
@@ -132,3 +133,15 @@ std::string *DampedSpringMuscle::createFromAttributes()
     setAttribute("BreakingStrain"s, *GSUtil::ToString(m_BreakingStrain, &buf));
 }
 
+void DampedSpringMuscle::saveState(StateBuffer *state)
+{
+    Muscle::saveState(state);
+    state->Write(m_Activation);
+}
+
+void DampedSpringMuscle::restoreState(StateBuffer *state)
+{
+    Muscle::restoreState(state);
+    state->Read(&m_Activation);
+}
+
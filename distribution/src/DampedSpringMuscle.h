@@ -44,6 +44,8 @@ public:
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 private:
 
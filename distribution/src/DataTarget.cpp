@@ -12,6 +12,7 @@
 #include "GSUtil.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <iostream>
 #include <cfloat>
@@ -29,6 +30,34 @@ std::vector<double> *DataTarget::targetTimeList()
     return &m_targetTimeList;
 }
 
+size_t DataTarget::targetTimeLowerBound(double time)
+{
+    if (m_cursor > m_targetTimeList.size()) m_cursor = m_targetTimeList.size();
+    while (m_cursor < m_targetTimeList.size() && m_targetTimeList[m_cursor] < time) m_cursor++;
+    while (m_cursor > 0 && m_targetTimeList[m_cursor - 1] >= time) m_cursor--;
+    return m_cursor;
+}
+
+void DataTarget::targetTimeInterval(double time, size_t *index, size_t *indexNext)
+{
+    size_t lowerBound = targetTimeLowerBound(time);
+    if (lowerBound == 0) // time <= lowest value in the list
+    {
+        *index = 0;
+        *indexNext = 0;
+    }
+    else if (time >= m_targetTimeList.back()) // time >= highest value in the list
+    {
+        *index = m_targetTimeList.size() - 1;
+        *indexNext = *index;
+    }
+    else
+    {
+        *index = lowerBound - 1;
+        *indexNext = lowerBound;
+    }
+}
+
 double DataTarget::positiveFunction(double v)
 {
     switch (m_matchType)
@@ -51,8 +80,7 @@ std::tuple<double, bool> DataTarget::calculateMatchValue(double time)
     {
     case Punctuated:
         {
-            auto lowerBound = std::lower_bound(m_targetTimeList.begin(), m_targetTimeList.end(), time);
-            size_t index = std::distance(m_targetTimeList.begin(), lowerBound);
+            size_t index = targetTimeLowerBound(time);
             if (index == 0)
                 return std::make_tuple(m_lastValue, false); // this means that time is less than the lowest value in the list
             if (index == m_lastIndex)
@@ -72,6 +100,24 @@ std::tuple<double, bool> DataTarget::calculateMatchValue(double time)
     return std::make_tuple(m_lastValue, true);
 }
 
+// each match value is intercept + slope * positiveFunction(error) so it can only be bounded when the
+// slope is zero or when it is negative and positiveFunction cannot go below zero
+double DataTarget::remainingValueBound(size_t remainingCalls)
+{
+    if (m_slope > 0 || (m_slope < 0 && m_matchType == Raw)) return DBL_MAX;
+    double maxValue = m_intercept;
+    if (maxValue <= 0) return 0; // the simulation might stop at any time so the bound cannot be less than zero
+    size_t count = remainingCalls;
+    if (m_interpolationType == Punctuated)
+    {
+        // each target time is only matched once and only later target times can still be matched
+        size_t remainingTargets = m_targetTimeList.size() - (m_lastIndex == SIZE_MAX ? 0 : m_lastIndex);
+        count = std::min(count, remainingTargets);
+    }
+    if (count == SIZE_MAX) return DBL_MAX;
+    return double(count) * maxValue;
+}
+
 void DataTarget::setIntercept(double intercept)
 {
     m_intercept = intercept;
@@ -124,17 +170,12 @@ std::string *DataTarget::createFromAttributes()
     if (findAttribute("AbortAbove"s, &buf)) m_abortAbove = GSUtil::Double(buf);
     if (findAttribute("AbortBelow"s, &buf)) m_abortBelow = GSUtil::Double(buf);
 
-    if (findAttribute("TargetTimes"s, &buf) == nullptr) return lastErrorPtr();
-    std::vector<std::string> targetTimesTokens;
-    pystring::split(buf, targetTimesTokens);
-    if (targetTimesTokens.size() == 0)
+    if (findAttribute("TargetTimes"s, &m_targetTimeList) == nullptr) return lastErrorPtr();
+    if (m_targetTimeList.size() == 0)
     {
         setLastError("DataTarget ID=\""s + name() +"\" No times found in TargetTimes"s);
         return lastErrorPtr();
     }
-    m_targetTimeList.clear();
-    m_targetTimeList.reserve(targetTimesTokens.size());
-    for (auto token : targetTimesTokens) m_targetTimeList.push_back(GSUtil::Double(token));
     if (std::is_sorted(m_targetTimeList.begin(), m_targetTimeList.end()) == false)
     {
         setLastError("DataTarget ID=\""s + name() +"\" TargetTimes are not in ascending order"s);
@@ -200,4 +241,17 @@ void DataTarget::appendToAttributes()
     setAttribute("InterpolationType", interpolationTypeStrings(m_interpolationType));
 }
 
+void DataTarget::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    state->Write(m_lastIndex);
+    state->Write(m_lastValue);
+}
+
+void DataTarget::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    state->Read(&m_lastIndex);
+    state->Read(&m_lastValue);
+}
 
@@ -39,6 +39,7 @@ public:
     void setAbortThreshold(double a);
 
     std::tuple<double, bool> calculateMatchValue(double time);
+    double remainingValueBound(size_t remainingCalls); // upper bound of the sum of the match values from the next remainingCalls calls
 
     double positiveFunction(double v);
 
@@ -51,6 +52,8 @@ public:
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     virtual double calculateError(double time) = 0;
     virtual double calculateError(size_t index) = 0;
@@ -58,6 +61,11 @@ public:
 protected:
     std::vector<double> *targetTimeList();
 
+    // these give the same results as std::lower_bound/std::upper_bound on targetTimeList() but move a cursor from
+    // the previous position so they are amortised O(1) when time increases as it does during a simulation
+    size_t targetTimeLowerBound(double time);
+    void targetTimeInterval(double time, size_t *index, size_t *indexNext); // index == indexNext outside the time range
+
 private:
     double m_intercept = 0;
     double m_slope = 0;
@@ -67,6 +75,7 @@ private:
     double m_abortAbove = DBL_MAX;
     std::vector<double> m_targetTimeList;
     size_t m_lastIndex = SIZE_MAX;
+    size_t m_cursor = 0;
     double m_lastValue = 0;
 };
 
@@ -14,6 +14,7 @@
 #include "PGDMath.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 #include <algorithm>
@@ -30,55 +31,41 @@ double DataTargetMarkerCompare::calculateError(double time)
     m_errorScore = 0;
 
     size_t index, indexNext;
-    auto lowerBound = std::lower_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    auto upperBound = std::upper_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    if (lowerBound == targetTimeList()->begin()) // time <= lowest value in the list
-    {
-        index = 0;
-        indexNext = index;
-    }
-    else if (upperBound == targetTimeList()->end()) // time > highest value in the list
-    {
-        index = targetTimeList()->size() - 1;
-        indexNext = index;
-    }
-    else
-    {
-        index = std::distance(targetTimeList()->begin(), lowerBound) - 1; // subtracting 1 because lower bound gives an index 1 higher than expected (IMO)
-        indexNext = std::min(index + 1, targetTimeList()->size() - 1);
-    }
+    targetTimeInterval(time, &index, &indexNext);
+    double target = m_ValueList[index];
+    if (indexNext != index) target += m_GradientList[index] * (time - (*targetTimeList())[index]);
 
     while (true)
     {
         if (m_marker1Comparison == XWP && m_marker2Comparison == XWP)
         {
             double distance = m_marker2->GetWorldPosition().x - m_marker1->GetWorldPosition().x;
-            m_errorScore = (distance - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (distance - target);
             break;
         }
         if (m_marker1Comparison == YWP && m_marker2Comparison == YWP)
         {
             double distance = m_marker2->GetWorldPosition().y - m_marker1->GetWorldPosition().y;
-            m_errorScore = (distance - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (distance - target);
             break;
         }
         if (m_marker1Comparison == ZWP && m_marker2Comparison == ZWP)
         {
             double distance = m_marker2->GetWorldPosition().z - m_marker1->GetWorldPosition().z;
-            m_errorScore = (distance - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (distance - target);
             break;
         }
         if (m_marker1Comparison == Distance && m_marker2Comparison == Distance)
         {
             double distance = (m_marker1->GetWorldPosition() - m_marker2->GetWorldPosition()).Magnitude();
-            m_errorScore = (distance - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (distance - target);
             break;
         }
         if (m_marker1Comparison == Angle && m_marker2Comparison == Angle)
         {
             pgd::Quaternion q = pgd::FindRotation(m_marker1->GetWorldQuaternion(), m_marker2->GetWorldQuaternion());
             double angle = pgd::QGetAngle(q);
-            m_errorScore = (angle - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (angle - target);
             break;
         }
         pgd::Vector3 axis1, axis2;
@@ -92,7 +79,7 @@ double DataTargetMarkerCompare::calculateError(double time)
         // angle = acos(v1 dot v2)
         // axis = norm(v1 cross v2)
         double angle = std::acos(axis1 * axis2);
-        m_errorScore = (angle - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+        m_errorScore = (angle - target);
         break;
     }
 
@@ -229,22 +216,23 @@ std::string *DataTargetMarkerCompare::createFromAttributes()
         return lastErrorPtr();
     }
 
-    if (findAttribute("TargetValues"s, &buf) == nullptr) return lastErrorPtr();
-    std::vector<std::string> targetValuesTokens;
-    pystring::split(buf, targetValuesTokens);
-    if (targetValuesTokens.size() == 0)
+    if (findAttribute("TargetValues"s, &m_ValueList) == nullptr) return lastErrorPtr();
+    if (m_ValueList.size() == 0)
     {
         setLastError("DataTarget ID=\""s + name() +"\" No values found in TargetValues"s);
         return lastErrorPtr();
     }
-    if (targetValuesTokens.size() != targetTimeList()->size())
+    if (m_ValueList.size() != targetTimeList()->size())
     {
         setLastError("DataTargetScalar ID=\""s + name() +"\" Number of values in TargetValues does not match TargetTimes"s);
         return lastErrorPtr();
     }
-    m_ValueList.clear();
-    m_ValueList.reserve(targetValuesTokens.size());
-    for (auto token : targetValuesTokens) m_ValueList.push_back(GSUtil::Double(token));
+    m_GradientList.assign(m_ValueList.size(), 0);
+    for (size_t i = 0; i + 1 < m_ValueList.size(); i++)
+    {
+        double delTime = (*targetTimeList())[i + 1] - (*targetTimeList())[i];
+        if (std::fabs(delTime) >= DBL_EPSILON) m_GradientList[i] = (m_ValueList[i + 1] - m_ValueList[i]) / delTime;
+    }
 
     setUpstreamObjects({m_marker1, m_marker2});
     return nullptr;
@@ -263,3 +251,15 @@ void DataTargetMarkerCompare::appendToAttributes()
     setAttribute("TargetValues"s, *GSUtil::ToString(m_ValueList.data(), m_ValueList.size(), &buf));
 }
 
+void DataTargetMarkerCompare::saveState(StateBuffer *state)
+{
+    DataTarget::saveState(state);
+    state->Write(m_errorScore);
+}
+
+void DataTargetMarkerCompare::restoreState(StateBuffer *state)
+{
+    DataTarget::restoreState(state);
+    state->Read(&m_errorScore);
+}
+
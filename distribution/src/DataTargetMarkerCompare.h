@@ -24,6 +24,8 @@ public:
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     virtual double calculateError(double time);
     virtual double calculateError(size_t index);
@@ -35,6 +37,7 @@ private:
     Comparison m_marker2Comparison = XWP;
 
     std::vector<double> m_ValueList;
+    std::vector<double> m_GradientList; // precalculated for Continuous interpolation
     double m_errorScore = 0;
 };
 
@@ -69,23 +69,7 @@ double DataTargetQuaternion::calculateError(double time)
     double angle = 0;
 
     size_t index, indexNext;
-    auto lowerBound = std::lower_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    auto upperBound = std::upper_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    if (lowerBound == targetTimeList()->begin()) // time <= lowest value in the list
-    {
-        index = 0;
-        indexNext = index;
-    }
-    else if (upperBound == targetTimeList()->end()) // time > highest value in the list
-    {
-        index = targetTimeList()->size() - 1;
-        indexNext = index;
-    }
-    else
-    {
-        index = std::distance(targetTimeList()->begin(), lowerBound) - 1; // subtracting 1 because lower bound gives an index 1 higher than expected (IMO)
-        indexNext = std::min(index + 1, targetTimeList()->size() - 1);
-    }
+    targetTimeInterval(time, &index, &indexNext);
 
     // do a slerp interpolation between the target quaternions
     double delTime = (*targetTimeList())[size_t(indexNext)] - (*targetTimeList())[size_t(index)];
@@ -127,9 +111,8 @@ std::string DataTargetQuaternion::dumpToString()
     double angle = 0;
     dQuaternion q;
 
-    size_t valueListIndex = 0;
-    auto lowerBounds = std::lower_bound(targetTimeList()->begin(), targetTimeList()->end(), simulation()->GetTime());
-    if (lowerBounds != targetTimeList()->end()) valueListIndex = std::distance(targetTimeList()->begin(), lowerBounds);
+    size_t valueListIndex = targetTimeLowerBound(simulation()->GetTime());
+    if (valueListIndex >= targetTimeList()->size()) valueListIndex = 0;
 
     if ((body = dynamic_cast<Body *>(GetTarget())) != nullptr)
     {
@@ -187,15 +170,14 @@ std::string *DataTargetQuaternion::createFromAttributes()
         return lastErrorPtr();
     }
 
-    if (findAttribute("TargetValues"s, &buf) == nullptr) return lastErrorPtr();
-    std::vector<std::string> targetValuesTokens;
-    pystring::split(buf, targetValuesTokens);
-    if (targetValuesTokens.size() == 0)
+    std::vector<double> targetValues;
+    if (findAttribute("TargetValues"s, &targetValues) == nullptr) return lastErrorPtr();
+    if (targetValues.size() == 0)
     {
         setLastError("DataTargetQuaternion ID=\""s + name() +"\" No values found in TargetValues"s);
         return lastErrorPtr();
     }
-    if (targetValuesTokens.size() != targetTimeList()->size() * 4)
+    if (targetValues.size() != targetTimeList()->size() * 4)
     {
         setLastError("DataTargetQuaternion ID=\""s + name() +"\" Number of values in TargetValues does not match 4 * TargetTimes"s);
         return lastErrorPtr();
@@ -204,8 +186,7 @@ std::string *DataTargetQuaternion::createFromAttributes()
     m_QValueList.reserve(targetTimeList()->size());
     for (size_t i = 0; i < targetTimeList()->size(); i++)
     {
-        pgd::Quaternion q(GSUtil::Double(targetValuesTokens[i * 4]), GSUtil::Double(targetValuesTokens[i * 4 + 1]),
-                          GSUtil::Double(targetValuesTokens[i * 4 + 2]), GSUtil::Double(targetValuesTokens[i * 4 + 3]));
+        pgd::Quaternion q(targetValues[i * 4], targetValues[i * 4 + 1], targetValues[i * 4 + 2], targetValues[i * 4 + 3]);
         m_QValueList.push_back(q);
     }
 
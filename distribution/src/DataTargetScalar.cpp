@@ -347,23 +347,9 @@ double DataTargetScalar::calculateError(double time)
     TegotaeDriver *tegotaeDriver;
 
     size_t index, indexNext;
-    auto lowerBound = std::lower_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    auto upperBound = std::upper_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    if (lowerBound == targetTimeList()->begin()) // time <= lowest value in the list
-    {
-        index = 0;
-        indexNext = index;
-    }
-    else if (upperBound == targetTimeList()->end()) // time > highest value in the list
-    {
-        index = targetTimeList()->size() - 1;
-        indexNext = index;
-    }
-    else
-    {
-        index = std::distance(targetTimeList()->begin(), lowerBound) - 1; // subtracting 1 because lower bound gives an index 1 higher than expected (IMO)
-        indexNext = std::min(index + 1, targetTimeList()->size() - 1);
-    }
+    targetTimeInterval(time, &index, &indexNext);
+    double target = m_ValueList[index];
+    if (indexNext != index) target += m_GradientList[index] * (time - (*targetTimeList())[index]);
 
     if ((body = dynamic_cast<Body *>(GetTarget())) != nullptr)
     {
@@ -371,55 +357,55 @@ double DataTargetScalar::calculateError(double time)
         {
         case Q0:
             r = body->GetQuaternion();
-            m_errorScore = (r[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[0] - target);
             break;
         case Q1:
             r = body->GetQuaternion();
-            m_errorScore = (r[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[1] - target);
             break;
         case Q2:
             r = body->GetQuaternion();
-            m_errorScore = (r[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[2] - target);
             break;
         case Q3:
             r = body->GetQuaternion();
-            m_errorScore = (r[3] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[3] - target);
             break;
         case XP:
             r = body->GetPosition();
-            m_errorScore = (r[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[0] - target);
             break;
         case YP:
             r = body->GetPosition();
-            m_errorScore = (r[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[1] - target);
             break;
         case ZP:
             r = body->GetPosition();
-            m_errorScore = (r[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[2] - target);
             break;
         case XV:
             r = body->GetLinearVelocity();
-            m_errorScore = (r[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[0] - target);
             break;
         case YV:
             r = body->GetLinearVelocity();
-            m_errorScore = (r[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[1] - target);
             break;
         case ZV:
             r = body->GetLinearVelocity();
-            m_errorScore = (r[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[2] - target);
             break;
         case XRV:
             r = body->GetAngularVelocity();
-            m_errorScore = (r[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[0] - target);
             break;
         case YRV:
             r = body->GetAngularVelocity();
-            m_errorScore = (r[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[1] - target);
             break;
         case ZRV:
             r = body->GetAngularVelocity();
-            m_errorScore = (r[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (r[2] - target);
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -431,43 +417,43 @@ double DataTargetScalar::calculateError(double time)
         {
         case Q0:
             pq = marker->GetWorldQuaternion();
-            m_errorScore = (pq.n - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pq.n - target);
             break;
         case Q1:
             pq = marker->GetWorldQuaternion();
-            m_errorScore = (pq.x - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pq.x - target);
             break;
         case Q2:
             pq = marker->GetWorldQuaternion();
-            m_errorScore = (pq.y - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pq.y - target);
             break;
         case Q3:
             pq = marker->GetWorldQuaternion();
-            m_errorScore = (pq.z - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pq.z - target);
             break;
         case XP:
             pv = marker->GetWorldPosition();
-            m_errorScore = (pv.x - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pv.x - target);
             break;
         case YP:
             pv = marker->GetWorldPosition();
-            m_errorScore = (pv.y - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pv.y - target);
             break;
         case ZP:
             pv = marker->GetWorldPosition();
-            m_errorScore = (pv.z - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pv.z - target);
             break;
         case XV:
             pv = marker->GetWorldVelocity();
-            m_errorScore = (pv.x - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pv.x - target);
             break;
         case YV:
             pv = marker->GetWorldVelocity();
-            m_errorScore = (pv.y - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pv.y - target);
             break;
         case ZV:
             pv = marker->GetWorldVelocity();
-            m_errorScore = (pv.z - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (pv.z - target);
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -479,16 +465,16 @@ double DataTargetScalar::calculateError(double time)
         switch (m_DataType)
         {
         case XP:
-            m_errorScore = (result[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[0] - target);
             break;
         case YP:
-            m_errorScore = (result[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[1] - target);
             break;
         case ZP:
-            m_errorScore = (result[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[2] - target);
             break;
         case Angle:
-            m_errorScore = (hingeJoint->GetHingeAngle() - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (hingeJoint->GetHingeAngle() - target);
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -500,13 +486,13 @@ double DataTargetScalar::calculateError(double time)
         switch (m_DataType)
         {
         case XP:
-            m_errorScore = (result[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[0] - target);
             break;
         case YP:
-            m_errorScore = (result[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[1] - target);
             break;
         case ZP:
-            m_errorScore = (result[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[2] - target);
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -518,13 +504,13 @@ double DataTargetScalar::calculateError(double time)
         switch (m_DataType)
         {
         case XP:
-            m_errorScore = (result[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[0] - target);
             break;
         case YP:
-            m_errorScore = (result[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[1] - target);
             break;
         case ZP:
-            m_errorScore = (result[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[2] - target);
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -536,31 +522,31 @@ double DataTargetScalar::calculateError(double time)
         {
         case Q0:
             geom->GetWorldQuaternion(q);
-            m_errorScore = (q[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (q[0] - target);
             break;
         case Q1:
             geom->GetWorldQuaternion(q);
-            m_errorScore = (q[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (q[1] - target);
             break;
         case Q2:
             geom->GetWorldQuaternion(q);
-            m_errorScore = (q[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (q[2] - target);
             break;
         case Q3:
             geom->GetWorldQuaternion(q);
-            m_errorScore = (q[3] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (q[3] - target);
             break;
         case XP:
             geom->GetWorldPosition(result);
-            m_errorScore = (result[0] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[0] - target);
             break;
         case YP:
             geom->GetWorldPosition(result);
-            m_errorScore = (result[1] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[1] - target);
             break;
         case ZP:
             geom->GetWorldPosition(result);
-            m_errorScore = (result[2] - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (result[2] - target);
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -573,7 +559,7 @@ double DataTargetScalar::calculateError(double time)
         {
         case DriverError:
             errorVector = tegotaeDriver->localErrorVector();
-            m_errorScore = errorVector.Magnitude() - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time);
+            m_errorScore = errorVector.Magnitude() - target;
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -584,10 +570,10 @@ double DataTargetScalar::calculateError(double time)
         switch(m_DataType)
         {
         case MetabolicEnergy:
-            m_errorScore = (simulation()->GetMetabolicEnergy() - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (simulation()->GetMetabolicEnergy() - target);
             break;
         case MechanicalEnergy:
-            m_errorScore = (simulation()->GetMechanicalEnergy() - GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_ValueList[size_t(index)], (*targetTimeList())[indexNext], m_ValueList[indexNext], time));
+            m_errorScore = (simulation()->GetMechanicalEnergy() - target);
             break;
         default:
             std::cerr << "DataTargetScalar::GetMatchValue error in " << name() << " unknown DataType " << m_DataType << "\n";
@@ -853,22 +839,23 @@ std::string *DataTargetScalar::createFromAttributes()
         }
     }
 
-    if (findAttribute("TargetValues"s, &buf) == nullptr) return lastErrorPtr();
-    std::vector<std::string> targetValuesTokens;
-    pystring::split(buf, targetValuesTokens);
-    if (targetValuesTokens.size() == 0)
+    if (findAttribute("TargetValues"s, &m_ValueList) == nullptr) return lastErrorPtr();
+    if (m_ValueList.size() == 0)
     {
         setLastError("DataTarget ID=\""s + name() +"\" No values found in TargetValues"s);
         return lastErrorPtr();
     }
-    if (targetValuesTokens.size() != targetTimeList()->size())
+    if (m_ValueList.size() != targetTimeList()->size())
     {
         setLastError("DataTargetScalar ID=\""s + name() +"\" Number of values in TargetValues does not match TargetTimes"s);
         return lastErrorPtr();
     }
-    m_ValueList.clear();
-    m_ValueList.reserve(targetValuesTokens.size());
-    for (auto token : targetValuesTokens) m_ValueList.push_back(GSUtil::Double(token));
+    m_GradientList.assign(m_ValueList.size(), 0);
+    for (size_t i = 0; i + 1 < m_ValueList.size(); i++)
+    {
+        double delTime = (*targetTimeList())[i + 1] - (*targetTimeList())[i];
+        if (std::fabs(delTime) >= DBL_EPSILON) m_GradientList[i] = (m_ValueList[i + 1] - m_ValueList[i]) / delTime;
+    }
 
     if (m_Target) setUpstreamObjects({m_Target});
     return nullptr;
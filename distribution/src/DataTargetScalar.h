@@ -69,6 +69,7 @@ private:
     std::set<DataType> m_noTargetList = {MetabolicEnergy, MechanicalEnergy};
 
     std::vector<double> m_ValueList;
+    std::vector<double> m_GradientList; // precalculated for Continuous interpolation
     double m_errorScore = 0;
 };
 
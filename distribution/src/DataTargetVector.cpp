@@ -101,29 +101,17 @@ double DataTargetVector::calculateError(double time)
     dVector3 v;
 
     size_t index, indexNext;
-    auto lowerBound = std::lower_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    auto upperBound = std::upper_bound(targetTimeList()->begin(), targetTimeList()->end(), time);
-    if (lowerBound == targetTimeList()->begin()) // time <= lowest value in the list
-    {
-        index = 0;
-        indexNext = index;
-    }
-    else if (upperBound == targetTimeList()->end()) // time > highest value in the list
-    {
-        index = targetTimeList()->size() - 1;
-        indexNext = index;
-    }
-    else
+    targetTimeInterval(time, &index, &indexNext);
+
+    pgd::Vector3 interpolatedTarget = m_VValueList[index];
+    if (indexNext != index)
     {
-        index = std::distance(targetTimeList()->begin(), lowerBound) - 1; // subtracting 1 because lower bound gives an index 1 higher than expected (IMO)
-        indexNext = std::min(index + 1, targetTimeList()->size() - 1);
+        double delTime = time - (*targetTimeList())[index];
+        interpolatedTarget.x += m_VGradientList[index].x * delTime;
+        interpolatedTarget.y += m_VGradientList[index].y * delTime;
+        interpolatedTarget.z += m_VGradientList[index].z * delTime;
     }
 
-    double interpX = GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_VValueList[size_t(index)].x, (*targetTimeList())[size_t(indexNext)], m_VValueList[size_t(indexNext)].x, time);
-    double interpY = GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_VValueList[size_t(index)].y, (*targetTimeList())[size_t(indexNext)], m_VValueList[size_t(indexNext)].y, time);
-    double interpZ = GSUtil::Interpolate((*targetTimeList())[size_t(index)], m_VValueList[size_t(index)].z, (*targetTimeList())[size_t(indexNext)], m_VValueList[size_t(indexNext)].z, time);
-    pgd::Vector3 interpolatedTarget(interpX, interpY, interpZ);
-
     if ((body = dynamic_cast<Body *>(GetTarget())) != nullptr)
     {
         r = body->GetPosition();
@@ -181,9 +169,8 @@ std::string DataTargetVector::dumpToString()
     double err = 0;
     dVector3 v;
 
-    size_t valueListIndex = 0;
-    auto lowerBounds = std::lower_bound(targetTimeList()->begin(), targetTimeList()->end(), simulation()->GetTime());
-    if (lowerBounds != targetTimeList()->end()) valueListIndex = std::distance(targetTimeList()->begin(), lowerBounds);
+    size_t valueListIndex = targetTimeLowerBound(simulation()->GetTime());
+    if (valueListIndex >= targetTimeList()->size()) valueListIndex = 0;
 
     if ((body = dynamic_cast<Body *>(GetTarget())) != nullptr)
     {
@@ -269,15 +256,14 @@ std::string *DataTargetVector::createFromAttributes()
         return lastErrorPtr();
     }
 
-    if (findAttribute("TargetValues"s, &buf) == nullptr) return lastErrorPtr();
-    std::vector<std::string> targetValuesTokens;
-    pystring::split(buf, targetValuesTokens);
-    if (targetValuesTokens.size() == 0)
+    std::vector<double> targetValues;
+    if (findAttribute("TargetValues"s, &targetValues) == nullptr) return lastErrorPtr();
+    if (targetValues.size() == 0)
     {
         setLastError("DataTargetVector ID=\""s + name() +"\" No values found in TargetValues"s);
         return lastErrorPtr();
     }
-    if (targetValuesTokens.size() != targetTimeList()->size() * 3)
+    if (targetValues.size() != targetTimeList()->size() * 3)
     {
         setLastError("DataTargetVector ID=\""s + name() +"\" Number of values in TargetValues does not match 3 * TargetTimes"s);
         return lastErrorPtr();
@@ -286,9 +272,18 @@ std::string *DataTargetVector::createFromAttributes()
     m_VValueList.reserve(targetTimeList()->size());
     for (size_t i = 0; i < targetTimeList()->size(); i++)
     {
-        pgd::Vector3 v(GSUtil::Double(targetValuesTokens[i * 3]), GSUtil::Double(targetValuesTokens[i * 3 + 1]), GSUtil::Double(targetValuesTokens[i * 3 + 2]));
+        pgd::Vector3 v(targetValues[i * 3], targetValues[i * 3 + 1], targetValues[i * 3 + 2]);
         m_VValueList.push_back(v);
     }
+    m_VGradientList.assign(m_VValueList.size(), pgd::Vector3(0, 0, 0));
+    for (size_t i = 0; i + 1 < m_VValueList.size(); i++)
+    {
+        double delTime = (*targetTimeList())[i + 1] - (*targetTimeList())[i];
+        if (std::fabs(delTime) < DBL_EPSILON) continue;
+        m_VGradientList[i].x = (m_VValueList[i + 1].x - m_VValueList[i].x) / delTime;
+        m_VGradientList[i].y = (m_VValueList[i + 1].y - m_VValueList[i].y) / delTime;
+        m_VGradientList[i].z = (m_VValueList[i + 1].z - m_VValueList[i].z) / delTime;
+    }
 
     if (m_Target) setUpstreamObjects({m_Target});
     return nullptr;
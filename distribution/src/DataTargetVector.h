@@ -35,6 +35,7 @@ private:
 
     NamedObject *m_Target = nullptr;
     std::vector<pgd::Vector3> m_VValueList;
+    std::vector<pgd::Vector3> m_VGradientList; // precalculated for Continuous interpolation
 
 };
 
@@ -9,6 +9,7 @@
 
 #include "Drivable.h"
 #include "Driver.h"
+#include "StateBuffer.h"
 
 Drivable::Drivable()
 {
@@ -40,3 +41,16 @@ void Drivable::setDataSum(double dataSum)
 {
     m_dataSum = dataSum;
 }
+
+void Drivable::saveState(StateBuffer *state)
+{
+    state->Write(m_dataSum);
+    state->Write(m_receiveDataStepCount);
+}
+
+void Drivable::restoreState(StateBuffer *state)
+{
+    state->Read(&m_dataSum);
+    state->Read(&m_receiveDataStepCount);
+}
+
@@ -17,6 +17,8 @@
 class Driver;
 class NamedObject;
 
+class StateBuffer;
+
 class Drivable
 {
 public:
@@ -24,6 +26,8 @@ public:
     virtual ~Drivable();
 
     virtual void ReceiveData(double receivedData, int64_t receiveDataStepCount);
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 protected:
     double dataSum() const;
@@ -17,6 +17,7 @@
 #include "GSUtil.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 
@@ -214,3 +215,17 @@ void Driver::setValue(double value)
     m_value = value;
 }
 
+void Driver::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    state->Write(m_lastStepCount);
+    state->Write(m_value);
+}
+
+void Driver::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    state->Read(&m_lastStepCount);
+    state->Read(&m_value);
+}
+
@@ -35,6 +35,8 @@ public:
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     double MinValue() const;
     void setMinValue(double MinValue);
@@ -11,9 +11,9 @@
 #include <stdarg.h>
 #include "ErrorHandler.h"
 
-static char gMessageText[1024] = "";
-static int gMessageNumber = 0;
-static int gMessageFlag = false;
+static thread_local char gMessageText[1024] = "";
+static thread_local int gMessageNumber = 0;
+static thread_local int gMessageFlag = false;
 
 extern "C" void ODEMessageTrap(int num, const char *msg, va_list ap)
 {
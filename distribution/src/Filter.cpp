@@ -10,6 +10,7 @@
  */
 
 #include "Filter.h"
+#include "StateBuffer.h"
 
 Filter::Filter()
 {
@@ -41,4 +42,13 @@ void Filter::setXn(double xn)
     m_xn = xn;
 }
 
+void Filter::saveState(StateBuffer *state)
+{
+    state->Write(m_xn);
+}
+
+void Filter::restoreState(StateBuffer *state)
+{
+    state->Read(&m_xn);
+}
 
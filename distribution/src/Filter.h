@@ -13,6 +13,8 @@
 #define FILTER_H
 
 
+class StateBuffer;
+
 class Filter
 {
 public:
@@ -21,6 +23,8 @@ public:
 
     virtual void AddNewSample(double x);
     virtual double Output();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 
     double xn() const;
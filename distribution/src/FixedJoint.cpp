@@ -15,8 +15,16 @@
 #include "ButterworthFilter.h"
 #include "MovingAverage.h"
 #include "Marker.h"
+#include "StateBuffer.h"
 
 #include <sstream>
+#include <cfloat>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIXED_JOINT_AVX2_DISPATCH
+#include <immintrin.h>
+#endif
 
 using namespace std::string_literals;
 
@@ -114,23 +122,34 @@ void FixedJoint::CalculateStress()
         double My = m_torqueStressCoords.y;
         double Mx = m_torqueStressCoords.x;
         // precalculate invariant bits of the formula
-        double t1 = (My * m_Ix + Mx * m_Ixy)/(m_Ix * m_Iy - m_Ixy * m_Ixy);
-        double t2 = (Mx * m_Iy + My * m_Ixy)/(m_Ix * m_Iy - m_Ixy * m_Ixy);
-        double *xDistancePtr = m_xDistances.data();
-        double *yDistancePtr = m_yDistances.data();
+        m_t1 = (My * m_Ix + Mx * m_Ixy)/(m_Ix * m_Iy - m_Ixy * m_Ixy);
+        m_t2 = (Mx * m_Iy + My * m_Ixy)/(m_Ix * m_Iy - m_Ixy * m_Ixy);
+        m_linearStress = linearStress;
 
-        double *stressPtr = m_stress.data();
-        m_minStress = DBL_MAX;
-        m_maxStress = -DBL_MAX;
-        for (size_t i = 0; i < m_nActivePixels; i++)
+        if (ReducedBeam())
         {
-            *stressPtr = -t1 * (*xDistancePtr) + t2 * (*yDistancePtr) + linearStress;
-            if (*stressPtr > m_maxStress) m_maxStress = *stressPtr;
-            if (*stressPtr < m_minStress) m_minStress = *stressPtr;
-            stressPtr++;
-            xDistancePtr++;
-            yDistancePtr++;
+            // the stress is linear in x and y so its extremes are on the convex hull of the cross section
+            // and the map itself is only calculated if something asks for it
+            BeamStressRange(m_hullXDistances, m_hullYDistances, m_t1, m_t2, m_linearStress, &m_minStress, &m_maxStress);
+            m_stressMapValid = false;
+            if (m_lowPassType != NoLowPass)
+            {
+                // the filters are linear so filtering the three coefficients is the same as filtering every pixel
+                m_filteredStress[0]->AddNewSample(m_t1);
+                m_filteredStress[1]->AddNewSample(m_t2);
+                m_filteredStress[2]->AddNewSample(m_linearStress);
+                BeamStressRange(m_hullXDistances, m_hullYDistances, m_filteredStress[0]->Output(), m_filteredStress[1]->Output(), m_filteredStress[2]->Output(),
+                                &m_lowPassMinStress, &m_lowPassMaxStress);
+            }
+            else
+            {
+                m_lowPassMinStress = m_minStress;
+                m_lowPassMaxStress = m_maxStress;
+            }
+            return;
         }
+
+        BeamStressKernel(m_xDistances.data(), m_yDistances.data(), m_nActivePixels, m_t1, m_t2, m_linearStress, m_stress.data(), &m_minStress, &m_maxStress);
     }
     else if (m_stressCalculationType == spring)
     {
@@ -241,6 +260,106 @@ void FixedJoint::CalculateStress()
     }
 }
 
+#ifdef FIXED_JOINT_AVX2_DISPATCH
+// AVX2 version of BeamStressKernel, only called when the CPU supports it. The multiplies and adds are done
+// separately and in the same order as the scalar loop (no FMA) so the stress values are bit identical
+__attribute__((target("avx2")))
+static void BeamStressKernelAVX2(const double *xDistances, const double *yDistances, size_t n, double t1, double t2, double linearStress,
+                                 double *stress, double *minStress, double *maxStress)
+{
+    __m256d minusT1 = _mm256_set1_pd(-t1);
+    __m256d plusT2 = _mm256_set1_pd(t2);
+    __m256d offset = _mm256_set1_pd(linearStress);
+    __m256d localMin4 = _mm256_set1_pd(DBL_MAX);
+    __m256d localMax4 = _mm256_set1_pd(-DBL_MAX);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d v = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(minusT1, _mm256_loadu_pd(xDistances + i)),
+                                                _mm256_mul_pd(plusT2, _mm256_loadu_pd(yDistances + i))), offset);
+        _mm256_storeu_pd(stress + i, v);
+        localMin4 = _mm256_min_pd(v, localMin4); // returns the second operand for NaN like the scalar comparison
+        localMax4 = _mm256_max_pd(v, localMax4);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, localMin4);
+    double localMin = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+    _mm256_storeu_pd(lanes, localMax4);
+    double localMax = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    for (; i < n; i++)
+    {
+        double v = -t1 * xDistances[i] + t2 * yDistances[i] + linearStress;
+        stress[i] = v;
+        if (v < localMin) localMin = v;
+        if (v > localMax) localMax = v;
+    }
+    *minStress = localMin;
+    *maxStress = localMax;
+}
+#endif
+
+// stress[i] = -t1 * xDistances[i] + t2 * yDistances[i] + linearStress and the range of stress
+void FixedJoint::BeamStressKernel(const double *xDistances, const double *yDistances, size_t n, double t1, double t2, double linearStress,
+                                  double *stress, double *minStress, double *maxStress)
+{
+#ifdef FIXED_JOINT_AVX2_DISPATCH
+    static const bool useAVX2 = __builtin_cpu_supports("avx2");
+    if (useAVX2)
+    {
+        BeamStressKernelAVX2(xDistances, yDistances, n, t1, t2, linearStress, stress, minStress, maxStress);
+        return;
+    }
+#endif
+    double localMin = DBL_MAX;
+    double localMax = -DBL_MAX;
+    for (size_t i = 0; i < n; i++)
+    {
+        double v = -t1 * xDistances[i] + t2 * yDistances[i] + linearStress;
+        stress[i] = v;
+        if (v < localMin) localMin = v;
+        if (v > localMax) localMax = v;
+    }
+    *minStress = localMin;
+    *maxStress = localMax;
+}
+
+// the range of the beam stress over a set of points without storing the values
+void FixedJoint::BeamStressRange(const std::vector<double> &xDistances, const std::vector<double> &yDistances, double t1, double t2, double linearStress,
+                                 double *minStress, double *maxStress)
+{
+    double localMin = DBL_MAX;
+    double localMax = -DBL_MAX;
+    for (size_t i = 0; i < xDistances.size(); i++)
+    {
+        double v = -t1 * xDistances[i] + t2 * yDistances[i] + linearStress;
+        if (v < localMin) localMin = v;
+        if (v > localMax) localMax = v;
+    }
+    *minStress = localMin;
+    *maxStress = localMax;
+}
+
+// fills in the full stress map (and the low pass map if needed) when the reduced calculation has been used
+void FixedJoint::CalculateStressMap()
+{
+    if (m_stressMapValid) return;
+    double minStress, maxStress;
+    BeamStressKernel(m_xDistances.data(), m_yDistances.data(), m_nActivePixels, m_t1, m_t2, m_linearStress, m_stress.data(), &minStress, &maxStress);
+    if (m_lowPassType != NoLowPass)
+    {
+        m_lowPassStress.resize(m_nActivePixels);
+        BeamStressKernel(m_xDistances.data(), m_yDistances.data(), m_nActivePixels, m_filteredStress[0]->Output(), m_filteredStress[1]->Output(), m_filteredStress[2]->Output(),
+                         m_lowPassStress.data(), &minStress, &maxStress);
+    }
+    m_stressMapValid = true;
+}
+
+const std::vector<double> &FixedJoint::GetStress()
+{
+    CalculateStressMap();
+    return m_stress;
+}
+
 const std::vector<unsigned char> &FixedJoint::pixMap() const
 {
     return m_pixMap;
@@ -381,6 +500,39 @@ void FixedJoint::SetCrossSection(const std::vector<unsigned char> &stiffness, si
         }
     }
 
+    // the convex hull of the pixel centres only needs the end pixels of each row as candidates
+    // and then Andrew's monotone chain (the candidates are already sorted by y then x)
+    std::vector<pgd::Vector2> candidates;
+    candidates.reserve(2 * m_ny);
+    xDistancePtr = m_xDistances.data();
+    yDistancePtr = m_yDistances.data();
+    for (size_t i = 0; i < m_nActivePixels; i++)
+    {
+        if (i == 0 || yDistancePtr[i] != yDistancePtr[i - 1]) candidates.push_back(pgd::Vector2(xDistancePtr[i], yDistancePtr[i]));
+        else if (i + 1 == m_nActivePixels || yDistancePtr[i] != yDistancePtr[i + 1]) candidates.push_back(pgd::Vector2(xDistancePtr[i], yDistancePtr[i]));
+    }
+    auto cross = [](const pgd::Vector2 &o, const pgd::Vector2 &a, const pgd::Vector2 &b) { return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x); };
+    std::vector<pgd::Vector2> hull(2 * candidates.size() + 1);
+    size_t k = 0;
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], candidates[i]) <= 0) k--;
+        hull[k++] = candidates[i];
+    }
+    for (size_t i = candidates.size() - 1, lower = k + 1; candidates.size() && i > 0; i--)
+    {
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], candidates[i - 1]) <= 0) k--;
+        hull[k++] = candidates[i - 1];
+    }
+    if (k > 1) k--; // the last point is the same as the first
+    m_hullXDistances.resize(k);
+    m_hullYDistances.resize(k);
+    for (size_t i = 0; i < k; i++)
+    {
+        m_hullXDistances[i] = hull[i].x;
+        m_hullYDistances[i] = hull[i].y;
+    }
+
     // allocate the vector list
     m_vectorList.clear();
     m_vectorList.resize(m_nActivePixels);
@@ -414,8 +566,9 @@ void FixedJoint::SetWindow(size_t window)
     m_window = window;
     m_lowPassType = MovingAverageLowPass;
     m_filteredStress.clear();
-    m_filteredStress.reserve(m_nActivePixels);
-    for (size_t i = 0; i < m_nActivePixels; i++) m_filteredStress.push_back(std::make_unique<MovingAverage>(int(window)));
+    size_t nFilters = ReducedBeam() ? 3 : m_nActivePixels; // reduced mode filters the beam coefficients rather than the pixels
+    m_filteredStress.reserve(nFilters);
+    for (size_t i = 0; i < nFilters; i++) m_filteredStress.push_back(std::make_unique<MovingAverage>(int(window)));
 }
 
 void FixedJoint::SetCutoffFrequency(double cutoffFrequency)
@@ -426,9 +579,13 @@ void FixedJoint::SetCutoffFrequency(double cutoffFrequency)
 //    m_maxStressButterworth = new ButterworthFilter(cutoffFrequency, samplingFrequency);
     m_lowPassType = Butterworth2ndOrderLowPass;
     m_filteredStress.clear();
-    m_filteredStress.reserve(m_nActivePixels);
-    for (size_t i = 0; i < m_nActivePixels; i++) m_filteredStress.push_back(std::make_unique<SharedButterworthFilter>());
-    SharedButterworthFilter::CalculateCoefficients(cutoffFrequency, samplingFrequency);
+    size_t nFilters = ReducedBeam() ? 3 : m_nActivePixels; // reduced mode filters the beam coefficients rather than the pixels
+    m_filteredStress.reserve(nFilters);
+    // as before the coefficients are shared by every fixed joint so the last cutoff frequency set is used by all of them
+    // but they belong to the simulation so that simulations running in other threads are not affected
+    SharedButterworthFilter::Coefficients *coefficients = simulation()->GetSharedButterworthCoefficients();
+    for (size_t i = 0; i < nFilters; i++) m_filteredStress.push_back(std::make_unique<SharedButterworthFilter>(coefficients));
+    SharedButterworthFilter::CalculateCoefficients(coefficients, cutoffFrequency, samplingFrequency);
 }
 
 bool FixedJoint::CheckStressAbort()
@@ -473,6 +630,8 @@ std::string *FixedJoint::createFromAttributes()
         else if (buf == "NoLowPass"s) this->SetLowPassType(FixedJoint::NoLowPass);
         else { setLastError("Joint ID=\""s + name() +"\" unrecognised LowPassType"s); return lastErrorPtr(); }
 
+        if (findAttribute("ReducedStressCalculation"s, &buf)) this->SetReducedStressCalculation(GSUtil::Bool(buf));
+
         if (findAttribute("StressLimit"s, &buf) == nullptr) return lastErrorPtr();
         this->SetStressLimit(GSUtil::Double(buf.c_str()));
 
@@ -548,6 +707,7 @@ void FixedJoint::appendToAttributes()
             setAttribute("LowPassType"s, "NoLowPass"s);
             break;
         }
+        setAttribute("ReducedStressCalculation"s, *GSUtil::ToString(m_reducedStressCalculation, &buf));
         setAttribute("StressLimit"s, *GSUtil::ToString(m_stressLimit, &buf));
         double doubleList[2] = { m_dx, m_dy };
         setAttribute("StressBitmapPixelSize"s, *GSUtil::ToString(doubleList, 2, &buf));
@@ -702,6 +862,8 @@ void FixedJoint::CalculatePixmap()
         }
         else
         {
+            CalculateStressMap();
+            bool reducedBeam = ReducedBeam();
             double *stressPtr = m_stress.data();
             size_t filteredStressIndex = 0;
             double v;
@@ -730,20 +892,23 @@ void FixedJoint::CalculatePixmap()
 
                         case MovingAverageLowPass:
                         case Butterworth2ndOrderLowPass:
+                        {
+                            double lowPassStress = reducedBeam ? m_lowPassStress[filteredStressIndex] : m_filteredStress[filteredStressIndex]->Output();
                             if (m_lowRange != m_highRange)
                             {
-                                v = (m_filteredStress[filteredStressIndex]->Output() - m_lowRange) / (m_highRange - m_lowRange);
+                                v = (lowPassStress - m_lowRange) / (m_highRange - m_lowRange);
                             }
                             else
                             {
                                 if (m_minStress != m_maxStress)
-                                    v = (m_filteredStress[filteredStressIndex]->Output() - m_minStress) / (m_maxStress - m_minStress);
+                                    v = (lowPassStress - m_minStress) / (m_maxStress - m_minStress);
                                 else
                                     v = 0;
                             }
                             filteredStressIndex++;
                             break;
                         }
+                        }
 
                         int idx = (int)(255.0 * v) * 4;
                         m_pixMap[i++] = m_colourMap[idx++];
@@ -811,5 +976,35 @@ std::vector<unsigned char> FixedJoint::AsciiToBitMap(const std::string &buffer,
     return bitmap;
 }
 
+void FixedJoint::saveState(StateBuffer *state)
+{
+    Joint::saveState(state);
+    state->Write(m_stress);
+    state->Write(m_minStress);
+    state->Write(m_maxStress);
+    state->Write(m_lowPassMinStress);
+    state->Write(m_lowPassMaxStress);
+    state->Write(m_lastDisplayTime);
+    state->Write(m_t1);
+    state->Write(m_t2);
+    state->Write(m_linearStress);
+    state->Write(m_stressMapValid);
+    for (auto &&it : m_filteredStress) it->saveState(state);
+}
 
+void FixedJoint::restoreState(StateBuffer *state)
+{
+    Joint::restoreState(state);
+    state->Read(&m_stress);
+    state->Read(&m_minStress);
+    state->Read(&m_maxStress);
+    state->Read(&m_lowPassMinStress);
+    state->Read(&m_lowPassMaxStress);
+    state->Read(&m_lastDisplayTime);
+    state->Read(&m_t1);
+    state->Read(&m_t2);
+    state->Read(&m_linearStress);
+    state->Read(&m_stressMapValid);
+    for (auto &&it : m_filteredStress) it->restoreState(state);
+}
 
@@ -57,13 +57,20 @@ class FixedJoint: public Joint
     double GetLowPassMinStress() { return m_lowPassMinStress; }
     double GetLowPassMaxStress() { return m_lowPassMaxStress; }
 
-    const std::vector<double> &GetStress() { return m_stress; }
+    const std::vector<double> &GetStress();
+
+    // in reduced mode a beam stress calculation only finds the minimum and maximum stress each step
+    // and the full stress map is calculated when it is asked for. This needs to be set before SetWindow or SetCutoffFrequency
+    void SetReducedStressCalculation(bool reducedStressCalculation) { m_reducedStressCalculation = reducedStressCalculation; }
+    bool GetReducedStressCalculation() { return m_reducedStressCalculation; }
 
     virtual void Update();
     virtual std::string dumpToString();
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     double maxStress() const;
 
@@ -94,6 +101,12 @@ class FixedJoint: public Joint
 private:
 
     void CalculateStress();
+    void CalculateStressMap();
+    bool ReducedBeam() const { return m_reducedStressCalculation && m_stressCalculationType == beam; }
+    static void BeamStressKernel(const double *xDistances, const double *yDistances, size_t n, double t1, double t2, double linearStress,
+                                 double *stress, double *minStress, double *maxStress);
+    static void BeamStressRange(const std::vector<double> &xDistances, const std::vector<double> &yDistances, double t1, double t2, double linearStress,
+                                double *minStress, double *maxStress);
     static std::vector<unsigned char> AsciiToBitMap(const std::string &buffer, size_t width, size_t height, char setChar, bool reverseY);
 
     // these are used for the stress/strain calculations
@@ -104,6 +117,8 @@ private:
     size_t m_nx = 0;
     size_t m_ny = 0;
     size_t m_nActivePixels = 0;
+    std::vector<double> m_hullXDistances; // convex hull of the pixel centres (the extremes of a linear stress field are always on it)
+    std::vector<double> m_hullYDistances;
     double m_dx = 0;
     double m_dy = 0;
     double m_Ix = 0;
@@ -117,6 +132,12 @@ private:
     double m_width = 0;
     double m_height = 0;
     StressCalculationType m_stressCalculationType = StressCalculationType::none;
+    bool m_reducedStressCalculation = false;
+    bool m_stressMapValid = true;
+    double m_t1 = 0; // beam stress is -t1 * x + t2 * y + linearStress
+    double m_t2 = 0;
+    double m_linearStress = 0;
+    std::vector<double> m_lowPassStress; // only used in reduced mode when the low pass map is needed
 
     pgd::Vector3 m_StressOrigin;
     pgd::Quaternion m_StressOrientation;
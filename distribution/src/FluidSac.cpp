@@ -15,6 +15,7 @@
 #include "ode/ode.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <map>
 #include <algorithm>
@@ -28,67 +29,108 @@ FluidSac::FluidSac()
 
 void FluidSac::calculateVolume()
 {
-    for (size_t i = 0; i < m_markerList.size(); i++) m_vertexList[i] = m_markerList[i]->GetWorldPosition();
-    m_sacVolume = volumeOfMesh(m_triangleList, m_vertexList);
+    for (size_t i = 0; i < m_markerList.size(); i++)
+    {
+        pgd::Vector3 position = m_markerList[i]->GetWorldPosition();
+        m_vertexX[i] = position.x;
+        m_vertexY[i] = position.y;
+        m_vertexZ[i] = position.z;
+    }
+
+    // this is the same as volumeOfMesh but using the structure of arrays copy of the mesh
+    double volumeSum = 0;
+    size_t nTriangles = m_triangleV0.size();
+    for (size_t i = 0; i < nTriangles; i++)
+    {
+        size_t i0 = m_triangleV0[i], i1 = m_triangleV1[i], i2 = m_triangleV2[i];
+        double x0 = m_vertexX[i0], y0 = m_vertexY[i0], z0 = m_vertexZ[i0];
+        double x1 = m_vertexX[i1], y1 = m_vertexY[i1], z1 = m_vertexZ[i1];
+        double x2 = m_vertexX[i2], y2 = m_vertexY[i2], z2 = m_vertexZ[i2];
+        volumeSum += x0 * (y1 * z2 - z1 * y2) + y0 * (z1 * x2 - x1 * z2) + z0 * (x1 * y2 - y1 * x2);
+    }
+    m_sacVolume = std::abs(volumeSum) / 6.0;
 }
 
 
 void FluidSac::calculateLoadsOnMarkers()
 {
-    pgd::Vector3 v01, v12, v20;
-    m_pointForceList.resize(m_triangleList.size() * 3);
-    size_t pointListIndex = 0;
-    for (size_t i = 0; i < m_triangleList.size(); i++)
+    // the pressure load on each triangle is F = pressure * area * normal acting at the centroid
+    // the barycentric coordinates of the centroid are (1/3, 1/3, 1/3) so each vertex reacts a third of F
+    // and since the cross product of two edges is 2 * area * normal each vertex gets pressure * cross / 6
+    // so there is no need to normalise or to rotate the triangle into a plane
+
+    // first the cross products (this loop has no dependencies between triangles)
+    size_t nTriangles = m_triangleV0.size();
+    for (size_t i = 0; i < nTriangles; i++)
+    {
+        size_t i0 = m_triangleV0[i], i1 = m_triangleV1[i], i2 = m_triangleV2[i];
+        double e0x = m_vertexX[i1] - m_vertexX[i0];
+        double e0y = m_vertexY[i1] - m_vertexY[i0];
+        double e0z = m_vertexZ[i1] - m_vertexZ[i0];
+        double e1x = m_vertexX[i2] - m_vertexX[i1];
+        double e1y = m_vertexY[i2] - m_vertexY[i1];
+        double e1z = m_vertexZ[i2] - m_vertexZ[i1];
+        m_crossX[i] = e0y * e1z - e0z * e1y;
+        m_crossY[i] = e0z * e1x - e0x * e1z;
+        m_crossZ[i] = e0x * e1y - e0y * e1x;
+    }
+
+    // then sum them onto the markers
+    std::fill(m_markerLoadX.begin(), m_markerLoadX.end(), 0.0);
+    std::fill(m_markerLoadY.begin(), m_markerLoadY.end(), 0.0);
+    std::fill(m_markerLoadZ.begin(), m_markerLoadZ.end(), 0.0);
+    for (size_t i = 0; i < nTriangles; i++)
+    {
+        size_t i0 = m_triangleV0[i], i1 = m_triangleV1[i], i2 = m_triangleV2[i];
+        m_markerLoadX[i0] += m_crossX[i]; m_markerLoadY[i0] += m_crossY[i]; m_markerLoadZ[i0] += m_crossZ[i];
+        m_markerLoadX[i1] += m_crossX[i]; m_markerLoadY[i1] += m_crossY[i]; m_markerLoadZ[i1] += m_crossZ[i];
+        m_markerLoadX[i2] += m_crossX[i]; m_markerLoadY[i2] += m_crossY[i]; m_markerLoadZ[i2] += m_crossZ[i];
+    }
+
+    // and finally apply the pressure (the bodies were set up in buildTopology)
+    double scale = m_pressure / 6.0;
+    for (size_t i = 0; i < m_pointForceList.size(); i++)
+    {
+        PointForce *pointForce = &m_pointForceList[i];
+        pointForce->point[0] = m_vertexX[i];
+        pointForce->point[1] = m_vertexY[i];
+        pointForce->point[2] = m_vertexZ[i];
+        pointForce->vector[0] = m_markerLoadX[i] * scale;
+        pointForce->vector[1] = m_markerLoadY[i] * scale;
+        pointForce->vector[2] = m_markerLoadZ[i] * scale;
+    }
+}
+
+void FluidSac::buildTopology()
+{
+    // everything that depends only on the mesh connectivity is done once here
+    size_t nTriangles = m_triangleList.size();
+    m_triangleV0.resize(nTriangles);
+    m_triangleV1.resize(nTriangles);
+    m_triangleV2.resize(nTriangles);
+    for (size_t i = 0; i < nTriangles; i++)
     {
-        // for each triangle calculate the equivalent force and torque on each marker.
-        FluidSac::Triangle *it = &m_triangleList[i];
-        areaCentroidNormal(m_vertexList[it->v0], m_vertexList[it->v1], m_vertexList[it->v2], &it->area, &it->centroid, &it->normal);
-
-        // now rotate the system so that the normal is aligned to the z axis
-        pgd::Quaternion r = pgd::FindRotation(it->normal, pgd::Vector3(0, 0, 1));
-        pgd::Vector3 v0 = pgd::QVRotate(r, m_vertexList[it->v0]);
-        pgd::Vector3 v1 = pgd::QVRotate(r, m_vertexList[it->v1]);
-        pgd::Vector3 v2 = pgd::QVRotate(r, m_vertexList[it->v2]);
-        pgd::Vector3 centroid = pgd::QVRotate(r, it->centroid);
-
-        // now we can use the Z=0 triangle formulae
-        // the triangle is in the z=0 plane
-        // the applied vertical force is F
-        // the reaction reaction forces are R0, R1, R2
-        // the position of the applied force is specified as x, y
-        // the positions of the vertices are x0,y0, x1,y1, x2,y2
-
-        // R0 = (F*(x*y1 - x1*y - x*y2 + x2*y + x1*y2 - x2*y1))/(x0*y1 - x1*y0 - x0*y2 + x2*y0 + x1*y2 - x2*y1)
-        // R1 = -(F*(x*y0 - x0*y - x*y2 + x0*y2 + x2*y - x2*y0))/(x0*y1 - x1*y0 - x0*y2 + x2*y0 + x1*y2 - x2*y1)
-        // R2 = (F*(x*y0 - x0*y - x*y1 + x0*y1 + x1*y - x1*y0))/(x0*y1 - x1*y0 - x0*y2 + x2*y0 + x1*y2 - x2*y1)
-
-        double x = centroid.x;
-        double y = centroid.y;
-        double x0 = v0.x;
-        double x1 = v1.x;
-        double x2 = v2.x;
-        double y0 = v0.y;
-        double y1 = v1.y;
-        double y2 = v2.y;
-        double F = it->area * m_pressure;
-        double denom = (x0*y1 - x1*y0 - x0*y2 + x2*y0 + x1*y2 - x2*y1);
-        double R0 = (F*(x*y1 - x1*y - x*y2 + x2*y + x1*y2 - x2*y1)) / denom;
-        double R1 = -(F*(x*y0 - x0*y - x*y2 + x0*y2 + x2*y - x2*y0)) / denom;
-        double R2 = (F*(x*y0 - x0*y - x*y1 + x0*y1 + x1*y - x1*y0)) / denom;
-
-        // and add the reaction forces to the body
-        m_pointForceList[pointListIndex].body = m_markerList[it->v0]->GetBody();
-        std::copy_n(m_vertexList[it->v0].data(), 3, m_pointForceList[pointListIndex].point);
-        std::copy_n((it->normal * R0).data(), 3, m_pointForceList[pointListIndex].vector);
-        pointListIndex++;
-        m_pointForceList[pointListIndex].body = m_markerList[it->v1]->GetBody();
-        std::copy_n(m_vertexList[it->v1].data(), 3, m_pointForceList[pointListIndex].point);
-        std::copy_n((it->normal * R1).data(), 3, m_pointForceList[pointListIndex].vector);
-        pointListIndex++;
-        m_pointForceList[pointListIndex].body = m_markerList[it->v2]->GetBody();
-        std::copy_n(m_vertexList[it->v2].data(), 3, m_pointForceList[pointListIndex].point);
-        std::copy_n((it->normal * R2).data(), 3, m_pointForceList[pointListIndex].vector);
-        pointListIndex++;
+        m_triangleV0[i] = m_triangleList[i].v0;
+        m_triangleV1[i] = m_triangleList[i].v1;
+        m_triangleV2[i] = m_triangleList[i].v2;
+    }
+    m_crossX.assign(nTriangles, 0);
+    m_crossY.assign(nTriangles, 0);
+    m_crossZ.assign(nTriangles, 0);
+
+    size_t nMarkers = m_markerList.size();
+    m_vertexX.assign(nMarkers, 0);
+    m_vertexY.assign(nMarkers, 0);
+    m_vertexZ.assign(nMarkers, 0);
+    m_markerLoadX.assign(nMarkers, 0);
+    m_markerLoadY.assign(nMarkers, 0);
+    m_markerLoadZ.assign(nMarkers, 0);
+    m_pointForceList.resize(nMarkers);
+    for (size_t i = 0; i < nMarkers; i++)
+    {
+        m_pointForceList[i].body = m_markerList[i]->GetBody();
+        std::fill_n(m_pointForceList[i].point, 3, 0);
+        std::fill_n(m_pointForceList[i].vector, 3, 0);
     }
 }
 
@@ -233,15 +275,15 @@ size_t FluidSac::numTriangles() const
 void FluidSac::triangleVertices(size_t triangleIndex, double vertices[9]) const
 {
     const Triangle *tri = &m_triangleList[triangleIndex];
-    vertices[0] = m_vertexList[tri->v0].x;
-    vertices[1] = m_vertexList[tri->v0].y;
-    vertices[2] = m_vertexList[tri->v0].z;
-    vertices[3] = m_vertexList[tri->v1].x;
-    vertices[4] = m_vertexList[tri->v1].y;
-    vertices[5] = m_vertexList[tri->v1].z;
-    vertices[6] = m_vertexList[tri->v2].x;
-    vertices[7] = m_vertexList[tri->v2].y;
-    vertices[8] = m_vertexList[tri->v2].z;
+    vertices[0] = m_vertexX[tri->v0];
+    vertices[1] = m_vertexY[tri->v0];
+    vertices[2] = m_vertexZ[tri->v0];
+    vertices[3] = m_vertexX[tri->v1];
+    vertices[4] = m_vertexY[tri->v1];
+    vertices[5] = m_vertexZ[tri->v1];
+    vertices[6] = m_vertexX[tri->v2];
+    vertices[7] = m_vertexY[tri->v2];
+    vertices[8] = m_vertexZ[tri->v2];
 }
 
 void FluidSac::LateInitialisation()
@@ -296,13 +338,14 @@ std::string *FluidSac::createFromAttributes()
         m_triangleList[i].v0 = size_t(GSUtil::Int(markerIndices[i * 3 + 0]));
         m_triangleList[i].v1 = size_t(GSUtil::Int(markerIndices[i * 3 + 1]));
         m_triangleList[i].v2 = size_t(GSUtil::Int(markerIndices[i * 3 + 2]));
-        m_triangleList[i].area = 0;
-        m_triangleList[i].normal = {0, 0, 0};
-        m_triangleList[i].centroid = {0, 0, 0};
+        if (m_triangleList[i].v0 >= numMarkers || m_triangleList[i].v1 >= numMarkers || m_triangleList[i].v2 >= numMarkers)
+        {
+            setLastError("FLUIDSAC ID=\""s + name() +"\" TriangleIndexList index out of range"s);
+            return lastErrorPtr();
+        }
     }
     // create the storage for the derived values
-    m_vertexList.resize(m_markerList.size());
-    m_pointForceList.resize(m_triangleList.size() * 3);
+    buildTopology();
 
     std::vector<NamedObject *> upstreamObjects;
     upstreamObjects.reserve(m_markerList.size());
@@ -375,3 +418,17 @@ void FluidSac::setPressure(double pressure)
     m_pressure = pressure;
 }
 
+void FluidSac::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    state->Write(m_sacVolume);
+    state->Write(m_pressure);
+}
+
+void FluidSac::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    state->Read(&m_sacVolume);
+    state->Read(&m_pressure);
+}
+
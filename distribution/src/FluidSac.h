@@ -27,9 +27,6 @@ public:
     struct Triangle
     {
         size_t v0; size_t v1; size_t v2;
-        double area;
-        pgd::Vector3 normal;
-        pgd::Vector3 centroid;
     };
 
     static double signedVolumeOfTriangle(pgd::Vector3 p1, pgd::Vector3 p2, pgd::Vector3 p3);
@@ -55,16 +52,33 @@ public:
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
     virtual std::string dumpToString();
 
     void setSacVolume(double sacVolume);
     void setPressure(double pressure);
 
 private:
+    void buildTopology();
+
     std::vector<FluidSac::Triangle> m_triangleList;
     std::vector<Marker *> m_markerList;
-    std::vector<pgd::Vector3> m_vertexList;
-    std::vector<PointForce> m_pointForceList;
+    std::vector<PointForce> m_pointForceList; // one per marker
+
+    // structure of arrays copies of the mesh so that the per step loops vectorise
+    std::vector<size_t> m_triangleV0;
+    std::vector<size_t> m_triangleV1;
+    std::vector<size_t> m_triangleV2;
+    std::vector<double> m_vertexX;
+    std::vector<double> m_vertexY;
+    std::vector<double> m_vertexZ;
+    std::vector<double> m_crossX;
+    std::vector<double> m_crossY;
+    std::vector<double> m_crossZ;
+    std::vector<double> m_markerLoadX;
+    std::vector<double> m_markerLoadY;
+    std::vector<double> m_markerLoadZ;
 
     double m_sacVolume = 0;
     double m_pressure = 0;
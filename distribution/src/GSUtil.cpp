@@ -1024,8 +1024,8 @@ std::string GSUtil::ToString(const size_t *v, size_t n)
 
 bool GSUtil::BoolRegex(const std::string &buf)
 {
-    const std::regex true_regex("^\\s*(true|yes)\\s*$"s, std::regex_constants::icase);
-    const std::regex false_regex("^\\s*(false|no)\\s*$"s, std::regex_constants::icase);
+    static const std::regex true_regex("^\\s*(true|yes)\\s*$"s, std::regex_constants::icase);
+    static const std::regex false_regex("^\\s*(false|no)\\s*$"s, std::regex_constants::icase);
     if (std::regex_match(buf, true_regex)) return true;
     if (std::regex_match(buf, false_regex)) return false;
     if (std::strtol(buf.c_str(), nullptr, 0) != 0) return true;
@@ -29,7 +29,7 @@ public:
 //    Global& operator=(const Global&);
 
     SMART_ENUM(StepType, stepTypeStrings, stepTypeCount, World, Quick);
-    SMART_ENUM(FitnessType, fitnessTypeStrings, fitnessTypeCount, KinematicMatch, KinematicMatchMiniMax);
+    SMART_ENUM(FitnessType, fitnessTypeStrings, fitnessTypeCount, KinematicMatch, KinematicMatchMiniMax, DistanceTravelled);
 
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
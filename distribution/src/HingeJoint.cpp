@@ -16,6 +16,7 @@
 #include "GSUtil.h"
 
 #include "ode/ode.h"
+#include "StateBuffer.h"
 
 #include <iostream>
 #include <cstdlib>
@@ -316,6 +317,24 @@ void HingeJoint::appendToAttributes()
     setAttribute("StopBounce"s, *GSUtil::ToString(dJointGetHingeParam(JointID(), dParamBounce), &buf));
 }
 
+std::vector<std::string> HingeJoint::dumpNames()
+{
+    return {"XP"s, "YP"s, "ZP"s, "XP2"s, "YP2"s, "ZP2"s, "XA"s, "YA"s, "ZA"s, "Angle"s, "AngleRate"s,
+            "FX1"s, "FY1"s, "FZ1"s, "TX1"s, "TY1"s, "TZ1"s, "FX2"s, "FY2"s, "FZ2"s, "TX2"s, "TY2"s, "TZ2"s, "StopTorque"s};
+}
+
+void HingeJoint::dumpValues(std::vector<double> *values)
+{
+    dVector3 p, p2, a;
+    GetHingeAnchor(p);
+    GetHingeAnchor2(p2);
+    GetHingeAxis(a);
+    const dJointFeedback *f = JointFeedback();
+    values->insert(values->end(), {p[0], p[1], p[2], p2[0], p2[1], p2[2], a[0], a[1], a[2], GetHingeAngle(), GetHingeAngleRate(),
+                                   f->f1[0], f->f1[1], f->f1[2], f->t1[0], f->t1[1], f->t1[2],
+                                   f->f2[0], f->f2[1], f->f2[2], f->t2[0], f->t2[1], f->t2[2], m_axisTorque});
+}
+
 std::string HingeJoint::dumpToString()
 {
     std::stringstream ss;
@@ -343,5 +362,23 @@ std::string HingeJoint::dumpToString()
     return ss.str();
 }
 
+void HingeJoint::saveState(StateBuffer *state)
+{
+    Joint::saveState(state);
+    state->Write(m_axisTorque);
+    state->Write(m_axisTorqueList);
+    state->Write(m_axisTorqueTotal);
+    state->Write(m_axisTorqueMean);
+    state->Write(m_axisTorqueIndex);
+}
 
+void HingeJoint::restoreState(StateBuffer *state)
+{
+    Joint::restoreState(state);
+    state->Read(&m_axisTorque);
+    state->Read(&m_axisTorqueList);
+    state->Read(&m_axisTorqueTotal);
+    state->Read(&m_axisTorqueMean);
+    state->Read(&m_axisTorqueIndex);
+}
 
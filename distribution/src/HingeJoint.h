@@ -43,8 +43,12 @@ public:
 
     virtual void Update();
     virtual std::string dumpToString();
+    virtual std::vector<std::string> dumpNames();
+    virtual void dumpValues(std::vector<double> *values);
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 private:
 
@@ -13,6 +13,7 @@
 #include "GSUtil.h"
 
 #include "ode/ode.h"
+#include "StateBuffer.h"
 
 #include <string.h>
 #include <cassert>
@@ -181,3 +182,15 @@ void Joint::setBody2(Body *Body2)
     m_Body2 = Body2;
 }
 
+void Joint::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    state->Write(m_JointFeedback);
+}
+
+void Joint::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    state->Read(&m_JointFeedback);
+}
+
@@ -15,6 +15,7 @@
 #include "GSUtil.h"
 
 #include "ode/ode.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 
@@ -538,4 +539,37 @@ std::string LMotorJoint::dumpToString()
 return ss.str();
 }
 
+void LMotorJoint::saveState(StateBuffer *state)
+{
+    Joint::saveState(state);
+    state->Write(m_lastPosition0);
+    state->Write(m_lastPosition1);
+    state->Write(m_lastPosition2);
+    state->Write(m_lastPositionRate0);
+    state->Write(m_lastPositionRate1);
+    state->Write(m_lastPositionRate2);
+    state->Write(m_lastTime0);
+    state->Write(m_lastTime1);
+    state->Write(m_lastTime2);
+    state->Write(m_lastTimeValid0);
+    state->Write(m_lastTimeValid1);
+    state->Write(m_lastTimeValid2);
+}
+
+void LMotorJoint::restoreState(StateBuffer *state)
+{
+    Joint::restoreState(state);
+    state->Read(&m_lastPosition0);
+    state->Read(&m_lastPosition1);
+    state->Read(&m_lastPosition2);
+    state->Read(&m_lastPositionRate0);
+    state->Read(&m_lastPositionRate1);
+    state->Read(&m_lastPositionRate2);
+    state->Read(&m_lastTime0);
+    state->Read(&m_lastTime1);
+    state->Read(&m_lastTime2);
+    state->Read(&m_lastTimeValid0);
+    state->Read(&m_lastTimeValid1);
+    state->Read(&m_lastTimeValid2);
+}
 
@@ -22,6 +22,7 @@
 #include "NPointStrap.h"
 #include "CylinderWrapStrap.h"
 #include "TwoCylinderWrapStrap.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 
@@ -214,5 +215,15 @@ std::string MAMuscle::dumpToString()
     return ss.str();
 }
 
+void MAMuscle::saveState(StateBuffer *state)
+{
+    Muscle::saveState(state);
+    state->Write(m_Alpha);
+}
 
+void MAMuscle::restoreState(StateBuffer *state)
+{
+    Muscle::restoreState(state);
+    state->Read(&m_Alpha);
+}
 
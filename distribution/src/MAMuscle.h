@@ -42,6 +42,8 @@ public:
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     double forcePerUnitArea() const;
     void setForcePerUnitArea(double forcePerUnitArea);
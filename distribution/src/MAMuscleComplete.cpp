@@ -25,6 +25,7 @@
 #include "TwoCylinderWrapStrap.h"
 
 #include "ode/ode.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 #include <cmath>
@@ -36,6 +37,7 @@
 using namespace std::string_literals;
 
 static double CalculateForceError (double lce, void *params);
+static double CalculateForceErrorDerivative (const MAMuscleComplete::CalculateForceErrorParams *p);
 
 // constructor
 
@@ -232,6 +234,7 @@ void MAMuscleComplete::SetActivation()
 
     m_Params.len = GetStrap()->GetLength();
     m_Params.v = GetStrap()->GetVelocity();
+    m_Params.evaluations = 0;
 
     double minlpe = m_Params.spe - (m_Params.spe * m_Params.width / 2);
     if (minlpe < 0) minlpe = 0;
@@ -279,8 +282,13 @@ void MAMuscleComplete::SetActivation()
             {
                 m_Params.err = flast;
             }
+            else if (SolveNewton(currentEstimate, flast))
+            {
+                // m_Params has already been set by the final Newton evaluation
+            }
             else
             {
+                m_SolverFallbacks++;
                 double ax = -DBL_MAX, bx = DBL_MAX, r, tol;
                 // double range = maxlpe - minlpe; // this doesn't quite work because of damping
                 double range = m_Params.len; // this should be bigger than necessary
@@ -337,6 +345,48 @@ void MAMuscleComplete::SetActivation()
     GetStrap()->SetTension(m_Params.fse);
 }
 
+// Newton iteration starting from the previous solution using the analytic derivative of CalculateForceError
+// this normally converges in 2 or 3 evaluations but the force function has discontinuities in its
+// derivative (slack elements, velocity limits, the eccentric/concentric switch at vce = 0) so as soon as
+// two iterates straddle the root that bracket is handed to zeroin, which is much tighter than the one found
+// by the linear search. A small step on its own is not accepted as convergence: the residual has to be within
+// tolerance too, and since the residual is a force it is compared as the length of the Newton step it implies.
+// It returns false if a step leaves the valid range, stalls without the residual converging, or it runs out of
+// iterations so that the bracketing solver is used instead
+// on success m_Params has been set by an evaluation at the solution
+bool MAMuscleComplete::SolveNewton(double currentEstimate, double flast)
+{
+    double x = currentEstimate;
+    double fx = flast;
+    double dfdx = CalculateForceErrorDerivative(&m_Params); // m_Params is currently evaluated at x
+    for (int i = 0; i < m_MaxNewtonIterations; i++)
+    {
+        if (dfdx == 0 || std::isfinite(dfdx) == false) return false;
+        double xNew = x - fx / dfdx;
+        if (xNew < 0 || xNew > m_Params.len || std::isfinite(xNew) == false) return false;
+        double fNew = CalculateForceError(xNew, &m_Params);
+        double dfdxNew = CalculateForceErrorDerivative(&m_Params);
+        if (fNew == 0 || fabs(fNew) <= m_Tolerance * fabs(dfdxNew))
+        {
+            m_Params.err = fNew;
+            m_Params.lastlpe = xNew;
+            return true;
+        }
+        if (std::signbit(fNew) != std::signbit(fx))
+        {
+            double r = GSUtil::zeroin(x, xNew, &CalculateForceError, &m_Params, m_Tolerance);
+            m_Params.err = CalculateForceError (r, &m_Params); // this sets m_Params with all the correct values
+            m_Params.lastlpe = r;
+            return true;
+        }
+        if (fabs(xNew - x) <= m_Tolerance) return false; // the step has stalled but the residual has not converged
+        x = xNew;
+        fx = fNew;
+        dfdx = dfdxNew;
+    }
+    return false;
+}
+
 // calculate the metabolic power of the muscle
 
 double MAMuscleComplete::GetMetabolicPower()
@@ -412,6 +462,7 @@ double MAMuscleComplete::GetEPE() // energy serial element
 double CalculateForceError (double lce, void *params)
 {
     MAMuscleComplete::CalculateForceErrorParams *p = reinterpret_cast<MAMuscleComplete::CalculateForceErrorParams *>(params);
+    p->evaluations++;
 
     // The elastic elements each generate a force and fce = fse - fpe
 
@@ -498,6 +549,74 @@ double CalculateForceError (double lce, void *params)
 
 }
 
+// this is the derivative of CalculateForceError with respect to lce
+// it uses the values stored in p by the last CalculateForceError call so that must be called first at the same lce
+// the branch choices (including the strain model used for the serial element) must match CalculateForceError exactly
+double CalculateForceErrorDerivative (const MAMuscleComplete::CalculateForceErrorParams *p)
+{
+    double dvce = 1 / p->timeIncrement;
+
+    // parallel element
+    double dfpe = 0;
+    if (p->lpe > p->spe && p->fpe > 0)
+    {
+        switch (p->smpe)
+        {
+        case MAMuscleComplete::linear:
+            dfpe = p->epe + p->dpe * dvce;
+            break;
+
+        case MAMuscleComplete::square:
+            dfpe = 2 * p->epe * (p->lpe - p->spe) + p->dpe * dvce;
+            break;
+        }
+    }
+
+    // serial element (lse and vse both decrease as lce increases)
+    double dfse = 0;
+    if (p->lse > p->sse && p->fse > 0)
+    {
+        switch (p->smpe)
+        {
+        case MAMuscleComplete::linear:
+            dfse = -p->ese - p->dse * dvce;
+            break;
+
+        case MAMuscleComplete::square:
+            dfse = -2 * p->ese * (p->lse - p->sse) - p->dse * dvce;
+            break;
+        }
+    }
+
+    // contractile element
+    double dfce = 0;
+    if (p->f0 > 0 && p->alpha != 0)
+    {
+        double df0 = -p->fmax * 8 * (-1 + p->lpe/p->spe) / (p->spe * p->width);
+        double localvce = p->vce;
+        double dlocalvce = dvce;
+        if (localvce > p->vmax) { localvce = p->vmax; dlocalvce = 0; }
+        if (localvce < -p->vmax) { localvce = -p->vmax; dlocalvce = 0; }
+
+        double g, dg;
+        if (localvce > 0) // eccentric
+        {
+            double denominator = 7.56 * localvce + p->k * p->vmax;
+            g = 1.8 + (0.8 * p->k*(localvce - 1.0 * p->vmax)) / denominator;
+            dg = 0.8 * p->k * p->vmax * (p->k + 7.56) / SQUARE(denominator);
+        }
+        else // concentric
+        {
+            double denominator = -localvce + p->k * p->vmax;
+            g = (p->k * (localvce + p->vmax)) / denominator;
+            dg = p->k * p->vmax * (p->k + 1) / SQUARE(denominator);
+        }
+        dfce = p->alpha * (df0 * g + p->f0 * dg * dlocalvce);
+    }
+
+    return dfce - (dfse - dfpe);
+}
+
 std::string *MAMuscleComplete::createFromAttributes()
 {
     if (Muscle::createFromAttributes()) return lastErrorPtr();
@@ -794,6 +913,23 @@ void MAMuscleComplete::setParallelStrainModel(const std::string &parallelStrainM
     if (parallelStrainModel == "Square"s) m_parallelStrainModel = MAMuscleComplete::square;
 }
 
+// the solver counters are only in the binary dump so that the tab file columns stay as they were
+std::vector<std::string> MAMuscleComplete::dumpNames()
+{
+    return {"m_Stim"s, "alpha"s, "len"s, "v"s, "lastlpe"s, "fce"s, "lpe"s, "fpe"s, "lse"s, "fse"s, "vce"s, "vse"s, "targetFce"s, "f0"s, "err"s,
+            "ESE"s, "EPE"s, "PSE"s, "PPE"s, "PCE"s, "tension"s, "length"s, "velocity"s, "PMECH"s, "PMET"s, "solverEvaluations"s, "solverFallbacks"s};
+}
+
+void MAMuscleComplete::dumpValues(std::vector<double> *values)
+{
+    values->insert(values->end(), {m_Stim, m_Params.alpha, m_Params.len, m_Params.v, m_Params.lastlpe,
+                                   m_Params.fce, m_Params.lpe, m_Params.fpe, m_Params.lse, m_Params.fse,
+                                   m_Params.vce, m_Params.vse, m_Params.targetFce, m_Params.f0, m_Params.err,
+                                   GetESE(), GetEPE(), GetPSE(), GetPPE(), GetPCE(),
+                                   GetTension(), GetLength(), GetVelocity(), GetPower(), GetMetabolicPower(),
+                                   double(m_Params.evaluations), double(m_SolverFallbacks)});
+}
+
 std::string MAMuscleComplete::dumpToString()
 {
     std::stringstream ss;
@@ -815,5 +951,17 @@ std::string MAMuscleComplete::dumpToString()
     return ss.str();
 }
 
+void MAMuscleComplete::saveState(StateBuffer *state)
+{
+    Muscle::saveState(state);
+    state->Write(m_Stim);
+    state->Write(m_Params);
+}
 
+void MAMuscleComplete::restoreState(StateBuffer *state)
+{
+    Muscle::restoreState(state);
+    state->Read(&m_Stim);
+    state->Read(&m_Params);
+}
 
@@ -69,6 +69,7 @@ public:
         double targetFce = -2; // fce calculated from elastic elements (N)
         double f0 = -2; // length corrected fmax (N)
         double err = -2; // error term in lpe (m)
+        int evaluations = 0; // number of CalculateForceError calls used by the last solve
     };
 
     MAMuscleComplete();
@@ -107,11 +108,18 @@ public:
     double GetSSE() { return m_Params.sse; }
     double GetSPE() { return m_Params.spe; }
 
+    int GetSolverEvaluations() { return m_Params.evaluations; } // CalculateForceError calls used in the last step
+    int64_t GetSolverFallbacks() { return m_SolverFallbacks; } // number of steps where Newton failed and the bracketing solver was used
+
     virtual std::string dumpToString();
+    virtual std::vector<std::string> dumpNames();
+    virtual void dumpValues(std::vector<double> *values);
     virtual void LateInitialisation();
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 
 
@@ -167,6 +175,7 @@ public:
     void setParallelStrainModel(const std::string &parallelStrainModel);
 
 private:
+    bool SolveNewton(double currentEstimate, double flast);
 
     double m_Stim = 0;
     bool m_ActivationKinetics = false;
@@ -182,6 +191,8 @@ private:
 
     CalculateForceErrorParams m_Params;
     double m_Tolerance = 1e-8; // solution tolerance (m) - small because the serial tendons are quite stiff
+    int m_MaxNewtonIterations = 20; // after this many Newton steps fall back to the bracketing solver
+    int64_t m_SolverFallbacks = 0;
 
     // these values are only used for loading and saving
     StrainModel m_serialStrainModel = StrainModel::linear;
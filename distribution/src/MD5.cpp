@@ -60,9 +60,9 @@ uint32_t *md5(const char *msg, int mlen)
     static int16_t rot3[] = { 6,10,15,21};
     static int16_t *rots[] = {rot0, rot1, rot2, rot3 };
     static uint32_t kspace[64];
-    static uint32_t *k;
+    static uint32_t *k = calcKs(kspace); // thread safe initialisation
 
-    static Digest h;
+    static thread_local Digest h; // each thread gets its own result buffer
     Digest abcd;
     DgstFctn fctn;
     int16_t m, o, g;
@@ -76,8 +76,6 @@ uint32_t *md5(const char *msg, int mlen)
     int grp, grps, q, p;
     uint8_t *msg2;
 
-    if (k==NULL) k= calcKs(kspace);
-
     for (q=0; q<4; q++) h[q] = h0[q];   // initialize
 
     {
@@ -15,6 +15,7 @@
 #include "GSUtil.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <iostream>
 #include <sstream>
@@ -457,6 +458,18 @@ void Marker::GetWorldBasis(pgd::Vector3 *x, pgd::Vector3 *y, pgd::Vector3 *z)
     z->z = m.e33;
 }
 
+std::vector<std::string> Marker::dumpNames()
+{
+    return {"XP"s, "YP"s, "ZP"s, "QW"s, "QX"s, "QY"s, "QZ"s};
+}
+
+void Marker::dumpValues(std::vector<double> *values)
+{
+    pgd::Vector3 p = GetWorldPosition();
+    pgd::Quaternion q = GetWorldQuaternion();
+    values->insert(values->end(), {p.x, p.y, p.z, q.n, q.x, q.y, q.z});
+}
+
 std::string Marker::dumpToString()
 {
     std::stringstream ss;
@@ -547,3 +560,17 @@ void Marker::SetBody(Body *body)
     m_body = body;
 }
 
+void Marker::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    state->Write(m_position);
+    state->Write(m_quaternion);
+}
+
+void Marker::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    state->Read(&m_position);
+    state->Read(&m_quaternion);
+}
+
@@ -58,9 +58,13 @@ public:
 
 
     virtual std::string dumpToString();
+    virtual std::vector<std::string> dumpNames();
+    virtual void dumpValues(std::vector<double> *values);
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     Body *GetBody() const;
     void SetBody(Body *body);
@@ -10,6 +10,7 @@
  */
 
 #include "MovingAverage.h"
+#include "StateBuffer.h"
 
 #include <algorithm>
 
@@ -64,3 +65,22 @@ int MovingAverage::window() const
 {
     return m_window;
 }
+
+void MovingAverage::saveState(StateBuffer *state)
+{
+    Filter::saveState(state);
+    state->Write(m_index);
+    state->Write(m_buffer);
+    state->Write(m_sum);
+    state->Write(m_average);
+}
+
+void MovingAverage::restoreState(StateBuffer *state)
+{
+    Filter::restoreState(state);
+    state->Read(&m_index);
+    state->Read(&m_buffer);
+    state->Read(&m_sum);
+    state->Read(&m_average);
+}
+
@@ -24,6 +24,8 @@ public:
 
     virtual void AddNewSample(double x);
     virtual double Output();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     void InitialiseBuffer(int window);
 
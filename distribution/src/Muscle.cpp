@@ -9,6 +9,7 @@
 
 
 #include "Muscle.h"
+#include "StateBuffer.h"
 
 #include <string>
 #include <iostream>
@@ -147,5 +148,15 @@ void Muscle::LateInitialisation()
     CalculateStrap();
 }
 
+void Muscle::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    Drivable::saveState(state);
+}
 
+void Muscle::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    Drivable::restoreState(state);
+}
 
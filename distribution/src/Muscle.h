@@ -49,6 +49,8 @@ public:
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     StrapColourControl strapColourControl() const;
     void setStrapColourControl(const Muscle::StrapColourControl &strapColourControl);
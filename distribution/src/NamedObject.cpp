@@ -14,6 +14,7 @@
 #include "GSUtil.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <iostream>
 #include <sstream>
@@ -43,6 +44,15 @@ std::string NamedObject::dumpToString()
     return s;
 }
 
+std::vector<std::string> NamedObject::dumpNames()
+{
+    return std::vector<std::string>();
+}
+
+void NamedObject::dumpValues(std::vector<double> * /* values */)
+{
+}
+
 // returns the value of a named attribute
 // using caller provided string
 // returns "" if attribute is not found
@@ -53,6 +63,12 @@ std::string *NamedObject::findAttribute(const std::string &name, std::string *at
     it = m_attributeMap.find(name);
     if (it == m_attributeMap.end())
     {
+        auto numericIt = m_numericAttributeMap.find(name);
+        if (numericIt != m_numericAttributeMap.end())
+        {
+            GSUtil::ToString(numericIt->second.data(), numericIt->second.size(), attributeValue);
+            return attributeValue;
+        }
         attributeValue->clear();
         setLastError("Attribute \""s + name + "\" not found in ID=\""s + this->name() + "\""s);
         return nullptr;
@@ -61,6 +77,28 @@ std::string *NamedObject::findAttribute(const std::string &name, std::string *at
     return attributeValue;
 }
 
+// returns the value of a named attribute as a list of numbers
+// using the pre-converted values if the model was binary and otherwise
+// splitting on whitespace and converting each token (0 if it is not a number)
+// returns nullptr if attribute is not found
+std::vector<double> *NamedObject::findAttribute(const std::string &name, std::vector<double> *values)
+{
+    values->clear();
+    auto numericIt = m_numericAttributeMap.find(name);
+    if (numericIt != m_numericAttributeMap.end())
+    {
+        *values = numericIt->second;
+        return values;
+    }
+    auto it = m_attributeMap.find(name);
+    if (it == m_attributeMap.end())
+    {
+        setLastError("Attribute \""s + name + "\" not found in ID=\""s + this->name() + "\""s);
+        return nullptr;
+    }
+    return GSUtil::Double(it->second, values);
+}
+
 // returns the value of a named attribute
 // returns "" if attribute is not found
 std::string NamedObject::findAttribute(const std::string &name)
@@ -79,6 +117,7 @@ const std::map<std::string, std::string> &NamedObject::serialise()
 std::string *NamedObject::unserialise(const std::map<std::string, std::string> &serialiseMap)
 {
     m_attributeMap = serialiseMap;
+    m_numericAttributeMap.clear();
     return createFromAttributes();
 }
 
@@ -90,6 +129,9 @@ void NamedObject::setAttribute(const std::string &name, const std::string &attri
 
 const std::map<std::string, std::string> &NamedObject::attributeMap()
 {
+    // callers expect every attribute as text so any pre-converted arrays are converted back
+    for (auto &&it : m_numericAttributeMap) GSUtil::ToString(it.second.data(), it.second.size(), &m_attributeMap[it.first]);
+    m_numericAttributeMap.clear();
     return m_attributeMap;
 }
 
@@ -146,7 +188,7 @@ std::string *NamedObject::createFromAttributes()
 void NamedObject::saveToAttributes()
 {
     m_tag = "NAMED_OBJECT"s;
-    m_attributeMap.clear();
+    clearAttributeMap();
     this->appendToAttributes();
 }
 
@@ -166,6 +208,13 @@ void NamedObject::appendToAttributes()
 void NamedObject::createAttributeMap(const std::map<std::string, std::string> &attributeMap)
 {
     m_attributeMap = attributeMap;
+    m_numericAttributeMap.clear();
+}
+
+void NamedObject::createAttributeMap(const std::map<std::string, std::string> &attributeMap, const std::map<std::string, std::vector<double>> &numericAttributeMap)
+{
+    m_attributeMap = attributeMap;
+    m_numericAttributeMap = numericAttributeMap;
 }
 
 std::string NamedObject::searchNames(const std::map<std::string, std::string> &attributeMap, const std::string &name)
@@ -244,6 +293,7 @@ bool NamedObject::isUpstreamObject(NamedObject *findObject)
 void NamedObject::clearAttributeMap()
 {
     m_attributeMap.clear();
+    m_numericAttributeMap.clear();
 }
 
 std::string NamedObject::className() const
@@ -407,3 +457,11 @@ std::string NamedObject::objectMessage() const // return value optimisation RVO
     return m_message;
 }
 
+void NamedObject::saveState(StateBuffer * /* state */)
+{
+}
+
+void NamedObject::restoreState(StateBuffer * /* state */)
+{
+}
+
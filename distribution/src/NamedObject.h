@@ -23,6 +23,7 @@
 
 class FacetedObject;
 class Simulation;
+class StateBuffer;
 
 namespace rapidxml { template<class Ch> class xml_node; }
 
@@ -54,13 +55,18 @@ public:
     std::string className() const; // return value optimisation RVO makes via reference unnecessary
 
     virtual std::string dumpToString();
+    virtual std::vector<std::string> dumpNames(); // column names for binary dumps (excluding Time), empty if not supported
+    virtual void dumpValues(std::vector<double> *values); // appends the values in dumpNames order
     void createAttributeMap(const std::map<std::string, std::string> &attributeMap);
+    void createAttributeMap(const std::map<std::string, std::string> &attributeMap, const std::map<std::string, std::vector<double>> &numericAttributeMap);
     virtual std::string *createFromAttributes();
     virtual void saveToAttributes();
     virtual void appendToAttributes();
     std::string findAttribute(const std::string &name);
     virtual const std::map<std::string, std::string> &serialise();
     virtual std::string *unserialise(const std::map<std::string, std::string> &serialiseMap);
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     std::vector<NamedObject *> *upstreamObjects();
     void setUpstreamObjects(const std::vector<NamedObject *> &upstreamObjects);
@@ -115,6 +121,7 @@ public:
 
 protected:
     std::string *findAttribute(const std::string &name, std::string *attributeValue);
+    std::vector<double> *findAttribute(const std::string &name, std::vector<double> *values);
     void setAttribute(const std::string &name, const std::string &attributeValue);
     void clearAttributeMap();
     void setFirstDump(bool firstDump);
@@ -141,6 +148,7 @@ private:
     bool m_firstDump = true;
 
     std::map<std::string, std::string> m_attributeMap;
+    std::map<std::string, std::vector<double>> m_numericAttributeMap; // pre-converted arrays from a binary model
     std::string m_tag;
     std::vector<NamedObject *> m_upstreamObjects;
 };
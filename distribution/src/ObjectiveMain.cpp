@@ -19,6 +19,8 @@
 #include "Body.h"
 #include "Geom.h"
 #include "ArgParse.h"
+#include "StepProfiler.h"
+#include "BinaryModel.h"
 
 #define MAX_ARGS 4096
 
@@ -49,8 +51,15 @@ ObjectiveMain::ObjectiveMain(int argc, const char **argv)
     m_argparse.AddArgument("-mw"s, "--outputModelStateAtWarehouseDistance"s, "Output model state at this warehouse distance"s, ""s, 1, false, ArgParse::Double);
     m_argparse.AddArgument("-wd"s, "--warehouseFailDistanceAbort"s, "Abort the simulation when the warehouse distance fails"s);
     m_argparse.AddArgument("-de"s, "--debug"s, "Turn debugging on"s);
+    m_argparse.AddArgument("-nt"s, "--numberOfThreads"s, "Number of threads used within each simulation step"s, "1"s, 1, false, ArgParse::Int);
+    m_argparse.AddArgument("-pf"s, "--profile"s, "Time each phase of the simulation step and print a summary at the end"s);
+    m_argparse.AddArgument("-sb"s, "--scoreToBeat"s, "Stop the simulation as soon as this KinematicMatch score can no longer be reached"s, ""s, 1, false, ArgParse::Double);
+    m_argparse.AddArgument("-pj"s, "--profileFile"s, "Write the step profile to this JSON file (implies --profile)"s, ""s, 1, false, ArgParse::String);
+    m_argparse.AddArgument("-cm"s, "--convertModel"s, "Convert the config file to binary (or back to XML if it is binary), write it to this file and exit"s, ""s, 1, false, ArgParse::String);
 
-    m_argparse.AddArgument("-ol"s, "-outputList"s, "List of objects to produce output"s, ""s, 1, MAX_ARGS, false, ArgParse::String);
+    m_argparse.AddArgument("-bd"s, "--binaryDump"s, "Write the output list objects to this single binary file where supported"s, ""s, 1, false, ArgParse::String);
+
+    m_argparse.AddArgument("-ol"s, "--outputList"s, "List of objects to produce output"s, ""s, 1, MAX_ARGS, false, ArgParse::String);
 
     int err = m_argparse.Parse();
     if (err)
@@ -72,10 +81,19 @@ ObjectiveMain::ObjectiveMain(int argc, const char **argv)
     m_argparse.Get("--inputWarehouse"s, &m_inputWarehouseFilename);
     m_argparse.Get("--outputWarehouse"s, &m_outputWarehouseFilename);
     m_argparse.Get("--debug"s, &m_debug);
+    m_argparse.Get("--numberOfThreads"s, &m_numberOfThreads);
+    m_argparse.Get("--binaryDump"s, &m_binaryDumpFilename);
+    m_argparse.Get("--scoreToBeat"s, &m_scoreToBeat);
+    m_argparse.Get("--profile"s, &m_profile);
+    m_argparse.Get("--profileFile"s, &m_profileFilename);
+    m_argparse.Get("--convertModel"s, &m_convertModelFilename);
+    if (m_profileFilename.size()) m_profile = true;
 }
 
 int ObjectiveMain::Run()
 {
+    if (m_convertModelFilename.size()) return ConvertModel();
+
     if (ReadModel()) return __LINE__;
 
     for (size_t i = 0; i < m_outputList.size(); i++)
@@ -129,6 +147,7 @@ int ObjectiveMain::ReadModel()
     m_simulation = std::make_unique<Simulation>();
     if (m_outputWarehouseFilename.size()) m_simulation->SetOutputWarehouseFile(m_outputWarehouseFilename);
     if (m_outputModelStateFilename.size()) m_simulation->SetOutputModelStateFile(m_outputModelStateFilename);
+    if (m_binaryDumpFilename.size()) m_simulation->SetBinaryDumpFile(m_binaryDumpFilename);
     if (m_outputModelStateAtTime >= 0) m_simulation->SetOutputModelStateAtTime(m_outputModelStateAtTime);
     if (m_outputModelStateAtCycle >= 0) m_simulation->SetOutputModelStateAtCycle(m_outputModelStateAtCycle);
     if (m_inputWarehouseFilename.size()) m_simulation->AddWarehouse(m_inputWarehouseFilename);
@@ -145,10 +164,49 @@ int ObjectiveMain::ReadModel()
     // late initialisation options
     if (m_simulationTimeLimit >= 0) m_simulation->SetTimeLimit(m_simulationTimeLimit);
     if (m_warehouseFailDistanceAbort != 0) m_simulation->SetWarehouseFailDistanceAbort(m_warehouseFailDistanceAbort);
+    if (m_numberOfThreads > 1) m_simulation->SetNumberOfThreads(size_t(m_numberOfThreads));
+    if (m_scoreToBeat > -DBL_MAX) m_simulation->SetScoreToBeat(m_scoreToBeat);
+    if (m_profile)
+    {
+        m_stepProfiler = std::make_unique<StepProfiler>();
+        m_simulation->SetStepProfiler(m_stepProfiler.get());
+    }
 
     return 0;
 }
 
+// converts the config file between XML and the binary model format
+// it returns zero on success
+int ObjectiveMain::ConvertModel()
+{
+    DataFile myFile;
+    myFile.SetExitOnError(true);
+    myFile.ReadFile(m_configFilename);
+
+    BinaryModel binaryModel;
+    std::string output;
+    bool toXML = BinaryModel::IsBinaryModel(myFile.GetRawData(), myFile.GetSize());
+    std::string *errorMessage;
+    if (toXML) errorMessage = binaryModel.ConvertToXML(myFile.GetRawData(), myFile.GetSize(), &output);
+    else errorMessage = binaryModel.ConvertFromXML(myFile.GetRawData(), myFile.GetSize(), &output);
+    if (errorMessage)
+    {
+        std::cerr << *errorMessage << "\n";
+        return __LINE__;
+    }
+
+    DataFile outputFile;
+    outputFile.SetExitOnError(false);
+    outputFile.SetRawData(output.data(), output.size());
+    if (outputFile.WriteFile(m_convertModelFilename, !toXML))
+    {
+        std::cerr << "Error: unable to write \"" << m_convertModelFilename << "\"\n";
+        return __LINE__;
+    }
+    if (m_debug) std::cerr << "Wrote " << output.size() << " bytes to \"" << m_convertModelFilename << "\"\n";
+    return 0;
+}
+
 // returns 0 if continuing
 // returns 1 if exit requested
 int ObjectiveMain::WriteOutput()
@@ -170,6 +228,16 @@ int ObjectiveMain::WriteOutput()
         if (myFile.WriteFile(m_scoreFilename, true)) return __LINE__;
     }
 
+    if (m_stepProfiler)
+    {
+        std::cerr << m_stepProfiler->Summary();
+        if (m_profileFilename.size() && m_stepProfiler->WriteJSON(m_profileFilename))
+        {
+            std::cerr << "Error: unable to write profile file \"" << m_profileFilename << "\"\n";
+            return __LINE__;
+        }
+    }
+
     return 0;
 }
 
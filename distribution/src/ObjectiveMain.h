@@ -7,8 +7,10 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cfloat>
 
 class Simulation;
+class StepProfiler;
 
 class ObjectiveMain
 {
@@ -18,11 +20,13 @@ public:
     int Run();
     int ReadModel();
     int WriteOutput();
+    int ConvertModel();
 
 private:
     std::vector<std::string> m_outputList;
 
     std::unique_ptr<Simulation> m_simulation;
+    std::unique_ptr<StepProfiler> m_stepProfiler;
     double m_runTimeLimit = 0;
     double m_simulationTime = 0;
     double m_outputModelStateAtTime = -1;
@@ -30,16 +34,22 @@ private:
     double m_outputModelStateAtWarehouseDistance = -1;
     double m_simulationTimeLimit = -1;
     double m_warehouseFailDistanceAbort = 0;
+    double m_scoreToBeat = -DBL_MAX;
 
     std::string m_configFilename;
     std::string m_outputWarehouseFilename;
     std::string m_outputModelStateFilename;
     std::string m_inputWarehouseFilename;
     std::string m_scoreFilename;
+    std::string m_binaryDumpFilename;
+    std::string m_profileFilename;
+    std::string m_convertModelFilename;
 
     XMLConverter m_XMLConverter;
     ArgParse m_argparse;
     bool m_debug = false;
+    int m_numberOfThreads = 1;
+    bool m_profile = false;
 };
 
 #endif // OBJECTIVEMAIN_H
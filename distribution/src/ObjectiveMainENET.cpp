@@ -20,6 +20,7 @@
 #include "Geom.h"
 #include "ArgParse.h"
 #include "MD5.h"
+#include "BatchEvaluator.h"
 
 #include "pystring.h"
 
@@ -69,8 +70,12 @@ ObjectiveMainENET::ObjectiveMainENET(int argc, const char **argv)
     m_argparse.AddArgument("-mw"s, "--outputModelStateAtWarehouseDistance"s, "Output model state at this warehouse distance"s, ""s, 1, false, ArgParse::Double);
     m_argparse.AddArgument("-wd"s, "--warehouseFailDistanceAbort"s, "Abort the simulation when the warehouse distance fails"s, "0"s, 1, false, ArgParse::Bool);
     m_argparse.AddArgument("-de"s, "--debug"s, "Turn debugging on"s);
+    m_argparse.AddArgument("-nt"s, "--numberOfThreads"s, "Number of simulations to run in parallel. Only the base XML text is shared, each simulation loads its own copy of everything else including meshes and data target tables, and models containing trimesh geoms are rejected when this is greater than 1"s, "1"s, 1, false, ArgParse::Int);
+    m_argparse.AddArgument("-pr"s, "--pruning"s, "Stop simulations early when the score to beat sent with the genome can no longer be reached"s);
+    m_argparse.AddArgument("-xc"s, "--xmlCacheFolder"s, "Folder for a base XML cache shared by the workers on this machine e.g. /dev/shm (off by default)"s, ""s, 1, false, ArgParse::String);
+    m_argparse.AddArgument("-cx"s, "--clearXMLCache"s, "Delete this user's entries from the --xmlCacheFolder base XML cache and exit"s);
 
-    m_argparse.AddArgument("-ol"s, "-outputList"s, "List of objects to produce output"s, ""s, 1, MAX_ARGS, false, ArgParse::String);
+    m_argparse.AddArgument("-ol"s, "--outputList"s, "List of objects to produce output"s, ""s, 1, MAX_ARGS, false, ArgParse::String);
 
     m_argparse.AddArgument("-hl"s, "--hostsList"s, "List of hosts "s, "localhost:8086"s, 1, MAX_ARGS, true, ArgParse::String);
     m_argparse.AddArgument("-to"s, "--timeout"s, "The timeout value in milliseconds"s, "100000"s, 1, false, ArgParse::Int);
@@ -93,6 +98,12 @@ ObjectiveMainENET::ObjectiveMainENET(int argc, const char **argv)
     m_argparse.Get("--inputWarehouse"s, &m_inputWarehouseFilename);
     m_argparse.Get("--outputWarehouse"s, &m_outputWarehouseFilename);
     m_argparse.Get("--debug"s, &m_debug);
+    m_argparse.Get("--pruning"s, &m_pruning);
+    m_argparse.Get("--numberOfThreads"s, &m_numberOfThreads);
+    std::string xmlCacheFolder;
+    m_argparse.Get("--xmlCacheFolder"s, &xmlCacheFolder);
+    m_sharedXMLCache.setCacheFolder(xmlCacheFolder);
+    m_argparse.Get("--clearXMLCache"s, &m_clearXMLCache);
 
     std::vector<std::string> rawHosts;
     std::vector<std::string> result;
@@ -119,6 +130,15 @@ ObjectiveMainENET::ObjectiveMainENET(int argc, const char **argv)
 
 int ObjectiveMainENET::Run()
 {
+    if (m_clearXMLCache)
+    {
+        if (m_sharedXMLCache.Clear())
+        {
+            std::cerr << "Error: unable to clear the XML cache in \"" << m_sharedXMLCache.cacheFolder() << "\"\n";
+            return __LINE__;
+        }
+        return 0;
+    }
     int status = enet_initialize();
     if (status)
     {
@@ -140,6 +160,14 @@ int ObjectiveMainENET::Run()
         return __LINE__;
     }
 
+    if (m_numberOfThreads > 1)
+    {
+        status = RunBatch();
+        enet_host_destroy(m_client);
+        enet_deinitialize();
+        return status;
+    }
+
     double startTime = GSUtil::GetTime();
     bool finishedFlag = true;
     int timeoutMultiplier = 1;
@@ -204,11 +232,11 @@ int ObjectiveMainENET::Run()
     return 0;
 }
 
-// this routine attemps to read the model specification and initialise the simulation
+// this routine attemps to read the genome and make sure that the matching model specification is loaded
 // it returns zero on success
-int ObjectiveMainENET::ReadModel()
+int ObjectiveMainENET::ReadGenome(std::vector<double> *genomeData)
 {
-    if (m_debug) std::cerr <<  "ReadModel m_currentHost " << m_currentHost << " host " << m_hosts[m_currentHost]->host << " port " << m_hosts[m_currentHost]->port << "\n";
+    if (m_debug) std::cerr <<  "ReadGenome m_currentHost " << m_currentHost << " host " << m_hosts[m_currentHost]->host << " port " << m_hosts[m_currentHost]->port << "\n";
 
     ENetAddress address;
     int status = enet_address_set_host(&address, m_hosts[m_currentHost]->host.c_str());
@@ -286,7 +314,7 @@ int ObjectiveMainENET::ReadModel()
         if (m_debug) std::cerr << "Message " << message.text << " sent to " << GSUtil::ToString(event.peer->address.host, event.peer->address.port) << "\n";
     }
     enet_host_flush(m_client);
-    std::vector<double> genomeData;
+    genomeData->clear();
     // wait for a response
     status = enet_host_service(m_client, &event, timeout);
     if (status > 0 && event.type == ENET_EVENT_TYPE_RECEIVE)
@@ -294,19 +322,20 @@ int ObjectiveMainENET::ReadModel()
         TCPIPMessage *messagePtr = reinterpret_cast<TCPIPMessage *>(event.packet->data);
         double *doublePtr = reinterpret_cast<double *>(event.packet->data + sizeof(TCPIPMessage));
         size_t lenGenome = (event.packet->dataLength - sizeof(TCPIPMessage)) / sizeof(double);
-        genomeData.reserve(lenGenome);
-        std::copy_n(doublePtr, lenGenome, std::back_inserter(genomeData));
+        genomeData->reserve(lenGenome);
+        std::copy_n(doublePtr, lenGenome, std::back_inserter(*genomeData));
         m_genomeMessage = *reinterpret_cast<TCPIPMessage *>(event.packet->data);
+        if (m_pruning) m_scoreToBeat = m_genomeMessage.score; // the server sends the score to beat with the genome
         if (m_debug)
         {
             std::cerr << "Message " << messagePtr->text << " received from " << GSUtil::ToString(event.peer->address.host, event.peer->address.port) << "\n";
-            for (size_t i = 0; i < genomeData.size(); i += 10)
+            for (size_t i = 0; i < genomeData->size(); i += 10)
             {
                 std::cerr << static_cast<unsigned long>(i);
                 for (size_t j = 0; j < 10; j++)
                 {
-                    if (i + j >= genomeData.size()) break;
-                    std::cerr << " " << genomeData[i + j];
+                    if (i + j >= genomeData->size()) break;
+                    std::cerr << " " << (*genomeData)[i + j];
                 }
                 std::cerr << "\n";
             }
@@ -319,7 +348,7 @@ int ObjectiveMainENET::ReadModel()
         return __LINE__;
     }
 
-    if (!genomeData.size())
+    if (!genomeData->size())
     {
         std::cerr << "Host " << m_currentHost << " no genome data sent\n";
         m_currentHost++;
@@ -337,7 +366,15 @@ int ObjectiveMainENET::ReadModel()
         {
             // yes, so just load it from the cache
             std::copy(std::begin(m_genomeMessage.md5), std::end(m_genomeMessage.md5), std::begin(m_MD5));
-            m_XMLConverter.LoadBaseXMLString(it->second.c_str(), it->second.size());
+            m_baseXML = it->second;
+            m_XMLConverter.LoadBaseXMLString(m_baseXML->c_str(), m_baseXML->size());
+        }
+        else if (m_sharedXMLCache.Load(m_genomeMessage.md5, &m_XMLConverter) == 0)
+        {
+            // another worker on this machine has already fetched it
+            std::copy(std::begin(m_genomeMessage.md5), std::end(m_genomeMessage.md5), std::begin(m_MD5));
+            m_baseXML = std::make_shared<const std::string>(m_sharedXMLCache.xmlData(), m_sharedXMLCache.xmlLength());
+            m_sharedXMLCache.Close();
         }
         else
         {
@@ -366,7 +403,9 @@ int ObjectiveMainENET::ReadModel()
                 std::string xml(reinterpret_cast<char *>(event.packet->data + sizeof(TCPIPMessage)), lenXML);
                 m_XMLConverter.LoadBaseXMLString(xml.c_str(), xml.size());
                 std::copy(std::begin(messagePtr->md5), std::end(messagePtr->md5), std::begin(m_MD5));
-                m_cachedConfigFiles[hash] = std::move(xml);
+                if (std::equal(hash.begin(), hash.end(), md5(xml.c_str(), int(xml.size())))) m_sharedXMLCache.Store(m_MD5, &m_XMLConverter);
+                m_baseXML = std::make_shared<const std::string>(std::move(xml));
+                m_cachedConfigFiles[hash] = m_baseXML;
                 m_cachedConfigFilesQueue.push_back(hash);
                 if (m_cachedConfigFilesQueue.size() > m_cachedConfigFilesLimit)
                 {
@@ -383,7 +422,7 @@ int ObjectiveMainENET::ReadModel()
                 if (m_debug)
                 {
                     std::cerr << "Message " << messagePtr->text << " received from " << GSUtil::ToString(event.peer->address.host, event.peer->address.port) << "\n";
-                    std::cerr << m_cachedConfigFiles[hash];
+                    std::cerr << *m_cachedConfigFiles[hash];
                 }
                 enet_packet_destroy(event.packet);
             }
@@ -397,10 +436,26 @@ int ObjectiveMainENET::ReadModel()
         }
     }
 
+    return 0;
+}
+
+// this routine attemps to read the model specification and initialise the simulation
+// it returns zero on success
+int ObjectiveMainENET::ReadModel()
+{
+    std::vector<double> genomeData;
+    int status = ReadGenome(&genomeData);
+    if (status) return status;
+
     // and apply the new genome
     m_XMLConverter.ApplyGenome(int(genomeData.size()), genomeData.data());
-    size_t xmlLen;
-    const char *xmlPtr = m_XMLConverter.GetFormattedXML(&xmlLen);
+    size_t xmlLen = 0;
+    const char *xmlPtr = nullptr;
+    if (m_XMLConverter.ApplyParameterMap())
+    {
+        // no parameter map so fall back to the full XML text
+        xmlPtr = m_XMLConverter.GetFormattedXML(&xmlLen);
+    }
 
     // create the simulation object
     m_simulation = std::make_unique<Simulation>();
@@ -411,7 +466,10 @@ int ObjectiveMainENET::ReadModel()
     if (m_inputWarehouseFilename.size()) m_simulation->AddWarehouse(m_inputWarehouseFilename);
     if (m_outputModelStateAtWarehouseDistance >= 0) m_simulation->SetOutputModelStateAtWarehouseDistance(m_outputModelStateAtWarehouseDistance);
 
-    if (m_simulation->LoadModel(xmlPtr, xmlLen))
+    std::string *errorMessage;
+    if (m_XMLConverter.ParameterMapValid()) errorMessage = m_simulation->LoadModel(m_XMLConverter.ParameterMapElementList());
+    else errorMessage = m_simulation->LoadModel(xmlPtr, xmlLen);
+    if (errorMessage)
     {
         m_simulation.reset();
         m_currentHost++;
@@ -422,6 +480,7 @@ int ObjectiveMainENET::ReadModel()
     // late initialisation options
     if (m_simulationTimeLimit >= 0) m_simulation->SetTimeLimit(m_simulationTimeLimit);
     if (m_warehouseFailDistanceAbort != 0) m_simulation->SetWarehouseFailDistanceAbort(m_warehouseFailDistanceAbort);
+    if (m_pruning) m_simulation->SetScoreToBeat(m_scoreToBeat);
 
     return 0;
 }
@@ -442,12 +501,17 @@ int ObjectiveMainENET::WriteOutput()
                  " CPUTimeSimulation: " << m_simulationTime <<
                  " CPUTimeIO: " << m_IOTime <<
                  "\n";
+    return SendResult(&m_genomeMessage, score, m_simulation->GetPruned(), m_simulation->GetPrunedTime());
+}
 
+// returns 0 if the result was sent
+int ObjectiveMainENET::SendResult(TCPIPMessage *genomeMessage, double score, bool pruned, double prunedTime)
+{
     ENetAddress address;
     int status = enet_address_set_host(&address, m_hosts[m_currentHost]->host.c_str());
     if (status)
     {
-        std::cerr << "WriteOutput Host " << m_currentHost << " " << m_hosts[m_currentHost]->host << " not parsed\n";
+        std::cerr << "SendResult Host " << m_currentHost << " " << m_hosts[m_currentHost]->host << " not parsed\n";
         m_currentHost++;
         if (m_currentHost >= m_hosts.size()) m_currentHost = 0;
         return __LINE__;
@@ -459,14 +523,14 @@ int ObjectiveMainENET::WriteOutput()
     m_peer = enet_host_connect(m_client, &address, channelCount, data);
     if (!m_peer)
     {
-        std::cerr << "WriteOutput Host " << m_currentHost << " " << m_hosts[m_currentHost]->host << " not available\n";
+        std::cerr << "SendResult Host " << m_currentHost << " " << m_hosts[m_currentHost]->host << " not available\n";
         m_currentHost++;
         if (m_currentHost >= m_hosts.size()) m_currentHost = 0;
         return __LINE__;
     }
     else
     {
-        if (m_debug) std::cerr <<  "WriteOutput enet_host_connect initiated\n" ;
+        if (m_debug) std::cerr <<  "SendResult enet_host_connect initiated\n" ;
     }
 
     ENetEvent event = {};
@@ -495,22 +559,145 @@ int ObjectiveMainENET::WriteOutput()
         }
     }
 
-    strcpy(m_genomeMessage.text, "result");
-    m_genomeMessage.score = score;
+    // a pruned simulation sends "result_pruned" instead of "result" followed by the simulation time when it was pruned (double)
+    std::vector<char> resultMessage(sizeof(TCPIPMessage));
+    strcpy(genomeMessage->text, pruned ? "result_pruned" : "result");
+    genomeMessage->score = score;
+    memcpy(resultMessage.data(), genomeMessage, sizeof(TCPIPMessage));
+    if (pruned)
+    {
+        resultMessage.insert(resultMessage.end(), reinterpret_cast<char *>(&prunedTime), reinterpret_cast<char *>(&prunedTime) + sizeof(double));
+    }
     enet_uint32 flags = ENET_PACKET_FLAG_RELIABLE; // zero of ENET_PACKET_FLAG_RELIABLE most commonly
-    ENetPacket *packet = enet_packet_create(m_genomeMessage.text, sizeof(TCPIPMessage), flags);
+    ENetPacket *packet = enet_packet_create(resultMessage.data(), resultMessage.size(), flags);
     enet_uint8 channelID = 0;
     status = enet_peer_send(m_peer, channelID, packet);
     if (status)
     {
-        std::cerr << "Message " << m_genomeMessage.text << " not sent\n";
+        std::cerr << "Message " << genomeMessage->text << " not sent\n";
         return __LINE__;
     }
     else
     {
-        if (m_debug) std::cerr << "Message " << m_genomeMessage.text << " sent to " << GSUtil::ToString(event.peer->address.host, event.peer->address.port) << "\n";
+        if (m_debug) std::cerr << "Message " << genomeMessage->text << " sent to " << GSUtil::ToString(event.peer->address.host, event.peer->address.port) << "\n";
     }
     enet_host_flush(m_client);
 
     return 0;
 }
+
+// runs m_numberOfThreads simulations at once, each in its own thread, keeping one genome queued per thread
+// so that the network requests overlap with the simulations
+int ObjectiveMainENET::RunBatch()
+{
+    if (m_outputWarehouseFilename.size() || m_outputModelStateFilename.size() || m_outputList.size())
+    {
+        std::cerr << "Error: output files cannot be written when --numberOfThreads is greater than 1\n";
+        return __LINE__;
+    }
+
+    BatchEvaluator batchEvaluator;
+    batchEvaluator.setSimulationTimeLimit(m_simulationTimeLimit);
+    batchEvaluator.setWarehouseFailDistanceAbort(m_warehouseFailDistanceAbort);
+    batchEvaluator.setInputWarehouseFilename(m_inputWarehouseFilename);
+    batchEvaluator.setSharedXMLCacheFolder(m_sharedXMLCache.cacheFolder());
+    batchEvaluator.Start(size_t(m_numberOfThreads));
+
+    // the reply to the server needs the original genome message so it is kept until the result comes back
+    std::map<uint32_t, TCPIPMessage> genomeMessages;
+    uint32_t jobNumber = 0;
+    double startTime = GSUtil::GetTime();
+    int timeoutMultiplier = 1;
+    double resultWaitTime = 0.01; // seconds
+    size_t maxOutstandingJobs = 2 * size_t(m_numberOfThreads);
+    while(m_runTimeLimit == 0 || m_runTime <= m_runTimeLimit)
+    {
+        m_runTime = GSUtil::GetTime() - startTime;
+
+        if (batchEvaluator.outstandingJobs() < maxOutstandingJobs)
+        {
+            double ioStartTime = GSUtil::GetTime();
+            std::vector<double> genomeData;
+            int status = ReadGenome(&genomeData);
+            if (m_peer)
+            {
+                if (m_debug) std::cerr <<  "enet_peer_reset(m_peer) after ReadGenome\n";
+                enet_peer_reset(m_peer);
+                m_peer = nullptr;
+            }
+            m_IOTime += (GSUtil::GetTime() - ioStartTime);
+            if (status == 0)
+            {
+                timeoutMultiplier = 1;
+                std::unique_ptr<BatchEvaluator::Job> job = std::make_unique<BatchEvaluator::Job>();
+                job->runID = jobNumber++;
+                std::copy(std::begin(m_MD5), std::end(m_MD5), std::begin(job->md5));
+                job->baseXML = m_baseXML;
+                job->genome = std::move(genomeData);
+                if (m_pruning) job->scoreToBeat = m_scoreToBeat;
+                genomeMessages[job->runID] = m_genomeMessage;
+                batchEvaluator.SubmitJob(std::move(job));
+                continue;
+            }
+            if (batchEvaluator.outstandingJobs() == 0)
+            {
+                // nothing to do so back off in the same way as the single simulation version
+                m_sleepTime = int((*m_distrib.get())(*m_gen.get()) * 10000.0 * timeoutMultiplier);
+                if (m_debug) std::cerr <<  "timeoutMultiplier = " << timeoutMultiplier << " m_sleepTime = " << m_sleepTime << " ms\n";
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_sleepTime));
+                if (timeoutMultiplier < 100) timeoutMultiplier++;
+                continue;
+            }
+        }
+
+        BatchEvaluator::Result result;
+        if (batchEvaluator.GetResult(&result, resultWaitTime) == false) continue;
+        auto messageIt = genomeMessages.find(result.runID);
+        if (messageIt == genomeMessages.end()) continue;
+        TCPIPMessage genomeMessage = messageIt->second;
+        genomeMessages.erase(messageIt);
+        if (result.error)
+        {
+            // the server is still waiting for this genome so it gets the worst possible score
+            std::cerr << "Unable to evaluate genome runID " << genomeMessage.runID << " Score: " << result.score << "\n";
+        }
+        else
+        {
+            m_simulationTime += result.CPUTimeSimulation;
+            std::cerr.precision(17);
+            std::cerr << "Simulation Time: " << result.time <<
+                         " Steps: " << result.stepCount <<
+                         " Score: " << result.score <<
+                         " Mechanical Energy: " << result.mechanicalEnergy <<
+                         " Metabolic Energy: " << result.metabolicEnergy <<
+                         " CPUTimeSimulation: " << result.CPUTimeSimulation <<
+                         " CPUTimeIO: " << m_IOTime <<
+                         "\n";
+        }
+        double ioStartTime = GSUtil::GetTime();
+        SendResult(&genomeMessage, result.score, result.pruned, result.prunedTime);
+        if (m_peer)
+        {
+            if (m_debug) std::cerr <<  "enet_peer_reset(m_peer) after SendResult\n";
+            enet_peer_reset(m_peer);
+            m_peer = nullptr;
+        }
+        m_IOTime += (GSUtil::GetTime() - ioStartTime);
+    }
+
+    // the server is waiting for every genome that was accepted so send back whatever is left
+    batchEvaluator.Stop();
+    BatchEvaluator::Result result;
+    while (batchEvaluator.GetResult(&result, 0))
+    {
+        auto messageIt = genomeMessages.find(result.runID);
+        if (messageIt == genomeMessages.end()) continue;
+        SendResult(&messageIt->second, result.score, result.pruned, result.prunedTime);
+        if (m_peer)
+        {
+            enet_peer_reset(m_peer);
+            m_peer = nullptr;
+        }
+    }
+    return 0;
+}
@@ -14,6 +14,7 @@
 #include "XMLConverter.h"
 #include "ArgParse.h"
 #include "TCPIPMessage.h"
+#include "SharedXMLCache.h"
 
 #include "enet/enet.h"
 
@@ -23,6 +24,7 @@
 #include <deque>
 #include <memory>
 #include <random>
+#include <cfloat>
 
 class Simulation;
 class Hosts;
@@ -33,8 +35,11 @@ public:
     ObjectiveMainENET(int argc, const char **argv);
 
     int Run();
+    int RunBatch();
+    int ReadGenome(std::vector<double> *genomeData);
     int ReadModel();
     int WriteOutput();
+    int SendResult(TCPIPMessage *genomeMessage, double score, bool pruned, double prunedTime);
 
 private:
     std::vector<std::string> m_outputList;
@@ -49,6 +54,8 @@ private:
     double m_outputModelStateAtWarehouseDistance = -1;
     double m_simulationTimeLimit = -1;
     double m_warehouseFailDistanceAbort = 0;
+    double m_scoreToBeat = -DBL_MAX;
+    int m_numberOfThreads = 1;
 
     std::string m_configFilename;
     std::string m_outputWarehouseFilename;
@@ -67,9 +74,11 @@ private:
     int m_sleepTime = 10000; // milliseconds
     int m_timeout = 100000; // milliseconds
 
-    std::map<std::vector<uint32_t>, std::string> m_cachedConfigFiles;
+    std::shared_ptr<const std::string> m_baseXML;
+    std::map<std::vector<uint32_t>, std::shared_ptr<const std::string>> m_cachedConfigFiles;
     std::deque<std::vector<uint32_t>> m_cachedConfigFilesQueue;
     size_t m_cachedConfigFilesLimit = 10;
+    SharedXMLCache m_sharedXMLCache;
     TCPIPMessage m_genomeMessage = {};
     bool m_connected = false;
 
@@ -77,6 +86,8 @@ private:
     std::unique_ptr<std::uniform_real_distribution<double>> m_distrib;
 
     bool m_debug = false;
+    bool m_pruning = false;
+    bool m_clearXMLCache = false;
 };
 
 #endif // OBJECTIVEMAINENET_H
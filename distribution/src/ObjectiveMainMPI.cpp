@@ -55,6 +55,7 @@ ObjectiveMainMPI::ObjectiveMainMPI()
 #include "Body.h"
 #include "Geom.h"
 #include "MD5.h"
+#include "StepProfiler.h"
 
 #ifdef USE_UDP
 #include "UDP.h"
@@ -105,12 +106,7 @@ static double gSimulationTimeLimit = -1;
 static int gRunTimeLimit = 0;
 static double gWarehouseFailDistanceAbort = 0;
 
-#ifndef USE_QT
-static double gLastTime = 0;
-static double gCurrentTime = 0;
-#endif
-static double gSimulationTime = 0;
-static double gIOTime = 0;
+static bool gProfileFlag = false;
 
 static XMLConverter gXMLConverter;
 
@@ -181,8 +177,11 @@ int GaitSymMain(int argc, char *argv[])
 #endif
 
 
+    // the profiler accumulates over all the runs so it outlives each simulation
+    std::unique_ptr<StepProfiler> stepProfiler;
+    if (gProfileFlag) stepProfiler = std::make_unique<StepProfiler>();
+
     // another never returned loop (exits are in WriteModel when required)
-    gLastTime = GSUtil::GetTime();
     long runTime = 0;
     long startTime = time(0);
     unsigned int runCount = 0;
@@ -192,7 +191,7 @@ int GaitSymMain(int argc, char *argv[])
 
         if (gFinishedFlag)
         {
-            if (ReadModel() == 0)
+            if (ReadModel(stepProfiler.get()) == 0)
             {
                 gFinishedFlag = false;
 
@@ -216,22 +215,16 @@ int GaitSymMain(int argc, char *argv[])
         }
         else
         {
-            gCurrentTime = GSUtil::GetTime();
-            gIOTime += (gCurrentTime - gLastTime);
-            gLastTime = gCurrentTime;
             while (gSimulation->ShouldQuit() == false)
             {
                 gSimulation->UpdateSimulation();
 
                 if (gSimulation->TestForCatastrophy()) break;
             }
-            gCurrentTime = GSUtil::GetTime();
-            gSimulationTime += (gCurrentTime - gLastTime);
-            gLastTime = gCurrentTime;
 
             gFinishedFlag = true;
             runCount++;
-            if (runCount % 100 == 0) std::cout << "gSimulationTime=" << gSimulationTime << " gIOTime=" << gIOTime << "\n" << std::flush;
+            if (stepProfiler && runCount % 100 == 0) std::cout << "Runs: " << runCount << "\n" << stepProfiler->Summary() << std::flush;
             if (WriteModel()) return 0;
         }
     }
@@ -514,6 +507,12 @@ void ParseArguments(int argc, char ** argv)
                 newHost.port = strtol(colonPtr, 0, 10);
                 gHosts.push_back(newHost);
             }
+        else
+            if (strcmp(argv[i], "--profile") == 0 ||
+                strcmp(argv[i], "-pf") == 0)
+            {
+                gProfileFlag = true;
+            }
         else
             if (strcmp(argv[i], "--quiet") == 0 ||
                 strcmp(argv[i], "-q") == 0)
@@ -571,6 +570,8 @@ void ParseArguments(int argc, char ** argv)
                 std::cerr << "Uses new standardised position and quaternion outputs\n\n";
                 std::cerr << "-m, --ModelConfigFile\n";
                 std::cerr << "Use a model config file that can be substituted by an external genome\n\n";
+                std::cerr << "-pf, --profile\n";
+                std::cerr << "Times each phase of the simulation step and prints a summary every 100 runs\n\n";
                 std::cerr << "-q, --quiet\n";
                 std::cerr << "Suppresses stdout and stderr messages by redirecting to /dev/null\n\n";
                 std::cerr << "-on, --outputName\n";
@@ -604,7 +605,7 @@ for (i = 0; i < argc; i++)
 
 // this routine attemps to read the model specification and initialise the simulation
 // it returns zero on success
-int ReadModel(void *userData)
+int ReadModel(StepProfiler *stepProfiler)
 {
     DataFile myFile;
 #if !defined(USE_UDP) && !defined(USE_TCP) && !defined(USE_MPI)
@@ -842,8 +843,9 @@ int ReadModel(void *userData)
             double *dPtr = (double *)(&iPtr[2]);
             iPtr[0] = MPI_MESSAGE_ID_SEND_TIMINGS;
             iPtr[1] = gRunID;
-            dPtr[0] = gSimulationTime;
-            dPtr[1] = gIOTime;
+            // only the simulation time is known and only when profiling
+            dPtr[0] = stepProfiler ? stepProfiler->totalTime() : 0;
+            dPtr[1] = 0;
             MPI_Send(results,            /* message buffer */
                      sizeof(results),    /* 'len' data item */
                      MPI_BYTE,           /* data items are bytes */
@@ -919,6 +921,7 @@ int ReadModel(void *userData)
     // late initialisation options
     if (gSimulationTimeLimit >= 0) gSimulation->SetTimeLimit(gSimulationTimeLimit);
     if (gWarehouseFailDistanceAbort != 0) gSimulation->SetWarehouseFailDistanceAbort(gWarehouseFailDistanceAbort);
+    if (stepProfiler) gSimulation->SetStepProfiler(stepProfiler);
 
     return 0;
 }
@@ -939,17 +942,13 @@ int WriteModel()
                  " Steps: " << gSimulation->GetStepCount() <<
                  " Score: " << score <<
                  " Mechanical Energy: " << gSimulation->GetMechanicalEnergy() <<
-                 " Metabolic Energy: " << gSimulation->GetMetabolicEnergy() <<
-                 " CPUTimeSimulation: " << gSimulationTime <<
-                 " CPUTimeIO: " << gIOTime << "\n";
+                 " Metabolic Energy: " << gSimulation->GetMetabolicEnergy() << "\n";
 #else
     std::cerr << "Simulation Time: " << gSimulation->GetTime() <<
                  " Steps: " << gSimulation->GetStepCount() <<
                  " Score: " << score <<
                  " Mechanical Energy: " << gSimulation->GetMechanicalEnergy() <<
-                 " Metabolic Energy: " << gSimulation->GetMetabolicEnergy() <<
-                 " CPUTimeSimulation: " << gSimulationTime <<
-                 " CPUTimeIO: " << gIOTime << "\n";
+                 " Metabolic Energy: " << gSimulation->GetMetabolicEnergy() << "\n";
 #endif
 
 #if defined(USE_UDP)
@@ -20,6 +20,8 @@
 #include "Geom.h"
 #include "ArgParse.h"
 #include "MD5.h"
+#include "BatchEvaluator.h"
+#include "PipelinedTCPClient.h"
 
 #include "pystring.h"
 
@@ -61,8 +63,15 @@ ObjectiveMainTCP::ObjectiveMainTCP(int argc, const char **argv)
     m_argparse.AddArgument("-mt"s, "--outputModelStateAtTime"s, "Output model state at this cycle"s, ""s, 1, false, ArgParse::Double);
     m_argparse.AddArgument("-mw"s, "--outputModelStateAtWarehouseDistance"s, "Output model state at this warehouse distance"s, ""s, 1, false, ArgParse::Double);
     m_argparse.AddArgument("-wd"s, "--warehouseFailDistanceAbort"s, "Abort the simulation when the warehouse distance fails"s, "0"s, 1, false, ArgParse::Bool);
+    m_argparse.AddArgument("-nt"s, "--numberOfThreads"s, "Number of simulations to run in parallel. Only the base XML text is shared, each simulation loads its own copy of everything else including meshes and data target tables, and models containing trimesh geoms are rejected when this is greater than 1"s, "1"s, 1, false, ArgParse::Int);
+    m_argparse.AddArgument("-pr"s, "--pruning"s, "Stop simulations early when the score to beat sent with the genome can no longer be reached"s);
+    m_argparse.AddArgument("-pc"s, "--persistentConnection"s, "Keep a single connection open to the server and prefetch genomes whilst simulating"s);
+    m_argparse.AddArgument("-pd"s, "--pipelineDepth"s, "Number of genomes to prefetch with --persistentConnection"s, "4"s, 1, false, ArgParse::Int);
+    m_argparse.AddArgument("-it"s, "--idleTimeout"s, "With --persistentConnection exit when no genomes have been received for this many seconds (0 to wait for the server to send stop)"s, "0"s, 1, false, ArgParse::Double);
+    m_argparse.AddArgument("-xc"s, "--xmlCacheFolder"s, "Folder for a base XML cache shared by the workers on this machine e.g. /dev/shm (off by default)"s, ""s, 1, false, ArgParse::String);
+    m_argparse.AddArgument("-cx"s, "--clearXMLCache"s, "Delete this user's entries from the --xmlCacheFolder base XML cache and exit"s);
 
-    m_argparse.AddArgument("-ol"s, "-outputList"s, "List of objects to produce output"s, ""s, 1, MAX_ARGS, false, ArgParse::String);
+    m_argparse.AddArgument("-ol"s, "--outputList"s, "List of objects to produce output"s, ""s, 1, MAX_ARGS, false, ArgParse::String);
 
     m_argparse.AddArgument("-hl"s, "--hostsList"s, "List of hosts "s, "localhost:8086"s, 1, MAX_ARGS, true, ArgParse::String);
 
@@ -85,6 +94,15 @@ ObjectiveMainTCP::ObjectiveMainTCP(int argc, const char **argv)
     m_argparse.Get("--modelState"s, &m_outputModelStateFilename);
     m_argparse.Get("--inputWarehouse"s, &m_inputWarehouseFilename);
     m_argparse.Get("--outputWarehouse"s, &m_outputWarehouseFilename);
+    m_argparse.Get("--numberOfThreads"s, &m_numberOfThreads);
+    m_argparse.Get("--pruning"s, &m_pruning);
+    m_argparse.Get("--persistentConnection"s, &m_persistentConnection);
+    m_argparse.Get("--pipelineDepth"s, &m_pipelineDepth);
+    m_argparse.Get("--idleTimeout"s, &m_idleTimeout);
+    std::string xmlCacheFolder;
+    m_argparse.Get("--xmlCacheFolder"s, &xmlCacheFolder);
+    m_sharedXMLCache.setCacheFolder(xmlCacheFolder);
+    m_argparse.Get("--clearXMLCache"s, &m_clearXMLCache);
 
     std::vector<std::string> rawHosts;
     std::vector<std::string> result;
@@ -104,6 +122,17 @@ ObjectiveMainTCP::ObjectiveMainTCP(int argc, const char **argv)
 
 int ObjectiveMainTCP::Run()
 {
+    if (m_clearXMLCache)
+    {
+        if (m_sharedXMLCache.Clear())
+        {
+            std::cerr << "Error: unable to clear the XML cache in \"" << m_sharedXMLCache.cacheFolder() << "\"\n";
+            return __LINE__;
+        }
+        return 0;
+    }
+    if (m_numberOfThreads > 1 || m_persistentConnection) return RunBatch();
+
     double startTime = GSUtil::GetTime();
     bool finishedFlag = true;
     double currentTime;
@@ -156,14 +185,12 @@ int ObjectiveMainTCP::Run()
     return 0;
 }
 
-// this routine attemps to read the model specification and initialise the simulation
+// this routine attemps to read the model specification and the genome from the server
 // it returns zero on success
-int ObjectiveMainTCP::ReadModel()
+int ObjectiveMainTCP::ReadGenome(std::vector<double> *genome)
 {
-    DataFile myFile;
-    myFile.SetExitOnError(false);
 #ifdef TCP_DEBUG
-    std::cerr <<  "ReadModel m_currentHost " << m_currentHost
+    std::cerr <<  "ReadGenome m_currentHost " << m_currentHost
         << " host " << m_hosts[m_currentHost].host
         << " port " << m_hosts[m_currentHost].port
         << "\n";
@@ -204,21 +231,29 @@ int ObjectiveMainTCP::ReadModel()
             if (numBytes != TCPIPMessage::StandardMessageSize) throw __LINE__;
             len = messagePtr->length;
             //OUT_VAR(len);
-            char *xmlbuf = new char[len];
 
-            strcpy(buffer, "req_xml_data");
-            numBytes = m_TCP.SendData(buffer, TCPIPMessage::StandardMessageSize);
-            //OUT_VAR(buffer);
-            if (numBytes != TCPIPMessage::StandardMessageSize) throw __LINE__;
-
-            numBytes = m_TCP.ReceiveData(xmlbuf, len, 10, 0);
-            //OUT_VAR(numBytes);
-            if (numBytes < len) throw __LINE__;
-            memcpy(m_MD5, md5(xmlbuf, len), sizeof(m_MD5)); // the is the md5 score of everything that is sent (which includes a terminating zero)
-            // std::cerr << hexDigest(gMD5) << "\n";
-
-            m_XMLConverter.LoadBaseXMLString(xmlbuf, len);
-            delete [] xmlbuf;
+            // if the server sends the md5 with the length then the XML might already be in the node local cache
+            bool md5Sent = std::any_of(std::begin(messagePtr->md5), std::end(messagePtr->md5), [](uint32_t v) { return v != 0; });
+            if (md5Sent == false || LoadSharedXML(messagePtr->md5))
+            {
+                char *xmlbuf = new char[len];
+
+                strcpy(buffer, "req_xml_data");
+                numBytes = m_TCP.SendData(buffer, TCPIPMessage::StandardMessageSize);
+                //OUT_VAR(buffer);
+                if (numBytes != TCPIPMessage::StandardMessageSize) throw __LINE__;
+
+                numBytes = m_TCP.ReceiveData(xmlbuf, len, 10, 0);
+                //OUT_VAR(numBytes);
+                if (numBytes < len) throw __LINE__;
+                memcpy(m_MD5, md5(xmlbuf, len), sizeof(m_MD5)); // the is the md5 score of everything that is sent (which includes a terminating zero)
+                // std::cerr << hexDigest(gMD5) << "\n";
+
+                m_XMLConverter.LoadBaseXMLString(xmlbuf, len);
+                m_baseXML = std::make_shared<const std::string>(xmlbuf, len);
+                delete [] xmlbuf;
+                m_sharedXMLCache.Store(m_MD5, &m_XMLConverter);
+            }
         }
 
         strcpy(buffer, "req_send_length");
@@ -229,9 +264,11 @@ int ObjectiveMainTCP::ReadModel()
         if (numBytes != TCPIPMessage::StandardMessageSize) throw __LINE__;
         len = messagePtr->length;
         m_submitCount = messagePtr->runID;
+        if (m_pruning) m_scoreToBeat = messagePtr->score; // the server sends the score to beat with the genome length
         // std::cerr << hexDigest((const unsigned int *)ptr) << "\n";
-        if (std::equal(std::begin(m_MD5), std::end(m_MD5), std::begin(messagePtr->md5)) == false)
+        if (std::equal(std::begin(m_MD5), std::end(m_MD5), std::begin(messagePtr->md5)) == false && LoadSharedXML(messagePtr->md5))
         {
+            // the model has changed and it is not in the node local cache so it is fetched next time
             m_XMLConverter.Clear();
             throw __LINE__;
         }
@@ -250,10 +287,7 @@ int ObjectiveMainTCP::ReadModel()
 
         double *dPtr = (double *)buf;
         int genomeLength = len / sizeof(double);
-        m_XMLConverter.ApplyGenome(genomeLength, dPtr);
-        size_t xmlLen;
-        const char *xmlPtr = m_XMLConverter.GetFormattedXML(&xmlLen);
-        myFile.SetRawData(xmlPtr, xmlLen);
+        genome->assign(dPtr, dPtr + genomeLength);
         delete [] buf;
         m_TCP.StopClient();
     }
@@ -262,13 +296,45 @@ int ObjectiveMainTCP::ReadModel()
     {
         if (e > 0) m_TCP.StopClient();
 #ifdef TCP_DEBUG
-        std::cerr <<  "ReadModel error on line " << e << "\n";
+        std::cerr <<  "ReadGenome error on line " << e << "\n";
 #endif
         m_currentHost++;
         if (m_currentHost >= m_hosts.size()) m_currentHost = 0;
         return 1;
     }
 
+    return 0;
+}
+
+// loads the base XML from the node local cache
+// it returns zero on success
+int ObjectiveMainTCP::LoadSharedXML(const uint32_t *md5)
+{
+    if (m_sharedXMLCache.Load(md5, &m_XMLConverter)) return __LINE__;
+    std::copy(md5, md5 + 4, std::begin(m_MD5));
+    m_baseXML = std::make_shared<const std::string>(m_sharedXMLCache.xmlData(), m_sharedXMLCache.xmlLength());
+    m_sharedXMLCache.Close();
+    return 0;
+}
+
+// this routine attemps to read the model specification and initialise the simulation
+// it returns zero on success
+int ObjectiveMainTCP::ReadModel()
+{
+    std::vector<double> genome;
+    if (ReadGenome(&genome)) return 1;
+
+    DataFile myFile;
+    myFile.SetExitOnError(false);
+    m_XMLConverter.ApplyGenome(int(genome.size()), genome.data());
+    if (m_XMLConverter.ApplyParameterMap())
+    {
+        // no parameter map so fall back to the full XML text
+        size_t xmlLen;
+        const char *xmlPtr = m_XMLConverter.GetFormattedXML(&xmlLen);
+        myFile.SetRawData(xmlPtr, xmlLen);
+    }
+
     // create the simulation object
     m_simulation = new Simulation();
     if (m_outputWarehouseFilename.size()) m_simulation->SetOutputWarehouseFile(m_outputWarehouseFilename);
@@ -278,7 +344,10 @@ int ObjectiveMainTCP::ReadModel()
     if (m_inputWarehouseFilename.size()) m_simulation->AddWarehouse(m_inputWarehouseFilename);
     if (m_outputModelStateAtWarehouseDistance >= 0) m_simulation->SetOutputModelStateAtWarehouseDistance(m_outputModelStateAtWarehouseDistance);
 
-    if (m_simulation->LoadModel(myFile.GetRawData(), myFile.GetSize()))
+    std::string *errorMessage;
+    if (m_XMLConverter.ParameterMapValid()) errorMessage = m_simulation->LoadModel(m_XMLConverter.ParameterMapElementList());
+    else errorMessage = m_simulation->LoadModel(myFile.GetRawData(), myFile.GetSize());
+    if (errorMessage)
     {
         delete m_simulation;
         m_simulation = nullptr;
@@ -288,6 +357,7 @@ int ObjectiveMainTCP::ReadModel()
     // late initialisation options
     if (m_simulationTimeLimit >= 0) m_simulation->SetTimeLimit(m_simulationTimeLimit);
     if (m_warehouseFailDistanceAbort != 0) m_simulation->SetWarehouseFailDistanceAbort(m_warehouseFailDistanceAbort);
+    if (m_pruning) m_simulation->SetScoreToBeat(m_scoreToBeat);
 
     return 0;
 }
@@ -305,10 +375,17 @@ int ObjectiveMainTCP::WriteOutput()
                  " CPUTimeSimulation: " << m_simulationTime <<
                  " CPUTimeIO: " << m_IOTime <<
                  "\n";
+    return SendResult(score, m_submitCount, m_MD5, m_simulation->GetPruned(), m_simulation->GetPrunedTime());
+}
 
+// returns 0 if continuing
+// returns 1 if exit requested
+// a pruned simulation sends "result_pruned" instead of "result" followed by the simulation time when it was pruned (double)
+int ObjectiveMainTCP::SendResult(double score, uint32_t runID, const unsigned int *md5, bool pruned, double prunedTime)
+{
     int status = 0;
     int numBytes;
-    char buffer[64];
+    char buffer[64 + sizeof(double)];
     struct TCPIPMessage
     {
         char text[32];
@@ -330,12 +407,18 @@ int ObjectiveMainTCP::WriteOutput()
         }
         if (status != 0) throw -1 * __LINE__;
 
-        strcpy(messagePtr->text, "result");
+        strcpy(messagePtr->text, pruned ? "result_pruned" : "result");
         messagePtr->score = score;
-        messagePtr->runID = m_submitCount;
-        memcpy(messagePtr->md5, m_MD5, sizeof(m_MD5));
-        numBytes = m_TCP.SendData(buffer, TCPIPMessage::StandardMessageSize);
-        if (numBytes != TCPIPMessage::StandardMessageSize) throw __LINE__;
+        messagePtr->runID = runID;
+        memcpy(messagePtr->md5, md5, sizeof(messagePtr->md5));
+        int messageSize = TCPIPMessage::StandardMessageSize;
+        if (pruned)
+        {
+            memcpy(buffer + TCPIPMessage::StandardMessageSize, &prunedTime, sizeof(double));
+            messageSize += int(sizeof(double));
+        }
+        numBytes = m_TCP.SendData(buffer, messageSize);
+        if (numBytes != messageSize) throw __LINE__;
         m_TCP.StopClient();
     }
 
@@ -348,3 +431,114 @@ int ObjectiveMainTCP::WriteOutput()
 
     return 0;
 }
+
+// runs m_numberOfThreads simulations at once, each in its own thread, keeping one genome queued per thread
+// so that the network requests overlap with the simulations
+// with --persistentConnection the genomes and results go through a single connection managed by PipelinedTCPClient
+int ObjectiveMainTCP::RunBatch()
+{
+    if (m_outputWarehouseFilename.size() || m_outputModelStateFilename.size() || m_outputList.size())
+    {
+        std::cerr << "Error: output files cannot be written when --numberOfThreads is greater than 1 or with --persistentConnection\n";
+        return 1;
+    }
+
+    PipelinedTCPClient client;
+    if (m_persistentConnection)
+    {
+        std::vector<PipelinedTCPClient::Host> hosts;
+        for (auto &&it : m_hosts) hosts.push_back({it.host, it.port});
+        client.setSleepTime(m_sleepTime);
+        client.setSharedXMLCacheFolder(m_sharedXMLCache.cacheFolder());
+        client.Start(hosts, size_t(std::max(m_pipelineDepth, 1)));
+    }
+
+    BatchEvaluator batchEvaluator;
+    batchEvaluator.setSimulationTimeLimit(m_simulationTimeLimit);
+    batchEvaluator.setWarehouseFailDistanceAbort(m_warehouseFailDistanceAbort);
+    batchEvaluator.setInputWarehouseFilename(m_inputWarehouseFilename);
+    batchEvaluator.setSharedXMLCacheFolder(m_sharedXMLCache.cacheFolder());
+    batchEvaluator.Start(size_t(m_numberOfThreads));
+
+    double startTime = GSUtil::GetTime();
+    double runTime = 0;
+    double lastJobTime = startTime;
+    size_t maxOutstandingJobs = m_persistentConnection ? size_t(m_numberOfThreads) : 2 * size_t(m_numberOfThreads);
+    while(m_runTimeLimit == 0 || runTime <= m_runTimeLimit)
+    {
+        runTime = GSUtil::GetTime() - startTime;
+
+        if (m_persistentConnection && batchEvaluator.outstandingJobs() < maxOutstandingJobs)
+        {
+            // when idle this blocks until a genome arrives or the server sends stop
+            std::unique_ptr<BatchEvaluator::Job> job;
+            if (client.GetJob(&job, batchEvaluator.outstandingJobs() ? 0 : 1.0))
+            {
+                if (m_pruning == false) job->scoreToBeat = -DBL_MAX;
+                batchEvaluator.SubmitJob(std::move(job));
+                lastJobTime = GSUtil::GetTime();
+                continue;
+            }
+            if (batchEvaluator.outstandingJobs() == 0)
+            {
+                if (client.finished()) break;
+                if (m_idleTimeout > 0 && GSUtil::GetTime() - lastJobTime > m_idleTimeout)
+                {
+                    std::cerr << "No genomes received for " << m_idleTimeout << " s so exiting\n";
+                    break;
+                }
+                continue;
+            }
+        }
+        else if (batchEvaluator.outstandingJobs() < maxOutstandingJobs)
+        {
+            std::vector<double> genome;
+            if (ReadGenome(&genome) == 0)
+            {
+                std::unique_ptr<BatchEvaluator::Job> job = std::make_unique<BatchEvaluator::Job>();
+                job->runID = m_submitCount;
+                std::copy(std::begin(m_MD5), std::end(m_MD5), std::begin(job->md5));
+                job->baseXML = m_baseXML;
+                job->genome = std::move(genome);
+                if (m_pruning) job->scoreToBeat = m_scoreToBeat;
+                batchEvaluator.SubmitJob(std::move(job));
+                continue;
+            }
+        }
+
+        BatchEvaluator::Result result;
+        if (batchEvaluator.GetResult(&result, double(m_sleepTime) / 1e6) == false) continue;
+        if (result.error)
+        {
+            // the server is still waiting for this genome so it gets the worst possible score
+            std::cerr << "Unable to evaluate genome runID " << result.runID << " Score: " << result.score << "\n";
+        }
+        else
+        {
+            std::cerr << "Simulation Time: " << result.time <<
+                         " Steps: " << result.stepCount <<
+                         " Score: " << result.score <<
+                         " Mechanical Energy: " << result.mechanicalEnergy <<
+                         " Metabolic Energy: " << result.metabolicEnergy <<
+                         " CPUTimeSimulation: " << result.CPUTimeSimulation <<
+                         "\n";
+        }
+        if (m_persistentConnection)
+        {
+            client.PostResult(result);
+            continue;
+        }
+        if (SendResult(result.score, result.runID, result.md5, result.pruned, result.prunedTime)) break;
+    }
+
+    // the server is waiting for every genome that was accepted so send back whatever is left
+    batchEvaluator.Stop();
+    BatchEvaluator::Result result;
+    while (batchEvaluator.GetResult(&result, 0))
+    {
+        if (m_persistentConnection) client.PostResult(result);
+        else if (SendResult(result.score, result.runID, result.md5, result.pruned, result.prunedTime)) break;
+    }
+    client.Stop();
+    return 0;
+}
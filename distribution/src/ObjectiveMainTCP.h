@@ -14,9 +14,12 @@
 #include "XMLConverter.h"
 #include "ArgParse.h"
 #include "TCP.h"
+#include "SharedXMLCache.h"
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <cfloat>
 
 class Simulation;
 
@@ -26,8 +29,12 @@ public:
     ObjectiveMainTCP(int argc, const char **argv);
 
     int Run();
+    int RunBatch();
+    int ReadGenome(std::vector<double> *genome);
     int ReadModel();
+    int LoadSharedXML(const uint32_t *md5);
     int WriteOutput();
+    int SendResult(double score, uint32_t runID, const unsigned int *md5, bool pruned, double prunedTime);
 
 private:
     std::vector<std::string> m_outputList;
@@ -41,6 +48,13 @@ private:
     double m_outputModelStateAtWarehouseDistance = -1;
     double m_simulationTimeLimit = -1;
     double m_warehouseFailDistanceAbort = 0;
+    int m_numberOfThreads = 1;
+    bool m_pruning = false;
+    bool m_clearXMLCache = false;
+    bool m_persistentConnection = false;
+    int m_pipelineDepth = 4;
+    double m_idleTimeout = 0;
+    double m_scoreToBeat = -DBL_MAX;
 
     std::string m_configFilename;
     std::string m_outputWarehouseFilename;
@@ -49,6 +63,7 @@ private:
     std::string m_scoreFilename;
 
     XMLConverter m_XMLConverter;
+    SharedXMLCache m_sharedXMLCache;
     ArgParse m_argparse;
 
     struct Hosts
@@ -60,6 +75,7 @@ private:
     size_t m_currentHost = 0;
     TCP m_TCP;
     unsigned int m_MD5[4] = {};
+    std::shared_ptr<const std::string> m_baseXML;
     uint32_t m_submitCount = 0;
     int m_sleepAfterFailMicroseconds = 1000000;
     int m_sleepTime = 10000;
@@ -12,6 +12,7 @@
 #include "Simulation.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 using namespace std::string_literals;
 
@@ -95,3 +96,23 @@ std::string PIDErrorInController::dumpToString()
     return s;
 }
 
+void PIDErrorInController::saveState(StateBuffer *state)
+{
+    Controller::saveState(state);
+    state->Write(m_previous_error);
+    state->Write(m_error);
+    state->Write(m_integral);
+    state->Write(m_derivative);
+    state->Write(m_output);
+}
+
+void PIDErrorInController::restoreState(StateBuffer *state)
+{
+    Controller::restoreState(state);
+    state->Read(&m_previous_error);
+    state->Read(&m_error);
+    state->Read(&m_integral);
+    state->Read(&m_derivative);
+    state->Read(&m_output);
+}
+
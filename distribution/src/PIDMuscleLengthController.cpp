@@ -14,6 +14,7 @@
 #include "GSUtil.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 using namespace std::string_literals;
 
@@ -123,3 +124,26 @@ double m_derivative = 0;
 double m_output = 0;
 double m_dt = 0;
 double m_current_length = 0;
+
+void PIDMuscleLengthController::saveState(StateBuffer *state)
+{
+    Controller::saveState(state);
+    state->Write(m_previous_error);
+    state->Write(m_error);
+    state->Write(m_integral);
+    state->Write(m_derivative);
+    state->Write(m_output);
+    state->Write(m_current_length);
+}
+
+void PIDMuscleLengthController::restoreState(StateBuffer *state)
+{
+    Controller::restoreState(state);
+    state->Read(&m_previous_error);
+    state->Read(&m_error);
+    state->Read(&m_integral);
+    state->Read(&m_derivative);
+    state->Read(&m_output);
+    state->Read(&m_current_length);
+}
+
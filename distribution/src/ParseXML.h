@@ -27,6 +27,7 @@ public:
     {
         std::string tag;
         std::map<std::string, std::string> attributes;
+        std::map<std::string, std::vector<double>> numericAttributes; // only filled when the model is read by BinaryModel
     };
 
     void AddElement(const std::string &tag, const std::map<std::string, std::string> &attributeList);
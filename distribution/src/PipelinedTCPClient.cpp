@@ -0,0 +1,431 @@
+/*
+ *  PipelinedTCPClient.cpp
+ *  GaitSym2019
+ *
+ *  Keeps a single connection open to the GA server on its own thread and keeps
+ *  a queue of genomes filled while the simulations run. Results are sent back on
+ *  the same connection and are batched together when several are waiting
+ *
+ */
+
+#include "PipelinedTCPClient.h"
+#include "GSUtil.h"
+#include "MD5.h"
+#include "XMLConverter.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <cfloat>
+
+PipelinedTCPClient::PipelinedTCPClient()
+{
+}
+
+PipelinedTCPClient::~PipelinedTCPClient()
+{
+    Stop();
+}
+
+void PipelinedTCPClient::Start(const std::vector<Host> &hosts, size_t pipelineDepth)
+{
+    Stop();
+    m_hosts = hosts;
+    m_currentHost = 0;
+    m_pipelineDepth = std::max(pipelineDepth, size_t(1));
+    m_stopFlag = false;
+    m_serverStopped = false;
+    m_stopReceived = false;
+    if (m_hosts.size() == 0) return;
+    m_thread = std::thread(&PipelinedTCPClient::Run, this);
+}
+
+void PipelinedTCPClient::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopFlag = true;
+    }
+    m_jobAvailable.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool PipelinedTCPClient::GetJob(std::unique_ptr<BatchEvaluator::Job> *job, double timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_jobQueue.empty() && timeout > 0)
+        m_jobAvailable.wait_for(lock, std::chrono::duration<double>(timeout), [this]{ return m_stopFlag || m_serverStopped || !m_jobQueue.empty(); });
+    if (m_jobQueue.empty()) return false;
+    *job = std::move(m_jobQueue.front());
+    m_jobQueue.pop_front();
+    return true;
+}
+
+void PipelinedTCPClient::PostResult(const BatchEvaluator::Result &result)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_resultQueue.push_back(result);
+}
+
+bool PipelinedTCPClient::finished()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_serverStopped && m_jobQueue.empty();
+}
+
+void PipelinedTCPClient::setSleepTime(int sleepTime)
+{
+    m_sleepTime = sleepTime;
+}
+
+void PipelinedTCPClient::setSharedXMLCacheFolder(const std::string &sharedXMLCacheFolder)
+{
+    m_sharedXMLCache.setCacheFolder(sharedXMLCacheFolder);
+}
+
+void PipelinedTCPClient::Run()
+{
+    while (true)
+    {
+        bool stopFlag;
+        size_t queuedJobs;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            stopFlag = m_stopFlag;
+            queuedJobs = m_jobQueue.size();
+        }
+
+        if (m_connected == false)
+        {
+            if (stopFlag) break;
+            if (Connect())
+            {
+                // wait before trying the next host but keep checking for a stop request
+                double retryTime = GSUtil::GetTime() + double(m_sleepAfterFailMicroseconds) / 1e6;
+                while (GSUtil::GetTime() < retryTime)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (m_stopFlag) break;
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(m_sleepTime));
+                }
+                continue;
+            }
+            if (RequestMissingXML())
+            {
+                Disconnect();
+                continue;
+            }
+        }
+
+        if (SendResults())
+        {
+            Disconnect();
+            continue;
+        }
+        if (stopFlag)
+        {
+            // anything that was not simulated is reported back so that the server is not left waiting for it
+            FailUnfinishedJobs();
+            SendResults();
+            break;
+        }
+
+        // only one request is outstanding at a time and it asks for enough genomes to fill the pipeline
+        size_t wanted = queuedJobs + m_waitingForXML.size() < m_pipelineDepth ? m_pipelineDepth - queuedJobs - m_waitingForXML.size() : 0;
+        if (m_stopReceived == false && m_requestPending == false && wanted > 0 && GSUtil::GetTime() >= m_nextRequestTime)
+        {
+            if (SendMessage("req_jobs", uint32_t(wanted), 0, nullptr, std::vector<char>()))
+            {
+                Disconnect();
+                continue;
+            }
+            m_requestPending = true;
+        }
+
+        int status = m_TCP.CheckReceiver(0, m_sleepTime);
+        if (status < 0 || (status > 0 && ReceiveMessage()))
+        {
+            Disconnect();
+            continue;
+        }
+    }
+    Disconnect();
+}
+
+int PipelinedTCPClient::Connect()
+{
+    int status = m_TCP.StartClient(m_hosts[m_currentHost].port, m_hosts[m_currentHost].host.c_str());
+    if (status != 0)
+    {
+#ifdef TCP_DEBUG
+        std::cerr << "PipelinedTCPClient unable to connect to host " << m_hosts[m_currentHost].host << " on port " << m_hosts[m_currentHost].port << "\n";
+#endif
+        m_currentHost++;
+        if (m_currentHost >= m_hosts.size()) m_currentHost = 0;
+        return __LINE__;
+    }
+    m_connected = true;
+    m_requestPending = false;
+    m_nextRequestTime = 0;
+    return 0;
+}
+
+// jobs that are ready are kept and their results are sent on the next connection
+// jobs still waiting for their base XML are also kept and the XML is requested again on the next connection
+void PipelinedTCPClient::Disconnect()
+{
+    if (m_connected == false) return;
+    m_TCP.StopClient();
+    m_connected = false;
+    m_requestPending = false;
+    m_requestedXML.clear();
+    m_currentHost++;
+    if (m_currentHost >= m_hosts.size()) m_currentHost = 0;
+}
+
+int PipelinedTCPClient::SendMessage(const char *text, uint32_t length, uint32_t runID, const uint32_t *md5, const std::vector<char> &payload)
+{
+    std::vector<char> buffer(MessageHeader::StandardMessageSize + payload.size(), 0);
+    MessageHeader header = {};
+    strncpy(header.text, text, sizeof(header.text) - 1);
+    header.length = length;
+    header.runID = runID;
+    if (md5) std::copy(md5, md5 + 4, header.md5);
+    memcpy(buffer.data(), &header, sizeof(header));
+    if (payload.size()) memcpy(buffer.data() + MessageHeader::StandardMessageSize, payload.data(), payload.size());
+    int numBytes = m_TCP.SendData(buffer.data(), int(buffer.size()));
+    if (numBytes != int(buffer.size())) return __LINE__;
+    return 0;
+}
+
+// all the waiting results go in a single message
+int PipelinedTCPClient::SendResults()
+{
+    std::vector<BatchEvaluator::Result> results;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_resultQueue.empty()) return 0;
+        results.swap(m_resultQueue);
+    }
+
+    const size_t recordSize = 6 * sizeof(uint32_t) + 2 * sizeof(double);
+    std::vector<char> payload(results.size() * recordSize);
+    char *ptr = payload.data();
+    for (auto &&result : results)
+    {
+        uint32_t values[6] = {result.runID, result.pruned ? 1u : 0u, result.md5[0], result.md5[1], result.md5[2], result.md5[3]};
+        memcpy(ptr, values, sizeof(values));
+        memcpy(ptr + sizeof(values), &result.score, sizeof(double));
+        memcpy(ptr + sizeof(values) + sizeof(double), &result.prunedTime, sizeof(double));
+        ptr += recordSize;
+    }
+
+    if (SendMessage("results", uint32_t(payload.size()), uint32_t(results.size()), nullptr, payload))
+    {
+        // put them back so they are sent when the connection is restored
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_resultQueue.insert(m_resultQueue.begin(), results.begin(), results.end());
+        return __LINE__;
+    }
+    return 0;
+}
+
+int PipelinedTCPClient::ReceiveMessage()
+{
+    char buffer[MessageHeader::StandardMessageSize];
+    int numBytes = m_TCP.ReceiveData(buffer, MessageHeader::StandardMessageSize, 10, 0);
+    if (numBytes != MessageHeader::StandardMessageSize) return __LINE__;
+    MessageHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    header.text[sizeof(header.text) - 1] = 0;
+
+    const uint32_t maxPayload = 1 << 30;
+    if (header.length > maxPayload) return __LINE__;
+    std::vector<char> payload(header.length);
+    if (header.length)
+    {
+        numBytes = m_TCP.ReceiveData(payload.data(), int(header.length), 10, 0);
+        if (numBytes != int(header.length)) return __LINE__;
+    }
+
+    if (strcmp(header.text, "jobs") == 0) return ReceiveJobs(header, payload);
+    if (strcmp(header.text, "xml") == 0) return ReceiveXML(header, payload);
+    if (strcmp(header.text, "stop") == 0)
+    {
+        m_stopReceived = true;
+        m_requestPending = false;
+        CheckStopped();
+        return 0;
+    }
+#ifdef TCP_DEBUG
+    std::cerr << "PipelinedTCPClient unrecognised message \"" << header.text << "\"\n";
+#endif
+    return __LINE__;
+}
+
+int PipelinedTCPClient::ReceiveJobs(const MessageHeader &header, const std::vector<char> &payload)
+{
+    m_requestPending = false;
+    if (header.runID == 0)
+    {
+        // nothing available so wait a little before asking again
+        m_nextRequestTime = GSUtil::GetTime() + double(m_sleepTime) / 1e6;
+        return 0;
+    }
+
+    const size_t fixedSize = 6 * sizeof(uint32_t) + sizeof(double);
+    std::vector<std::unique_ptr<BatchEvaluator::Job>> readyJobs;
+    size_t offset = 0;
+    for (uint32_t i = 0; i < header.runID; i++)
+    {
+        if (offset + fixedSize > payload.size()) return __LINE__;
+        uint32_t values[6];
+        memcpy(values, payload.data() + offset, sizeof(values));
+        size_t genomeLength = values[1];
+        if (offset + fixedSize + genomeLength * sizeof(double) > payload.size()) return __LINE__;
+        std::unique_ptr<BatchEvaluator::Job> job = std::make_unique<BatchEvaluator::Job>();
+        job->runID = values[0];
+        std::copy(values + 2, values + 6, job->md5);
+        memcpy(&job->scoreToBeat, payload.data() + offset + sizeof(values), sizeof(double));
+        job->genome.resize(genomeLength);
+        if (genomeLength) memcpy(job->genome.data(), payload.data() + offset + fixedSize, genomeLength * sizeof(double));
+        offset += fixedSize + genomeLength * sizeof(double);
+
+        std::vector<uint32_t> key(values + 2, values + 6);
+        std::shared_ptr<const std::string> baseXML = FindBaseXML(key);
+        if (baseXML)
+        {
+            job->baseXML = baseXML;
+            readyJobs.push_back(std::move(job));
+            continue;
+        }
+        m_waitingForXML.push_back(std::move(job));
+        if (m_requestedXML.count(key) == 0)
+        {
+            if (SendMessage("req_xml", 0, 0, key.data(), std::vector<char>())) return __LINE__;
+            m_requestedXML.insert(key);
+        }
+    }
+
+    if (readyJobs.size())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &&job : readyJobs) m_jobQueue.push_back(std::move(job));
+    }
+    if (readyJobs.size()) m_jobAvailable.notify_all();
+    return 0;
+}
+
+int PipelinedTCPClient::ReceiveXML(const MessageHeader &header, const std::vector<char> &payload)
+{
+    std::vector<uint32_t> key(header.md5, header.md5 + 4);
+    m_requestedXML.erase(key);
+    uint32_t *hash = md5(payload.data(), int(payload.size())); // the hash includes the terminating zero
+    if (std::equal(key.begin(), key.end(), hash) == false) return __LINE__;
+
+    std::shared_ptr<const std::string> baseXML = AddBaseXML(key, payload.data(), payload.size());
+
+    // parse it once here so that the workers on this machine can load the pre-parsed version
+    if (m_sharedXMLCache.cacheFolder().size())
+    {
+        XMLConverter xmlConverter;
+        xmlConverter.LoadBaseXMLString(payload.data(), payload.size());
+        m_sharedXMLCache.Store(key.data(), &xmlConverter);
+    }
+
+    std::vector<std::unique_ptr<BatchEvaluator::Job>> readyJobs;
+    for (auto it = m_waitingForXML.begin(); it != m_waitingForXML.end();)
+    {
+        if (std::equal(key.begin(), key.end(), (*it)->md5))
+        {
+            (*it)->baseXML = baseXML;
+            readyJobs.push_back(std::move(*it));
+            it = m_waitingForXML.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+
+    if (readyJobs.size())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &&job : readyJobs) m_jobQueue.push_back(std::move(job));
+    }
+    if (readyJobs.size()) m_jobAvailable.notify_all();
+    CheckStopped();
+    return 0;
+}
+
+// asks for the base XML of any jobs whose request was lost when the connection dropped
+int PipelinedTCPClient::RequestMissingXML()
+{
+    for (auto &&job : m_waitingForXML)
+    {
+        std::vector<uint32_t> key(job->md5, job->md5 + 4);
+        if (m_requestedXML.count(key)) continue;
+        if (SendMessage("req_xml", 0, 0, key.data(), std::vector<char>())) return __LINE__;
+        m_requestedXML.insert(key);
+    }
+    return 0;
+}
+
+// jobs that have not been handed out are returned with the worst possible score
+void PipelinedTCPClient::FailUnfinishedJobs()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::deque<std::unique_ptr<BatchEvaluator::Job>> unfinished;
+    unfinished.swap(m_waitingForXML);
+    for (auto &&job : m_jobQueue) unfinished.push_back(std::move(job));
+    m_jobQueue.clear();
+    for (auto &&job : unfinished)
+    {
+        BatchEvaluator::Result result;
+        result.runID = job->runID;
+        std::copy(std::begin(job->md5), std::end(job->md5), std::begin(result.md5));
+        result.error = true;
+        result.score = -DBL_MAX;
+        m_resultQueue.push_back(result);
+    }
+}
+
+// once the server has asked us to stop we are finished when the last job is ready to run
+void PipelinedTCPClient::CheckStopped()
+{
+    if (m_stopReceived == false || m_waitingForXML.size()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_serverStopped = true;
+    }
+    m_jobAvailable.notify_all();
+}
+
+// looks in the memory cache and then the node local cache
+std::shared_ptr<const std::string> PipelinedTCPClient::FindBaseXML(const std::vector<uint32_t> &key)
+{
+    auto it = m_baseXMLCache.find(key);
+    if (it != m_baseXMLCache.end()) return it->second;
+    if (m_sharedXMLCache.Open(key.data())) return nullptr;
+    std::shared_ptr<const std::string> baseXML = AddBaseXML(key, m_sharedXMLCache.xmlData(), m_sharedXMLCache.xmlLength());
+    m_sharedXMLCache.Close();
+    return baseXML;
+}
+
+std::shared_ptr<const std::string> PipelinedTCPClient::AddBaseXML(const std::vector<uint32_t> &key, const char *xml, size_t length)
+{
+    auto it = m_baseXMLCache.find(key);
+    if (it != m_baseXMLCache.end()) return it->second;
+    std::shared_ptr<const std::string> baseXML = std::make_shared<const std::string>(xml, length);
+    m_baseXMLCache[key] = baseXML;
+    m_baseXMLCacheQueue.push_back(key);
+    while (m_baseXMLCacheQueue.size() > m_baseXMLCacheLimit)
+    {
+        m_baseXMLCache.erase(m_baseXMLCacheQueue.front());
+        m_baseXMLCacheQueue.pop_front();
+    }
+    return baseXML;
+}
@@ -0,0 +1,125 @@
+/*
+ *  PipelinedTCPClient.h
+ *  GaitSym2019
+ *
+ *  Keeps a single connection open to the GA server on its own thread and keeps
+ *  a queue of genomes filled while the simulations run. Results are sent back on
+ *  the same connection and are batched together when several are waiting
+ *  Base XML files are looked for in the node local SharedXMLCache before they are requested
+ *
+ *  All messages start with the standard 64 byte header (text, length, runID, score, md5)
+ *  client to server:
+ *  "req_jobs"  length = number of genomes wanted
+ *  "req_xml"   md5 = hash of the base XML wanted
+ *  "results"   runID = number of results, length = payload bytes
+ *              then for each result: uint32 runID, uint32 pruned, uint32 md5[4], double score, double prunedTime
+ *  server to client:
+ *  "jobs"      runID = number of genomes (zero if none are available), length = payload bytes
+ *              then for each genome: uint32 runID, uint32 number of genes, uint32 md5[4], double scoreToBeat, double genes[]
+ *  "xml"       length = payload bytes, md5 = hash of the payload
+ *              then the base XML (including the terminating zero)
+ *  "stop"      no more genomes will be sent so finish the current ones, send the results and exit
+ *
+ *  Genomes that cannot be simulated (including any still queued when the client stops) are
+ *  returned with a score of -DBL_MAX so that the server is never left waiting for them
+ *
+ *  scripts/mock_ga_server.py implements the server side of this protocol (and the classic one) for testing
+ *
+ */
+
+#ifndef PIPELINEDTCPCLIENT_H
+#define PIPELINEDTCPCLIENT_H
+
+#include "BatchEvaluator.h"
+#include "TCP.h"
+#include "SharedXMLCache.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+class PipelinedTCPClient
+{
+public:
+    PipelinedTCPClient();
+    ~PipelinedTCPClient();
+
+    struct Host
+    {
+        std::string host;
+        int port = 0;
+    };
+
+    void Start(const std::vector<Host> &hosts, size_t pipelineDepth);
+    void Stop();
+
+    bool GetJob(std::unique_ptr<BatchEvaluator::Job> *job, double timeout); // returns true if a genome is available within the timeout (s)
+    void PostResult(const BatchEvaluator::Result &result);
+    bool finished(); // true once the server has sent "stop" and every genome it sent has been handed out
+
+    void setSleepTime(int sleepTime); // microseconds
+    void setSharedXMLCacheFolder(const std::string &sharedXMLCacheFolder); // empty to disable
+
+private:
+    struct MessageHeader
+    {
+        char text[32];
+        uint32_t length;
+        uint32_t runID;
+        double score;
+        uint32_t md5[4];
+
+        enum { StandardMessageSize = 64 };
+    };
+
+    void Run();
+    int Connect();
+    void Disconnect();
+    int SendMessage(const char *text, uint32_t length, uint32_t runID, const uint32_t *md5, const std::vector<char> &payload);
+    int SendResults();
+    int ReceiveMessage();
+    int ReceiveJobs(const MessageHeader &header, const std::vector<char> &payload);
+    int ReceiveXML(const MessageHeader &header, const std::vector<char> &payload);
+    int RequestMissingXML();
+    void FailUnfinishedJobs();
+    void CheckStopped();
+    std::shared_ptr<const std::string> FindBaseXML(const std::vector<uint32_t> &key);
+    std::shared_ptr<const std::string> AddBaseXML(const std::vector<uint32_t> &key, const char *xml, size_t length);
+
+    std::vector<Host> m_hosts;
+    size_t m_currentHost = 0;
+    size_t m_pipelineDepth = 4;
+    int m_sleepTime = 10000;
+    int m_sleepAfterFailMicroseconds = 1000000;
+
+    // only used by the network thread
+    TCP m_TCP;
+    bool m_connected = false;
+    bool m_requestPending = false;
+    double m_nextRequestTime = 0;
+    bool m_stopReceived = false;
+    std::deque<std::unique_ptr<BatchEvaluator::Job>> m_waitingForXML;
+    std::set<std::vector<uint32_t>> m_requestedXML;
+    std::map<std::vector<uint32_t>, std::shared_ptr<const std::string>> m_baseXMLCache;
+    std::deque<std::vector<uint32_t>> m_baseXMLCacheQueue;
+    size_t m_baseXMLCacheLimit = 16;
+    SharedXMLCache m_sharedXMLCache;
+
+    // shared with the caller
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_jobAvailable;
+    std::deque<std::unique_ptr<BatchEvaluator::Job>> m_jobQueue;
+    std::vector<BatchEvaluator::Result> m_resultQueue;
+    bool m_stopFlag = false;
+    bool m_serverStopped = false;
+};
+
+#endif // PIPELINEDTCPCLIENT_H
@@ -0,0 +1,321 @@
+/*
+ *  SharedXMLCache.cpp
+ *  GaitSym2019
+ *
+ *  Node local cache of base XML files shared between all the worker processes on a machine
+ *
+ */
+
+#include "SharedXMLCache.h"
+#include "XMLConverter.h"
+#include "MD5.h"
+
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <climits>
+#include <thread>
+#include <functional>
+#include <algorithm>
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+// the cache uses POSIX shared memory files so it is disabled on Windows
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <time.h>
+#define SHARED_XML_CACHE_ENABLED
+#endif
+
+using namespace std::string_literals;
+
+static const char gSharedXMLCacheMagic[8] = {'G', 'S', 'X', 'M', 'L', 'C', '0', '3'};
+static const size_t gSharedXMLCacheHeaderSize = sizeof(gSharedXMLCacheMagic) + 4 * sizeof(uint32_t) + 3 * sizeof(uint64_t) + 4 * sizeof(uint32_t) + 2 * sizeof(int64_t);
+
+#ifdef SHARED_XML_CACHE_ENABLED
+static struct timespec ModificationTime(const struct stat &fileStat)
+{
+#if defined(__APPLE__)
+    return fileStat.st_mtimespec;
+#else
+    return fileStat.st_mtim;
+#endif
+}
+#endif
+
+SharedXMLCache::SharedXMLCache()
+{
+}
+
+SharedXMLCache::~SharedXMLCache()
+{
+    Close();
+}
+
+std::string SharedXMLCache::Filename(const uint32_t *md5) const
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "gaitsym2019_%08x%08x%08x%08x.xmlcache", md5[0], md5[1], md5[2], md5[3]);
+    return PrivateFolder() + "/"s + buffer;
+}
+
+std::string SharedXMLCache::PrivateFolder() const
+{
+#ifdef SHARED_XML_CACHE_ENABLED
+    return m_cacheFolder + "/gaitsym2019_xmlcache_"s + std::to_string(getuid());
+#else
+    return m_cacheFolder;
+#endif
+}
+
+// the private folder must be a real directory owned by this user that nobody else can get into
+int SharedXMLCache::CheckPrivateFolder(bool create) const
+{
+#ifdef SHARED_XML_CACHE_ENABLED
+    if (m_cacheFolder.size() == 0) return __LINE__;
+    std::string folder = PrivateFolder();
+    if (create && mkdir(folder.c_str(), 0700) && errno != EEXIST) return __LINE__;
+    struct stat folderStat;
+    if (lstat(folder.c_str(), &folderStat)) return __LINE__;
+    if (!S_ISDIR(folderStat.st_mode) || folderStat.st_uid != getuid() || (folderStat.st_mode & 077)) return __LINE__;
+    return 0;
+#else
+    (void)create;
+    return __LINE__;
+#endif
+}
+
+int SharedXMLCache::Open(const uint32_t *md5, bool validate)
+{
+    Close();
+#ifdef SHARED_XML_CACHE_ENABLED
+    if (CheckPrivateFolder(false)) return __LINE__;
+    int fd = open(Filename(md5).c_str(), O_RDONLY | O_NOFOLLOW);
+    if (fd < 0) return __LINE__;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) || !S_ISREG(fileStat.st_mode) || fileStat.st_uid != getuid() || (fileStat.st_mode & 077) ||
+        size_t(fileStat.st_size) < gSharedXMLCacheHeaderSize)
+    {
+        close(fd);
+        return __LINE__;
+    }
+    void *ptr = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping stays valid after the file is closed
+    if (ptr == MAP_FAILED) return __LINE__;
+    m_mapData = static_cast<const char *>(ptr);
+    m_mapLength = size_t(fileStat.st_size);
+
+    size_t offset = 0;
+    uint32_t fileMD5[4], elementMD5[4];
+    uint64_t xmlLength, elementCount, elementLength;
+    int64_t modificationTime[2];
+    if (memcmp(m_mapData, gSharedXMLCacheMagic, sizeof(gSharedXMLCacheMagic))) { Close(); return __LINE__; }
+    offset += sizeof(gSharedXMLCacheMagic);
+    memcpy(fileMD5, m_mapData + offset, sizeof(fileMD5));
+    offset += sizeof(fileMD5);
+    memcpy(&xmlLength, m_mapData + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&elementCount, m_mapData + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(&elementLength, m_mapData + offset, sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    memcpy(elementMD5, m_mapData + offset, sizeof(elementMD5));
+    offset += sizeof(elementMD5);
+    memcpy(modificationTime, m_mapData + offset, sizeof(modificationTime));
+    offset += sizeof(modificationTime);
+    struct timespec fileTime = ModificationTime(fileStat);
+    if (std::equal(fileMD5, fileMD5 + 4, md5) == false || xmlLength == 0 || xmlLength > m_mapLength - offset ||
+        elementLength != m_mapLength - offset - xmlLength || xmlLength > INT_MAX || elementLength > INT_MAX ||
+        m_mapData[offset + xmlLength - 1] != 0) { Close(); return __LINE__; }
+    // Store sets the modification time to the one in the header so a file changed since then is not used
+    if (int64_t(fileTime.tv_sec) != modificationTime[0] || int64_t(fileTime.tv_nsec) != modificationTime[1]) { Close(); return __LINE__; }
+
+    if (validate)
+    {
+        uint32_t *hash = ::md5(m_mapData + offset, int(xmlLength)); // the parameter hides the function
+        if (std::equal(md5, md5 + 4, hash) == false) { Close(); return __LINE__; }
+        hash = ::md5(m_mapData + offset + xmlLength, int(elementLength));
+        if (std::equal(elementMD5, elementMD5 + 4, hash) == false) { Close(); return __LINE__; }
+    }
+    m_xmlData = m_mapData + offset;
+    m_xmlLength = size_t(xmlLength);
+    m_elementCount = size_t(elementCount);
+    m_elementOffset = offset + size_t(xmlLength);
+    return 0;
+#else
+    (void)md5;
+    return __LINE__;
+#endif
+}
+
+void SharedXMLCache::Close()
+{
+#ifdef SHARED_XML_CACHE_ENABLED
+    if (m_mapData) munmap(const_cast<char *>(m_mapData), m_mapLength);
+#endif
+    m_mapData = nullptr;
+    m_mapLength = 0;
+    m_xmlData = nullptr;
+    m_xmlLength = 0;
+    m_elementCount = 0;
+    m_elementOffset = 0;
+}
+
+int SharedXMLCache::ReadElementList(std::vector<std::unique_ptr<ParseXML::XMLElement>> *elementList) const
+{
+    elementList->clear();
+    if (m_mapData == nullptr) return __LINE__;
+    size_t offset = m_elementOffset;
+    auto readInteger = [this, &offset](uint64_t *value) -> bool
+    {
+        if (m_mapLength - offset < sizeof(uint64_t)) return false;
+        memcpy(value, m_mapData + offset, sizeof(uint64_t));
+        offset += sizeof(uint64_t);
+        return true;
+    };
+    auto readString = [this, &offset, &readInteger](std::string *value) -> bool
+    {
+        uint64_t length;
+        if (!readInteger(&length) || length > m_mapLength - offset) return false;
+        value->assign(m_mapData + offset, size_t(length));
+        offset += size_t(length);
+        return true;
+    };
+    elementList->reserve(m_elementCount);
+    for (size_t i = 0; i < m_elementCount; i++)
+    {
+        std::unique_ptr<ParseXML::XMLElement> element = std::make_unique<ParseXML::XMLElement>();
+        uint64_t attributeCount;
+        if (!readString(&element->tag) || !readInteger(&attributeCount)) { elementList->clear(); return __LINE__; }
+        for (uint64_t j = 0; j < attributeCount; j++)
+        {
+            std::string name, value;
+            if (!readString(&name) || !readString(&value)) { elementList->clear(); return __LINE__; }
+            element->attributes[name] = std::move(value);
+        }
+        elementList->push_back(std::move(element));
+    }
+    return 0;
+}
+
+int SharedXMLCache::Store(const uint32_t *md5, const char *xml, size_t xmlLength, const std::vector<std::unique_ptr<ParseXML::XMLElement>> &elementList)
+{
+#ifdef SHARED_XML_CACHE_ENABLED
+    if (CheckPrivateFolder(true)) return __LINE__;
+    std::string elements;
+    auto appendInteger = [](std::string *data, uint64_t value) { data->append(reinterpret_cast<const char *>(&value), sizeof(value)); };
+    auto appendString = [&elements, &appendInteger](const std::string &value) { appendInteger(&elements, value.size()); elements.append(value); };
+    for (auto &&element : elementList)
+    {
+        appendString(element->tag);
+        appendInteger(&elements, element->attributes.size());
+        for (auto &&attribute : element->attributes)
+        {
+            appendString(attribute.first);
+            appendString(attribute.second);
+        }
+    }
+    if (xmlLength > INT_MAX || elements.size() > INT_MAX) return __LINE__;
+
+    std::string data(gSharedXMLCacheMagic, sizeof(gSharedXMLCacheMagic));
+    data.append(reinterpret_cast<const char *>(md5), 4 * sizeof(uint32_t));
+    appendInteger(&data, xmlLength);
+    appendInteger(&data, elementList.size());
+    appendInteger(&data, elements.size());
+    data.append(reinterpret_cast<const char *>(::md5(elements.data(), int(elements.size()))), 4 * sizeof(uint32_t)); // the parameter hides the function
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t modificationTime[2] = {int64_t(now.tv_sec), int64_t(now.tv_nsec)};
+    data.append(reinterpret_cast<const char *>(modificationTime), sizeof(modificationTime));
+    data.append(xml, xmlLength);
+    data.append(elements);
+
+    // write to a unique temporary name and rename so that other processes only ever see a complete file
+    std::string filename = Filename(md5);
+    std::string temporaryFilename = filename + "."s + std::to_string(getpid()) + "."s + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    int fd = open(temporaryFilename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0600);
+    if (fd < 0) return __LINE__;
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) break;
+        written += size_t(n);
+    }
+    struct timespec times[2] = {now, now};
+    int timeError = futimens(fd, times);
+    close(fd);
+    if (written != data.size() || timeError || rename(temporaryFilename.c_str(), filename.c_str()))
+    {
+        unlink(temporaryFilename.c_str());
+        return __LINE__;
+    }
+    return 0;
+#else
+    (void)md5; (void)xml; (void)xmlLength; (void)elementList;
+    return __LINE__;
+#endif
+}
+
+int SharedXMLCache::Clear()
+{
+    Close();
+#ifdef SHARED_XML_CACHE_ENABLED
+    if (CheckPrivateFolder(false)) return __LINE__;
+    std::string folder = PrivateFolder();
+    DIR *dir = opendir(folder.c_str());
+    if (dir == nullptr) return __LINE__;
+    std::vector<std::string> filenames;
+    while (struct dirent *entry = readdir(dir))
+    {
+        if (strncmp(entry->d_name, "gaitsym2019_", strlen("gaitsym2019_")) == 0) filenames.push_back(folder + "/"s + entry->d_name);
+    }
+    closedir(dir);
+    int status = 0;
+    for (auto &&it : filenames) if (unlink(it.c_str())) status = __LINE__;
+    if (rmdir(folder.c_str())) status = __LINE__;
+    return status;
+#else
+    return __LINE__;
+#endif
+}
+
+int SharedXMLCache::Load(const uint32_t *md5, XMLConverter *xmlConverter)
+{
+    if (Open(md5)) return __LINE__;
+    std::vector<std::unique_ptr<ParseXML::XMLElement>> elementList;
+    if (ReadElementList(&elementList)) elementList.clear(); // the XML is still good so it just gets parsed again
+    xmlConverter->LoadBaseXMLString(m_xmlData, m_xmlLength, &elementList);
+    return 0;
+}
+
+int SharedXMLCache::Store(const uint32_t *md5, XMLConverter *xmlConverter)
+{
+    std::vector<std::unique_ptr<ParseXML::XMLElement>> elementList;
+    xmlConverter->CopyMarkedElementList(&elementList);
+    const std::string &xml = xmlConverter->BaseXMLString();
+    return Store(md5, xml.data(), xml.size(), elementList);
+}
+
+const char *SharedXMLCache::xmlData() const
+{
+    return m_xmlData;
+}
+
+size_t SharedXMLCache::xmlLength() const
+{
+    return m_xmlLength;
+}
+
+std::string SharedXMLCache::cacheFolder() const
+{
+    return m_cacheFolder;
+}
+
+void SharedXMLCache::setCacheFolder(const std::string &cacheFolder)
+{
+    m_cacheFolder = cacheFolder;
+}
@@ -0,0 +1,84 @@
+/*
+ *  SharedXMLCache.h
+ *  GaitSym2019
+ *
+ *  Node local cache of base XML files shared between all the worker processes on a machine
+ *  Each entry is a file named from the MD5 that the server sends with the genome containing
+ *  the XML text and the element list that XMLConverter would otherwise have to parse.
+ *  A worker that restarts or joins part way through a run maps the file instead of fetching
+ *  and parsing the XML. The cache is off unless a folder is set (/dev/shm is memory backed)
+ *
+ *  The entries go in a per user subfolder "gaitsym2019_xmlcache_<uid>" created with mode 0700
+ *  and the files are created with mode 0600. The subfolder and each file must be owned by the
+ *  user and not be accessible to anyone else or they are ignored.
+ *
+ *  The MD5s of the XML text and the element list are stored when the entry is written but
+ *  Open only checks the magic, the size and the modification time (which Store sets to the
+ *  value in the header) unless asked to validate, because hashing on every load would cost
+ *  more than the parse it replaces. The element list is still copied into each worker's own
+ *  XMLElement list so what is saved is the XML parse, not the memory
+ *
+ *  File layout (native byte order):
+ *  char magic[8] "GSXMLC03", uint32 md5[4], uint64 XML length, uint64 number of elements,
+ *  uint64 element list length, uint32 element list md5[4], int64 mtime seconds, int64 mtime nanoseconds
+ *  XML text (including the terminating zero that is part of the MD5)
+ *  for each element: string tag, uint64 number of attributes, then string name, string value for each attribute
+ *  where a string is a uint64 length followed by the characters
+ *
+ *  Entries are written to a temporary file and renamed so readers never see a partial file
+ *  Clear removes the subfolder and everything in it
+ *
+ */
+
+#ifndef SHAREDXMLCACHE_H
+#define SHAREDXMLCACHE_H
+
+#include "ParseXML.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class XMLConverter;
+
+class SharedXMLCache
+{
+public:
+    SharedXMLCache();
+    ~SharedXMLCache();
+
+    // all these return 0 on success
+    int Open(const uint32_t *md5, bool validate = false); // validate also checks both MD5s
+    int ReadElementList(std::vector<std::unique_ptr<ParseXML::XMLElement>> *elementList) const;
+    int Store(const uint32_t *md5, const char *xml, size_t xmlLength, const std::vector<std::unique_ptr<ParseXML::XMLElement>> &elementList);
+    void Close();
+    int Clear(); // deletes all this user's entries
+
+    // convenience functions that move the base XML between the cache and an XMLConverter
+    int Load(const uint32_t *md5, XMLConverter *xmlConverter);
+    int Store(const uint32_t *md5, XMLConverter *xmlConverter);
+
+    const char *xmlData() const;
+    size_t xmlLength() const;
+
+    std::string cacheFolder() const;
+    void setCacheFolder(const std::string &cacheFolder); // an empty folder disables the cache
+
+    std::string Filename(const uint32_t *md5) const;
+    std::string PrivateFolder() const;
+
+private:
+    int CheckPrivateFolder(bool create) const;
+
+    std::string m_cacheFolder;
+
+    const char *m_mapData = nullptr;
+    size_t m_mapLength = 0;
+    const char *m_xmlData = nullptr;
+    size_t m_xmlLength = 0;
+    size_t m_elementCount = 0;
+    size_t m_elementOffset = 0;
+};
+
+#endif // SHAREDXMLCACHE_H
@@ -61,6 +61,12 @@
 #include "TegotaeDriver.h"
 #include "ThreeHingeJointDriver.h"
 #include "Filter.h"
+#include "ThreadPool.h"
+#include "BinaryDump.h"
+#include "StepProfiler.h"
+#include "StateBuffer.h"
+#include "BinaryModel.h"
+#include "MD5.h"
 
 #ifdef USE_QT
 #include "FacetedObject.h"
@@ -106,6 +112,7 @@ Simulation::~Simulation()
 {
     // these need to be cleared before we destroy the ODE world
     m_ContactList.clear();
+    m_ContactPool.clear();
     m_BodyList.clear();
     m_JointList.clear();
     m_GeomList.clear();
@@ -120,9 +127,7 @@ Simulation::~Simulation()
     m_WarehouseList.clear();
 
     // destroy the ODE world
-    dSetMessageHandler(nullptr);
-    dSetErrorHandler(nullptr);
-    dSetDebugHandler(nullptr);
+    // the ODE message handlers are left in place because they are process wide and other simulations may still be running
     dJointGroupDestroy(m_ContactGroup);
     dSpaceDestroy(m_SpaceID);
     dWorldDestroy(m_WorldID);
@@ -133,12 +138,28 @@ Simulation::~Simulation()
 //----------------------------------------------------------------------------
 std::string *Simulation::LoadModel(const char *buffer, size_t length)
 {
+    if (BinaryModel::IsBinaryModel(buffer, length))
+    {
+        BinaryModel binaryModel;
+        std::string *ptr = binaryModel.Read(buffer, length, m_parseXML.elementList());
+        if (ptr)
+        {
+            setLastError(*ptr);
+            return lastErrorPtr();
+        }
+        return LoadModel(*m_parseXML.elementList());
+    }
     std::string *ptr = m_parseXML.LoadModel(buffer, length, "GAITSYM2019"s);
     if (ptr) return ptr;
+    return LoadModel(*m_parseXML.elementList());
+}
 
+//----------------------------------------------------------------------------
+std::string *Simulation::LoadModel(const std::vector<std::unique_ptr<ParseXML::XMLElement>> &elementList)
+{
     // this logic allows forward references at the expense of slightly less obvious error messages
     std::list<ParseXML::XMLElement *> unprocessedList;
-    for (auto &&it : *m_parseXML.elementList()) unprocessedList.push_back(it.get());
+    for (auto &&it : elementList) unprocessedList.push_back(it.get());
     size_t lastSize = 0;
     size_t cycles = 0;
     while (unprocessedList.size() > 0 && unprocessedList.size() != lastSize)
@@ -163,6 +184,7 @@ std::string *Simulation::LoadModel(const char *buffer, size_t length)
             else if ((*it)->tag == "FLUIDSAC"s) ParseFluidSac(*it);
             if (lastErrorPtr()->size())
             {
+                if ((*it)->tag == "GLOBAL"s) return lastErrorPtr(); // everything else depends on GLOBAL so there is no point continuing
                 it++;
             }
             else
@@ -171,6 +193,7 @@ std::string *Simulation::LoadModel(const char *buffer, size_t length)
             }
         }
     }
+    m_UpdateListsDirty = true;
     if (lastErrorPtr()->size()) return lastErrorPtr();
     if (cycles > 1)
         std::cerr << "Warning: file took " << cycles << " cycles to parse. Consider reordering for speed.\n";
@@ -200,18 +223,190 @@ std::string *Simulation::LoadModel(const char *buffer, size_t length)
 }
 
 
+//----------------------------------------------------------------------------
+// this stores everything that changes as the simulation runs so that RestoreSnapshot can put
+// the simulation back into exactly this state (e.g. to reset to time zero for a new genome)
+// contacts are not stored because they are regenerated at the start of each step
+// the header holds a magic number, the format version, the total size and the MD5 of everything after the header
+// so that RestoreSnapshot can reject a damaged snapshot before it changes anything
+// the MD5 is only checked on request because hashing the whole snapshot would dominate the restore time
+static const uint32_t kSnapshotMagic = 0x50534753; // "SGSP" little endian
+static const uint32_t kSnapshotVersion = 1;
+static const size_t kSnapshotHeaderSize = 2 * sizeof(uint32_t) + sizeof(uint64_t) + 4 * sizeof(uint32_t);
+
+void Simulation::SaveSnapshot(StateBuffer *snapshot)
+{
+    snapshot->Clear();
+    uint32_t digest[4] = {0, 0, 0, 0};
+    snapshot->Write(kSnapshotMagic);
+    snapshot->Write(kSnapshotVersion);
+    snapshot->Write(uint64_t(0)); // filled in at the end
+    for (size_t i = 0; i < 4; i++) snapshot->Write(digest[i]);
+    std::vector<size_t> listSizes = {m_BodyList.size(), m_JointList.size(), m_GeomList.size(), m_MuscleList.size(), m_StrapList.size(),
+                                     m_FluidSacList.size(), m_DriverList.size(), m_DataTargetList.size(), m_MarkerList.size(),
+                                     m_ReporterList.size(), m_ControllerList.size(), m_WarehouseList.size()};
+    snapshot->Write(listSizes);
+    snapshot->Write(m_AdhesionJointList.size());
+
+    snapshot->Write(m_SimulationTime);
+    snapshot->Write(m_StepCount);
+    snapshot->Write(m_CycleTime);
+    snapshot->Write(m_MechanicalEnergy);
+    snapshot->Write(m_MetabolicEnergy);
+    snapshot->Write(m_KinematicMatchMiniMaxFitness);
+    snapshot->Write(m_ClosestWarehouseFitness);
+    snapshot->Write(m_KinematicMatchFitness);
+    snapshot->Write(m_OutputModelStateOccured);
+    snapshot->Write(m_OutputModelStateAtTime);
+    snapshot->Write(m_OutputModelStateAtCycle);
+    snapshot->Write(m_SimulationError);
+    snapshot->Write(m_WarehouseDistance);
+    snapshot->Write(m_OutputKinematicsFirstTimeFlag);
+    snapshot->Write(m_OutputWarehouseLastTime);
+    snapshot->Write(m_DataTargetAbort);
+    snapshot->Write(m_Pruned);
+    snapshot->Write(m_PrunedTime);
+    snapshot->Write(m_ContactAbort);
+    snapshot->Write(m_PositiveMechanicalWork);
+    snapshot->Write(m_NegativeMechanicalWork);
+    snapshot->Write(m_PositiveContractileWork);
+    snapshot->Write(m_NegativeContractileWork);
+    snapshot->Write(m_PositiveSerialElasticWork);
+    snapshot->Write(m_NegativeSerialElasticWork);
+    snapshot->Write(m_PositiveParallelElasticWork);
+    snapshot->Write(m_NegativeParallelElasticWork);
+    snapshot->Write(dRandGetSeed()); // QuickStep uses the ODE random number generator to reorder constraints
+
+    for (auto &&it : m_BodyList) it.second->saveState(snapshot);
+    for (auto &&it : m_JointList) it.second->saveState(snapshot);
+    for (auto &&it : m_GeomList) it.second->saveState(snapshot);
+    for (auto &&it : m_MuscleList) it.second->saveState(snapshot);
+    for (auto &&it : m_StrapList) it.second->saveState(snapshot);
+    for (auto &&it : m_FluidSacList) it.second->saveState(snapshot);
+    for (auto &&it : m_DriverList) it.second->saveState(snapshot);
+    for (auto &&it : m_DataTargetList) it.second->saveState(snapshot);
+    for (auto &&it : m_MarkerList) it.second->saveState(snapshot);
+    for (auto &&it : m_ReporterList) it.second->saveState(snapshot);
+    for (auto &&it : m_ControllerList) it.second->saveState(snapshot);
+    for (auto &&it : m_WarehouseList) it.second->saveState(snapshot);
+
+    uint32_t *hash = md5(snapshot->data() + kSnapshotHeaderSize, int(snapshot->size() - kSnapshotHeaderSize));
+    snapshot->Overwrite(2 * sizeof(uint32_t), uint64_t(snapshot->size()));
+    for (size_t i = 0; i < 4; i++) snapshot->Overwrite(2 * sizeof(uint32_t) + sizeof(uint64_t) + i * sizeof(uint32_t), hash[i]);
+}
+
+//----------------------------------------------------------------------------
+// the snapshot must come from this simulation (or an identical one loaded from the same file)
+// and it will fail if objects have been removed since the snapshot was taken (e.g. broken muscles)
+std::string *Simulation::RestoreSnapshot(StateBuffer *snapshot, bool validate)
+{
+    // check the snapshot before touching any state so a bad snapshot leaves the simulation unchanged
+    snapshot->Rewind();
+    uint32_t magic = 0, version = 0;
+    uint64_t size = 0;
+    uint32_t digest[4] = {0, 0, 0, 0};
+    snapshot->Read(&magic);
+    snapshot->Read(&version);
+    snapshot->Read(&size);
+    for (size_t i = 0; i < 4; i++) snapshot->Read(&digest[i]);
+    if (snapshot->readError() || magic != kSnapshotMagic || version != kSnapshotVersion || size != snapshot->size())
+    {
+        setLastError("Simulation::RestoreSnapshot snapshot is corrupt"s);
+        return lastErrorPtr();
+    }
+    if (validate && std::equal(digest, digest + 4, md5(snapshot->data() + kSnapshotHeaderSize, int(snapshot->size() - kSnapshotHeaderSize))) == false)
+    {
+        setLastError("Simulation::RestoreSnapshot snapshot is corrupt"s);
+        return lastErrorPtr();
+    }
+
+    std::vector<size_t> listSizes = {m_BodyList.size(), m_JointList.size(), m_GeomList.size(), m_MuscleList.size(), m_StrapList.size(),
+                                     m_FluidSacList.size(), m_DriverList.size(), m_DataTargetList.size(), m_MarkerList.size(),
+                                     m_ReporterList.size(), m_ControllerList.size(), m_WarehouseList.size()};
+    std::vector<size_t> snapshotListSizes;
+    size_t adhesionJointCount = 0;
+    snapshot->Read(&snapshotListSizes);
+    snapshot->Read(&adhesionJointCount);
+    if (snapshotListSizes != listSizes || adhesionJointCount > m_AdhesionJointList.size())
+    {
+        setLastError("Simulation::RestoreSnapshot snapshot does not match the current simulation"s);
+        return lastErrorPtr();
+    }
+
+    // remove anything that has been created since the snapshot
+    dJointGroupEmpty(m_ContactGroup);
+    m_ContactList.clear();
+    for (auto &&geomIter : m_GeomList) geomIter.second->ClearContacts();
+    for (size_t i = adhesionJointCount; i < m_AdhesionJointList.size(); i++) dJointDestroy(m_AdhesionJointList[i]);
+    m_AdhesionJointList.resize(adhesionJointCount);
+
+    unsigned long seed = 0;
+    snapshot->Read(&m_SimulationTime);
+    snapshot->Read(&m_StepCount);
+    snapshot->Read(&m_CycleTime);
+    snapshot->Read(&m_MechanicalEnergy);
+    snapshot->Read(&m_MetabolicEnergy);
+    snapshot->Read(&m_KinematicMatchMiniMaxFitness);
+    snapshot->Read(&m_ClosestWarehouseFitness);
+    snapshot->Read(&m_KinematicMatchFitness);
+    snapshot->Read(&m_OutputModelStateOccured);
+    snapshot->Read(&m_OutputModelStateAtTime);
+    snapshot->Read(&m_OutputModelStateAtCycle);
+    snapshot->Read(&m_SimulationError);
+    snapshot->Read(&m_WarehouseDistance);
+    snapshot->Read(&m_OutputKinematicsFirstTimeFlag);
+    snapshot->Read(&m_OutputWarehouseLastTime);
+    snapshot->Read(&m_DataTargetAbort);
+    snapshot->Read(&m_Pruned);
+    snapshot->Read(&m_PrunedTime);
+    snapshot->Read(&m_ContactAbort);
+    snapshot->Read(&m_PositiveMechanicalWork);
+    snapshot->Read(&m_NegativeMechanicalWork);
+    snapshot->Read(&m_PositiveContractileWork);
+    snapshot->Read(&m_NegativeContractileWork);
+    snapshot->Read(&m_PositiveSerialElasticWork);
+    snapshot->Read(&m_NegativeSerialElasticWork);
+    snapshot->Read(&m_PositiveParallelElasticWork);
+    snapshot->Read(&m_NegativeParallelElasticWork);
+    snapshot->Read(&seed);
+    dRandSetSeed(seed);
+
+    for (auto &&it : m_BodyList) it.second->restoreState(snapshot);
+    for (auto &&it : m_JointList) it.second->restoreState(snapshot);
+    for (auto &&it : m_GeomList) it.second->restoreState(snapshot);
+    for (auto &&it : m_MuscleList) it.second->restoreState(snapshot);
+    for (auto &&it : m_StrapList) it.second->restoreState(snapshot);
+    for (auto &&it : m_FluidSacList) it.second->restoreState(snapshot);
+    for (auto &&it : m_DriverList) it.second->restoreState(snapshot);
+    for (auto &&it : m_DataTargetList) it.second->restoreState(snapshot);
+    for (auto &&it : m_MarkerList) it.second->restoreState(snapshot);
+    for (auto &&it : m_ReporterList) it.second->restoreState(snapshot);
+    for (auto &&it : m_ControllerList) it.second->restoreState(snapshot);
+    for (auto &&it : m_WarehouseList) it.second->restoreState(snapshot);
+
+    if (snapshot->readError() || !snapshot->atEnd())
+    {
+        setLastError("Simulation::RestoreSnapshot snapshot is corrupt"s);
+        return lastErrorPtr();
+    }
+    return nullptr;
+}
+
 //----------------------------------------------------------------------------
 void Simulation::UpdateSimulation()
 {
+    if (m_UpdateListsDirty) BuildUpdateLists();
+    if (m_stepProfiler) m_stepProfiler->StartStep();
+
     // calculate the warehouse and position matching fitnesses before we move to a new location
-    else if (m_global->fitnessType() == Global::KinematicMatch || m_global->fitnessType() == Global::KinematicMatchMiniMax)
+    if (m_global->fitnessType() == Global::KinematicMatch || m_global->fitnessType() == Global::KinematicMatchMiniMax)
     {
         double minScore = DBL_MAX;
-        for (auto &&it : m_DataTargetList)
+        for (auto &&dataTarget : m_DataTargetUpdateList)
         {
             double matchScore;
             bool matchScoreValid;
-            std::tie(matchScore, matchScoreValid) = it.second->calculateMatchValue(m_SimulationTime);
+            std::tie(matchScore, matchScoreValid) = dataTarget->calculateMatchValue(m_SimulationTime);
             if (matchScoreValid)
             {
                 m_KinematicMatchFitness += matchScore;
@@ -221,55 +416,80 @@ void Simulation::UpdateSimulation()
         }
         if (minScore < DBL_MAX)
             m_KinematicMatchMiniMaxFitness += minScore;
+
+        // stop as soon as the best possible final score cannot beat the threshold
+        if (m_global->fitnessType() == Global::KinematicMatch && m_ScoreToBeat > -DBL_MAX && m_Pruned == false)
+        {
+            if (m_KinematicMatchFitness + KinematicMatchRemainingBound() < m_ScoreToBeat)
+            {
+                m_Pruned = true;
+                m_PrunedTime = m_SimulationTime;
+            }
+        }
     }
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::DataTargets);
 
     // now start the actual simulation
 
     // check collisions first
-    dJointGroupEmpty(m_ContactGroup);
-    m_ContactList.clear();
-    for (auto &&geomIter : m_GeomList) geomIter.second->ClearContacts();
-    dSpaceCollide(m_SpaceID, this, &NearCallback);
+    UpdateContacts();
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Collisions);
 
 
     // update the drivers
-    for (auto &&it : m_DriverList)
+    for (auto &&driver : m_DriverUpdateList)
     {
-        it.second->Update();
-        it.second->SendData();
+        driver->Update();
+        driver->SendData();
+        if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Drivers, driver);
     }
     // and the controllers (which are drivers too probably)
-    for (auto &&it : m_ControllerList)
+    for (auto &&it : m_ControllerUpdateList)
     {
-        auto driver = dynamic_cast<Driver *>(it.second.get());
-        if (driver)
+        if (it.driver)
         {
-            driver->Update();
-            driver->SendData();
+            it.driver->Update();
+            it.driver->SendData();
         }
-        if (it.second->lastStepCount() != m_StepCount)
-            std::cerr << "Warning: " << it.first << " controller not updated\n"; // currently cannot stack controllers although this is fixable
+        if (it.controller->lastStepCount() != m_StepCount)
+            std::cerr << "Warning: " << it.controller->name() << " controller not updated\n"; // currently cannot stack controllers although this is fixable
+        if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Controllers, it.controller);
     }
 
-    // update the muscles
-    for (auto iter1 = m_MuscleList.begin(); iter1 != m_MuscleList.end(); /* no increment */)
+    // update the muscles (the forces are accumulated in the bodies and applied after the fluid sacs)
+    // CalculateStrap and SetActivation only depend on the state at the start of the step and on the muscle itself
+    // so they can be run in parallel and the results reduced onto the bodies in the usual order afterwards
+    if (m_threadPool)
+    {
+        m_threadPool->ParallelFor(m_MuscleUpdateList.size(), [this](size_t i)
+        {
+            m_MuscleUpdateList[i].muscle->CalculateStrap();
+            m_MuscleUpdateList[i].muscle->SetActivation();
+        });
+    }
+    for (size_t muscleIndex = 0; muscleIndex < m_MuscleUpdateList.size(); /* no increment */)
     {
-        iter1->second->CalculateStrap();
-        iter1->second->SetActivation();
+        Muscle *muscle = m_MuscleUpdateList[muscleIndex].muscle;
+        if (!m_threadPool)
+        {
+            muscle->CalculateStrap();
+            muscle->SetActivation();
+        }
 
         // check for breaking strain
-        DampedSpringMuscle *dampedSpringMuscle = dynamic_cast<DampedSpringMuscle *>(iter1->second.get());
+        DampedSpringMuscle *dampedSpringMuscle = m_MuscleUpdateList[muscleIndex].dampedSpringMuscle;
         if (dampedSpringMuscle)
         {
             if (dampedSpringMuscle->ShouldBreak())
             {
-                iter1 = m_MuscleList.erase(iter1); // erase returns the next iterator [but m_MuscleList.erase(iter1++) would also work and is compatible with older C++ compilers]
+                m_MuscleUpdateList.erase(m_MuscleUpdateList.begin() + std::ptrdiff_t(muscleIndex)); // the next muscle is now at muscleIndex
+                m_MuscleList.erase(m_MuscleList.find(muscle->name()));
                 continue;
             }
         }
 
-        std::vector<std::unique_ptr<PointForce>> *pointForceList = iter1->second->GetPointForceList();
-        double tension = iter1->second->GetTension();
+        std::vector<std::unique_ptr<PointForce>> *pointForceList = muscle->GetPointForceList();
+        double tension = muscle->GetTension();
 #ifdef DEBUG_CHECK_FORCES
         pgd::Vector3 force(0, 0, 0);
 #endif
@@ -277,37 +497,58 @@ void Simulation::UpdateSimulation()
         {
             PointForce *pointForce = (*pointForceList)[i].get();
             if (pointForce->body)
-                dBodyAddForceAtPos(pointForce->body->GetBodyID(),
-                                   pointForce->vector[0] * tension, pointForce->vector[1] * tension, pointForce->vector[2] * tension,
-                                   pointForce->point[0], pointForce->point[1], pointForce->point[2]);
+                pointForce->body->AccumulateForceAtPos(pointForce->vector[0] * tension, pointForce->vector[1] * tension, pointForce->vector[2] * tension,
+                                                       pointForce->point);
 #ifdef DEBUG_CHECK_FORCES
             force += pgd::Vector3(pointForce->vector[0] * tension, pointForce->vector[1] * tension, pointForce->vector[2] * tension);
 #endif
         }
 #ifdef DEBUG_CHECK_FORCES
         std::cerr.setf(std::ios::floatfield, std::ios::fixed);
-        std::cerr << iter1->first << " " << force.x << " " << force.y << " " << force.z << "\n";
+        std::cerr << muscle->name() << " " << force.x << " " << force.y << " " << force.z << "\n";
         std::cerr.unsetf(std::ios::floatfield);
 #endif
-        iter1++; // this has to be done outside the for definition because erase returns the next iterator
+        if (m_stepProfiler && !m_threadPool) m_stepProfiler->Lap(StepProfiler::Muscles, muscle);
+        muscleIndex++; // this has to be done outside the for definition because erase moves the next muscle to the current index
     }
+    if (m_stepProfiler && m_threadPool) m_stepProfiler->Lap(StepProfiler::Muscles); // per type timing is not meaningful when the muscles run in parallel
 
     // update the joints (needed for motors, end stops and stress calculations)
-    for (auto &&jointIter : m_JointList) jointIter.second->Update();
+    // the stress maps only depend on the joint feedback from the last step so they can be run in parallel
+    bool parallelStress = m_threadPool && m_StressJointUpdateList.size() > 1;
+    if (parallelStress)
+    {
+        m_threadPool->ParallelFor(m_StressJointUpdateList.size(), [this](size_t i)
+        {
+            m_StressJointUpdateList[i]->Update();
+        });
+        if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Joints);
+    }
+    for (auto &&it : m_JointUpdateList)
+    {
+        if (parallelStress && it.fixedJoint && it.fixedJoint->GetStressCalculationType() != FixedJoint::none) continue;
+        it.joint->Update();
+        if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Joints, it.joint);
+    }
 
     // update the fluid sacs
-    for (auto fsIter = m_FluidSacList.begin(); fsIter != m_FluidSacList.end(); fsIter++)
+    for (auto &&fluidSac : m_FluidSacUpdateList)
     {
-        fsIter->second->calculateVolume();
-        fsIter->second->calculatePressure();
-        fsIter->second->calculateLoadsOnMarkers();
-        for (size_t i = 0; i < fsIter->second->pointForceList().size(); i++)
+        fluidSac->calculateVolume();
+        fluidSac->calculatePressure();
+        fluidSac->calculateLoadsOnMarkers();
+        for (size_t i = 0; i < fluidSac->pointForceList().size(); i++)
         {
-            const PointForce *pf = &fsIter->second->pointForceList().at(i);
-            dBodyAddForceAtPos(pf->body->GetBodyID(), pf->vector[0], pf->vector[1], pf->vector[2], pf->point[0], pf->point[1], pf->point[2]);
+            const PointForce *pf = &fluidSac->pointForceList().at(i);
+            pf->body->AccumulateForceAtPos(pf->vector[0], pf->vector[1], pf->vector[2], pf->point);
         }
+        if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::FluidSacs, fluidSac);
     }
 
+    // the muscle and fluid sac forces have been summed per body so they can now be passed to ODE
+    for (auto &&body : m_BodyUpdateList) body->ApplyAccumulatedForce();
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::BodyForces);
+
 
 #ifndef OUTPUTS_AFTER_SIMULATION_STEP
     if (m_OutputWarehouseFlag) OutputWarehouse();
@@ -330,6 +571,7 @@ void Simulation::UpdateSimulation()
         m_OutputModelStateAtWarehouseDistance = 0;
     }
 #endif
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Outputs);
 
     // run the simulation
     switch (m_global->stepType())
@@ -342,25 +584,24 @@ void Simulation::UpdateSimulation()
         dWorldQuickStep(m_WorldID, m_global->StepSize());
         break;
     }
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::WorldStep);
 
     // calculate the energies
-    for (auto &&iter1 : m_MuscleList)
+    for (auto &&it : m_MuscleUpdateList)
     {
-        m_MechanicalEnergy += iter1.second->GetPower() * m_global->StepSize();
-        m_MetabolicEnergy += iter1.second->GetMetabolicPower() * m_global->StepSize();
+        m_MechanicalEnergy += it.muscle->GetPower() * m_global->StepSize();
+        m_MetabolicEnergy += it.muscle->GetMetabolicPower() * m_global->StepSize();
     }
     m_MetabolicEnergy += m_global->BMR() * m_global->StepSize();
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Energy);
 
     // update any contact force dependent drivers (because only after the simulation is the force valid
     // update the footprint indicator
     if (m_ContactList.size() > 0)
     {
-        for (auto &&it : m_DriverList)
-        {
-            TegotaeDriver *tegotaeDriver = dynamic_cast<TegotaeDriver *>(it.second.get());
-            if (tegotaeDriver) tegotaeDriver->UpdateReactionForce();
-        }
+        for (auto &&tegotaeDriver : m_TegotaeDriverUpdateList) tegotaeDriver->UpdateReactionForce();
     }
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Drivers);
 
     // all reporting is done after a simulation step
 
@@ -395,11 +636,16 @@ void Simulation::UpdateSimulation()
         m_OutputModelStateAtWarehouseDistance = 0;
     }
 #endif
+    if (m_stepProfiler) m_stepProfiler->Lap(StepProfiler::Outputs);
 }
 
 //----------------------------------------------------------------------------
 bool Simulation::TestForCatastrophy()
 {
+    // there are several exit points so the lap is recorded when the guard goes out of scope
+    struct ProfilerGuard { StepProfiler *profiler; ~ProfilerGuard() { if (profiler) profiler->Lap(StepProfiler::Catastrophy); } };
+    if (m_stepProfiler) m_stepProfiler->Restart();
+    ProfilerGuard profilerGuard = {m_stepProfiler};
 #if defined(USE_QT)
     std::stringstream ss;
 #endif
@@ -450,6 +696,17 @@ bool Simulation::TestForCatastrophy()
         return true;
     }
 
+    // check for pruning against the score to beat
+    if (m_Pruned)
+    {
+#if defined(USE_QT)
+        ss << "Pruned at " << m_PrunedTime << " because the score to beat cannot be reached";
+        if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
+#endif
+        std::cerr << "Pruned at " << m_PrunedTime << " because the score to beat cannot be reached\n";
+        return true;
+    }
+
     // check for data target abort
     if (m_DataTargetAbort)
     {
@@ -463,10 +720,11 @@ bool Simulation::TestForCatastrophy()
 
     // check that all bodies meet velocity and stop conditions
 
+    if (m_UpdateListsDirty) BuildUpdateLists();
     Body::LimitTestResult p;
-    for (auto &&iter1 : m_BodyList)
+    for (auto &&body : m_BodyUpdateList)
     {
-        p = iter1.second->TestLimits();
+        p = body->TestLimits();
         switch (p)
         {
         case Body::WithinLimits:
@@ -476,28 +734,28 @@ bool Simulation::TestForCatastrophy()
         case Body::YPosError:
         case Body::ZPosError:
 #if defined(USE_QT)
-            ss << "Failed due to position error " << p << " in: " << iter1.second->name();
+            ss << "Failed due to position error " << p << " in: " << body->name();
             if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to position error " << p << " in: " << iter1.second->name() << "\n";
+            std::cerr << "Failed due to position error " << p << " in: " << body->name() << "\n";
             return true;
 
         case Body::XVelError:
         case Body::YVelError:
         case Body::ZVelError:
 #if defined(USE_QT)
-            ss << "Failed due to velocity error " << p << " in: " << iter1.second->name();
+            ss << "Failed due to velocity error " << p << " in: " << body->name();
             if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to velocity error " << p << " in: " << iter1.second->name() << "\n";
+            std::cerr << "Failed due to velocity error " << p << " in: " << body->name() << "\n";
             return true;
 
         case Body::NumericalError:
 #if defined(USE_QT)
-            ss << "Failed due to numerical error " << p << " in: " << iter1.second->name();
+            ss << "Failed due to numerical error " << p << " in: " << body->name();
             if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to numerical error " << p << " in: " << iter1.second->name() << "\n";
+            std::cerr << "Failed due to numerical error " << p << " in: " << body->name() << "\n";
             return true;
         }
     }
@@ -505,57 +763,57 @@ bool Simulation::TestForCatastrophy()
     HingeJoint *j;
     FixedJoint *f;
     int t;
-    for (auto &&iter3 : m_JointList)
+    for (auto &&it : m_JointUpdateList)
     {
-        j = dynamic_cast<HingeJoint *>(iter3.second.get());
+        j = it.hingeJoint;
         if (j)
         {
             t = j->TestLimits();
             if (t < 0)
             {
 #if defined(USE_QT)
-                ss << __FILE__ << "Failed due to LoStopTorqueLimit error in: " << iter3.second->name();
+                ss << __FILE__ << "Failed due to LoStopTorqueLimit error in: " << it.joint->name();
                 if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
 #endif
-                std::cerr << "Failed due to LoStopTorqueLimit error in: " << iter3.second->name() << "\n";
+                std::cerr << "Failed due to LoStopTorqueLimit error in: " << it.joint->name() << "\n";
                 return true;
             }
             else if (t > 0)
             {
 #if defined(USE_QT)
-                ss << __FILE__ << "Failed due to HiStopTorqueLimit error in: " << iter3.second->name();
+                ss << __FILE__ << "Failed due to HiStopTorqueLimit error in: " << it.joint->name();
                 if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
 #endif
-                std::cerr << "Failed due to HiStopTorqueLimit error in: " << iter3.second->name() << "\n";
+                std::cerr << "Failed due to HiStopTorqueLimit error in: " << it.joint->name() << "\n";
                 return true;
             }
         }
 
-        f = dynamic_cast<FixedJoint *>(iter3.second.get());
+        f = it.fixedJoint;
         if (f)
         {
             if (f->CheckStressAbort())
             {
 #if defined(USE_QT)
-                ss << __FILE__ << "Failed due to stress limit error in: " << iter3.second->name() << " " << f->GetLowPassMinStress() << " " << f->GetLowPassMaxStress();
+                ss << __FILE__ << "Failed due to stress limit error in: " << it.joint->name() << " " << f->GetLowPassMinStress() << " " << f->GetLowPassMaxStress();
                 if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
 #endif
-                std::cerr << "Failed due to stress limit error in: " << iter3.second->name() << " " << f->GetLowPassMinStress() << " " << f->GetLowPassMaxStress() << "\n";
+                std::cerr << "Failed due to stress limit error in: " << it.joint->name() << " " << f->GetLowPassMinStress() << " " << f->GetLowPassMaxStress() << "\n";
                 return true;
             }
         }
     }
 
     // and test the reporters for stop conditions
-    for (auto &&reporterIter : m_ReporterList)
+    for (auto &&reporter : m_ReporterUpdateList)
     {
-        if (reporterIter.second->ShouldAbort())
+        if (reporter->ShouldAbort())
         {
 #if defined(USE_QT)
-            ss << __FILE__ << "Failed due to Reporter Abort in: " << reporterIter.second->name();
+            ss << __FILE__ << "Failed due to Reporter Abort in: " << reporter->name();
             if (m_MainWindow) m_MainWindow->log(ss.str().c_str());
 #endif
-            std::cerr << "Failed due to Reporter Abort in: " << reporterIter.second->name() << "\n";
+            std::cerr << "Failed due to Reporter Abort in: " << reporter->name() << "\n";
             return true;
         }
     }
@@ -576,6 +834,22 @@ bool Simulation::TestForCatastrophy()
 
 
 //----------------------------------------------------------------------------
+// upper bound of the KinematicMatch fitness that can still be added after the current step
+double Simulation::KinematicMatchRemainingBound()
+{
+    // the remaining steps are limited by the TimeLimit (rounded up so the bound is never too small)
+    size_t remainingCalls = SIZE_MAX;
+    if (m_global->TimeLimit() > 0)
+        remainingCalls = size_t(std::max(0.0, std::ceil((m_global->TimeLimit() - m_SimulationTime) / m_global->StepSize()))) + 1;
+    double bound = 0;
+    for (auto &&dataTarget : m_DataTargetUpdateList)
+    {
+        bound += dataTarget->remainingValueBound(remainingCalls);
+        if (bound >= DBL_MAX) break;
+    }
+    return bound;
+}
+
 double Simulation::CalculateInstantaneousFitness()
 {
     switch (m_global->fitnessType())
@@ -585,6 +859,13 @@ double Simulation::CalculateInstantaneousFitness()
 
     case Global::KinematicMatchMiniMax:
         return m_KinematicMatchMiniMaxFitness;
+
+    case Global::DistanceTravelled:
+        {
+            auto it = m_BodyList.find(m_global->DistanceTravelledBodyIDName());
+            if (it != m_BodyList.end()) return it->second->GetPosition()[0];
+            break;
+        }
     }
     return 0;
 }
@@ -918,7 +1199,7 @@ std::string *Simulation::ParseDriver(const ParseXML::XMLElement *node)
     }
 
     driver->setSimulation(this);
-    driver->createAttributeMap(node->attributes);
+    driver->createAttributeMap(node->attributes, node->numericAttributes);
     errorMessage = driver->createFromAttributes();
     if (errorMessage)
     {
@@ -959,7 +1240,7 @@ std::string *Simulation::ParseDataTarget(const ParseXML::XMLElement *node)
     }
 
     dataTarget->setSimulation(this);
-    dataTarget->createAttributeMap(node->attributes);
+    dataTarget->createAttributeMap(node->attributes, node->numericAttributes);
     errorMessage = dataTarget->createFromAttributes();
     if (errorMessage)
     {
@@ -1313,6 +1594,12 @@ void Simulation::SetGlobal(std::unique_ptr<Global> global)
     dWorldSetDamping(m_WorldID, m_global->LinearDamping(), m_global->AngularDamping());
 }
 
+void Simulation::SetNumberOfThreads(size_t numberOfThreads)
+{
+    if (numberOfThreads > 1) m_threadPool = std::make_unique<ThreadPool>(numberOfThreads);
+    else m_threadPool.reset();
+}
+
 // add a warehouse from a file
 void Simulation::AddWarehouse(const std::string &filename)
 {
@@ -1329,6 +1616,49 @@ bool Simulation::ShouldQuit()
     return false;
 }
 
+// this builds the flat lists of objects that are visited every step from the owning maps
+void Simulation::BuildUpdateLists()
+{
+    m_BodyUpdateList.clear();
+    for (auto &&it : m_BodyList) m_BodyUpdateList.push_back(it.second.get());
+    m_JointUpdateList.clear();
+    for (auto &&it : m_JointList) m_JointUpdateList.push_back({it.second.get(), dynamic_cast<HingeJoint *>(it.second.get()), dynamic_cast<FixedJoint *>(it.second.get())});
+    m_StressJointUpdateList.clear();
+    for (auto &&it : m_JointUpdateList) if (it.fixedJoint && it.fixedJoint->GetStressCalculationType() != FixedJoint::none) m_StressJointUpdateList.push_back(it.fixedJoint);
+    m_GeomUpdateList.clear();
+    for (auto &&it : m_GeomList) m_GeomUpdateList.push_back(it.second.get());
+    m_MuscleUpdateList.clear();
+    for (auto &&it : m_MuscleList) m_MuscleUpdateList.push_back({it.second.get(), dynamic_cast<DampedSpringMuscle *>(it.second.get())});
+    m_FluidSacUpdateList.clear();
+    for (auto &&it : m_FluidSacList) m_FluidSacUpdateList.push_back(it.second.get());
+    m_DriverUpdateList.clear();
+    m_TegotaeDriverUpdateList.clear();
+    for (auto &&it : m_DriverList)
+    {
+        m_DriverUpdateList.push_back(it.second.get());
+        TegotaeDriver *tegotaeDriver = dynamic_cast<TegotaeDriver *>(it.second.get());
+        if (tegotaeDriver) m_TegotaeDriverUpdateList.push_back(tegotaeDriver);
+    }
+    m_DataTargetUpdateList.clear();
+    for (auto &&it : m_DataTargetList) m_DataTargetUpdateList.push_back(it.second.get());
+    m_ReporterUpdateList.clear();
+    for (auto &&it : m_ReporterList) m_ReporterUpdateList.push_back(it.second.get());
+    m_ControllerUpdateList.clear();
+    for (auto &&it : m_ControllerList) m_ControllerUpdateList.push_back({it.second.get(), dynamic_cast<Driver *>(it.second.get())});
+    m_UpdateListsDirty = false;
+}
+
+// this removes the contacts from the previous step and generates the new ones
+void Simulation::UpdateContacts()
+{
+    if (m_UpdateListsDirty) BuildUpdateLists();
+    dJointGroupEmpty(m_ContactGroup);
+    m_ContactList.clear();
+    for (auto &&geom : m_GeomUpdateList) geom->ClearContacts();
+    if (m_ContactBuffer.size() != size_t(m_MaxContacts)) m_ContactBuffer.resize(size_t(m_MaxContacts));
+    dSpaceCollide(m_SpaceID, this, &NearCallback);
+}
+
 // this is called by dSpaceCollide when two objects in space are
 // potentially colliding.
 
@@ -1346,72 +1676,81 @@ void Simulation::NearCallback(void *data, dGeomID o1, dGeomID o2)
         if (b1 && b2 && dAreConnectedExcluding(b1, b2, dJointTypeContact)) return;
     }
 
+    Geom *g1 = reinterpret_cast<Geom *>(dGeomGetData(o1));
+    Geom *g2 = reinterpret_cast<Geom *>(dGeomGetData(o2));
     if (s->m_global->AllowInternalCollisions() == false)
     {
-        if (reinterpret_cast<Geom *>(dGeomGetData(o1))->GetGeomLocation() == reinterpret_cast<Geom *>(dGeomGetData(o2))->GetGeomLocation()) return;
+        if (g1->GetGeomLocation() == g2->GetGeomLocation()) return;
     }
 
-    std::unique_ptr<dContact[]> contact = std::make_unique<dContact[]>(size_t(s->m_MaxContacts)); // up to m_MaxContacts contacts per box-box
-    double cfm = MAX(reinterpret_cast<Geom *>(dGeomGetData(o1))->GetContactSoftCFM(),
-                     reinterpret_cast<Geom *>(dGeomGetData(o2))->GetContactSoftCFM());
-    double erp = MIN(reinterpret_cast<Geom *>(dGeomGetData(o1))->GetContactSoftERP(),
-                     reinterpret_cast<Geom *>(dGeomGetData(o2))->GetContactSoftERP());
-    double mu = MIN(reinterpret_cast<Geom *>(dGeomGetData(o1))->GetContactMu(),
-                    reinterpret_cast<Geom *>(dGeomGetData(o2))->GetContactMu());
-    double bounce = MAX(reinterpret_cast<Geom *>(dGeomGetData(o1))->GetContactBounce(),
-                        reinterpret_cast<Geom *>(dGeomGetData(o2))->GetContactBounce());
-    for (size_t i = 0; i < size_t(s->m_MaxContacts); i++)
+    dContact *contact = s->m_ContactBuffer.data(); // up to m_MaxContacts contacts per box-box
+    numc = dCollide(o1, o2, s->m_MaxContacts, &contact[0].geom, sizeof(dContact));
+    if (numc == 0) return;
+
+    // the surface parameters only depend on the geom pair so they are calculated once and copied into each contact
+    dSurfaceParameters surface = {};
+    double cfm = MAX(g1->GetContactSoftCFM(), g2->GetContactSoftCFM());
+    double erp = MIN(g1->GetContactSoftERP(), g2->GetContactSoftERP());
+    double mu = MIN(g1->GetContactMu(), g2->GetContactMu());
+    double bounce = MAX(g1->GetContactBounce(), g2->GetContactBounce());
+    surface.mode = dContactApprox1;
+    surface.mu = mu;
+    if (bounce >= 0)
     {
-        contact[i].surface.mode = dContactApprox1;
-        contact[i].surface.mu = mu;
-        if (bounce >= 0)
-        {
-            contact[i].surface.bounce = bounce;
-            contact[i].surface.mode += dContactBounce;
-        }
-        if (cfm >= 0)
-        {
-            contact[i].surface.soft_cfm = cfm;
-            contact[i].surface.mode += dContactSoftCFM;
-        }
-        if (erp <= 1)
-        {
-            contact[i].surface.soft_erp = erp;
-            contact[i].surface.mode += dContactSoftERP;
-        }
+        surface.bounce = bounce;
+        surface.mode += dContactBounce;
     }
-    numc = dCollide(o1, o2, s->m_MaxContacts, &contact[0].geom, sizeof(dContact));
-    if (numc)
+    if (cfm >= 0)
     {
-        for (size_t i = 0; i < size_t(numc); i++)
+        surface.soft_cfm = cfm;
+        surface.mode += dContactSoftCFM;
+    }
+    if (erp <= 1)
+    {
+        surface.soft_erp = erp;
+        surface.mode += dContactSoftERP;
+    }
+
+    for (size_t i = 0; i < size_t(numc); i++)
+    {
+        contact[i].surface = surface;
+        if (g1->GetAbort()) s->SetContactAbort(true);
+        if (g2->GetAbort()) s->SetContactAbort(true);
+        dJointID c;
+        if (g1->GetAdhesion() == false && g2->GetAdhesion() == false)
         {
-            if (reinterpret_cast<Geom *>(dGeomGetData(o1))->GetAbort()) s->SetContactAbort(true);
-            if (reinterpret_cast<Geom *>(dGeomGetData(o2))->GetAbort()) s->SetContactAbort(true);
-            dJointID c;
-            if (reinterpret_cast<Geom *>(dGeomGetData(o1))->GetAdhesion() == false && reinterpret_cast<Geom *>(dGeomGetData(o2))->GetAdhesion() == false)
+            c = dJointCreateContact(s->m_WorldID, s->m_ContactGroup, &contact[i]);
+            dJointAttach(c, b1, b2);
+            // reuse a Contact from the pool if there is a spare one
+            Contact *myContact;
+            if (s->m_ContactList.size() < s->m_ContactPool.size())
             {
-                c = dJointCreateContact(s->m_WorldID, s->m_ContactGroup, &contact[i]);
-                dJointAttach(c, b1, b2);
-                std::unique_ptr<Contact> myContact = std::make_unique<Contact>();
-                myContact->setSimulation(s);
-                dJointSetFeedback(c, myContact->GetJointFeedback());
-                myContact->SetJointID(c);
-                std::copy_n(contact[i].geom.pos, dV3E__MAX, myContact->GetContactPosition());
-                // only add the contact information once
-                // and add it to the non-environment geom
-                if (reinterpret_cast<Geom *>(dGeomGetData(o1))->GetGeomLocation() == Geom::environment)
-                    reinterpret_cast<Geom *>(dGeomGetData(o2))->AddContact(myContact.get());
-                else
-                    reinterpret_cast<Geom *>(dGeomGetData(o1))->AddContact(myContact.get());
-                s->m_ContactList.push_back(std::move(myContact));
+                myContact = s->m_ContactPool[s->m_ContactList.size()].get();
             }
             else
             {
-                // FIX ME adhesive joints are added permanently and forces cannot be measured
-                c = dJointCreateBall(s->m_WorldID, nullptr);
-                dJointAttach(c, b1, b2);
-                dJointSetBallAnchor(c, contact[i].geom.pos[0], contact[i].geom.pos[1], contact[i].geom.pos[2]);
+                s->m_ContactPool.push_back(std::make_unique<Contact>());
+                myContact = s->m_ContactPool.back().get();
+                myContact->setSimulation(s);
             }
+            dJointSetFeedback(c, myContact->GetJointFeedback());
+            myContact->SetJointID(c);
+            std::copy_n(contact[i].geom.pos, dV3E__MAX, myContact->GetContactPosition());
+            // only add the contact information once
+            // and add it to the non-environment geom
+            if (g1->GetGeomLocation() == Geom::environment)
+                g2->AddContact(myContact);
+            else
+                g1->AddContact(myContact);
+            s->m_ContactList.push_back(myContact);
+        }
+        else
+        {
+            // FIX ME adhesive joints are added permanently and forces cannot be measured
+            c = dJointCreateBall(s->m_WorldID, nullptr);
+            dJointAttach(c, b1, b2);
+            dJointSetBallAnchor(c, contact[i].geom.pos[0], contact[i].geom.pos[1], contact[i].geom.pos[2]);
+            s->m_AdhesionJointList.push_back(c);
         }
     }
 }
@@ -1519,6 +1858,7 @@ Global *Simulation::GetGlobal()
 
 void Simulation::DumpObjects()
 {
+    if (m_binaryDumpFilename.size()) DumpBinaryObjects();
     for (auto &&it : m_BodyList) DumpObject(it.second.get());
     for (auto &&it : m_MarkerList) DumpObject(it.second.get());
     for (auto &&it : m_JointList) DumpObject(it.second.get());
@@ -1538,7 +1878,7 @@ void Simulation::DumpObjects()
 
 void Simulation::DumpObject(NamedObject *namedObject)
 {
-    if (namedObject->dump())
+    if (namedObject->dump() && m_binaryDumpObjectSet.count(namedObject) == 0)
     {
         if (namedObject->firstDump())
         {
@@ -1555,6 +1895,53 @@ void Simulation::DumpObject(NamedObject *namedObject)
     }
 }
 
+void Simulation::DumpBinaryObjects()
+{
+    if (!m_binaryDump)
+    {
+        // the layout is fixed by the objects flagged at the first dump so anything flagged later, or that
+        // does not support binary output, still goes to its own tab file
+        m_binaryDump = std::make_unique<BinaryDump>();
+        std::string *errorMessage = m_binaryDump->Open(m_binaryDumpFilename);
+        if (errorMessage)
+        {
+            std::cerr << *errorMessage << "\n";
+            m_binaryDump.reset();
+            m_binaryDumpFilename.clear();
+            return;
+        }
+        for (auto &&namedObject : GetObjectList())
+        {
+            if (namedObject->dump() == false) continue;
+            std::vector<std::string> columnNames = namedObject->dumpNames();
+            if (columnNames.size() == 0) continue;
+            m_binaryDump->AddObject(namedObject->name(), columnNames);
+            m_binaryDumpObjectList.push_back(namedObject);
+            m_binaryDumpColumnCounts.push_back(columnNames.size());
+            m_binaryDumpObjectSet.insert(namedObject);
+        }
+        m_binaryDumpRecord.reserve(m_binaryDump->recordSize());
+    }
+
+    m_binaryDumpRecord.clear();
+    for (size_t i = 0; i < m_binaryDumpObjectList.size(); i++)
+    {
+        if (m_binaryDumpObjectList[i]) m_binaryDumpObjectList[i]->dumpValues(&m_binaryDumpRecord);
+        else m_binaryDumpRecord.insert(m_binaryDumpRecord.end(), m_binaryDumpColumnCounts[i], 0.0);
+    }
+    m_binaryDump->WriteRecord(m_SimulationTime, m_binaryDumpRecord);
+}
+
+void Simulation::SetStepProfiler(StepProfiler *stepProfiler)
+{
+    m_stepProfiler = stepProfiler;
+}
+
+void Simulation::SetBinaryDumpFile(const std::string &filename)
+{
+    m_binaryDumpFilename = filename;
+}
+
 std::vector<std::string> Simulation::GetNameList() const
 {
     std::vector<std::string> output;
@@ -1667,6 +2054,12 @@ NamedObject *Simulation::GetNamedObject(const std::string &name) const
 
 bool Simulation::DeleteNamedObject(const std::string &name)
 {
+    m_UpdateListsDirty = true;
+    if (m_binaryDumpObjectSet.size())
+    {
+        NamedObject *namedObject = GetNamedObject(name);
+        if (m_binaryDumpObjectSet.erase(namedObject)) std::replace(m_binaryDumpObjectList.begin(), m_binaryDumpObjectList.end(), namedObject, static_cast<NamedObject *>(nullptr));
+    }
     auto BodyListIt = m_BodyList.find(name); if (BodyListIt != m_BodyList.end()) { m_BodyList.erase(BodyListIt); return true; }
     auto JointListIt = m_JointList.find(name); if (JointListIt != m_JointList.end()) { m_JointList.erase(JointListIt); return true; }
     auto GeomListIt = m_GeomList.find(name); if (GeomListIt != m_GeomList.end()) { m_GeomList.erase(GeomListIt); return true; }
@@ -17,6 +17,7 @@
 #include "Contact.h"
 #include "ParseXML.h"
 #include "SmartEnum.h"
+#include "ButterworthFilter.h"
 
 #include "ode/ode.h"
 
@@ -31,19 +32,26 @@ class Body;
 class Joint;
 class Geom;
 class Muscle;
+class DampedSpringMuscle;
 class Strap;
 class FluidSac;
 class Driver;
+class TegotaeDriver;
 class DataTarget;
 class Contact;
 class Marker;
 class Reporter;
 class Controller;
+class HingeJoint;
 class FixedJoint;
 class Warehouse;
 class SimulationWindow;
 class MainWindow;
 class Drivable;
+class StateBuffer;
+class ThreadPool;
+class BinaryDump;
+class StepProfiler;
 
 class Simulation : NamedObject
 {
@@ -58,7 +66,14 @@ public:
     static void NearCallback(void *data, dGeomID o1, dGeomID o2);
 
     std::string *LoadModel(const char *buffer, size_t length);  // load parameters from the XML configuration file
+    std::string *LoadModel(const std::vector<std::unique_ptr<ParseXML::XMLElement>> &elementList);  // load parameters from an already parsed element list
     void UpdateSimulation(void);     // called at each iteration through simulation
+    void UpdateContacts(void);       // collision detection phase of UpdateSimulation
+
+    // snapshot the run time state so that the simulation can be reset without reloading the model
+    void SaveSnapshot(StateBuffer *snapshot);
+    // validate checks the MD5 of the whole snapshot and is only needed when it did not come from this process
+    std::string *RestoreSnapshot(StateBuffer *snapshot, bool validate = false);
 
     // get hold of various variables
 
@@ -95,10 +110,14 @@ public:
     void SetOutputModelStateFile(const std::string &filename);
     void SetOutputWarehouseFile(const std::string &filename);
     void SetWarehouseFailDistanceAbort(double warehouseFailDistanceAbort);
+    void SetNumberOfThreads(size_t numberOfThreads); // threads used within each step (1 is fully serial)
+    void SetBinaryDumpFile(const std::string &filename); // objects that support it dump to this single file rather than individual tab files
+    void SetStepProfiler(StepProfiler *stepProfiler); // not owned, nullptr switches profiling off
 
     void AddWarehouse(const std::string &filename);
 
     // get hold of the internal lists (HANDLE WITH CARE)
+    // call InvalidateUpdateLists after adding or removing anything so that the per step lists are rebuilt
     std::map<std::string, std::unique_ptr<Body>> *GetBodyList() { return &m_BodyList; }
     std::map<std::string, std::unique_ptr<Joint>> *GetJointList() { return &m_JointList; }
     std::map<std::string, std::unique_ptr<Geom>> *GetGeomList() { return &m_GeomList; }
@@ -110,8 +129,19 @@ public:
     std::map<std::string, std::unique_ptr<Marker>> *GetMarkerList() { return &m_MarkerList; }
     std::map<std::string, std::unique_ptr<Reporter>> *GetReporterList() { return &m_ReporterList; }
     std::map<std::string, std::unique_ptr<Controller>> *GetControllerList() { return &m_ControllerList; }
+    void InvalidateUpdateLists() { m_UpdateListsDirty = true; }
+    // the fixed joint stress filters all share one set of coefficients within a simulation
+    SharedButterworthFilter::Coefficients *GetSharedButterworthCoefficients() { return &m_sharedButterworthCoefficients; }
+    // read only versions that can be used for drawing whilst another thread steps the simulation
+    const std::map<std::string, std::unique_ptr<Body>> *GetBodyList() const { return &m_BodyList; }
+    const std::map<std::string, std::unique_ptr<Joint>> *GetJointList() const { return &m_JointList; }
+    const std::map<std::string, std::unique_ptr<Geom>> *GetGeomList() const { return &m_GeomList; }
+    const std::map<std::string, std::unique_ptr<Muscle>> *GetMuscleList() const { return &m_MuscleList; }
+    const std::map<std::string, std::unique_ptr<FluidSac>> *GetFluidSacList() const { return &m_FluidSacList; }
+    const std::map<std::string, std::unique_ptr<Marker>> *GetMarkerList() const { return &m_MarkerList; }
+    const std::map<std::string, std::unique_ptr<Controller>> *GetControllerList() const { return &m_ControllerList; }
     std::map<std::string, std::unique_ptr<Warehouse>> *GetWarehouseList() { return &m_WarehouseList; }
-    std::vector<std::unique_ptr<Contact>> *GetContactList() { return &m_ContactList; }
+    std::vector<Contact *> *GetContactList() { return &m_ContactList; }
 
     std::vector<std::string> GetNameList() const;
     std::set<std::string> GetNameSet() const;
@@ -127,6 +157,9 @@ public:
     bool ShouldQuit();
     void SetContactAbort(bool contactAbort) { m_ContactAbort = contactAbort; }
     void SetDataTargetAbort(bool dataTargetAbort) { m_DataTargetAbort = dataTargetAbort; }
+    void SetScoreToBeat(double scoreToBeat) { m_ScoreToBeat = scoreToBeat; } // KinematicMatch runs stop as soon as this score cannot be reached
+    bool GetPruned() { return m_Pruned; }
+    double GetPrunedTime() { return m_PrunedTime; }
 
     std::string SaveToXML();
     void OutputProgramState();
@@ -156,6 +189,9 @@ private:
 
     void DumpObjects();
     void DumpObject(NamedObject *namedObject);
+    void DumpBinaryObjects();
+    void BuildUpdateLists();
+    double KinematicMatchRemainingBound();
 
     ParseXML m_parseXML;
 
@@ -174,7 +210,39 @@ private:
     std::map<std::string, std::unique_ptr<Warehouse>> m_WarehouseList;
 
     // this is a list of contacts that are active at the current time step
-    std::vector<std::unique_ptr<Contact>> m_ContactList;
+    // the Contact objects are owned by m_ContactPool and are reused from step to step rather than reallocated
+    std::vector<Contact *> m_ContactList;
+    std::vector<std::unique_ptr<Contact>> m_ContactPool;
+
+    // scratch space for dCollide so that NearCallback does not allocate for every geom pair
+    std::vector<dContact> m_ContactBuffer;
+
+    // flat lists of the objects that are visited every step with the subclass casts already done so that
+    // UpdateSimulation does not need to walk the maps or use dynamic_cast
+    // they are non-owning and are rebuilt from the maps whenever m_UpdateListsDirty is set
+    struct ControllerUpdate { Controller *controller; Driver *driver; };
+    struct MuscleUpdate { Muscle *muscle; DampedSpringMuscle *dampedSpringMuscle; };
+    struct JointUpdate { Joint *joint; HingeJoint *hingeJoint; FixedJoint *fixedJoint; };
+    bool m_UpdateListsDirty = true;
+    std::vector<Body *> m_BodyUpdateList;
+    std::vector<JointUpdate> m_JointUpdateList;
+    std::vector<FixedJoint *> m_StressJointUpdateList; // fixed joints that calculate a stress map
+    std::vector<Geom *> m_GeomUpdateList;
+    std::vector<MuscleUpdate> m_MuscleUpdateList;
+    std::vector<FluidSac *> m_FluidSacUpdateList;
+    std::vector<Driver *> m_DriverUpdateList;
+    std::vector<TegotaeDriver *> m_TegotaeDriverUpdateList;
+    std::vector<DataTarget *> m_DataTargetUpdateList;
+    std::vector<Reporter *> m_ReporterUpdateList;
+    std::vector<ControllerUpdate> m_ControllerUpdateList;
+
+    // optional pool used to evaluate the muscles in parallel within a step
+    std::unique_ptr<ThreadPool> m_threadPool;
+    StepProfiler *m_stepProfiler = nullptr;
+    SharedButterworthFilter::Coefficients m_sharedButterworthCoefficients;
+
+    // adhesion joints are permanent but need to be removed when a snapshot is restored
+    std::vector<dJointID> m_AdhesionJointList;
 
     // Simulation variables
     dWorldID m_WorldID;
@@ -220,6 +288,9 @@ private:
 
     // for fitness calculations
     double m_KinematicMatchFitness = 0;
+    double m_ScoreToBeat = -DBL_MAX;
+    bool m_Pruned = false;
+    double m_PrunedTime = 0;
 
     // values for energy partition
     double m_PositiveMechanicalWork = 0;
@@ -236,6 +307,12 @@ private:
     // values for dump output
     std::string m_dumpExtension = {".tab"};
     std::map<std::string, std::ofstream> m_dumpFileStreams;
+    std::string m_binaryDumpFilename;
+    std::unique_ptr<BinaryDump> m_binaryDump;
+    std::vector<NamedObject *> m_binaryDumpObjectList; // set to nullptr if the object is deleted
+    std::vector<size_t> m_binaryDumpColumnCounts;
+    std::set<NamedObject *> m_binaryDumpObjectSet;
+    std::vector<double> m_binaryDumpRecord;
 
 };
 
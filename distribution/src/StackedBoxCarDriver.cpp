@@ -100,18 +100,20 @@ std::string *StackedBoxcarDriver::createFromAttributes()
     if (findAttribute("StackSize"s, &buf) == nullptr) return lastErrorPtr();
     this->SetStackSize(size_t(GSUtil::Int(buf)));
 
-    buf.reserve(m_StackSize * 32);
-    std::vector<double> doubleList;
-    doubleList.reserve(m_StackSize);
-
     if (findAttribute("CycleTime"s, &buf) == nullptr) return lastErrorPtr();
     this->SetCycleTime(GSUtil::Double(buf));
-    if (findAttribute("Delays"s, &buf) == nullptr) return lastErrorPtr();
-    this->SetDelays(GSUtil::Double(buf, int(m_StackSize), doubleList.data()));
-    if (findAttribute("Widths"s, &buf) == nullptr) return lastErrorPtr();
-    this->SetWidths(GSUtil::Double(buf, int(m_StackSize), doubleList.data()));
-    if (findAttribute("Heights"s, &buf) == nullptr) return lastErrorPtr();
-    this->SetHeights(GSUtil::Double(buf, int(m_StackSize), doubleList.data()));
+
+    // missing values are set to zero
+    std::vector<double> doubleList;
+    if (findAttribute("Delays"s, &doubleList) == nullptr) return lastErrorPtr();
+    doubleList.resize(m_StackSize, 0);
+    this->SetDelays(doubleList.data());
+    if (findAttribute("Widths"s, &doubleList) == nullptr) return lastErrorPtr();
+    doubleList.resize(m_StackSize, 0);
+    this->SetWidths(doubleList.data());
+    if (findAttribute("Heights"s, &doubleList) == nullptr) return lastErrorPtr();
+    doubleList.resize(m_StackSize, 0);
+    this->SetHeights(doubleList.data());
 
     return nullptr;
 }
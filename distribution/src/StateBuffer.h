@@ -0,0 +1,98 @@
+/*
+ *  StateBuffer.h
+ *  GaitSym2019
+ *
+ *  Simple binary buffer used to snapshot the run time state of a simulation
+ *  so that it can be restored without reloading the model
+ *
+ */
+
+#ifndef STATEBUFFER_H
+#define STATEBUFFER_H
+
+#include <vector>
+#include <cstring>
+#include <type_traits>
+
+class StateBuffer
+{
+public:
+
+    template<typename T> void Write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "StateBuffer can only store trivially copyable types");
+        size_t offset = m_data.size();
+        m_data.resize(offset + sizeof(T));
+        std::memcpy(m_data.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T> void Write(const std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "StateBuffer can only store trivially copyable types");
+        Write(values.size());
+        size_t offset = m_data.size();
+        m_data.resize(offset + sizeof(T) * values.size());
+        if (values.size()) std::memcpy(m_data.data() + offset, values.data(), sizeof(T) * values.size());
+    }
+
+    void Write(const double *values, size_t count)
+    {
+        size_t offset = m_data.size();
+        m_data.resize(offset + sizeof(double) * count);
+        std::memcpy(m_data.data() + offset, values, sizeof(double) * count);
+    }
+
+    // the Read functions return false and leave the value unchanged if there is not enough data left
+    template<typename T> bool Read(T *value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "StateBuffer can only store trivially copyable types");
+        if (m_readIndex + sizeof(T) > m_data.size()) { m_readError = true; return false; }
+        std::memcpy(value, m_data.data() + m_readIndex, sizeof(T));
+        m_readIndex += sizeof(T);
+        return true;
+    }
+
+    template<typename T> bool Read(std::vector<T> *values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "StateBuffer can only store trivially copyable types");
+        size_t count;
+        if (Read(&count) == false) return false;
+        if (m_readIndex + sizeof(T) * count > m_data.size()) { m_readError = true; return false; }
+        values->resize(count);
+        if (count) std::memcpy(values->data(), m_data.data() + m_readIndex, sizeof(T) * count);
+        m_readIndex += sizeof(T) * count;
+        return true;
+    }
+
+    bool Read(double *values, size_t count)
+    {
+        if (m_readIndex + sizeof(double) * count > m_data.size()) { m_readError = true; return false; }
+        std::memcpy(values, m_data.data() + m_readIndex, sizeof(double) * count);
+        m_readIndex += sizeof(double) * count;
+        return true;
+    }
+
+    // replaces a value that has already been written e.g. a header field that can only be filled in at the end
+    template<typename T> void Overwrite(size_t offset, const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "StateBuffer can only store trivially copyable types");
+        if (offset + sizeof(T) > m_data.size()) return;
+        std::memcpy(m_data.data() + offset, &value, sizeof(T));
+    }
+
+    void Rewind() { m_readIndex = 0; m_readError = false; }
+    void Clear() { m_data.clear(); m_readIndex = 0; m_readError = false; }
+
+    const char *data() const { return m_data.data(); }
+    size_t size() const { return m_data.size(); }
+    bool readError() const { return m_readError; }
+    bool atEnd() const { return m_readIndex == m_data.size(); }
+
+private:
+
+    std::vector<char> m_data;
+    size_t m_readIndex = 0;
+    bool m_readError = false;
+};
+
+#endif // STATEBUFFER_H
@@ -14,6 +14,7 @@
 #include "Simulation.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <algorithm>
 
@@ -80,14 +81,10 @@ std::string *StepDriver::createFromAttributes()
 {
     if (Driver::createFromAttributes()) return lastErrorPtr();
 
-    std::string buf;
-    buf.reserve(100000);
-    if (findAttribute("Values"s, &buf) == nullptr) return lastErrorPtr();
     std::vector<double> values;
-    GSUtil::Double(buf, &values);
-    if (findAttribute("Durations"s, &buf) == nullptr) return lastErrorPtr();
+    if (findAttribute("Values"s, &values) == nullptr) return lastErrorPtr();
     std::vector<double> durations;
-    GSUtil::Double(buf, &durations);
+    if (findAttribute("Durations"s, &durations) == nullptr) return lastErrorPtr();
     if (values.size() != durations.size())
     {
         setLastError("StepDriver ID=\""s + name() + "\" number of values ("s + std::to_string(values.size()) + ") must match number of durations ("s + std::to_string(durations.size()) + ")"s);
@@ -133,4 +130,15 @@ void StepDriver::setDurationList(const std::vector<double> &durationList)
     m_durationList = durationList;
 }
 
+void StepDriver::saveState(StateBuffer *state)
+{
+    Driver::saveState(state);
+    state->Write(m_index);
+}
+
+void StepDriver::restoreState(StateBuffer *state)
+{
+    Driver::restoreState(state);
+    state->Read(&m_index);
+}
 
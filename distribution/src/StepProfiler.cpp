@@ -0,0 +1,165 @@
+/*
+ *  StepProfiler.cpp
+ *  GaitSym2019
+ *
+ *  Accumulates the time spent in each phase of Simulation::UpdateSimulation
+ *  and, where the phase loops over objects, the time spent in each object type
+ *  It works as a lap timer: each call to Lap attributes the time since the previous
+ *  call to the named phase so each phase only needs a single call at its end
+ *
+ */
+
+#include "StepProfiler.h"
+#include "NamedObject.h"
+
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <typeinfo>
+
+using namespace std::string_literals;
+
+StepProfiler::StepProfiler()
+{
+    m_lastLap = std::chrono::steady_clock::now();
+}
+
+void StepProfiler::StartStep()
+{
+    m_stepCount++;
+    m_lastLap = std::chrono::steady_clock::now();
+}
+
+void StepProfiler::Restart()
+{
+    m_lastLap = std::chrono::steady_clock::now();
+}
+
+int64_t StepProfiler::Elapsed()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_lastLap).count();
+    m_lastLap = now;
+    return elapsed;
+}
+
+void StepProfiler::Lap(Phase phase)
+{
+    m_phaseTimers[phase].nanoseconds += Elapsed();
+    m_phaseTimers[phase].count++;
+}
+
+void StepProfiler::Lap(Phase phase, const NamedObject *object)
+{
+    int64_t elapsed = Elapsed();
+    m_phaseTimers[phase].nanoseconds += elapsed;
+    std::type_index type(typeid(*object));
+    auto it = m_typeTimerIndex[phase].find(type);
+    size_t index;
+    if (it != m_typeTimerIndex[phase].end())
+    {
+        index = it->second;
+    }
+    else
+    {
+        index = m_typeTimers.size();
+        TypeTimer typeTimer;
+        typeTimer.phase = phase;
+        typeTimer.typeName = object->className();
+        m_typeTimers.push_back(typeTimer);
+        m_typeTimerIndex[phase][type] = index;
+    }
+    m_typeTimers[index].timer.nanoseconds += elapsed;
+    m_typeTimers[index].timer.count++;
+}
+
+void StepProfiler::Clear()
+{
+    m_stepCount = 0;
+    for (size_t i = 0; i < phaseCount; i++)
+    {
+        m_phaseTimers[i] = Timer();
+        m_typeTimerIndex[i].clear();
+    }
+    m_typeTimers.clear();
+    m_lastLap = std::chrono::steady_clock::now();
+}
+
+int64_t StepProfiler::stepCount() const
+{
+    return m_stepCount;
+}
+
+double StepProfiler::totalTime() const
+{
+    int64_t total = 0;
+    for (size_t i = 0; i < phaseCount; i++) total += m_phaseTimers[i].nanoseconds;
+    return double(total) * 1e-9;
+}
+
+double StepProfiler::phaseTime(Phase phase) const
+{
+    return double(m_phaseTimers[phase].nanoseconds) * 1e-9;
+}
+
+std::string StepProfiler::Summary() const
+{
+    double total = totalTime();
+    double steps = m_stepCount > 0 ? double(m_stepCount) : 1.0;
+    std::stringstream ss;
+    ss << "Step profile: " << m_stepCount << " steps " << total << " s " << total / steps * 1e6 << " us per step\n";
+    ss << std::left << std::setw(32) << "Phase" << std::right << std::setw(14) << "Time (s)" << std::setw(14) << "us/step" << std::setw(10) << "%" << "\n";
+    ss << std::fixed;
+    for (size_t i = 0; i < phaseCount; i++)
+    {
+        double time = double(m_phaseTimers[i].nanoseconds) * 1e-9;
+        ss << std::left << std::setw(32) << phaseStrings(i) << std::right << std::setprecision(6) << std::setw(14) << time <<
+              std::setprecision(3) << std::setw(14) << time / steps * 1e6 << std::setprecision(2) << std::setw(10) << (total > 0 ? 100 * time / total : 0) << "\n";
+        for (auto &&typeTimer : m_typeTimers)
+        {
+            if (size_t(typeTimer.phase) != i) continue;
+            double typeTime = double(typeTimer.timer.nanoseconds) * 1e-9;
+            ss << std::left << std::setw(32) << ("  "s + typeTimer.typeName) << std::right << std::setprecision(6) << std::setw(14) << typeTime <<
+                  std::setprecision(3) << std::setw(14) << typeTime / steps * 1e6 << std::setprecision(2) << std::setw(10) << (total > 0 ? 100 * typeTime / total : 0) <<
+                  "  (" << typeTimer.timer.count / int64_t(steps) << " per step)\n";
+        }
+    }
+    return ss.str();
+}
+
+std::string StepProfiler::JSON() const
+{
+    std::stringstream ss;
+    ss.precision(9);
+    ss << "{\n";
+    ss << "  \"steps\": " << m_stepCount << ",\n";
+    ss << "  \"totalTime\": " << totalTime() << ",\n";
+    ss << "  \"phases\": [\n";
+    for (size_t i = 0; i < phaseCount; i++)
+    {
+        ss << "    { \"name\": \"" << phaseStrings(i) << "\", \"time\": " << double(m_phaseTimers[i].nanoseconds) * 1e-9 <<
+              ", \"laps\": " << m_phaseTimers[i].count << ", \"types\": [";
+        bool first = true;
+        for (auto &&typeTimer : m_typeTimers)
+        {
+            if (size_t(typeTimer.phase) != i) continue;
+            ss << (first ? "\n" : ",\n");
+            first = false;
+            ss << "        { \"name\": \"" << typeTimer.typeName << "\", \"time\": " << double(typeTimer.timer.nanoseconds) * 1e-9 <<
+                  ", \"count\": " << typeTimer.timer.count << " }";
+        }
+        ss << (first ? "] }" : "\n      ] }") << (i + 1 < phaseCount ? ",\n" : "\n");
+    }
+    ss << "  ]\n";
+    ss << "}\n";
+    return ss.str();
+}
+
+int StepProfiler::WriteJSON(const std::string &filename) const
+{
+    std::ofstream file(filename);
+    if (!file.is_open()) return __LINE__;
+    file << JSON();
+    if (!file.good()) return __LINE__;
+    return 0;
+}
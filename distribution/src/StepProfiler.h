@@ -0,0 +1,70 @@
+/*
+ *  StepProfiler.h
+ *  GaitSym2019
+ *
+ *  Accumulates the time spent in each phase of Simulation::UpdateSimulation
+ *  and, where the phase loops over objects, the time spent in each object type
+ *  It works as a lap timer: each call to Lap attributes the time since the previous
+ *  call to the named phase so each phase only needs a single call at its end
+ *
+ */
+
+#ifndef STEPPROFILER_H
+#define STEPPROFILER_H
+
+#include "SmartEnum.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+#include <typeindex>
+#include <cstdint>
+
+class NamedObject;
+
+class StepProfiler
+{
+public:
+    StepProfiler();
+
+    SMART_ENUM(Phase, phaseStrings, phaseCount, DataTargets, Collisions, Drivers, Controllers, Muscles, Joints, FluidSacs, BodyForces, WorldStep, Energy, Outputs, Catastrophy);
+
+    void StartStep(); // counts the step and restarts the lap timer
+    void Restart(); // restarts the lap timer without attributing the elapsed time to anything
+    void Lap(Phase phase);
+    void Lap(Phase phase, const NamedObject *object); // also attributes the time to the object's type
+
+    void Clear();
+
+    std::string Summary() const;
+    std::string JSON() const;
+    int WriteJSON(const std::string &filename) const; // returns 0 on success
+
+    int64_t stepCount() const;
+    double totalTime() const; // seconds
+    double phaseTime(Phase phase) const; // seconds
+
+private:
+    struct Timer
+    {
+        int64_t nanoseconds = 0;
+        int64_t count = 0;
+    };
+    struct TypeTimer
+    {
+        Phase phase = DataTargets;
+        std::string typeName;
+        Timer timer;
+    };
+
+    int64_t Elapsed();
+
+    std::chrono::steady_clock::time_point m_lastLap;
+    int64_t m_stepCount = 0;
+    Timer m_phaseTimers[phaseCount];
+    std::vector<TypeTimer> m_typeTimers;
+    std::unordered_map<std::type_index, size_t> m_typeTimerIndex[phaseCount];
+};
+
+#endif // STEPPROFILER_H
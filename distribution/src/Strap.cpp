@@ -14,6 +14,7 @@
 #include "Marker.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <string>
 #include <sstream>
@@ -255,7 +256,19 @@ std::string Strap::dumpToString()
     return ss.str();
 }
 
+void Strap::saveState(StateBuffer *state)
+{
+    NamedObject::saveState(state);
+    state->Write(m_tension);
+    state->Write(m_velocity);
+    state->Write(m_length);
+}
 
-
-
+void Strap::restoreState(StateBuffer *state)
+{
+    NamedObject::restoreState(state);
+    state->Read(&m_tension);
+    state->Read(&m_velocity);
+    state->Read(&m_length);
+}
 
@@ -11,6 +11,7 @@
 #include "GSUtil.h"
 #include "Body.h"
 #include "Simulation.h"
+#include "StateBuffer.h"
 
 #include <sstream>
 
@@ -111,3 +112,17 @@ std::string SwingClearanceAbortReporter::dumpToString()
     return ss.str();
 }
 
+void SwingClearanceAbortReporter::saveState(StateBuffer *state)
+{
+    Marker::saveState(state);
+    state->Write(m_velocity);
+    state->Write(m_height);
+}
+
+void SwingClearanceAbortReporter::restoreState(StateBuffer *state)
+{
+    Marker::restoreState(state);
+    state->Read(&m_velocity);
+    state->Read(&m_height);
+}
+
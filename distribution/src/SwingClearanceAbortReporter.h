@@ -27,6 +27,8 @@ public:
 
     virtual bool ShouldAbort();
     virtual std::string dumpToString();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
 private:
 
@@ -7,6 +7,9 @@
  *
  */
 
+#ifndef TCP_H
+#define TCP_H
+
 #if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
 #include <WinSock2.h>
 #else
@@ -55,3 +58,4 @@ private:
 #endif
 };
 
+#endif // TCP_H
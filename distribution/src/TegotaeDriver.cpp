@@ -19,6 +19,7 @@
 #include "Controller.h"
 
 #include "pystring.h"
+#include "StateBuffer.h"
 
 #include <cmath>
 #include <vector>
@@ -431,4 +432,27 @@ pgd::Vector3 TegotaeDriver::localErrorVector() const
     return m_localErrorVector;
 }
 
+void TegotaeDriver::saveState(StateBuffer *state)
+{
+    Driver::saveState(state);
+    state->Write(m_phi);
+    state->Write(m_X);
+    state->Write(m_Y);
+    state->Write(m_N);
+    state->Write(m_phi_dot);
+    state->Write(m_worldErrorVector);
+    state->Write(m_localErrorVector);
+}
+
+void TegotaeDriver::restoreState(StateBuffer *state)
+{
+    Driver::restoreState(state);
+    state->Read(&m_phi);
+    state->Read(&m_X);
+    state->Read(&m_Y);
+    state->Read(&m_N);
+    state->Read(&m_phi_dot);
+    state->Read(&m_worldErrorVector);
+    state->Read(&m_localErrorVector);
+}
 
@@ -49,6 +49,8 @@ public:
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     pgd::Vector3 worldErrorVector() const;
     pgd::Vector3 localErrorVector() const;
@@ -0,0 +1,92 @@
+/*
+ *  ThreadPool.cpp
+ *  GaitSym2019
+ *
+ *  Small pool of persistent threads used to run independent parts of a
+ *  simulation step in parallel
+ *
+ */
+
+#include "ThreadPool.h"
+
+#include "ode/ode.h"
+
+ThreadPool::ThreadPool(size_t numberOfThreads)
+{
+    // the pool holds its own reference to ODE so that the workers can release their thread data before it is closed
+    dInitODE2(dInitFlagManualThreadCleanup);
+    for (size_t i = 1; i < numberOfThreads; i++) m_threadList.push_back(std::thread(&ThreadPool::Worker, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopFlag = true;
+    }
+    m_startCondition.notify_all();
+    for (auto &&it : m_threadList) it.join();
+    dCloseODE();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &function)
+{
+    if (m_threadList.size() == 0 || count < 2)
+    {
+        for (size_t i = 0; i < count; i++) function(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_function = &function;
+        m_count = count;
+        m_nextIndex = 0;
+        m_activeWorkers = m_threadList.size();
+        m_generation++;
+    }
+    m_startCondition.notify_all();
+
+    RunTasks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finishedCondition.wait(lock, [this]{ return m_activeWorkers == 0; });
+    m_function = nullptr;
+}
+
+size_t ThreadPool::numberOfThreads() const
+{
+    return m_threadList.size() + 1;
+}
+
+void ThreadPool::Worker()
+{
+    // the tasks call into ODE so each worker needs its own ODE thread data if ODE is built with TLS
+    dAllocateODEDataForThread(dAllocateMaskAll);
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_startCondition.wait(lock, [this, generation]{ return m_stopFlag || m_generation != generation; });
+            if (m_stopFlag) break;
+            generation = m_generation;
+        }
+
+        RunTasks();
+
+        bool lastWorker;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activeWorkers--;
+            lastWorker = (m_activeWorkers == 0);
+        }
+        if (lastWorker) m_finishedCondition.notify_one();
+    }
+    dCleanupODEAllDataForThread();
+}
+
+void ThreadPool::RunTasks()
+{
+    for (size_t i = m_nextIndex++; i < m_count; i = m_nextIndex++) (*m_function)(i);
+}
@@ -0,0 +1,50 @@
+/*
+ *  ThreadPool.h
+ *  GaitSym2019
+ *
+ *  Small pool of persistent threads used to run independent parts of a
+ *  simulation step in parallel. The calling thread joins in and the work
+ *  items are handed out one at a time from a shared counter so threads that
+ *  finish early take work that would otherwise wait for a busy thread
+ *
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+class ThreadPool
+{
+public:
+    ThreadPool(size_t numberOfThreads); // this includes the calling thread so 1 means everything is run serially
+    ~ThreadPool();
+
+    // calls function(i) for i = 0 to count - 1 and returns once they have all finished
+    void ParallelFor(size_t count, const std::function<void(size_t)> &function);
+
+    size_t numberOfThreads() const;
+
+private:
+    void Worker();
+    void RunTasks();
+
+    std::vector<std::thread> m_threadList;
+    std::mutex m_mutex;
+    std::condition_variable m_startCondition;
+    std::condition_variable m_finishedCondition;
+    const std::function<void(size_t)> *m_function = nullptr;
+    size_t m_count = 0;
+    std::atomic<size_t> m_nextIndex{0};
+    size_t m_activeWorkers = 0;
+    uint64_t m_generation = 0;
+    bool m_stopFlag = false;
+};
+
+#endif // THREADPOOL_H
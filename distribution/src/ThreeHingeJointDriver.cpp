@@ -28,6 +28,8 @@
 #include <cassert>
 #include <algorithm>
 #include <utility>
+#include <limits>
+#include <cmath>
 
 using namespace std::string_literals;
 
@@ -46,10 +48,16 @@ void ThreeHingeJointDriver::Update()
     m_desiredLength = (targetPositionWorld - proximalJointPositionWorld).Magnitude();
 
     // now find the zero of the CalculateLengthDifference to get the angle fraction that achieves this length
-    m_angleFraction = GSUtil::zeroin(0, 1, &CalculateLengthDifference, this, m_tolerance);
+    // starting from last step's solution and only using zeroin if that fails
+    m_solverEvaluations = 0;
+    if (SolveWarmStart() == false)
+    {
+        m_solverFallbacks++;
+        m_angleFraction = GSUtil::zeroin(0, 1, &CalculateLengthDifference, this, m_tolerance);
+    }
 
     // that sorts out the angles on the intermediate and distal joints - lets see where that takes us
-    // CalculateLength(m_angleFraction); // not needed because zeroin will have called this with the returned angleFraction as its last operation
+    // CalculateLength(m_angleFraction); // not needed because both solvers will have called this with the returned angleFraction as their last operation
 
     pgd::Vector3 targetVector = m_targetMarker->GetPosition() - m_proximalJoint->body1Marker()->GetPosition(); // these will both be on the same body
     // need to find the rotations about m_proximalJoint->body1Marker()->GetAxis(Marker::X) and m_proximalJoint->body1Marker()->GetAxis(Marker::y)
@@ -106,56 +114,36 @@ void ThreeHingeJointDriver::Update()
     std::cerr << "difference = " << targetVector - checkVector << "\n";
 #endif
 
-    while (true)
+    // the proximal joint type is found once when the driver is created
+    switch (m_proximalJointType)
     {
-        HingeJoint *hingeJoint = dynamic_cast<HingeJoint *>(m_proximalJoint);
-        if (hingeJoint)
-        {
-            m_proximalJointAxis1 = normal1;
-            m_proximalJointAngle1 = -angle1; // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
-            m_proximalAngleFraction1 = (m_proximalJointAngle1 - m_proximalJointRange[0]) / (m_proximalJointRange[1] - m_proximalJointRange[0]);
-            if (m_proximalAngleFraction1 < 0 || m_proximalAngleFraction1 > 1)
-            {
-                m_proximalAngleFraction1 = GSUtil::Clamp(m_proximalAngleFraction1, 0.0, 1.0);
-                m_proximalJointAngle1 = m_proximalAngleFraction1 * (m_proximalJointRange[1] - m_proximalJointRange[0]) + m_proximalJointRange[0];
-            }
-            m_proximalJointRotation = pgd::MakeQFromAxisAngle(m_proximalJointAxis1, -m_proximalJointAngle1); // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
-            break;
-        }
-        UniversalJoint *universalJoint = dynamic_cast<UniversalJoint *>(m_proximalJoint);
-        if (universalJoint)
+    case HingeProximal:
+        m_proximalJointAxis1 = normal1;
+        m_proximalJointAngle1 = -angle1; // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
+        m_proximalAngleFraction1 = (m_proximalJointAngle1 - m_proximalJointRange[0]) / (m_proximalJointRange[1] - m_proximalJointRange[0]);
+        if (m_proximalAngleFraction1 < 0 || m_proximalAngleFraction1 > 1)
         {
-            m_proximalJointAxis1 = normal1;
-            m_proximalJointAngle1 = -angle1; // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
-            m_proximalAngleFraction1 = (m_proximalJointAngle1 - m_proximalJointRange[0]) / (m_proximalJointRange[1] - m_proximalJointRange[0]);
-            if (m_proximalAngleFraction1 < 0 || m_proximalAngleFraction1 > 1)
-            {
-                m_proximalAngleFraction1 = GSUtil::Clamp(m_proximalAngleFraction1, 0.0, 1.0);
-                m_proximalJointAngle1 = m_proximalAngleFraction1 * (m_proximalJointRange[1] - m_proximalJointRange[0]) + m_proximalJointRange[0];
-            }
-            m_proximalJointRotation = pgd::MakeQFromAxisAngle(m_proximalJointAxis1, -m_proximalJointAngle1); // note that the angle is negated again to put it back to the correct sign
-            m_proximalJointAxis2 = normal2;
-            m_proximalJointAngle2 = angle2;
-            m_proximalJointRotation =  pgd::MakeQFromAxisAngle(m_proximalJointAxis2, m_proximalJointAngle2) * m_proximalJointRotation;
-            break;
+            m_proximalAngleFraction1 = GSUtil::Clamp(m_proximalAngleFraction1, 0.0, 1.0);
+            m_proximalJointAngle1 = m_proximalAngleFraction1 * (m_proximalJointRange[1] - m_proximalJointRange[0]) + m_proximalJointRange[0];
         }
-        BallJoint *ballJoint = dynamic_cast<BallJoint *>(m_proximalJoint);
-        if (ballJoint)
+        m_proximalJointRotation = pgd::MakeQFromAxisAngle(m_proximalJointAxis1, -m_proximalJointAngle1); // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
+        break;
+    case UniversalProximal:
+    case BallProximal:
+        m_proximalJointAxis1 = normal1;
+        m_proximalJointAngle1 = -angle1; // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
+        m_proximalAngleFraction1 = (m_proximalJointAngle1 - m_proximalJointRange[0]) / (m_proximalJointRange[1] - m_proximalJointRange[0]);
+        if (m_proximalAngleFraction1 < 0 || m_proximalAngleFraction1 > 1)
         {
-            m_proximalJointAxis1 = normal1;
-            m_proximalJointAngle1 = -angle1; // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
-            m_proximalAngleFraction1 = (m_proximalJointAngle1 - m_proximalJointRange[0]) / (m_proximalJointRange[1] - m_proximalJointRange[0]);
-            if (m_proximalAngleFraction1 < 0 || m_proximalAngleFraction1 > 1)
-            {
-                m_proximalAngleFraction1 = GSUtil::Clamp(m_proximalAngleFraction1, 0.0, 1.0);
-                m_proximalJointAngle1 = m_proximalAngleFraction1 * (m_proximalJointRange[1] - m_proximalJointRange[0]) + m_proximalJointRange[0];
-            }
-            m_proximalJointRotation = pgd::MakeQFromAxisAngle(m_proximalJointAxis1, -m_proximalJointAngle1); // note that the angle is negated again to put it back to the correct sign
-            m_proximalJointAxis2 = normal2;
-            m_proximalJointAngle2 = angle2;
-            m_proximalJointRotation =  pgd::MakeQFromAxisAngle(m_proximalJointAxis2, m_proximalJointAngle2) * m_proximalJointRotation;
-            break;
+            m_proximalAngleFraction1 = GSUtil::Clamp(m_proximalAngleFraction1, 0.0, 1.0);
+            m_proximalJointAngle1 = m_proximalAngleFraction1 * (m_proximalJointRange[1] - m_proximalJointRange[0]) + m_proximalJointRange[0];
         }
+        m_proximalJointRotation = pgd::MakeQFromAxisAngle(m_proximalJointAxis1, -m_proximalJointAngle1); // note that the angle is negated again to put it back to the correct sign
+        m_proximalJointAxis2 = normal2;
+        m_proximalJointAngle2 = angle2;
+        m_proximalJointRotation =  pgd::MakeQFromAxisAngle(m_proximalJointAxis2, m_proximalJointAngle2) * m_proximalJointRotation;
+        break;
+    case UnknownProximal:
         std::cerr << "ThreeHingeJointDriver::Update(): unrecognised proximal joint type\n";
         break;
     }
@@ -414,11 +402,10 @@ void ThreeHingeJointDriver::SendData()
 void ThreeHingeJointDriver::CalculateLength(double angleFraction)
 {
     // now calculate the rotations at the joints in a consistent coordinate frame (and this can be the local frame because at contruction nothing is rotated)
+    // m_intermediateJointAxis and m_distalJointAxis are fixed in the local frame so they are set in createFromAttributes
     m_intermediateJointAngle = std::pow(angleFraction, m_intermediateJointAngleGamma) * (m_intermediateJointRange[1] - m_intermediateJointRange[0]) + m_intermediateJointRange[0];
-    m_intermediateJointAxis = m_intermediateJoint->body1Marker()->GetAxis(Marker::X);
     m_intermediateJointRotation = pgd::MakeQFromAxisAngle(m_intermediateJointAxis, -m_intermediateJointAngle); // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
     m_distalJointAngle = std::pow(angleFraction, m_distalJointAngleGamma) * (m_distalJointRange[1] - m_distalJointRange[0]) + m_distalJointRange[0];
-    m_distalJointAxis = m_distalJoint->body1Marker()->GetAxis(Marker::X);
     m_distalJointRotation = pgd::MakeQFromAxisAngle(m_distalJointAxis, -m_distalJointAngle); // note that the angle is negated because ODE calculates hinge joint angle wrt body 2 and this is a rotation wrt body 1
 
     // now sum the vectors to get the position of the end point
@@ -431,11 +418,54 @@ void ThreeHingeJointDriver::CalculateLength(double angleFraction)
 double ThreeHingeJointDriver::CalculateLengthDifference(double angleFraction, void *data)
 {
     ThreeHingeJointDriver *threeHingeJointController = static_cast<ThreeHingeJointDriver *>(data);
+    threeHingeJointController->m_solverEvaluations++;
     threeHingeJointController->CalculateLength(angleFraction);
     double lengthError = threeHingeJointController->actualLength() - threeHingeJointController->desiredLength();
     return lengthError;
 }
 
+// secant iteration starting from the previous step's angle fraction and length derivative
+// the length is monotonic in the angle fraction so the root is kept bracketed and any step that
+// leaves the bracket is replaced by bisection. It returns false if the desired length is not
+// bracketed by the ends of the range (zeroin then handles the end points exactly as before)
+// or if it does not converge within the iteration cap
+// on success the last CalculateLength call was at the returned m_angleFraction
+bool ThreeHingeJointDriver::SolveWarmStart()
+{
+    double fa = m_lengthAtZero - m_desiredLength;
+    double fb = m_lengthAtOne - m_desiredLength;
+    if (fa == 0 || fb == 0 || std::signbit(fa) == std::signbit(fb)) return false;
+    double a = 0, b = 1; // f(a) always has the sign of f(0) so a stays below the root and b above it
+    double x = GSUtil::Clamp(m_angleFraction, 0.0, 1.0);
+    double fx = CalculateLengthDifference(x, this);
+    double dfdx = m_lengthDerivative;
+    int maxIterations = m_maxIterations >= 0 ? m_maxIterations : 20;
+    for (int i = 0; i < maxIterations; i++)
+    {
+        if (fx == 0)
+        {
+            m_angleFraction = x;
+            return true;
+        }
+        if (std::signbit(fx) == std::signbit(fa)) a = x;
+        else b = x;
+        double xNew = x - fx / dfdx;
+        if (!(xNew > a && xNew < b)) xNew = (a + b) / 2; // also catches dfdx == 0 and NaN
+        double fNew = CalculateLengthDifference(xNew, this);
+        double dfdxNew = (fNew - fx) / (xNew - x);
+        if (dfdxNew != 0 && std::isfinite(dfdxNew)) dfdx = dfdxNew;
+        bool converged = std::fabs(xNew - x) <= m_tolerance;
+        x = xNew;
+        fx = fNew;
+        if (converged)
+        {
+            m_angleFraction = x;
+            m_lengthDerivative = dfdx;
+            return true;
+        }
+    }
+    return false;
+}
 
 Marker *ThreeHingeJointDriver::createLocalMarkerCopy(const Marker *marker)
 {
@@ -562,6 +592,7 @@ std::string *ThreeHingeJointDriver::createFromAttributes()
         setLastError("ThreeHingeJointDriver ID=\""s + name() + "\" ProximalJointID joint not found or not Hinge, Universal or Ball\""s + buf + "\"");
         return lastErrorPtr();
     }
+    setProximalJointType();
     if (findAttribute("IntermediateJointID"s, &buf) == nullptr) return lastErrorPtr();
     m_intermediateJoint = dynamic_cast<HingeJoint *>(simulation()->GetJoint(buf));
     if (!m_intermediateJoint)
@@ -597,6 +628,7 @@ std::string *ThreeHingeJointDriver::createFromAttributes()
     m_distalJointAngleGamma = GSUtil::Double(buf);
 
     if (findAttribute("Tolerance"s, &buf)) m_tolerance = GSUtil::Double(buf);
+    if (findAttribute("MaxIterations"s, &buf)) m_maxIterations = GSUtil::Int(buf);
 
     // check for consistency
     if (m_proximalJoint->body2Marker()->GetBody() != m_intermediateJoint->body1Marker()->GetBody())
@@ -620,10 +652,7 @@ std::string *ThreeHingeJointDriver::createFromAttributes()
         return lastErrorPtr();
     }
 
-    // during contruction the bodies are not rotated, so the body vectors are the contruction vectors
-    m_proximalBodyVector = m_intermediateJoint->body1Marker()->GetPosition() - m_proximalJoint->body2Marker()->GetPosition();
-    m_intermediateBodyVector = m_distalJoint->body1Marker()->GetPosition() - m_intermediateJoint->body2Marker()->GetPosition();
-    m_distalBodyVector = m_distalBodyMarker->GetPosition() - m_distalJoint->body2Marker()->GetPosition();
+    CalculateJointGeometry();
 
     // we need to find the best ordering for the intermediate and distal joint ranges
     // so that we get a monotonically increasing function
@@ -658,6 +687,8 @@ std::string *ThreeHingeJointDriver::createFromAttributes()
         return lastErrorPtr();
     }
 
+    m_angleFraction = 0;
+
     // assemble the local copies of bodies, markers and joints
     std::unique_ptr<Body> baseBody = std::make_unique<Body>(nullptr);
     baseBody->setName(m_proximalJoint->body1Marker()->GetBody()->name());
@@ -792,6 +823,7 @@ void ThreeHingeJointDriver::appendToAttributes()
     setAttribute("IntermediateJointGamma"s, *GSUtil::ToString(m_intermediateJointAngleGamma, &buf));
     setAttribute("DistalJointGamma"s, *GSUtil::ToString(m_distalJointAngleGamma, &buf));
     setAttribute("Tolerance"s, *GSUtil::ToString(m_tolerance, &buf));
+    if (m_maxIterations >= 0) setAttribute("MaxIterations"s, *GSUtil::ToString(m_maxIterations, &buf));
 }
 
 
@@ -813,6 +845,7 @@ Marker *ThreeHingeJointDriver::distalBodyMarker() const
 void ThreeHingeJointDriver::setDistalBodyMarker(Marker *distalBodyMarker)
 {
     m_distalBodyMarker = distalBodyMarker;
+    CalculateJointGeometry();
 }
 
 Joint *ThreeHingeJointDriver::proximalJoint() const
@@ -823,6 +856,16 @@ Joint *ThreeHingeJointDriver::proximalJoint() const
 void ThreeHingeJointDriver::setProximalJoint(Joint *proximalJoint)
 {
     m_proximalJoint = proximalJoint;
+    setProximalJointType();
+    CalculateJointGeometry();
+}
+
+void ThreeHingeJointDriver::setProximalJointType()
+{
+    m_proximalJointType = UnknownProximal;
+    if (dynamic_cast<HingeJoint *>(m_proximalJoint)) m_proximalJointType = HingeProximal;
+    else if (dynamic_cast<UniversalJoint *>(m_proximalJoint)) m_proximalJointType = UniversalProximal;
+    else if (dynamic_cast<BallJoint *>(m_proximalJoint)) m_proximalJointType = BallProximal;
 }
 
 HingeJoint *ThreeHingeJointDriver::intermediateJoint() const
@@ -833,6 +876,7 @@ HingeJoint *ThreeHingeJointDriver::intermediateJoint() const
 void ThreeHingeJointDriver::setIntermediateJoint(HingeJoint *intermediateJoint)
 {
     m_intermediateJoint = intermediateJoint;
+    CalculateJointGeometry();
 }
 
 HingeJoint *ThreeHingeJointDriver::distalJoint() const
@@ -843,6 +887,27 @@ HingeJoint *ThreeHingeJointDriver::distalJoint() const
 void ThreeHingeJointDriver::setDistalJoint(HingeJoint *distalJoint)
 {
     m_distalJoint = distalJoint;
+    CalculateJointGeometry();
+}
+
+// the body vectors, joint axes and the lengths at the ends of the range only depend on the joints and the distal
+// body marker so they are calculated here whenever one of those changes rather than every step
+void ThreeHingeJointDriver::CalculateJointGeometry()
+{
+    if (!m_proximalJoint || !m_intermediateJoint || !m_distalJoint || !m_distalBodyMarker) return;
+    // during contruction the bodies are not rotated, so the body vectors are the contruction vectors
+    m_proximalBodyVector = m_intermediateJoint->body1Marker()->GetPosition() - m_proximalJoint->body2Marker()->GetPosition();
+    m_intermediateBodyVector = m_distalJoint->body1Marker()->GetPosition() - m_intermediateJoint->body2Marker()->GetPosition();
+    m_distalBodyVector = m_distalBodyMarker->GetPosition() - m_distalJoint->body2Marker()->GetPosition();
+    m_intermediateJointAxis = m_intermediateJoint->body1Marker()->GetAxis(Marker::X);
+    m_distalJointAxis = m_distalJoint->body1Marker()->GetAxis(Marker::X);
+    // the lengths at the ends of the range are used to check the bracket each step
+    CalculateLength(0);
+    m_lengthAtZero = m_actualLength;
+    CalculateLength(1);
+    m_lengthAtOne = m_actualLength;
+    m_lengthDerivative = m_lengthAtOne - m_lengthAtZero;
+    CalculateLength(m_angleFraction); // neeeded because CalculateLength changes m_intermediateJointAngle and m_distalJointAngle
 }
 
 double ThreeHingeJointDriver::desiredLength() const
@@ -860,3 +925,13 @@ double ThreeHingeJointDriver::actualLength() const
     return m_actualLength;
 }
 
+int ThreeHingeJointDriver::solverEvaluations() const
+{
+    return m_solverEvaluations;
+}
+
+int64_t ThreeHingeJointDriver::solverFallbacks() const
+{
+    return m_solverFallbacks;
+}
+
@@ -15,6 +15,7 @@
 
 #include <memory>
 #include <map>
+#include <cstdint>
 
 class Marker;
 class HingeJoint;
@@ -59,7 +60,16 @@ public:
 
     double actualLength() const;
 
+    int solverEvaluations() const; // CalculateLength calls used in the last step
+    int64_t solverFallbacks() const; // number of steps where the warm start failed and zeroin was used
+
 private:
+    enum ProximalJointType { UnknownProximal, HingeProximal, UniversalProximal, BallProximal };
+
+    bool SolveWarmStart();
+    void setProximalJointType();
+    void CalculateJointGeometry();
+
     Marker *m_targetMarker = nullptr;
     Marker *m_distalBodyMarker = nullptr;
     Joint *m_proximalJoint = nullptr;
@@ -71,6 +81,7 @@ private:
     double m_intermediateJointAngleGamma = 1.0;
     double m_distalJointAngleGamma = 1.0;
     double m_tolerance  =1.0e-6;
+    int m_maxIterations = -1; // per step iteration cap for the warm started solver, negative means use the default
     bool m_dumpExtensionCurve = false;
 
     double m_proximalJointAngle1 = 0;
@@ -91,6 +102,14 @@ private:
     double m_proximalAngleFraction1 = 0;
     double m_proximalAngleFraction2 = 0;
 
+    // solver state carried between steps
+    ProximalJointType m_proximalJointType = UnknownProximal;
+    double m_lengthAtZero = 0;
+    double m_lengthAtOne = 0;
+    double m_lengthDerivative = 0;
+    int m_solverEvaluations = 0;
+    int64_t m_solverFallbacks = 0;
+
     // during contruction the bodies are not rotated, so the body vectors are the contruction vectors
     pgd::Vector3 m_proximalBodyVector;
     pgd::Vector3 m_intermediateBodyVector;
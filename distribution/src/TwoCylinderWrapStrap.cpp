@@ -14,6 +14,7 @@
 #include "Simulation.h"
 #include "GSUtil.h"
 #include "Marker.h"
+#include "StateBuffer.h"
 
 #include <cmath>
 #include <string.h>
@@ -1078,3 +1079,19 @@ void TwoCylinderWrapStrap::appendToAttributes()
     setAttribute("Cylinder2Radius"s, *GSUtil::ToString(m_cylinder2Radius, &buf));
 }
 
+void TwoCylinderWrapStrap::saveState(StateBuffer *state)
+{
+    Strap::saveState(state);
+    state->Write(m_wrapStatus);
+    state->Write(m_pathCoordinates);
+    state->Write(m_numPathCoordinates);
+}
+
+void TwoCylinderWrapStrap::restoreState(StateBuffer *state)
+{
+    Strap::restoreState(state);
+    state->Read(&m_wrapStatus);
+    state->Read(&m_pathCoordinates);
+    state->Read(&m_numPathCoordinates);
+}
+
@@ -53,6 +53,8 @@ public:
 
     virtual std::string *createFromAttributes();
     virtual void appendToAttributes();
+    virtual void saveState(StateBuffer *state);
+    virtual void restoreState(StateBuffer *state);
 
     double Cylinder1Radius() const;
     double Cylinder2Radius() const;
@@ -22,10 +22,40 @@
 #include <iostream>
 #include <sstream>
 
+using namespace std::string_literals;
+
+// expressions that are just a gene or are affine in a single gene are evaluated directly
+// as value = scale * g[gene] + offset which gives exactly the same result as exprtk
+struct AffineGene
+{
+    bool valid = false;
+    size_t gene = 0;
+    bool hasScale = false;
+    double scale = 1;
+    bool hasOffset = false;
+    double offset = 0;
+};
+
+struct XMLConverter::ExpressionCache
+{
+    std::vector<double> genome; // all the expressions refer to this so it must not be reallocated
+    exprtk::symbol_table<double> symbolTable;
+    exprtk::parser<double> parser;
+    std::vector<exprtk::expression<double>> expressionList;
+    std::vector<bool> compiledList;
+    std::vector<AffineGene> affineGeneList;
+};
+
+static bool ParseAffineGene(const std::string &text, size_t genomeSize, exprtk::parser<double> *parser, AffineGene *affineGene);
+
 XMLConverter::XMLConverter()
 {
 }
 
+XMLConverter::~XMLConverter()
+{
+}
+
 // load the base file for smart substitution file
 int XMLConverter::LoadBaseXMLFile(const char *filename)
 {
@@ -41,16 +71,28 @@ void XMLConverter::Clear()
     m_SmartSubstitutionTextComponents.clear();
     m_SmartSubstitutionParserText.clear();
     m_SmartSubstitutionValues.clear();
+    m_ExpressionCache.reset();
     m_BaseXMLString.clear();
+    m_ParameterMap.clear();
+    m_ParameterMapParseXML.elementList()->clear();
+    m_ParameterMapValid = false;
 }
 
 // load the base XML for smart substitution file
 int XMLConverter::LoadBaseXMLString(const char *dataPtr, size_t length)
+{
+    return LoadBaseXMLString(dataPtr, length, nullptr);
+}
+
+// as above but a non empty markedElementList (from CopyMarkedElementList) is used instead of parsing the XML again
+// the contents of markedElementList are consumed
+int XMLConverter::LoadBaseXMLString(const char *dataPtr, size_t length, std::vector<std::unique_ptr<ParseXML::XMLElement>> *markedElementList)
 {
     m_SmartSubstitutionTextBuffer.clear();
     m_SmartSubstitutionTextComponents.clear();
     m_SmartSubstitutionParserText.clear();
     m_SmartSubstitutionValues.clear();
+    m_ExpressionCache.reset();
     m_BaseXMLString.assign(dataPtr, length);
 
     const char *ptr1 = dataPtr;
@@ -80,9 +122,142 @@ int XMLConverter::LoadBaseXMLString(const char *dataPtr, size_t length)
     // get the vector brackets in the right format for exprtk if necessary
     ConvertVectorBrackets();
 
+    // and work out where the substitutions end up in the parsed model
+    if (markedElementList && markedElementList->size())
+    {
+        m_ParameterMap.clear();
+        m_ParameterMapValid = false;
+        m_ParameterMapParseXML.elementList()->swap(*markedElementList);
+        markedElementList->clear();
+        BindParameterMap();
+    }
+    else
+    {
+        BuildParameterMap();
+    }
+
     return 0;
 }
 
+// this routine parses the base XML once with each substitution replaced by a marker
+// and records which attribute of which element each substitution is found in
+// the parameter map is only valid if every substitution is found within an attribute value
+void XMLConverter::BuildParameterMap()
+{
+    m_ParameterMap.clear();
+    m_ParameterMapValid = false;
+
+    // the "[[" has already been consumed from all the text components so "[[index]]" is a unique marker
+    std::string markedXML;
+    for (size_t i = 0; i < m_SmartSubstitutionValues.size(); i++)
+    {
+        markedXML += m_SmartSubstitutionTextComponents[i];
+        markedXML += "[["s + std::to_string(i) + "]]"s;
+    }
+    markedXML += m_SmartSubstitutionTextComponents[m_SmartSubstitutionValues.size()];
+    if (m_ParameterMapParseXML.LoadModel(markedXML.c_str(), markedXML.size(), "GAITSYM2019"s))
+    {
+        m_ParameterMapParseXML.elementList()->clear();
+        return;
+    }
+    BindParameterMap();
+}
+
+// finds the "[[index]]" markers in the parsed element list
+void XMLConverter::BindParameterMap()
+{
+    size_t substitutionsFound = 0;
+    for (auto &&element : *m_ParameterMapParseXML.elementList())
+    {
+        for (auto &&attribute : element->attributes)
+        {
+            const std::string &value = attribute.second;
+            size_t start = value.find("[["s);
+            if (start == std::string::npos) continue;
+            ParameterBinding binding;
+            binding.attributeValue = &attribute.second;
+            size_t last = 0;
+            while (start != std::string::npos)
+            {
+                size_t end = value.find("]]"s, start + 2);
+                std::string indexText = end == std::string::npos ? ""s : value.substr(start + 2, end - start - 2);
+                // the element list may have come from a cache so the markers are checked before they are used
+                if (indexText.size() == 0 || indexText.size() > 9 || indexText.find_first_not_of("0123456789"s) != std::string::npos ||
+                        std::stoul(indexText) >= m_SmartSubstitutionValues.size())
+                {
+                    m_ParameterMap.clear();
+                    m_ParameterMapParseXML.elementList()->clear();
+                    return;
+                }
+                binding.textComponents.push_back(value.substr(last, start - last));
+                binding.substitutionIndices.push_back(size_t(std::stoul(indexText)));
+                substitutionsFound++;
+                last = end + 2;
+                start = value.find("[["s, last);
+            }
+            binding.textComponents.push_back(value.substr(last));
+            m_ParameterMap.push_back(std::move(binding));
+        }
+    }
+    if (substitutionsFound != m_SmartSubstitutionValues.size())
+    {
+        m_ParameterMap.clear();
+        m_ParameterMapParseXML.elementList()->clear();
+        return;
+    }
+    m_ParameterMapValid = true;
+}
+
+// writes the current substitution values directly into the pre-parsed element list
+// the values are formatted identically to GetFormattedXML so the resulting model is the same
+int XMLConverter::ApplyParameterMap()
+{
+    if (m_ParameterMapValid == false) return 1;
+    char buffer[64];
+    for (auto &&binding : m_ParameterMap)
+    {
+        std::string *value = binding.attributeValue;
+        value->assign(binding.textComponents[0]);
+        for (size_t i = 0; i < binding.substitutionIndices.size(); i++)
+        {
+            int n = snprintf(buffer, sizeof(buffer), "%.17e", m_SmartSubstitutionValues[binding.substitutionIndices[i]]);
+            value->append(buffer, size_t(n));
+            value->append(binding.textComponents[i + 1]);
+        }
+    }
+    return 0;
+}
+
+// copies the parsed element list with the "[[index]]" markers put back so that it can be
+// cached and later passed to LoadBaseXMLString to skip the parse
+void XMLConverter::CopyMarkedElementList(std::vector<std::unique_ptr<ParseXML::XMLElement>> *markedElementList)
+{
+    markedElementList->clear();
+    if (m_ParameterMapValid == false) return;
+    for (auto &&binding : m_ParameterMap) // this is safe because ApplyParameterMap rewrites every bound value
+    {
+        std::string *value = binding.attributeValue;
+        value->assign(binding.textComponents[0]);
+        for (size_t i = 0; i < binding.substitutionIndices.size(); i++)
+        {
+            value->append("[["s + std::to_string(binding.substitutionIndices[i]) + "]]"s);
+            value->append(binding.textComponents[i + 1]);
+        }
+    }
+    for (auto &&element : *m_ParameterMapParseXML.elementList())
+        markedElementList->push_back(std::make_unique<ParseXML::XMLElement>(*element));
+}
+
+bool XMLConverter::ParameterMapValid() const
+{
+    return m_ParameterMapValid;
+}
+
+const std::vector<std::unique_ptr<ParseXML::XMLElement>> &XMLConverter::ParameterMapElementList()
+{
+    return *m_ParameterMapParseXML.elementList();
+}
+
 const char *XMLConverter::GetFormattedXML(size_t *docTxtLen)
 {
     std::ostringstream ss;
@@ -102,44 +277,213 @@ const char *XMLConverter::GetFormattedXML(size_t *docTxtLen)
 // the XML file specifying the simulation
 int XMLConverter::ApplyGenome(int genomeSize, double *genomeData)
 {
-    exprtk::symbol_table<double> *symbol_table;
-    exprtk::expression<double> *expression;
-    exprtk::parser<double> *parser;
+    // the expressions are compiled on the first call and again only if the genome size changes
+    if (!m_ExpressionCache || m_ExpressionCache->genome.size() != size_t(genomeSize)) CompileExpressions(size_t(genomeSize));
+    std::copy(genomeData, genomeData + genomeSize, m_ExpressionCache->genome.begin());
 
-    for (unsigned int i = 0; i < m_SmartSubstitutionParserText.size(); i++)
+    const double *genome = m_ExpressionCache->genome.data();
+    for (size_t i = 0; i < m_SmartSubstitutionParserText.size(); i++)
     {
-        // set up the genome as a function g(locus) and evaluate
+        const AffineGene &affineGene = m_ExpressionCache->affineGeneList[i];
+        if (affineGene.valid)
+        {
+            double value = genome[affineGene.gene];
+            if (affineGene.hasScale) value = affineGene.scale * value;
+            if (affineGene.hasOffset) value = value + affineGene.offset;
+            m_SmartSubstitutionValues[i] = value;
+        }
+        else if (m_ExpressionCache->compiledList[i])
+        {
+            m_SmartSubstitutionValues[i] = m_ExpressionCache->expressionList[i].value();
+        }
+        else
+        {
+            std::cerr << "Error: XMLConverter::ApplyGenome m_SmartSubstitutionParserComponents[" << i << "] does not evaluate to a number\n";
+            std::cerr << "Applying standard fix up and setting to zero\n";
+            m_SmartSubstitutionValues[i] = 0;
+        }
+    }
 
-        symbol_table = new exprtk::symbol_table<double>();
-        expression = new exprtk::expression<double>();
-        parser = new exprtk::parser<double>();
+    return 0;
+}
 
-        symbol_table->add_vector("g", genomeData, size_t(genomeSize));
-        symbol_table->add_constants();
+// set up the genome as a function g(locus) and compile all the expressions against it
+void XMLConverter::CompileExpressions(size_t genomeSize)
+{
+    m_ExpressionCache = std::make_unique<ExpressionCache>();
+    ExpressionCache *cache = m_ExpressionCache.get();
+    cache->genome.assign(genomeSize, 0);
+    cache->symbolTable.add_vector("g", cache->genome.data(), genomeSize);
+    cache->symbolTable.add_constants();
+    cache->expressionList.resize(m_SmartSubstitutionParserText.size());
+    cache->compiledList.resize(m_SmartSubstitutionParserText.size());
+    cache->affineGeneList.resize(m_SmartSubstitutionParserText.size());
 
-        expression->register_symbol_table(*symbol_table);
+    // these values are only used to check that the direct evaluation matches exprtk
+    const double testValues[] = {0.123456789012345, -9876.54321, 3.3e-5};
+    for (size_t i = 0; i < m_SmartSubstitutionParserText.size(); i++)
+    {
+        exprtk::expression<double> &expression = cache->expressionList[i];
+        expression.register_symbol_table(cache->symbolTable);
+//        std::cerr << "substitution text " << i << ": " << m_SmartSubstitutionParserText[i] << "\n";
+        cache->compiledList[i] = cache->parser.compile(m_SmartSubstitutionParserText[i], expression);
+        if (cache->compiledList[i] == false) continue;
 
-//        std::cerr << "substitution text " << i << ": " << *m_SmartSubstitutionParserText[i] << "\n";
-        bool success = parser->compile(m_SmartSubstitutionParserText[i], *expression);
+        AffineGene affineGene;
+        if (ParseAffineGene(m_SmartSubstitutionParserText[i], genomeSize, &cache->parser, &affineGene) == false) continue;
+        for (size_t j = 0; j < sizeof(testValues) / sizeof(testValues[0]) && affineGene.valid; j++)
+        {
+            cache->genome[affineGene.gene] = testValues[j];
+            double value = testValues[j];
+            if (affineGene.hasScale) value = affineGene.scale * value;
+            if (affineGene.hasOffset) value = value + affineGene.offset;
+            double exprtkValue = expression.value();
+            if (memcmp(&value, &exprtkValue, sizeof(double))) affineGene.valid = false;
+        }
+        cache->genome[affineGene.gene] = 0;
+        cache->affineGeneList[i] = affineGene;
+    }
+}
 
-        if (success)
+// recognises g[i], a*g[i], g[i]*a and -g[i], with an optional +b or -b before or after
+// the literals are converted by exprtk so that they have exactly the values it would use
+static bool ParseAffineGene(const std::string &text, size_t genomeSize, exprtk::parser<double> *parser, AffineGene *affineGene)
+{
+    struct Token
+    {
+        char type; // 'n' number, 'g' gene, or the operator character
+        std::string text;
+        size_t gene;
+    };
+    std::vector<Token> tokens;
+    size_t i = 0;
+    while (i < text.size())
+    {
+        char c = text[i];
+        if (c <= ' ') { i++; continue; }
+        Token token;
+        token.type = c;
+        token.gene = 0;
+        if (c == '+' || c == '-' || c == '*')
+        {
+            i++;
+        }
+        else if ((c >= '0' && c <= '9') || c == '.')
         {
-            m_SmartSubstitutionValues[i] = expression->value();
-//            std::cerr << "substitution value " << i << " = " << m_SmartSubstitutionValues[i] << "\n";
+            size_t start = i;
+            while (i < text.size() && ((text[i] >= '0' && text[i] <= '9') || text[i] == '.')) i++;
+            if (i < text.size() && (text[i] == 'e' || text[i] == 'E'))
+            {
+                i++;
+                if (i < text.size() && (text[i] == '+' || text[i] == '-')) i++;
+                while (i < text.size() && text[i] >= '0' && text[i] <= '9') i++;
+            }
+            token.type = 'n';
+            token.text = text.substr(start, i - start);
+        }
+        else if (c == 'g')
+        {
+            i++;
+            while (i < text.size() && text[i] <= ' ') i++;
+            if (i >= text.size() || text[i] != '[') return false;
+            i++;
+            while (i < text.size() && text[i] <= ' ') i++;
+            size_t start = i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') i++;
+            if (i == start || i - start > 9) return false;
+            token.gene = size_t(std::stoul(text.substr(start, i - start)));
+            while (i < text.size() && text[i] <= ' ') i++;
+            if (i >= text.size() || text[i] != ']') return false;
+            i++;
         }
         else
         {
-            std::cerr << "Error: XMLConverter::ApplyGenome m_SmartSubstitutionParserComponents[" << i << "] does not evaluate to a number\n";
-            std::cerr << "Applying standard fix up and setting to zero\n";
-            m_SmartSubstitutionValues[i] = 0;
+            return false;
         }
+        tokens.push_back(token);
+    }
+
+    auto literal = [parser](const std::string &literalText, double *value) -> bool
+    {
+        exprtk::expression<double> expression;
+        if (parser->compile(literalText, expression) == false) return false;
+        *value = expression.value();
+        return true;
+    };
+    auto matches = [&tokens](size_t start, const char *pattern) -> bool
+    {
+        size_t n = strlen(pattern);
+        if (start + n > tokens.size()) return false;
+        for (size_t j = 0; j < n; j++) if (tokens[start + j].type != pattern[j]) return false;
+        return true;
+    };
+
+    // the optional leading or trailing offset
+    size_t first = 0, last = tokens.size();
+    double offset = 0;
+    bool hasOffset = false, subtractTerm = false;
+    if (matches(0, "n+") || matches(0, "n-") || matches(0, "-n+") || matches(0, "-n-"))
+    {
+        bool negative = tokens[0].type == '-';
+        size_t n = negative ? 1 : 0;
+        if (literal(tokens[n].text, &offset) == false) return false;
+        if (negative) offset = -offset;
+        subtractTerm = tokens[n + 1].type == '-';
+        hasOffset = true;
+        first = n + 2;
+    }
+    else if (last >= 2 && tokens[last - 1].type == 'n' && (tokens[last - 2].type == '+' || tokens[last - 2].type == '-'))
+    {
+        if (literal(tokens[last - 1].text, &offset) == false) return false;
+        if (tokens[last - 2].type == '-') offset = -offset;
+        hasOffset = true;
+        last -= 2;
+    }
 
-        delete parser;
-        delete expression;
-        delete symbol_table;
+    // the term
+    bool negative = false;
+    if (first < last && tokens[first].type == '-')
+    {
+        negative = true;
+        first++;
+    }
+    double scale = 1;
+    bool hasScale = false;
+    size_t geneToken;
+    if (last - first == 1 && matches(first, "g"))
+    {
+        geneToken = first;
+    }
+    else if (last - first == 3 && matches(first, "n*g"))
+    {
+        if (literal(tokens[first].text, &scale) == false) return false;
+        hasScale = true;
+        geneToken = first + 2;
+    }
+    else if (last - first == 3 && matches(first, "g*n"))
+    {
+        if (literal(tokens[first + 2].text, &scale) == false) return false;
+        hasScale = true;
+        geneToken = first;
+    }
+    else
+    {
+        return false;
+    }
+    if (tokens[geneToken].gene >= genomeSize) return false;
+    if (negative != subtractTerm)
+    {
+        scale = -scale;
+        hasScale = true;
     }
 
-    return 0;
+    affineGene->valid = true;
+    affineGene->gene = tokens[geneToken].gene;
+    affineGene->hasScale = hasScale;
+    affineGene->scale = scale;
+    affineGene->hasOffset = hasOffset;
+    affineGene->offset = offset;
+    return true;
 }
 
 // exprtk requires [] around vector indices whereas my parser used ()
@@ -10,8 +10,11 @@
 #ifndef XMLConverter_h
 #define XMLConverter_h
 
+#include "ParseXML.h"
+
 #include <vector>
 #include <string>
+#include <memory>
 
 class Genome;
 class DataFile;
@@ -21,12 +24,20 @@ class XMLConverter
 {
 public:
     XMLConverter();
+    ~XMLConverter();
 
     int LoadBaseXMLFile(const char *filename);
     int LoadBaseXMLString(const char *dataPtr, size_t length);
+    int LoadBaseXMLString(const char *dataPtr, size_t length, std::vector<std::unique_ptr<ParseXML::XMLElement>> *markedElementList);
     int ApplyGenome(int genomeSize, double *genomeData);
     const char* GetFormattedXML(size_t *docTxtLen);
 
+    // the parameter map allows the genome to be written directly into a pre-parsed element list
+    int ApplyParameterMap();
+    bool ParameterMapValid() const;
+    const std::vector<std::unique_ptr<ParseXML::XMLElement>> &ParameterMapElementList();
+    void CopyMarkedElementList(std::vector<std::unique_ptr<ParseXML::XMLElement>> *markedElementList);
+
     const std::string &BaseXMLString() const;
 
     void Clear();
@@ -34,12 +45,30 @@ public:
 private:
 
     void ConvertVectorBrackets();
+    void CompileExpressions(size_t genomeSize);
+    void BuildParameterMap();
+    void BindParameterMap();
+
+    struct ParameterBinding
+    {
+        std::string *attributeValue = nullptr; // points into the attribute map of an element in m_ParameterMapParseXML
+        std::vector<std::string> textComponents; // always one more text component than substitution index
+        std::vector<size_t> substitutionIndices;
+    };
 
     std::string m_BaseXMLString;
     std::vector<std::string> m_SmartSubstitutionTextComponents;
     std::vector<std::string> m_SmartSubstitutionParserText;
     std::vector<double> m_SmartSubstitutionValues;
     std::string m_SmartSubstitutionTextBuffer;
+
+    // the substitution expressions are compiled once against m_ExpressionCache->genome (defined in XMLConverter.cpp to keep exprtk out of this header)
+    struct ExpressionCache;
+    std::unique_ptr<ExpressionCache> m_ExpressionCache;
+
+    ParseXML m_ParameterMapParseXML;
+    std::vector<ParameterBinding> m_ParameterMap;
+    bool m_ParameterMapValid = false;
 };
 
 